@@ -0,0 +1,379 @@
+#include "api/edl2ffmpeg.h"
+#include "media/DecoderCache.h"
+#include "render/FrameSource.h"
+#include "render/Renderer.h"
+#include "utils/Logger.h"
+#include "utils/MemoryBudget.h"
+#include <filesystem>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+struct edl2ffmpeg_session {
+	render::Options options;
+	edl2ffmpeg_progress_callback progressCallback = nullptr;
+	void* progressUserData = nullptr;
+	
+	std::mutex mutex;
+	std::unique_ptr<render::Renderer> renderer;     // Set while rendering
+	std::thread worker;                             // Render started by edl2ffmpeg_render_async()
+	bool asyncRunning = false;
+	std::condition_variable asyncDone;              // Signalled when asyncRunning turns false
+	edl2ffmpeg_status asyncStatus = EDL2FFMPEG_OK;
+	std::string asyncError;
+	
+	std::unique_ptr<render::FrameSource> frames;    // Opened by the first frame or info request
+	std::shared_ptr<AVFrame> frame;                 // Last frame handed out
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+edl2ffmpeg_status fail(edl2ffmpeg_status status, const std::string& message) {
+	lastError = message;
+	return status;
+}
+
+// Everything the sessions of this process keep warm
+std::shared_ptr<media::DecoderCache> decoderCache() {
+	static std::shared_ptr<media::DecoderCache> cache =
+		std::make_shared<media::DecoderCache>(media::DecoderCache::Config());
+	return cache;
+}
+
+void initialize() {
+	static std::once_flag once;
+	std::call_once(once, []() {
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+		av_register_all();
+#endif
+	});
+}
+
+edl2ffmpeg_session* createSession(render::Options options) {
+	initialize();
+	auto session = new edl2ffmpeg_session();
+	options.quiet = true;
+	session->options = std::move(options);
+	return session;
+}
+
+// Open the timeline for frames and info; caller holds the session mutex
+edl2ffmpeg_status openFrames(edl2ffmpeg_session* session) {
+	if (session->renderer) {
+		return fail(EDL2FFMPEG_BUSY, "The session is rendering");
+	}
+	if (!session->frames) {
+		session->frames = std::make_unique<render::FrameSource>(session->options, decoderCache());
+	}
+	return EDL2FFMPEG_OK;
+}
+
+// Set up a render to output_path; caller holds the session mutex, and joins
+// finished (an earlier async render nobody waited for) after releasing it
+edl2ffmpeg_status prepareRender(edl2ffmpeg_session* session, const char* outputPath, std::thread& finished) {
+	if (!outputPath) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "No output path");
+	}
+	if (session->renderer) {
+		return fail(EDL2FFMPEG_BUSY, "The session is rendering");
+	}
+	finished = std::move(session->worker);
+	
+	render::Options options = session->options;
+	options.outputFile = outputPath;
+	session->renderer = std::make_unique<render::Renderer>(options);
+	session->renderer->setDecoderCache(decoderCache());
+	
+	edl2ffmpeg_progress_callback callback = session->progressCallback;
+	void* userData = session->progressUserData;
+	if (callback) {
+		session->renderer->setProgressCallback([callback, userData](const render::Renderer::Progress& progress) {
+			edl2ffmpeg_progress report;
+			report.frame = progress.frame;
+			report.total_frames = progress.totalFrames;
+			report.fps = progress.fps;
+			report.done = progress.done ? 1 : 0;
+			callback(&report, userData);
+		});
+	}
+	return EDL2FFMPEG_OK;
+}
+
+// Run the prepared render; the caller releases the renderer under the
+// session mutex afterwards
+edl2ffmpeg_status runRender(edl2ffmpeg_session* session, std::string& error) {
+	edl2ffmpeg_status status = EDL2FFMPEG_OK;
+	try {
+		render::Renderer::Result result = session->renderer->render();
+		if (result.cancelled) {
+			status = EDL2FFMPEG_CANCELLED;
+			error = "Render cancelled";
+		}
+	} catch (const std::exception& e) {
+		status = EDL2FFMPEG_ERROR;
+		error = e.what();
+	}
+	return status;
+}
+
+}
+
+extern "C" {
+
+int edl2ffmpeg_api_version(void) {
+	return EDL2FFMPEG_API_VERSION;
+}
+
+const char* edl2ffmpeg_last_error(void) {
+	return lastError.c_str();
+}
+
+void edl2ffmpeg_set_log_level(edl2ffmpeg_log_level level) {
+	utils::Logger::setLevel(static_cast<utils::Logger::Level>(level));
+}
+
+void edl2ffmpeg_set_max_memory(uint64_t megabytes) {
+	utils::MemoryBudget::getInstance().setLimit(megabytes * 1024 * 1024);
+}
+
+void edl2ffmpeg_release_decoders(void) {
+	decoderCache()->clear();
+}
+
+edl2ffmpeg_session* edl2ffmpeg_session_create_from_file(const char* edl_path) {
+	if (!edl_path || !std::filesystem::exists(edl_path)) {
+		fail(EDL2FFMPEG_INVALID_ARGUMENT, std::string("EDL file not found: ") + (edl_path ? edl_path : "(null)"));
+		return nullptr;
+	}
+	try {
+		render::Options options;
+		options.edlFile = edl_path;
+		return createSession(std::move(options));
+	} catch (const std::exception& e) {
+		fail(EDL2FFMPEG_ERROR, e.what());
+		return nullptr;
+	}
+}
+
+edl2ffmpeg_session* edl2ffmpeg_session_create_from_string(const char* edl_json, const char* media_dir) {
+	if (!edl_json) {
+		fail(EDL2FFMPEG_INVALID_ARGUMENT, "No EDL");
+		return nullptr;
+	}
+	try {
+		// Syntax errors show up here; errors in the EDL itself when it is used
+		render::Options options;
+		options.edlJson = nlohmann::json::parse(edl_json).dump();
+		options.mediaDir = media_dir ? media_dir : ".";
+		options.usePlanCache = false;
+		return createSession(std::move(options));
+	} catch (const std::exception& e) {
+		fail(EDL2FFMPEG_INVALID_ARGUMENT, std::string("Invalid EDL: ") + e.what());
+		return nullptr;
+	}
+}
+
+void edl2ffmpeg_session_destroy(edl2ffmpeg_session* session) {
+	if (!session) {
+		return;
+	}
+	edl2ffmpeg_cancel(session);
+	std::thread worker;
+	{
+		std::lock_guard<std::mutex> lock(session->mutex);
+		worker = std::move(session->worker);
+	}
+	if (worker.joinable()) {
+		worker.join();
+	}
+	delete session;
+}
+
+edl2ffmpeg_status edl2ffmpeg_session_set_option(edl2ffmpeg_session* session, const char* key, const char* value) {
+	if (!session || !key || !value) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session, key or value");
+	}
+	
+	// Values that are not JSON are strings
+	nlohmann::json parsed = nlohmann::json::parse(value, nullptr, false);
+	if (parsed.is_discarded()) {
+		parsed = value;
+	}
+	
+	std::lock_guard<std::mutex> lock(session->mutex);
+	if (session->renderer) {
+		return fail(EDL2FFMPEG_BUSY, "The session is rendering");
+	}
+	try {
+		render::Options options = session->options;
+		render::applyJobOption(options, key, parsed);
+		session->options = std::move(options);
+	} catch (const std::exception& e) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, e.what());
+	}
+	
+	// Frames follow the new decoder and thread settings
+	session->frames.reset();
+	return EDL2FFMPEG_OK;
+}
+
+void edl2ffmpeg_session_set_progress_callback(edl2ffmpeg_session* session,
+	edl2ffmpeg_progress_callback callback, void* user_data) {
+	if (!session) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(session->mutex);
+	session->progressCallback = callback;
+	session->progressUserData = user_data;
+}
+
+edl2ffmpeg_status edl2ffmpeg_session_get_info(edl2ffmpeg_session* session, edl2ffmpeg_info* info) {
+	if (!session || !info) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session or info");
+	}
+	std::lock_guard<std::mutex> lock(session->mutex);
+	try {
+		edl2ffmpeg_status status = openFrames(session);
+		if (status != EDL2FFMPEG_OK) {
+			return status;
+		}
+		info->width = session->frames->getWidth();
+		info->height = session->frames->getHeight();
+		info->frame_rate = session->frames->getFrameRate();
+		info->total_frames = session->frames->getTotalFrames();
+		return EDL2FFMPEG_OK;
+	} catch (const std::exception& e) {
+		return fail(EDL2FFMPEG_ERROR, e.what());
+	}
+}
+
+edl2ffmpeg_status edl2ffmpeg_render(edl2ffmpeg_session* session, const char* output_path) {
+	if (!session) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session");
+	}
+	std::thread finished;
+	{
+		std::lock_guard<std::mutex> lock(session->mutex);
+		edl2ffmpeg_status status = prepareRender(session, output_path, finished);
+		if (status != EDL2FFMPEG_OK) {
+			return status;
+		}
+	}
+	if (finished.joinable()) {
+		finished.join();
+	}
+	
+	std::string error;
+	edl2ffmpeg_status status = runRender(session, error);
+	{
+		std::lock_guard<std::mutex> lock(session->mutex);
+		session->renderer.reset();
+	}
+	if (status != EDL2FFMPEG_OK) {
+		lastError = error;
+	}
+	return status;
+}
+
+edl2ffmpeg_status edl2ffmpeg_render_async(edl2ffmpeg_session* session, const char* output_path) {
+	if (!session) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session");
+	}
+	std::thread finished;
+	{
+		std::lock_guard<std::mutex> lock(session->mutex);
+		edl2ffmpeg_status status = prepareRender(session, output_path, finished);
+		if (status != EDL2FFMPEG_OK) {
+			return status;
+		}
+		
+		session->asyncRunning = true;
+		session->asyncStatus = EDL2FFMPEG_OK;
+		session->asyncError.clear();
+		session->worker = std::thread([session]() {
+			std::string error;
+			edl2ffmpeg_status result = runRender(session, error);
+			std::lock_guard<std::mutex> lock(session->mutex);
+			session->renderer.reset();
+			session->asyncStatus = result;
+			session->asyncError = error;
+			session->asyncRunning = false;
+			session->asyncDone.notify_all();
+		});
+	}
+	if (finished.joinable()) {
+		finished.join();
+	}
+	return EDL2FFMPEG_OK;
+}
+
+edl2ffmpeg_status edl2ffmpeg_wait(edl2ffmpeg_session* session) {
+	if (!session) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session");
+	}
+	
+	// Any number of threads may wait; one of them joins the worker
+	std::thread worker;
+	edl2ffmpeg_status status;
+	{
+		std::unique_lock<std::mutex> lock(session->mutex);
+		session->asyncDone.wait(lock, [session]() { return !session->asyncRunning; });
+		worker = std::move(session->worker);
+		status = session->asyncStatus;
+		if (status != EDL2FFMPEG_OK) {
+			lastError = session->asyncError;
+		}
+	}
+	if (worker.joinable()) {
+		worker.join();
+	}
+	return status;
+}
+
+void edl2ffmpeg_cancel(edl2ffmpeg_session* session) {
+	if (!session) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(session->mutex);
+	if (session->renderer) {
+		session->renderer->cancel();
+	}
+}
+
+edl2ffmpeg_status edl2ffmpeg_get_frame(edl2ffmpeg_session* session, int frame_number, edl2ffmpeg_frame* frame) {
+	if (!session || !frame) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, "Missing session or frame");
+	}
+	std::lock_guard<std::mutex> lock(session->mutex);
+	try {
+		edl2ffmpeg_status status = openFrames(session);
+		if (status != EDL2FFMPEG_OK) {
+			return status;
+		}
+		session->frame = session->frames->getFrame(frame_number);
+	} catch (const std::out_of_range& e) {
+		return fail(EDL2FFMPEG_INVALID_ARGUMENT, e.what());
+	} catch (const std::exception& e) {
+		return fail(EDL2FFMPEG_ERROR, e.what());
+	}
+	
+	const AVFrame* composited = session->frame.get();
+	frame->number = frame_number;
+	frame->width = composited->width;
+	frame->height = composited->height;
+	for (int plane = 0; plane < 3; plane++) {
+		frame->data[plane] = composited->data[plane];
+		frame->linesize[plane] = composited->linesize[plane];
+	}
+	return EDL2FFMPEG_OK;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+/*
+ * libedl2ffmpeg: render publishing EDLs in-process.
+ *
+ * A session holds one EDL and the options to render it with. It renders to
+ * a file, synchronously or on a thread of its own, or hands out single
+ * composited frames. Sessions are independent and may be used from
+ * different threads. Every call on one session is thread-safe, but frames
+ * must not be pulled while that session renders. Sources probed and
+ * decoders opened by one session are kept warm for the next, so many short
+ * renders in one process do not each pay for opening their media.
+ *
+ * Functions that fail return a status other than EDL2FFMPEG_OK (or NULL)
+ * and leave a message for edl2ffmpeg_last_error() on the calling thread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented when a function or struct changes incompatibly */
+#define EDL2FFMPEG_API_VERSION 1
+
+typedef enum edl2ffmpeg_status {
+	EDL2FFMPEG_OK = 0,
+	EDL2FFMPEG_ERROR = 1,               /* See edl2ffmpeg_last_error() */
+	EDL2FFMPEG_INVALID_ARGUMENT = 2,    /* Bad option, value or frame number */
+	EDL2FFMPEG_BUSY = 3,                /* The session is rendering */
+	EDL2FFMPEG_CANCELLED = 4            /* Stopped by edl2ffmpeg_cancel(); the output ends early */
+} edl2ffmpeg_status;
+
+typedef enum edl2ffmpeg_log_level {
+	EDL2FFMPEG_LOG_ERROR = 0,
+	EDL2FFMPEG_LOG_WARN = 1,
+	EDL2FFMPEG_LOG_INFO = 2,
+	EDL2FFMPEG_LOG_DEBUG = 3
+} edl2ffmpeg_log_level;
+
+typedef struct edl2ffmpeg_session edl2ffmpeg_session;
+
+typedef struct edl2ffmpeg_info {
+	int width;
+	int height;
+	int frame_rate;         /* Frames per second */
+	int total_frames;
+} edl2ffmpeg_info;
+
+typedef struct edl2ffmpeg_progress {
+	int frame;              /* Frames rendered so far */
+	int total_frames;
+	double fps;
+	int done;               /* Non-zero on the last report, after the last frame */
+} edl2ffmpeg_progress;
+
+/* Called on the rendering thread about twice per second of output */
+typedef void (*edl2ffmpeg_progress_callback)(const edl2ffmpeg_progress* progress, void* user_data);
+
+/* One composited frame, YUV 4:2:0 with 8 bits per sample */
+typedef struct edl2ffmpeg_frame {
+	int number;             /* Output frame number */
+	int width;
+	int height;
+	const uint8_t* data[3]; /* Y, U and V planes; U and V are half width and height */
+	int linesize[3];        /* Bytes from one row of a plane to the next */
+} edl2ffmpeg_frame;
+
+/* EDL2FFMPEG_API_VERSION the library was built with */
+int edl2ffmpeg_api_version(void);
+
+/* Message of the last failure on the calling thread, "" if none */
+const char* edl2ffmpeg_last_error(void);
+
+/* Log output (stdout, errors to stderr) of the whole process; default INFO */
+void edl2ffmpeg_set_log_level(edl2ffmpeg_log_level level);
+
+/*
+ * Memory budget of the whole process in MB, 0 for none (the default).
+ * Caches shrink first, then queues, then idle decoders close.
+ */
+void edl2ffmpeg_set_max_memory(uint64_t megabytes);
+
+/* Close the decoders kept warm between sessions */
+void edl2ffmpeg_release_decoders(void);
+
+/*
+ * Create a session for an EDL file; relative media paths are resolved
+ * against its directory. Returns NULL if the file does not exist.
+ */
+edl2ffmpeg_session* edl2ffmpeg_session_create_from_file(const char* edl_path);
+
+/*
+ * Create a session for an EDL given as a JSON document; relative media
+ * paths are resolved against media_dir (NULL for the working directory).
+ * Returns NULL if edl_json is not valid JSON.
+ */
+edl2ffmpeg_session* edl2ffmpeg_session_create_from_string(const char* edl_json, const char* media_dir);
+
+/* Cancel a running render, wait for it and free the session */
+void edl2ffmpeg_session_destroy(edl2ffmpeg_session* session);
+
+/*
+ * Set a render option. Keys are the long command line options with '_' for
+ * '-': codec, bitrate, crf, preset, threads, hw_accel, hw_decode, audio,
+ * segment_format, raw, ... Values are JSON ("28", "true",
+ * "[\"proxy.mp4,size=360\"]" for outputs); anything else is taken as a
+ * string ("libx265"). Settings of the whole process (logging, memory) are
+ * not session options.
+ */
+edl2ffmpeg_status edl2ffmpeg_session_set_option(edl2ffmpeg_session* session, const char* key, const char* value);
+
+void edl2ffmpeg_session_set_progress_callback(edl2ffmpeg_session* session,
+	edl2ffmpeg_progress_callback callback, void* user_data);
+
+/* Size, frame rate and length of the timeline */
+edl2ffmpeg_status edl2ffmpeg_session_get_info(edl2ffmpeg_session* session, edl2ffmpeg_info* info);
+
+/* Render to output_path on the calling thread */
+edl2ffmpeg_status edl2ffmpeg_render(edl2ffmpeg_session* session, const char* output_path);
+
+/* Start rendering to output_path on a new thread; edl2ffmpeg_wait() for the result */
+edl2ffmpeg_status edl2ffmpeg_render_async(edl2ffmpeg_session* session, const char* output_path);
+
+/* Wait for the render started by edl2ffmpeg_render_async() and return its result */
+edl2ffmpeg_status edl2ffmpeg_wait(edl2ffmpeg_session* session);
+
+/* Stop the running render after the current frame; may be called from any thread */
+void edl2ffmpeg_cancel(edl2ffmpeg_session* session);
+
+/*
+ * Composite one output frame, in any order. The planes stay valid until the
+ * next call on the session that returns a frame, or until it is destroyed.
+ */
+edl2ffmpeg_status edl2ffmpeg_get_frame(edl2ffmpeg_session* session, int frame_number, edl2ffmpeg_frame* frame);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "audio/AudioDecoder.h"
+#include "media/FFmpegCompat.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
+}
+
+namespace audio {
+
+AudioDecoder::AudioDecoder(const std::string& filename, const std::string& trackId, int sampleRate)
+	: sampleRate(sampleRate) {
+	try {
+		openFile(filename);
+		findAudioStream(trackId);
+		setupDecoder();
+		setupResampler();
+	} catch (...) {
+		cleanup();
+		throw;
+	}
+	
+	utils::Logger::debug("Audio decoder opened for {}: stream {}, {} channels, {} Hz -> {} Hz",
+		filename, streamIndex, channels, codecCtx->sample_rate, sampleRate);
+}
+
+AudioDecoder::~AudioDecoder() {
+	cleanup();
+}
+
+void AudioDecoder::openFile(const std::string& filename) {
+	int ret = avformat_open_input(&formatCtx, filename.c_str(), nullptr, nullptr);
+	if (ret < 0) {
+		char errbuf[AV_ERROR_MAX_STRING_SIZE];
+		av_strerror(ret, errbuf, sizeof(errbuf));
+		throw std::runtime_error("Failed to open input file: " + std::string(errbuf));
+	}
+	
+	ret = avformat_find_stream_info(formatCtx, nullptr);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to find stream info");
+	}
+	
+	packet = media::FFmpegCompat::allocPacket();
+	frame = av_frame_alloc();
+	if (!packet || !frame) {
+		throw std::runtime_error("Failed to allocate audio packet/frame");
+	}
+}
+
+int AudioDecoder::selectStream(AVFormatContext* formatCtx, const std::string& trackId) {
+	int streamIndex = -1;
+#if HAVE_CODECPAR_API
+	// "A<n>" selects the n-th audio stream of the file
+	int wanted = 0;
+	if (trackId.size() > 1 && (trackId[0] == 'A' || trackId[0] == 'a')) {
+		wanted = std::max(1, std::atoi(trackId.c_str() + 1));
+	}
+	
+	int audioStreams = 0;
+	for (unsigned int i = 0; i < formatCtx->nb_streams && wanted > 0; i++) {
+		if (formatCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && ++audioStreams == wanted) {
+			streamIndex = static_cast<int>(i);
+		}
+	}
+	if (wanted > 0 && streamIndex < 0) {
+		utils::Logger::warn("Audio track {} not found, using the default audio stream", trackId);
+	}
+#else
+	(void)trackId;
+#endif
+	
+	if (streamIndex < 0) {
+		streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+	}
+	if (streamIndex < 0) {
+		throw std::runtime_error("No audio stream found");
+	}
+	return streamIndex;
+}
+
+void AudioDecoder::findAudioStream(const std::string& trackId) {
+	streamIndex = selectStream(formatCtx, trackId);
+	
+	AVStream* stream = formatCtx->streams[streamIndex];
+	startPts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+	
+	// Let the demuxer drop packets of every other stream
+	for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+		if (static_cast<int>(i) != streamIndex) {
+			formatCtx->streams[i]->discard = AVDISCARD_ALL;
+		}
+	}
+}
+
+void AudioDecoder::setupDecoder() {
+#if HAVE_SEND_RECEIVE_API && HAVE_CODECPAR_API
+	AVStream* stream = formatCtx->streams[streamIndex];
+	const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+	if (!codec) {
+		throw std::runtime_error("Audio codec not supported");
+	}
+	
+	codecCtx = avcodec_alloc_context3(codec);
+	if (!codecCtx) {
+		throw std::runtime_error("Failed to allocate audio codec context");
+	}
+	
+	if (media::FFmpegCompat::copyCodecParameters(codecCtx, stream) < 0) {
+		throw std::runtime_error("Failed to copy audio codec parameters");
+	}
+	
+	// Audio decoding is cheap; keep it off the video thread budget
+	codecCtx->thread_count = 1;
+	
+	if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
+		throw std::runtime_error("Failed to open audio codec");
+	}
+#else
+	throw std::runtime_error("Audio decoding requires FFmpeg 3.1+");
+#endif
+}
+
+void AudioDecoder::setupResampler() {
+	int ret;
+#if HAVE_CH_LAYOUT_API
+	channels = codecCtx->ch_layout.nb_channels;
+	if (channels <= 0) {
+		throw std::runtime_error("Audio stream has no channels");
+	}
+	
+	AVChannelLayout inLayout;
+	if (codecCtx->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+		av_channel_layout_default(&inLayout, channels);
+	} else {
+		av_channel_layout_copy(&inLayout, &codecCtx->ch_layout);
+	}
+	AVChannelLayout outLayout;
+	av_channel_layout_default(&outLayout, channels);
+	
+	ret = swr_alloc_set_opts2(&swrCtx, &outLayout, AV_SAMPLE_FMT_FLTP, sampleRate,
+		&inLayout, codecCtx->sample_fmt, codecCtx->sample_rate, 0, nullptr);
+	av_channel_layout_uninit(&inLayout);
+	av_channel_layout_uninit(&outLayout);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to configure audio resampler");
+	}
+#else
+	channels = codecCtx->channels;
+	if (channels <= 0) {
+		throw std::runtime_error("Audio stream has no channels");
+	}
+	
+	int64_t inLayout = codecCtx->channel_layout ? codecCtx->channel_layout : av_get_default_channel_layout(channels);
+	swrCtx = swr_alloc_set_opts(nullptr, av_get_default_channel_layout(channels), AV_SAMPLE_FMT_FLTP, sampleRate,
+		inLayout, codecCtx->sample_fmt, codecCtx->sample_rate, 0, nullptr);
+	if (!swrCtx) {
+		throw std::runtime_error("Failed to configure audio resampler");
+	}
+#endif
+
+	ret = swr_init(swrCtx);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to initialize audio resampler");
+	}
+	
+	buffer.assign(channels, {});
+	convertBuffer.assign(channels, {});
+	convertPlanes.assign(channels, nullptr);
+}
+
+void AudioDecoder::cleanup() {
+	if (swrCtx) {
+		swr_free(&swrCtx);
+	}
+	if (frame) {
+		av_frame_free(&frame);
+	}
+	if (packet) {
+		media::FFmpegCompat::freePacket(&packet);
+	}
+	if (codecCtx) {
+		avcodec_free_context(&codecCtx);
+	}
+	if (formatCtx) {
+		avformat_close_input(&formatCtx);
+	}
+}
+
+void AudioDecoder::read(int64_t position, int count, std::vector<std::vector<float>>& out) {
+	int64_t buffered = static_cast<int64_t>(buffer[0].size());
+	
+	// Reads within a second past the buffered samples stream on; anything
+	// else (first read, jumps back or far ahead) seeks
+	if (!started || (bufferStartKnown &&
+		(position < bufferStart || position > bufferStart + buffered + sampleRate))) {
+		seek(position);
+	}
+	
+	while (!flushed && (!bufferStartKnown ||
+		bufferStart + static_cast<int64_t>(buffer[0].size()) < position + count)) {
+		decodeMore();
+	}
+	
+	if (bufferStartKnown && bufferStart < position) {
+		discard(position - bufferStart);
+	}
+	
+	// Silence before the first decoded sample and past the end of the stream
+	int64_t offset = bufferStartKnown ? std::min<int64_t>(bufferStart - position, count) : count;
+	int available = static_cast<int>(std::min<int64_t>(count - offset, buffer[0].size()));
+	
+	out.resize(channels);
+	for (int ch = 0; ch < channels; ch++) {
+		out[ch].assign(count, 0.0f);
+		std::copy_n(buffer[ch].begin(), available, out[ch].begin() + offset);
+	}
+	discard(available);
+}
+
+void AudioDecoder::seek(int64_t position) {
+	AVStream* stream = formatCtx->streams[streamIndex];
+	int64_t timestamp = av_rescale_q(position, AVRational{1, sampleRate}, stream->time_base) + startPts;
+	
+	int ret = av_seek_frame(formatCtx, streamIndex, timestamp, AVSEEK_FLAG_BACKWARD);
+	if (ret < 0) {
+		utils::Logger::warn("Audio seek to sample {} failed", position);
+	}
+
+#if HAVE_SEND_RECEIVE_API
+	avcodec_flush_buffers(codecCtx);
+#endif
+
+	// Re-initialising drops the samples held back by the resampler
+	swr_init(swrCtx);
+	
+	for (auto& channel : buffer) {
+		channel.clear();
+	}
+	started = true;
+	bufferStartKnown = false;
+	endOfStream = false;
+	flushed = false;
+}
+
+bool AudioDecoder::decodeMore() {
+#if HAVE_SEND_RECEIVE_API
+	while (true) {
+		int ret = avcodec_receive_frame(codecCtx, frame);
+		if (ret == 0) {
+			appendFrame(frame);
+			av_frame_unref(frame);
+			return true;
+		}
+		if (ret != AVERROR(EAGAIN)) {
+			// Decoder drained (or failed): empty the resampler and stop
+			resample(nullptr, 0);
+			flushed = true;
+			return false;
+		}
+		
+		if (endOfStream) {
+			flushed = true;
+			return false;
+		}
+		
+		ret = av_read_frame(formatCtx, packet);
+		if (ret < 0) {
+			endOfStream = true;
+			avcodec_send_packet(codecCtx, nullptr);
+			continue;
+		}
+		
+		if (packet->stream_index == streamIndex) {
+			ret = avcodec_send_packet(codecCtx, packet);
+			if (ret < 0 && ret != AVERROR(EAGAIN)) {
+				utils::Logger::debug("Dropping undecodable audio packet");
+			}
+		}
+		av_packet_unref(packet);
+	}
+#else
+	flushed = true;
+	return false;
+#endif
+}
+
+void AudioDecoder::appendFrame(AVFrame* decoded) {
+	if (!bufferStartKnown) {
+		// Position of the first frame after a seek; later frames follow on
+		int64_t pts = decoded->best_effort_timestamp != AV_NOPTS_VALUE ? decoded->best_effort_timestamp : decoded->pts;
+		if (pts == AV_NOPTS_VALUE) {
+			pts = startPts;
+		}
+		AVStream* stream = formatCtx->streams[streamIndex];
+		bufferStart = av_rescale_q(pts - startPts, stream->time_base, AVRational{1, sampleRate});
+		bufferStartKnown = true;
+	}
+	
+	resample(const_cast<const uint8_t**>(decoded->extended_data), decoded->nb_samples);
+}
+
+void AudioDecoder::resample(const uint8_t** input, int inputSamples) {
+	int capacity = swr_get_out_samples(swrCtx, inputSamples);
+	if (capacity <= 0) {
+		return;
+	}
+	
+	for (int ch = 0; ch < channels; ch++) {
+		if (static_cast<int>(convertBuffer[ch].size()) < capacity) {
+			convertBuffer[ch].resize(capacity);
+		}
+		convertPlanes[ch] = convertBuffer[ch].data();
+	}
+	
+	int converted = swr_convert(swrCtx, reinterpret_cast<uint8_t**>(convertPlanes.data()), capacity,
+		input, inputSamples);
+	if (converted <= 0) {
+		return;
+	}
+	
+	for (int ch = 0; ch < channels; ch++) {
+		buffer[ch].insert(buffer[ch].end(), convertBuffer[ch].begin(), convertBuffer[ch].begin() + converted);
+	}
+}
+
+void AudioDecoder::discard(int64_t samples) {
+	int64_t count = std::min<int64_t>(samples, buffer[0].size());
+	if (count <= 0) {
+		return;
+	}
+	for (auto& channel : buffer) {
+		channel.erase(channel.begin(), channel.begin() + count);
+	}
+	bufferStart += count;
+}
+
+} // namespace audio
\ No newline at end of file
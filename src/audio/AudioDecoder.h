@@ -0,0 +1,83 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SwrContext;
+
+namespace audio {
+
+/**
+ * Decodes one audio stream of a media file and resamples it to planar float
+ * at the output sample rate, keeping the source channel count.
+ *
+ * Reads are addressed in output samples from the start of the media. Reads
+ * that follow on from the previous one stream through the file; anything
+ * else seeks first.
+ */
+class AudioDecoder {
+public:
+	/**
+	 * @param trackId Audio stream to decode ("A1" = first audio stream), empty = best stream
+	 * @param sampleRate Output sample rate
+	 * @throws std::runtime_error if the file has no decodable audio stream
+	 */
+	AudioDecoder(const std::string& filename, const std::string& trackId, int sampleRate);
+	~AudioDecoder();
+	
+	AudioDecoder(const AudioDecoder&) = delete;
+	AudioDecoder& operator=(const AudioDecoder&) = delete;
+	
+	int getChannels() const { return channels; }
+	
+	/**
+	 * Pick the audio stream for a track ID ("A1" = first audio stream, empty
+	 * or not found = best stream)
+	 * @throws std::runtime_error if the file has no audio stream
+	 */
+	static int selectStream(AVFormatContext* formatCtx, const std::string& trackId);
+	
+	/**
+	 * Read samples starting at a position, padding with silence past the end
+	 * of the stream
+	 * @param out One buffer per channel, each resized to count samples
+	 */
+	void read(int64_t position, int count, std::vector<std::vector<float>>& out);
+
+private:
+	void openFile(const std::string& filename);
+	void findAudioStream(const std::string& trackId);
+	void setupDecoder();
+	void setupResampler();
+	void cleanup();
+	void seek(int64_t position);
+	bool decodeMore();
+	void appendFrame(AVFrame* frame);
+	void resample(const uint8_t** input, int inputSamples);
+	void discard(int64_t samples);
+	
+	AVFormatContext* formatCtx = nullptr;
+	AVCodecContext* codecCtx = nullptr;
+	AVPacket* packet = nullptr;
+	AVFrame* frame = nullptr;
+	SwrContext* swrCtx = nullptr;
+	int streamIndex = -1;
+	int64_t startPts = 0;
+	
+	int sampleRate;
+	int channels = 0;
+	
+	// Decoded samples not yet read, starting at bufferStart
+	std::vector<std::vector<float>> buffer;
+	int64_t bufferStart = 0;
+	bool started = false;                  // A seek set the read position
+	bool bufferStartKnown = false;
+	bool endOfStream = false;
+	bool flushed = false;
+	std::vector<float*> convertPlanes;
+	std::vector<std::vector<float>> convertBuffer;
+};
+
+} // namespace audio
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "audio/AudioKernels.h"
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define AUDIO_KERNELS_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_KERNELS_NEON 1
+#endif
+
+namespace audio {
+
+namespace kernels {
+
+void mixWithRamp(float* dst, const float* src, int count, float gainStart, float gainEnd) {
+	if (count <= 0) {
+		return;
+	}
+	
+	float step = (gainEnd - gainStart) / count;
+	int i = 0;
+	
+#if defined(AUDIO_KERNELS_SSE)
+	__m128 gain = _mm_setr_ps(gainStart, gainStart + step, gainStart + 2 * step, gainStart + 3 * step);
+	__m128 gainStep = _mm_set1_ps(4 * step);
+	for (; i + 4 <= count; i += 4) {
+		__m128 d = _mm_loadu_ps(dst + i);
+		__m128 s = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, gain)));
+		gain = _mm_add_ps(gain, gainStep);
+	}
+#elif defined(AUDIO_KERNELS_NEON)
+	float start[4] = {gainStart, gainStart + step, gainStart + 2 * step, gainStart + 3 * step};
+	float32x4_t gain = vld1q_f32(start);
+	float32x4_t gainStep = vdupq_n_f32(4 * step);
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t d = vld1q_f32(dst + i);
+		float32x4_t s = vld1q_f32(src + i);
+		vst1q_f32(dst + i, vmlaq_f32(d, s, gain));
+		gain = vaddq_f32(gain, gainStep);
+	}
+#endif
+	
+	for (; i < count; ++i) {
+		dst[i] += src[i] * (gainStart + step * i);
+	}
+}
+
+void clampSamples(float* data, int count) {
+	int i = 0;
+	
+#if defined(AUDIO_KERNELS_SSE)
+	__m128 low = _mm_set1_ps(-1.0f);
+	__m128 high = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_loadu_ps(data + i);
+		_mm_storeu_ps(data + i, _mm_min_ps(_mm_max_ps(v, low), high));
+	}
+#elif defined(AUDIO_KERNELS_NEON)
+	float32x4_t low = vdupq_n_f32(-1.0f);
+	float32x4_t high = vdupq_n_f32(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t v = vld1q_f32(data + i);
+		vst1q_f32(data + i, vminq_f32(vmaxq_f32(v, low), high));
+	}
+#endif
+	
+	for (; i < count; ++i) {
+		data[i] = std::clamp(data[i], -1.0f, 1.0f);
+	}
+}
+
+} // namespace kernels
+
+} // namespace audio
\ No newline at end of file
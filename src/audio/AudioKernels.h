@@ -0,0 +1,21 @@
+#pragma once
+
+namespace audio {
+
+/**
+ * Sample kernels for the mixer, vectorised with SSE or NEON where available
+ * (scalar fallback otherwise). All buffers are planar float.
+ */
+namespace kernels {
+
+// dst[i] += src[i] * gain, with gain ramping linearly from gainStart (first
+// sample) towards gainEnd (sample after the last), so block boundaries of
+// level/pan automation do not click
+void mixWithRamp(float* dst, const float* src, int count, float gainStart, float gainEnd);
+
+// Hard limit samples to [-1, 1]
+void clampSamples(float* data, int count);
+
+} // namespace kernels
+
+} // namespace audio
\ No newline at end of file
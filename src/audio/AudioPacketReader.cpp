@@ -0,0 +1,117 @@
+#include "audio/AudioPacketReader.h"
+#include "audio/AudioDecoder.h"
+#include "media/FFmpegCompat.h"
+#include "utils/Logger.h"
+#include <stdexcept>
+
+namespace audio {
+
+AudioStreamInfo AudioStreamInfo::fromCodecContext(const AVCodecContext* codecCtx) {
+	AudioStreamInfo result;
+	if (!codecCtx) {
+		return result;
+	}
+	
+	result.codecId = codecCtx->codec_id;
+	result.sampleRate = codecCtx->sample_rate;
+#if HAVE_CH_LAYOUT_API
+	result.channels = codecCtx->ch_layout.nb_channels;
+#else
+	result.channels = codecCtx->channels;
+#endif
+	if (codecCtx->extradata && codecCtx->extradata_size > 0) {
+		result.extradata.assign(codecCtx->extradata, codecCtx->extradata + codecCtx->extradata_size);
+	}
+	return result;
+}
+
+AudioPacketReader::AudioPacketReader(const std::string& filename, const std::string& trackId) {
+	try {
+		int ret = avformat_open_input(&formatCtx, filename.c_str(), nullptr, nullptr);
+		if (ret < 0) {
+			char errbuf[AV_ERROR_MAX_STRING_SIZE];
+			av_strerror(ret, errbuf, sizeof(errbuf));
+			throw std::runtime_error("Failed to open input file: " + std::string(errbuf));
+		}
+		
+		ret = avformat_find_stream_info(formatCtx, nullptr);
+		if (ret < 0) {
+			throw std::runtime_error("Failed to find stream info");
+		}
+		
+		streamIndex = AudioDecoder::selectStream(formatCtx, trackId);
+		AVStream* stream = formatCtx->streams[streamIndex];
+		startPts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+		
+		for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+			if (static_cast<int>(i) != streamIndex) {
+				formatCtx->streams[i]->discard = AVDISCARD_ALL;
+			}
+		}
+		
+#if HAVE_CODECPAR_API
+		const AVCodecParameters* par = stream->codecpar;
+		info.codecId = par->codec_id;
+		info.sampleRate = par->sample_rate;
+#if HAVE_CH_LAYOUT_API
+		info.channels = par->ch_layout.nb_channels;
+#else
+		info.channels = par->channels;
+#endif
+		if (par->extradata && par->extradata_size > 0) {
+			info.extradata.assign(par->extradata, par->extradata + par->extradata_size);
+		}
+		frameSize = par->frame_size;
+#endif
+	} catch (...) {
+		cleanup();
+		throw;
+	}
+}
+
+AudioPacketReader::~AudioPacketReader() {
+	cleanup();
+}
+
+void AudioPacketReader::cleanup() {
+	if (formatCtx) {
+		avformat_close_input(&formatCtx);
+	}
+}
+
+AudioStreamInfo AudioPacketReader::probe(const std::string& filename, const std::string& trackId) {
+	AudioPacketReader reader(filename, trackId);
+	return reader.getInfo();
+}
+
+void AudioPacketReader::seek(int64_t position) {
+	AVStream* stream = formatCtx->streams[streamIndex];
+	int64_t timestamp = av_rescale_q(position, AVRational{1, info.sampleRate}, stream->time_base) + startPts;
+	if (av_seek_frame(formatCtx, streamIndex, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+		utils::Logger::warn("Audio packet seek to sample {} failed", position);
+	}
+}
+
+bool AudioPacketReader::readPacket(AVPacket* packet, int64_t& start, int64_t& duration) {
+	AVStream* stream = formatCtx->streams[streamIndex];
+	AVRational sampleBase{1, info.sampleRate};
+	
+	while (av_read_frame(formatCtx, packet) >= 0) {
+		if (packet->stream_index != streamIndex || packet->pts == AV_NOPTS_VALUE) {
+			av_packet_unref(packet);
+			continue;
+		}
+		
+		start = av_rescale_q(packet->pts - startPts, stream->time_base, sampleBase);
+		duration = packet->duration > 0 ? av_rescale_q(packet->duration, stream->time_base, sampleBase) : frameSize;
+		if (duration <= 0) {
+			// Without a duration the packet cannot be placed exactly
+			av_packet_unref(packet);
+			return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+} // namespace audio
\ No newline at end of file
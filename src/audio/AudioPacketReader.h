@@ -0,0 +1,70 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+// Codec parameters that must match for packets to be copied between streams
+struct AudioStreamInfo {
+	AVCodecID codecId = AV_CODEC_ID_NONE;
+	int sampleRate = 0;
+	int channels = 0;
+	std::vector<uint8_t> extradata;        // e.g. the AAC AudioSpecificConfig
+	
+	bool isValid() const { return codecId != AV_CODEC_ID_NONE && sampleRate > 0 && channels > 0; }
+	bool matches(const AudioStreamInfo& other) const {
+		return codecId == other.codecId && sampleRate == other.sampleRate &&
+			channels == other.channels && extradata == other.extradata;
+	}
+	
+	// Parameters of an open encoder
+	static AudioStreamInfo fromCodecContext(const AVCodecContext* codecCtx);
+};
+
+/**
+ * Demuxes the compressed packets of one audio stream, for copying them into
+ * the output without decoding. Positions are in samples from the start of
+ * the media.
+ */
+class AudioPacketReader {
+public:
+	/**
+	 * @param trackId Audio stream ("A1" = first audio stream), empty = best stream
+	 * @throws std::runtime_error if the file has no audio stream
+	 */
+	AudioPacketReader(const std::string& filename, const std::string& trackId);
+	~AudioPacketReader();
+	
+	AudioPacketReader(const AudioPacketReader&) = delete;
+	AudioPacketReader& operator=(const AudioPacketReader&) = delete;
+	
+	const AudioStreamInfo& getInfo() const { return info; }
+	
+	// Open a file only to read its stream parameters
+	static AudioStreamInfo probe(const std::string& filename, const std::string& trackId);
+	
+	// Position the reader so the next packet starts at or before a sample
+	void seek(int64_t position);
+	
+	/**
+	 * Read the next packet of the stream
+	 * @param start Start of the packet in samples
+	 * @param duration Length of the packet in samples
+	 * @return false at the end of the stream
+	 */
+	bool readPacket(AVPacket* packet, int64_t& start, int64_t& duration);
+
+private:
+	void cleanup();
+	
+	AVFormatContext* formatCtx = nullptr;
+	int streamIndex = -1;
+	int64_t startPts = 0;
+	AudioStreamInfo info;
+	int frameSize = 0;                     // Fallback packet duration
+};
+
+} // namespace audio
\ No newline at end of file
@@ -0,0 +1,443 @@
+#include "audio/AudioPipeline.h"
+#include "audio/AudioKernels.h"
+#include "audio/AudioPacketReader.h"
+#include "media/FFmpegCompat.h"
+#include "utils/Logger.h"
+#include "utils/Timer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace audio {
+
+namespace {
+
+std::string decoderKey(const AudioClip& clip) {
+	return clip.uri + "|" + clip.trackId + "|" + std::to_string(clip.track);
+}
+
+// Shortest stretch worth splicing, in encoder blocks
+constexpr int64_t MIN_COPY_BLOCKS = 16;
+
+// Remove [start, end) from a list of ranges
+void subtractRange(std::vector<TimeRange>& ranges, double start, double end) {
+	std::vector<TimeRange> result;
+	for (const auto& range : ranges) {
+		if (end <= range.start || start >= range.end) {
+			result.push_back(range);
+			continue;
+		}
+		if (range.start < start) {
+			result.push_back({range.start, start});
+		}
+		if (end < range.end) {
+			result.push_back({end, range.end});
+		}
+	}
+	ranges = std::move(result);
+}
+
+}
+
+AudioPipeline::AudioPipeline(AudioTimeline timeline, std::vector<media::FFmpegEncoder*> encoders, double duration,
+	PathResolver resolvePath)
+	: AudioPipeline(std::move(timeline), std::move(encoders), duration, std::move(resolvePath), Config()) {
+}
+
+AudioPipeline::AudioPipeline(AudioTimeline timeline, std::vector<media::FFmpegEncoder*> encoders, double duration,
+	PathResolver resolvePath, const Config& config)
+	: timeline(std::move(timeline))
+	, encoders(std::move(encoders))
+	, resolvePath(std::move(resolvePath))
+	, config(config)
+	, sampleRate(this->encoders.front()->getAudioSampleRate())
+	, channels(this->encoders.front()->getAudioChannels())
+	, blockSize(this->encoders.front()->getAudioFrameSize()) {
+	totalSamples = static_cast<int64_t>(std::llround(duration * sampleRate));
+	mix.assign(channels, std::vector<float>(blockSize));
+	monoBlock.resize(blockSize);
+}
+
+AudioPipeline::~AudioPipeline() {
+	stop();
+}
+
+void AudioPipeline::start() {
+	thread = std::thread(&AudioPipeline::run, this);
+}
+
+void AudioPipeline::setVideoPosition(double seconds) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		videoPosition = seconds;
+	}
+	positionChanged.notify_one();
+}
+
+bool AudioPipeline::finish() {
+	// Let the audio run to the end
+	setVideoPosition(std::numeric_limits<double>::infinity());
+	if (thread.joinable()) {
+		thread.join();
+	}
+	decoders.clear();
+	
+	bool flushed = true;
+	for (auto* encoder : encoders) {
+		flushed = encoder->finishAudio() && flushed;
+	}
+	return flushed && !failed;
+}
+
+void AudioPipeline::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	positionChanged.notify_one();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void AudioPipeline::run() {
+	utils::Timer::getInstance().setThreadName("audio");
+	
+	try {
+		std::vector<CopyRun> runs;
+		if (config.passthrough) {
+			runs = planCopyRuns();
+		}
+		size_t nextRun = 0;
+		
+		int64_t position = 0;
+		while (position < totalSamples) {
+			// Hand over to packet copy once the next run starts in this block;
+			// if it cannot be copied it is mixed like everything else
+			if (nextRun < runs.size() && runs[nextRun].start < position + blockSize) {
+				position = copyRun(runs[nextRun++], position);
+				continue;
+			}
+			
+			if (!waitForVideo(position)) {
+				return;
+			}
+			encodeBlock(position, static_cast<int>(std::min<int64_t>(blockSize, totalSamples - position)));
+			position += blockSize;
+		}
+	} catch (const std::exception& e) {
+		utils::Logger::error("Audio rendering failed: {}", e.what());
+		failed = true;
+	}
+}
+
+bool AudioPipeline::waitForVideo(int64_t position) {
+	// Stay within maxLead of the video
+	std::unique_lock<std::mutex> lock(mutex);
+	double time = static_cast<double>(position) / sampleRate;
+	positionChanged.wait(lock, [&]() {
+		return stopping || time <= videoPosition + config.maxLead;
+	});
+	return !stopping;
+}
+
+void AudioPipeline::encodeBlock(int64_t position, int samples) {
+	mixBlock(position, samples);
+	
+	std::vector<const float*> planes(channels);
+	for (int ch = 0; ch < channels; ch++) {
+		planes[ch] = mix[ch].data();
+	}
+	for (auto* encoder : encoders) {
+		if (!encoder->writeAudioSamples(planes.data(), samples)) {
+			throw std::runtime_error("Failed to encode audio");
+		}
+	}
+}
+
+std::vector<AudioPipeline::CopyRun> AudioPipeline::planCopyRuns() const {
+	std::vector<CopyRun> runs;
+	const auto& clips = timeline.getClips();
+	double minLength = static_cast<double>(MIN_COPY_BLOCKS * blockSize) / sampleRate;
+	double end = static_cast<double>(totalSamples) / sampleRate;
+	
+	for (size_t i = 0; i < clips.size(); i++) {
+		const AudioClip& clip = clips[i];
+		if (clip.average) {
+			continue;
+		}
+		bool identity = clip.outputChannels.empty() ||
+			static_cast<int>(clip.outputChannels.size()) == channels;
+		for (size_t ch = 0; identity && ch < clip.outputChannels.size(); ch++) {
+			identity = clip.outputChannels[ch] == static_cast<int>(ch);
+		}
+		if (!identity) {
+			continue;
+		}
+		
+		// The clip alone, at unity on its track
+		std::vector<TimeRange> ranges{{clip.timelineIn, std::min(clip.timelineOut, end)}};
+		for (size_t j = 0; j < clips.size(); j++) {
+			if (j != i) {
+				subtractRange(ranges, clips[j].timelineIn, clips[j].timelineOut);
+			}
+		}
+		for (const auto& range : ranges) {
+			for (const auto& unity : timeline.unityRanges(clip.track, range.start, range.end)) {
+				if (unity.end - unity.start >= minLength) {
+					runs.push_back({i, std::llround(unity.start * sampleRate), std::llround(unity.end * sampleRate)});
+				}
+			}
+		}
+	}
+	
+	std::sort(runs.begin(), runs.end(), [](const CopyRun& a, const CopyRun& b) {
+		return a.start < b.start;
+	});
+	return runs;
+}
+
+int64_t AudioPipeline::copyRun(const CopyRun& run, int64_t position) {
+	const AudioClip& clip = timeline.getClips()[run.clip];
+	std::unique_ptr<AudioPacketReader> reader;
+	try {
+		reader = std::make_unique<AudioPacketReader>(resolvePath(clip.uri), clip.trackId);
+	} catch (const std::exception& e) {
+		utils::Logger::debug("Not copying audio from {}: {}", clip.uri, e.what());
+		return position;
+	}
+	for (auto* encoder : encoders) {
+		if (!reader->getInfo().matches(AudioStreamInfo::fromCodecContext(encoder->getAudioCodecContext()))) {
+			return position;
+		}
+	}
+	
+	// Source sample = output sample + offset
+	int64_t offset = std::llround(clip.sourceIn * sampleRate) - std::llround(clip.timelineIn * sampleRate);
+	int64_t from = std::max(run.start, position);
+	
+	AVPacket* packet = media::FFmpegCompat::allocPacket();
+	if (!packet) {
+		return position;
+	}
+	
+	// First packet starting inside the run
+	reader->seek(from + offset);
+	int64_t start = 0;
+	int64_t duration = 0;
+	bool found = false;
+	while (reader->readPacket(packet, start, duration)) {
+		if (start - offset >= from) {
+			found = true;
+			break;
+		}
+		av_packet_unref(packet);
+	}
+	int64_t copyStart = start - offset;
+	if (!found || run.end - copyStart < MIN_COPY_BLOCKS * blockSize / 2) {
+		media::FFmpegCompat::freePacket(&packet);
+		return position;
+	}
+	
+	// Encode up to the splice point and drain the encoder there
+	while (position < copyStart) {
+		if (!waitForVideo(position)) {
+			media::FFmpegCompat::freePacket(&packet);
+			return totalSamples;
+		}
+		encodeBlock(position, blockSize);
+		position += blockSize;
+	}
+	for (auto* encoder : encoders) {
+		if (!encoder->restartAudioSession(copyStart)) {
+			media::FFmpegCompat::freePacket(&packet);
+			throw std::runtime_error("Failed to restart audio encoder");
+		}
+	}
+	
+	// Copy packets while they end inside the run
+	int64_t copyEnd = copyStart;
+	int64_t copied = 0;
+	do {
+		int64_t outStart = start - offset;
+		if (outStart != copyEnd || outStart + duration > run.end) {
+			av_packet_unref(packet);
+			break;
+		}
+		if (!waitForVideo(outStart)) {
+			media::FFmpegCompat::freePacket(&packet);
+			return totalSamples;
+		}
+		
+		packet->pts = outStart;
+		packet->duration = duration;
+		// Muxing consumes the packet, so every output but the last gets a reference
+		for (size_t i = 0; i < encoders.size(); i++) {
+			AVPacket* copy = i + 1 < encoders.size() ? av_packet_clone(packet) : packet;
+			bool written = copy && encoders[i]->writeAudioPacket(copy);
+			if (copy != packet) {
+				av_packet_free(&copy);
+			}
+			if (!written) {
+				media::FFmpegCompat::freePacket(&packet);
+				throw std::runtime_error("Failed to write copied audio");
+			}
+		}
+		av_packet_unref(packet);
+		copyEnd = outStart + duration;
+		copied++;
+	} while (reader->readPacket(packet, start, duration));
+	media::FFmpegCompat::freePacket(&packet);
+	
+	utils::Logger::debug("Copied {} audio packets from {} ({} - {})", copied, clip.uri, copyStart, copyEnd);
+	
+	// A fresh encoder session picks up at copyEnd; one block of pre-roll
+	// primes it, and its packets before copyEnd are dropped
+	int64_t preRoll = std::max(copyStart, copyEnd - blockSize);
+	for (auto* encoder : encoders) {
+		encoder->setAudioPosition(preRoll, copyEnd);
+	}
+	return preRoll;
+}
+
+void AudioPipeline::mixBlock(int64_t position, int samples) {
+	for (auto& channel : mix) {
+		std::fill(channel.begin(), channel.end(), 0.0f);
+	}
+	
+	const auto& clips = timeline.getClips();
+	int64_t blockEnd = position + samples;
+	
+	// Pick up clips starting in this block
+	while (nextClip < clips.size() &&
+		std::llround(clips[nextClip].timelineIn * sampleRate) < blockEnd) {
+		activeClips.push_back(nextClip++);
+	}
+	
+	// Retire clips that ended, closing decoders no remaining clip shares
+	auto ended = [&](size_t index) {
+		return std::llround(clips[index].timelineOut * sampleRate) <= position;
+	};
+	for (size_t index : activeClips) {
+		if (!ended(index)) {
+			continue;
+		}
+		std::string key = decoderKey(clips[index]);
+		bool shared = std::any_of(activeClips.begin(), activeClips.end(), [&](size_t other) {
+			return !ended(other) && decoderKey(clips[other]) == key;
+		}) || (nextClip < clips.size() && decoderKey(clips[nextClip]) == key);
+		if (!shared) {
+			decoders.erase(key);
+		}
+	}
+	activeClips.erase(std::remove_if(activeClips.begin(), activeClips.end(), ended), activeClips.end());
+	
+	for (size_t index : activeClips) {
+		mixClip(clips[index], position, samples);
+	}
+	
+	for (auto& channel : mix) {
+		kernels::clampSamples(channel.data(), samples);
+	}
+}
+
+void AudioPipeline::mixClip(const AudioClip& clip, int64_t position, int samples) {
+	int64_t clipStart = std::llround(clip.timelineIn * sampleRate);
+	int64_t clipEnd = std::llround(clip.timelineOut * sampleRate);
+	int64_t begin = std::max(position, clipStart);
+	int64_t end = std::min(position + samples, clipEnd);
+	if (end <= begin) {
+		return;
+	}
+	
+	AudioDecoder* decoder = decoderFor(clip);
+	if (!decoder) {
+		return;
+	}
+	
+	int count = static_cast<int>(end - begin);
+	int offset = static_cast<int>(begin - position);
+	int64_t sourcePosition = std::llround(clip.sourceIn * sampleRate) + (begin - clipStart);
+	decoder->read(sourcePosition, count, sourceBlock);
+	
+	// Track level and pan at both ends of the block, ramped in between
+	double startTime = static_cast<double>(begin) / sampleRate;
+	double endTime = static_cast<double>(end) / sampleRate;
+	float gainStart = timeline.gainAt(clip.track, startTime);
+	float gainEnd = timeline.gainAt(clip.track, endTime);
+	float panStart = timeline.panAt(clip.track, startTime);
+	float panEnd = timeline.panAt(clip.track, endTime);
+	
+	// Balance law: the far side is attenuated, the near side stays at unity
+	auto channelGain = [&](int channel, float gain, float pan) {
+		if (channels != 2) {
+			return gain;
+		}
+		return gain * (channel == 0 ? std::min(1.0f, 1.0f - pan) : std::min(1.0f, 1.0f + pan));
+	};
+	
+	// Output channels the clip is routed to
+	std::vector<int> targets;
+	for (int channel : clip.outputChannels) {
+		if (channel >= 0 && channel < channels) {
+			targets.push_back(channel);
+		}
+	}
+	if (targets.empty()) {
+		for (int channel = 0; channel < channels; channel++) {
+			targets.push_back(channel);
+		}
+	}
+	
+	int sourceChannels = decoder->getChannels();
+	if (clip.average || sourceChannels == 1) {
+		// One signal (the source channel average for audiomix "avg") to every target
+		const float* mono = sourceBlock[0].data();
+		if (sourceChannels > 1) {
+			std::fill(monoBlock.begin(), monoBlock.begin() + count, 0.0f);
+			float scale = 1.0f / sourceChannels;
+			for (int ch = 0; ch < sourceChannels; ch++) {
+				kernels::mixWithRamp(monoBlock.data(), sourceBlock[ch].data(), count, scale, scale);
+			}
+			mono = monoBlock.data();
+		}
+		for (int target : targets) {
+			kernels::mixWithRamp(mix[target].data() + offset, mono, count,
+				channelGain(target, gainStart, panStart), channelGain(target, gainEnd, panEnd));
+		}
+		return;
+	}
+	
+	// Source channels in order onto the targets, folding extra channels down
+	int targetCount = static_cast<int>(targets.size());
+	float fold = sourceChannels > targetCount ? static_cast<float>(targetCount) / sourceChannels : 1.0f;
+	for (int ch = 0; ch < sourceChannels; ch++) {
+		int target = targets[ch % targetCount];
+		kernels::mixWithRamp(mix[target].data() + offset, sourceBlock[ch].data(), count,
+			fold * channelGain(target, gainStart, panStart), fold * channelGain(target, gainEnd, panEnd));
+	}
+}
+
+AudioDecoder* AudioPipeline::decoderFor(const AudioClip& clip) {
+	std::string key = decoderKey(clip);
+	auto it = decoders.find(key);
+	if (it != decoders.end()) {
+		return it->second.get();
+	}
+	if (failedSources.count(key)) {
+		return nullptr;
+	}
+	
+	try {
+		auto decoder = std::make_unique<AudioDecoder>(resolvePath(clip.uri), clip.trackId, sampleRate);
+		return decoders.emplace(key, std::move(decoder)).first->second.get();
+	} catch (const std::exception& e) {
+		// A source without usable audio plays as silence
+		utils::Logger::warn("No audio from {}: {}", clip.uri, e.what());
+		failedSources.insert(key);
+		return nullptr;
+	}
+}
+
+} // namespace audio
\ No newline at end of file
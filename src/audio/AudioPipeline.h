@@ -0,0 +1,124 @@
+#pragma once
+
+#include "audio/AudioDecoder.h"
+#include "audio/AudioTimeline.h"
+#include "media/FFmpegEncoder.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace audio {
+
+/**
+ * Renders the audio of an EDL into the audio streams of one or more encoders
+ * on its own thread. Every encoder gets the same mix.
+ *
+ * Blocks of one encoder frame are mixed at a time: each clip under the block
+ * is decoded (and resampled) by a decoder of its own, routed to the output
+ * channels and added with the level and pan of its track, ramped across the
+ * block. Audio runs at most maxLead seconds ahead of the position reported
+ * by the video loop, so it never competes with video for more than a short
+ * burst and the muxer does not have to buffer much.
+ *
+ * Stretches where a single clip plays untouched (unity level, centre pan,
+ * default routing, nothing mixed over it) from a source whose stream matches
+ * the encoder's parameters are copied as compressed packets instead. Only the
+ * edges are re-encoded: the encoder is drained at the first copied packet,
+ * its last packet trimmed there, and restarted after the last copied packet
+ * with one block of pre-roll so its first kept packet splices cleanly.
+ */
+class AudioPipeline {
+public:
+	struct Config {
+		double maxLead = 1.0;           // Seconds audio may run ahead of video
+		bool passthrough = true;        // Copy untouched stretches without re-encoding
+	};
+	
+	// Maps a media URI to the file to open
+	using PathResolver = std::function<std::string(const std::string& uri)>;
+	
+	/**
+	 * @param encoders Encoders with identically configured audio streams;
+	 *                 sample rate, channel count and block size are taken
+	 *                 from the first
+	 * @param duration Length of the audio to render in seconds (the video length)
+	 */
+	AudioPipeline(AudioTimeline timeline, std::vector<media::FFmpegEncoder*> encoders, double duration,
+		PathResolver resolvePath);
+	AudioPipeline(AudioTimeline timeline, std::vector<media::FFmpegEncoder*> encoders, double duration,
+		PathResolver resolvePath, const Config& config);
+	~AudioPipeline();
+	
+	AudioPipeline(const AudioPipeline&) = delete;
+	AudioPipeline& operator=(const AudioPipeline&) = delete;
+	
+	// Start the audio thread
+	void start();
+	
+	// Report the timeline position (seconds) the video has been rendered to
+	void setVideoPosition(double seconds);
+	
+	/**
+	 * Render the remaining audio, wait for the thread and flush the encoders
+	 * @return false if the audio thread failed
+	 */
+	bool finish();
+
+private:
+	// Stretch of the output (in samples) that one clip's packets can fill
+	struct CopyRun {
+		size_t clip = 0;
+		int64_t start = 0;
+		int64_t end = 0;
+	};
+	
+	void run();
+	bool waitForVideo(int64_t position);
+	void encodeBlock(int64_t position, int samples);
+	std::vector<CopyRun> planCopyRuns() const;
+	int64_t copyRun(const CopyRun& run, int64_t position);
+	void mixBlock(int64_t position, int samples);
+	void mixClip(const AudioClip& clip, int64_t position, int samples);
+	AudioDecoder* decoderFor(const AudioClip& clip);
+	void stop();
+	
+	AudioTimeline timeline;
+	std::vector<media::FFmpegEncoder*> encoders;
+	PathResolver resolvePath;
+	Config config;
+	
+	int sampleRate;
+	int channels;
+	int blockSize;
+	int64_t totalSamples;
+	
+	// Clips overlapping the current block; clips are sorted by start
+	size_t nextClip = 0;
+	std::vector<size_t> activeClips;
+	
+	// One decoder per (source, stream, track), so clips reading the same
+	// file on different tracks stream independently
+	std::unordered_map<std::string, std::unique_ptr<AudioDecoder>> decoders;
+	std::unordered_set<std::string> failedSources;
+	
+	std::vector<std::vector<float>> mix;            // Output block, one buffer per channel
+	std::vector<std::vector<float>> sourceBlock;    // Decoded clip samples
+	std::vector<float> monoBlock;
+	
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable positionChanged;
+	double videoPosition = 0.0;
+	bool stopping = false;
+	std::atomic<bool> failed{false};
+};
+
+} // namespace audio
\ No newline at end of file
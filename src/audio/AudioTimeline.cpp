@@ -0,0 +1,231 @@
+#include "audio/AudioTimeline.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+
+namespace {
+
+const edl::Source* clipSource(const edl::Clip& clip) {
+	if (clip.source.has_value()) {
+		return &clip.source.value();
+	}
+	return clip.sources.empty() ? nullptr : &clip.sources[0];
+}
+
+}
+
+void Envelope::addSegment(double in, double out, std::vector<Point> points) {
+	if (points.empty() || out <= in) {
+		return;
+	}
+	
+	std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+		return a.time < b.time;
+	});
+	
+	Segment segment{in, out, std::move(points)};
+	auto it = std::upper_bound(segments.begin(), segments.end(), segment.in,
+		[](double time, const Segment& s) { return time < s.in; });
+	segments.insert(it, std::move(segment));
+}
+
+float Envelope::valueAt(double time) const {
+	// Last segment starting at or before the time
+	auto it = std::upper_bound(segments.begin(), segments.end(), time,
+		[](double t, const Segment& s) { return t < s.in; });
+	if (it == segments.begin()) {
+		return defaultValue;
+	}
+	--it;
+	if (time >= it->out) {
+		return defaultValue;
+	}
+	
+	const auto& points = it->points;
+	if (time <= points.front().time) {
+		return points.front().value;
+	}
+	if (time >= points.back().time) {
+		return points.back().value;
+	}
+	
+	auto next = std::upper_bound(points.begin(), points.end(), time,
+		[](double t, const Point& p) { return t < p.time; });
+	auto prev = next - 1;
+	double span = next->time - prev->time;
+	if (span <= 0.0) {
+		return next->value;
+	}
+	float t = static_cast<float>((time - prev->time) / span);
+	return prev->value + (next->value - prev->value) * t;
+}
+
+std::vector<TimeRange> Envelope::rangesAt(double from, double to, float value) const {
+	if (to <= from) {
+		return {};
+	}
+	if (defaultValue != value) {
+		// Only the inside of segments could match; not needed so far
+		return {};
+	}
+	
+	// Collect where each overlapping segment departs from the value
+	std::vector<TimeRange> departures;
+	for (const auto& segment : segments) {
+		if (segment.out <= from || segment.in >= to) {
+			continue;
+		}
+		const auto& points = segment.points;
+		if (points.front().value != value) {
+			departures.push_back({segment.in, points.front().time});
+		}
+		for (size_t i = 0; i + 1 < points.size(); ++i) {
+			if (points[i].value != value || points[i + 1].value != value) {
+				departures.push_back({points[i].time, points[i + 1].time});
+			}
+		}
+		if (points.back().value != value) {
+			departures.push_back({points.back().time, segment.out});
+		}
+	}
+	
+	std::sort(departures.begin(), departures.end(), [](const TimeRange& a, const TimeRange& b) {
+		return a.start < b.start;
+	});
+	
+	// The rest of [from, to) holds the value
+	std::vector<TimeRange> result;
+	double cursor = from;
+	for (const auto& departure : departures) {
+		double start = std::max(departure.start, from);
+		if (start > cursor) {
+			result.push_back({cursor, std::min(start, to)});
+		}
+		cursor = std::max(cursor, departure.end);
+		if (cursor >= to) {
+			break;
+		}
+	}
+	if (cursor < to) {
+		result.push_back({cursor, to});
+	}
+	return result;
+}
+
+AudioTimeline::AudioTimeline(const edl::EDL& edl) {
+	for (const auto& clip : edl.clips) {
+		if (clip.track.type != edl::Track::Audio || clip.isNullClip) {
+			continue;
+		}
+		
+		if (clip.track.subtype == "level" || clip.track.subtype == "pan") {
+			addAutomation(clip);
+			continue;
+		}
+		if (!clip.track.subtype.empty()) {
+			continue;
+		}
+		
+		const edl::Source* source = clipSource(clip);
+		if (!source || !std::holds_alternative<edl::MediaSource>(*source)) {
+			continue;
+		}
+		const auto& media = std::get<edl::MediaSource>(*source);
+		
+		if (media.speed != 1.0f) {
+			utils::Logger::warn("Audio speed {} not supported, playing {} at normal speed",
+				media.speed, media.uri);
+		}
+		
+		AudioClip audioClip;
+		audioClip.track = clip.track.number;
+		audioClip.uri = media.uri;
+		audioClip.trackId = media.trackId;
+		audioClip.timelineIn = clip.in;
+		audioClip.timelineOut = clip.out;
+		audioClip.sourceIn = media.in;
+		audioClip.average = media.audiomix == "avg";
+		for (const auto& [channel, level] : clip.channelMap) {
+			audioClip.outputChannels.push_back(channel - 1);
+		}
+		
+		duration = std::max(duration, clip.out);
+		clips.push_back(std::move(audioClip));
+	}
+	
+	std::sort(clips.begin(), clips.end(), [](const AudioClip& a, const AudioClip& b) {
+		return a.timelineIn < b.timelineIn;
+	});
+	
+	if (!clips.empty()) {
+		utils::Logger::info("Audio timeline: {} clips, {} seconds", clips.size(), duration);
+	}
+}
+
+void AudioTimeline::addAutomation(const edl::Clip& clip) {
+	const edl::Source* source = clipSource(clip);
+	if (!source || !std::holds_alternative<edl::TransformSource>(*source)) {
+		return;
+	}
+	const auto& transform = std::get<edl::TransformSource>(*source);
+	bool isLevel = clip.track.subtype == "level";
+	
+	// Control points are in source time; map them onto the timeline
+	std::vector<Envelope::Point> points;
+	for (const auto& cp : transform.controlPoints) {
+		Envelope::Point point;
+		point.time = clip.in + (cp.point - transform.in);
+		point.value = isLevel ? dbToGain(cp.db) : std::clamp(cp.pan, -1.0f, 1.0f);
+		points.push_back(point);
+	}
+	
+	int track = clip.track.number;
+	if (isLevel) {
+		levels.try_emplace(track, 1.0f).first->second.addSegment(clip.in, clip.out, std::move(points));
+	} else {
+		pans.try_emplace(track, 0.0f).first->second.addSegment(clip.in, clip.out, std::move(points));
+	}
+}
+
+float AudioTimeline::gainAt(int track, double time) const {
+	auto it = levels.find(track);
+	return it != levels.end() ? it->second.valueAt(time) : 1.0f;
+}
+
+float AudioTimeline::panAt(int track, double time) const {
+	auto it = pans.find(track);
+	return it != pans.end() ? it->second.valueAt(time) : 0.0f;
+}
+
+std::vector<TimeRange> AudioTimeline::unityRanges(int track, double from, double to) const {
+	std::vector<TimeRange> unity{{from, to}};
+	auto level = levels.find(track);
+	if (level != levels.end()) {
+		unity = level->second.rangesAt(from, to, 1.0f);
+	}
+	
+	auto pan = pans.find(track);
+	if (pan == pans.end()) {
+		return unity;
+	}
+	
+	// Intersect with the centre-pan ranges
+	std::vector<TimeRange> result;
+	for (const auto& range : unity) {
+		for (const auto& centred : pan->second.rangesAt(range.start, range.end, 0.0f)) {
+			result.push_back(centred);
+		}
+	}
+	return result;
+}
+
+float AudioTimeline::dbToGain(float db) {
+	if (std::isinf(db) && db < 0.0f) {
+		return 0.0f;
+	}
+	return std::pow(10.0f, db / 20.0f);
+}
+
+} // namespace audio
\ No newline at end of file
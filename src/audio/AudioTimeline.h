@@ -0,0 +1,100 @@
+#pragma once
+
+#include "edl/EDLTypes.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+// Time range in seconds
+struct TimeRange {
+	double start = 0.0;
+	double end = 0.0;
+};
+
+// Audio clip resolved from the EDL, in seconds
+struct AudioClip {
+	int track = 1;
+	std::string uri;
+	std::string trackId;                // Source audio stream ("A1", "A2", ...), empty = best
+	double timelineIn = 0.0;
+	double timelineOut = 0.0;
+	double sourceIn = 0.0;
+	
+	// Output channels (0-based) from the clip's channel map; empty = default routing
+	std::vector<int> outputChannels;
+	bool average = false;               // audiomix "avg": mix all source channels down to one
+};
+
+/**
+ * Piecewise linear automation curve (level or pan) of one audio track.
+ * Outside the level/pan clips of the track the default value applies; inside
+ * a clip the value is held before the first and after the last control point.
+ */
+class Envelope {
+public:
+	struct Point {
+		double time = 0.0;              // Timeline position in seconds
+		float value = 0.0f;
+	};
+	
+	explicit Envelope(float defaultValue = 0.0f) : defaultValue(defaultValue) {}
+	
+	// Add the control points of one level/pan clip covering [in, out)
+	void addSegment(double in, double out, std::vector<Point> points);
+	
+	float valueAt(double time) const;
+	bool isConstant() const { return segments.empty(); }
+	
+	// Parts of [from, to) over which the curve stays at exactly this value
+	std::vector<TimeRange> rangesAt(double from, double to, float value) const;
+
+private:
+	struct Segment {
+		double in = 0.0;
+		double out = 0.0;
+		std::vector<Point> points;
+	};
+	
+	float defaultValue;
+	std::vector<Segment> segments;     // Sorted by start
+};
+
+/**
+ * Audio view of an EDL: the media clips of all audio tracks plus the level
+ * and pan automation of each track.
+ */
+class AudioTimeline {
+public:
+	explicit AudioTimeline(const edl::EDL& edl);
+	
+	const std::vector<AudioClip>& getClips() const { return clips; }
+	bool empty() const { return clips.empty(); }
+	
+	// End of the last audio clip in seconds
+	double getDuration() const { return duration; }
+	
+	// Linear gain of a track at a timeline position (1 = unity)
+	float gainAt(int track, double time) const;
+	
+	// Pan of a track at a timeline position (-1 = left, 1 = right)
+	float panAt(int track, double time) const;
+	
+	// Parts of [from, to) where a track plays at unity gain and centre pan,
+	// i.e. where its audio reaches the output unchanged
+	std::vector<TimeRange> unityRanges(int track, double from, double to) const;
+	
+	// Convert a level in decibels to linear gain (-infinity = 0)
+	static float dbToGain(float db);
+
+private:
+	void addAutomation(const edl::Clip& clip);
+	
+	std::vector<AudioClip> clips;
+	std::map<int, Envelope> levels;    // Linear gain by track number
+	std::map<int, Envelope> pans;
+	double duration = 0.0;
+};
+
+} // namespace audio
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace cache {
+
+/**
+ * Incremental 64-bit FNV-1a hash used to key cached artifacts.
+ * Not cryptographic; only meant to detect changed inputs.
+ */
+class ContentHash {
+public:
+	void update(const void* data, size_t size) {
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			state ^= p[i];
+			state *= 1099511628211ULL;
+		}
+	}
+	
+	template<typename T>
+	void add(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "hash raw bytes of trivially copyable values only");
+		update(&value, sizeof(value));
+	}
+	
+	void add(const std::string& value) {
+		// Length prefix keeps ("ab", "c") and ("a", "bc") apart
+		add(static_cast<uint64_t>(value.size()));
+		update(value.data(), value.size());
+	}
+	
+	uint64_t value() const { return state; }
+	
+private:
+	uint64_t state = 14695981039346656037ULL;
+};
+
+} // namespace cache
\ No newline at end of file
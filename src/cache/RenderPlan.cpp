@@ -0,0 +1,448 @@
+#include "cache/RenderPlan.h"
+#include "cache/ContentHash.h"
+#include "utils/Logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace cache {
+
+namespace {
+
+constexpr char PLAN_MAGIC[8] = {'E', '2', 'F', 'P', 'L', 'A', 'N', '\0'};
+constexpr uint32_t PLAN_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Temporary file next to path that no other writer (thread or process) uses
+std::string uniqueTempPath(const std::string& path) {
+	static std::atomic<uint64_t> counter{0};
+#ifndef _WIN32
+	long pid = static_cast<long>(::getpid());
+#else
+	long pid = static_cast<long>(::_getpid());
+#endif
+	return path + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
+struct Section {
+	uint64_t offset;
+	uint64_t count;
+};
+
+struct PlanHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t spanSize;      // sizeof() of each record type, to catch layout changes
+	uint32_t effectSize;
+	uint32_t sourceSize;
+	uint32_t timelineSources;   // Leading source records that spans index into
+	uint64_t edlHash;
+	int32_t fps;
+	int32_t width;
+	int32_t height;
+	int32_t totalFrames;
+	Section spans;
+	Section effects;
+	Section sources;
+	Section keyframes;
+	Section strings;        // count is the blob size in bytes
+	uint64_t fileSize;
+};
+
+struct SourceRecord {
+	uint64_t uriOffset;
+	uint64_t uriLength;
+	uint64_t pathOffset;
+	uint64_t pathLength;
+	int64_t mtime;
+	int64_t size;
+	int32_t width;
+	int32_t height;
+	int32_t pixelFormat;
+	int32_t codecId;
+	int32_t frameRateNum;
+	int32_t frameRateDen;
+	int32_t timeBaseNum;
+	int32_t timeBaseDen;
+	int64_t totalFrames;
+	uint64_t keyframeOffset;    // Index into the keyframe section
+	uint64_t keyframeCount;
+};
+
+static_assert(std::is_trivially_copyable_v<PlanHeader>);
+static_assert(std::is_trivially_copyable_v<SourceRecord>);
+static_assert(sizeof(PlanHeader) % 8 == 0);
+static_assert(sizeof(SourceRecord) % 8 == 0);
+static_assert(sizeof(compositor::TimelineSpan) % 8 == 0);
+
+uint64_t alignUp(uint64_t value) {
+	return (value + 7) & ~uint64_t(7);
+}
+
+const PlanHeader& header(const uint8_t* data) {
+	return *reinterpret_cast<const PlanHeader*>(data);
+}
+
+template<typename T>
+const T* sectionData(const uint8_t* data, const Section& section) {
+	return reinterpret_cast<const T*>(data + section.offset);
+}
+
+} // namespace
+
+RenderPlan::~RenderPlan() {
+#ifndef _WIN32
+	if (mapped && data) {
+		munmap(const_cast<uint8_t*>(data), dataSize);
+	}
+#endif
+}
+
+std::string RenderPlan::planPathFor(const std::string& edlPath) {
+	return edlPath + ".plan";
+}
+
+uint64_t RenderPlan::hashBytes(const void* bytes, size_t size) {
+	ContentHash hash;
+	hash.update(bytes, size);
+	return hash.value();
+}
+
+uint64_t RenderPlan::hashFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Cannot open file for hashing: " + path);
+	}
+	std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return hashBytes(contents.data(), contents.size());
+}
+
+bool RenderPlan::statFile(const std::string& path, int64_t& mtime, int64_t& size) {
+	std::error_code ec;
+	auto fileSize = std::filesystem::file_size(path, ec);
+	if (ec) {
+		return false;
+	}
+	auto writeTime = std::filesystem::last_write_time(path, ec);
+	if (ec) {
+		return false;
+	}
+	size = static_cast<int64_t>(fileSize);
+	mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(writeTime.time_since_epoch()).count();
+	return true;
+}
+
+std::unique_ptr<RenderPlan> RenderPlan::load(const std::string& planPath) {
+	std::unique_ptr<RenderPlan> plan(new RenderPlan());
+
+#ifndef _WIN32
+	int fd = open(planPath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(PlanHeader))) {
+		close(fd);
+		return nullptr;
+	}
+	void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		return nullptr;
+	}
+	plan->data = static_cast<const uint8_t*>(addr);
+	plan->dataSize = static_cast<size_t>(st.st_size);
+	plan->mapped = true;
+#else
+	std::ifstream file(planPath, std::ios::binary);
+	if (!file) {
+		return nullptr;
+	}
+	plan->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	if (plan->buffer.size() < sizeof(PlanHeader)) {
+		return nullptr;
+	}
+	plan->data = plan->buffer.data();
+	plan->dataSize = plan->buffer.size();
+#endif
+
+	if (!plan->validate()) {
+		utils::Logger::warn("Ignoring invalid render plan: {}", planPath);
+		return nullptr;
+	}
+	
+	return plan;
+}
+
+bool RenderPlan::validate() const {
+	const PlanHeader& h = header(data);
+	if (std::memcmp(h.magic, PLAN_MAGIC, sizeof(PLAN_MAGIC)) != 0 ||
+		h.version != PLAN_VERSION ||
+		h.byteOrder != BYTE_ORDER_MARK ||
+		h.spanSize != sizeof(compositor::TimelineSpan) ||
+		h.effectSize != sizeof(compositor::EffectEntry) ||
+		h.sourceSize != sizeof(SourceRecord) ||
+		h.fileSize != dataSize) {
+		return false;
+	}
+	
+	auto fits = [this](const Section& section, size_t elementSize) {
+		return section.offset % 8 == 0 &&
+			section.offset <= dataSize &&
+			section.count <= (dataSize - section.offset) / elementSize;
+	};
+	
+	if (!fits(h.spans, sizeof(compositor::TimelineSpan)) ||
+		!fits(h.effects, sizeof(compositor::EffectEntry)) ||
+		!fits(h.sources, sizeof(SourceRecord)) ||
+		!fits(h.keyframes, sizeof(int64_t)) ||
+		!fits(h.strings, 1) ||
+		h.timelineSources > h.sources.count) {
+		return false;
+	}
+	
+	// Every reference into another section must stay in bounds
+	const auto* spans = sectionData<compositor::TimelineSpan>(data, h.spans);
+	for (uint64_t i = 0; i < h.spans.count; ++i) {
+		const auto& span = spans[i];
+		if (span.effectOffset < 0 || span.effectCount < 0 ||
+			static_cast<uint64_t>(span.effectOffset) + span.effectCount > h.effects.count ||
+			span.sourceIndex >= static_cast<int64_t>(h.timelineSources) ||
+			(span.kind == compositor::TimelineSpan::Media && span.sourceIndex < 0)) {
+			return false;
+		}
+	}
+	
+	const auto* sources = sectionData<SourceRecord>(data, h.sources);
+	for (uint64_t i = 0; i < h.sources.count; ++i) {
+		const auto& record = sources[i];
+		if (record.uriOffset > h.strings.count || record.uriLength > h.strings.count - record.uriOffset ||
+			record.pathOffset > h.strings.count || record.pathLength > h.strings.count - record.pathOffset ||
+			record.keyframeOffset > h.keyframes.count ||
+			record.keyframeCount > h.keyframes.count - record.keyframeOffset) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+void RenderPlan::write(const std::string& planPath, uint64_t edlHash,
+	const compositor::CompiledTimeline& timeline, const std::vector<Source>& sources) {
+	
+	// Source records start with the timeline's sources, in timeline order
+	if (sources.size() < timeline.sources.size()) {
+		throw std::runtime_error("Render plan is missing source records");
+	}
+	for (size_t i = 0; i < timeline.sources.size(); ++i) {
+		if (sources[i].uri != timeline.sources[i]) {
+			throw std::runtime_error("Render plan source records do not match the timeline");
+		}
+	}
+	
+	std::string strings;
+	std::vector<int64_t> keyframes;
+	std::vector<SourceRecord> records;
+	records.reserve(sources.size());
+	
+	for (const auto& source : sources) {
+		SourceRecord record{};
+		record.uriOffset = strings.size();
+		record.uriLength = source.uri.size();
+		strings += source.uri;
+		record.pathOffset = strings.size();
+		record.pathLength = source.path.size();
+		strings += source.path;
+		record.mtime = source.mtime;
+		record.size = source.size;
+		record.width = source.probe.width;
+		record.height = source.probe.height;
+		record.pixelFormat = source.probe.pixelFormat;
+		record.codecId = source.probe.codecId;
+		record.frameRateNum = source.probe.frameRateNum;
+		record.frameRateDen = source.probe.frameRateDen;
+		record.timeBaseNum = source.probe.timeBaseNum;
+		record.timeBaseDen = source.probe.timeBaseDen;
+		record.totalFrames = source.probe.totalFrames;
+		record.keyframeOffset = keyframes.size();
+		record.keyframeCount = source.probe.keyframes.size();
+		keyframes.insert(keyframes.end(), source.probe.keyframes.begin(), source.probe.keyframes.end());
+		records.push_back(record);
+	}
+	
+	PlanHeader h{};
+	std::memcpy(h.magic, PLAN_MAGIC, sizeof(PLAN_MAGIC));
+	h.version = PLAN_VERSION;
+	h.byteOrder = BYTE_ORDER_MARK;
+	h.spanSize = sizeof(compositor::TimelineSpan);
+	h.effectSize = sizeof(compositor::EffectEntry);
+	h.sourceSize = sizeof(SourceRecord);
+	h.timelineSources = static_cast<uint32_t>(timeline.sources.size());
+	h.edlHash = edlHash;
+	h.fps = timeline.fps;
+	h.width = timeline.width;
+	h.height = timeline.height;
+	h.totalFrames = timeline.totalFrames;
+	
+	uint64_t offset = sizeof(PlanHeader);
+	auto place = [&offset](Section& section, uint64_t count, size_t elementSize) {
+		section.offset = offset;
+		section.count = count;
+		offset = alignUp(offset + count * elementSize);
+	};
+	place(h.spans, timeline.spans.size(), sizeof(compositor::TimelineSpan));
+	place(h.effects, timeline.effects.size(), sizeof(compositor::EffectEntry));
+	place(h.sources, records.size(), sizeof(SourceRecord));
+	place(h.keyframes, keyframes.size(), sizeof(int64_t));
+	place(h.strings, strings.size(), 1);
+	h.fileSize = offset;
+	
+	std::vector<uint8_t> out(h.fileSize, 0);
+	auto copy = [&out](const Section& section, const void* src, size_t bytes) {
+		if (bytes > 0) {
+			std::memcpy(out.data() + section.offset, src, bytes);
+		}
+	};
+	std::memcpy(out.data(), &h, sizeof(h));
+	copy(h.spans, timeline.spans.data(), timeline.spans.size() * sizeof(compositor::TimelineSpan));
+	copy(h.effects, timeline.effects.data(), timeline.effects.size() * sizeof(compositor::EffectEntry));
+	copy(h.sources, records.data(), records.size() * sizeof(SourceRecord));
+	copy(h.keyframes, keyframes.data(), keyframes.size() * sizeof(int64_t));
+	copy(h.strings, strings.data(), strings.size());
+	
+	// Write to a temporary file first so a concurrent reader never maps a
+	// partial plan; concurrent writers of the same plan each get their own
+	std::string tempPath = uniqueTempPath(planPath);
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			throw std::runtime_error("Cannot create render plan: " + tempPath);
+		}
+		file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+		if (!file) {
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove(tempPath, ec);
+			throw std::runtime_error("Failed to write render plan: " + tempPath);
+		}
+	}
+	
+	std::error_code ec;
+	std::filesystem::rename(tempPath, planPath, ec);
+	if (ec) {
+		std::filesystem::remove(tempPath, ec);
+		throw std::runtime_error("Failed to install render plan: " + planPath);
+	}
+}
+
+uint64_t RenderPlan::getEDLHash() const {
+	return header(data).edlHash;
+}
+
+compositor::CompiledTimeline RenderPlan::getTimeline() const {
+	const PlanHeader& h = header(data);
+	
+	compositor::CompiledTimeline timeline;
+	timeline.fps = h.fps;
+	timeline.width = h.width;
+	timeline.height = h.height;
+	timeline.totalFrames = h.totalFrames;
+	
+	const auto* spans = sectionData<compositor::TimelineSpan>(data, h.spans);
+	timeline.spans.assign(spans, spans + h.spans.count);
+	const auto* effects = sectionData<compositor::EffectEntry>(data, h.effects);
+	timeline.effects.assign(effects, effects + h.effects.count);
+	
+	const auto* records = sectionData<SourceRecord>(data, h.sources);
+	timeline.sources.reserve(h.timelineSources);
+	for (uint64_t i = 0; i < h.timelineSources; ++i) {
+		timeline.sources.push_back(readString(records[i].uriOffset, records[i].uriLength));
+	}
+	
+	return timeline;
+}
+
+std::vector<RenderPlan::Source> RenderPlan::getSources() const {
+	const PlanHeader& h = header(data);
+	std::vector<Source> sources;
+	sources.reserve(h.sources.count);
+	for (uint64_t i = 0; i < h.sources.count; ++i) {
+		sources.push_back(readSource(i));
+	}
+	return sources;
+}
+
+std::shared_ptr<const media::SourceProbe> RenderPlan::findProbe(const std::string& path) const {
+	const PlanHeader& h = header(data);
+	const auto* records = sectionData<SourceRecord>(data, h.sources);
+	
+	for (uint64_t i = 0; i < h.sources.count; ++i) {
+		const auto& record = records[i];
+		if (record.pathLength != path.size() ||
+			std::memcmp(data + h.strings.offset + record.pathOffset, path.data(), path.size()) != 0) {
+			continue;
+		}
+		
+		int64_t mtime = 0;
+		int64_t size = 0;
+		if (!statFile(path, mtime, size) || mtime != record.mtime || size != record.size) {
+			utils::Logger::debug("Cached probe for {} is stale", path);
+			return nullptr;
+		}
+		
+		// Sources that were never opened are stored without a probe
+		media::SourceProbe probe = readSource(i).probe;
+		if (!probe.isValid()) {
+			return nullptr;
+		}
+		return std::make_shared<const media::SourceProbe>(std::move(probe));
+	}
+	
+	return nullptr;
+}
+
+RenderPlan::Source RenderPlan::readSource(size_t index) const {
+	const PlanHeader& h = header(data);
+	const SourceRecord& record = sectionData<SourceRecord>(data, h.sources)[index];
+	
+	Source source;
+	source.uri = readString(record.uriOffset, record.uriLength);
+	source.path = readString(record.pathOffset, record.pathLength);
+	source.mtime = record.mtime;
+	source.size = record.size;
+	source.probe.width = record.width;
+	source.probe.height = record.height;
+	source.probe.pixelFormat = record.pixelFormat;
+	source.probe.codecId = record.codecId;
+	source.probe.frameRateNum = record.frameRateNum;
+	source.probe.frameRateDen = record.frameRateDen;
+	source.probe.timeBaseNum = record.timeBaseNum;
+	source.probe.timeBaseDen = record.timeBaseDen;
+	source.probe.totalFrames = record.totalFrames;
+	
+	const int64_t* keyframes = sectionData<int64_t>(data, h.keyframes) + record.keyframeOffset;
+	source.probe.keyframes.assign(keyframes, keyframes + record.keyframeCount);
+	
+	return source;
+}
+
+std::string RenderPlan::readString(uint64_t offset, uint64_t length) const {
+	const PlanHeader& h = header(data);
+	return std::string(reinterpret_cast<const char*>(data + h.strings.offset + offset), length);
+}
+
+} // namespace cache
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "compositor/TimelineSpan.h"
+#include "media/SourceProbe.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cache {
+
+/**
+ * Compiled render plan: the resolved timeline (spans and effect table) plus
+ * the probe results of every source it references, stored next to the EDL
+ * as "<edl>.plan" and memory-mapped on later runs.
+ *
+ * The timeline is valid only for the EDL it was compiled from (keyed by a
+ * hash of the EDL bytes). Source probes are keyed by path, mtime and size, so
+ * they survive edits to the EDL as long as the media files are unchanged.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ *   Header | TimelineSpan[] | EffectEntry[] | SourceRecord[] | int64 keyframes[] | string blob
+ */
+class RenderPlan {
+public:
+	// A media source and the probe taken when the plan was written
+	struct Source {
+		std::string uri;    // URI as referenced by the timeline
+		std::string path;   // Resolved file path the probe was taken from
+		int64_t mtime = 0;  // Modification time when probed (ns since epoch)
+		int64_t size = 0;   // File size when probed
+		media::SourceProbe probe;
+	};
+
+	~RenderPlan();
+
+	RenderPlan(const RenderPlan&) = delete;
+	RenderPlan& operator=(const RenderPlan&) = delete;
+
+	// Default plan location for an EDL file
+	static std::string planPathFor(const std::string& edlPath);
+
+	// FNV-1a 64-bit hash
+	static uint64_t hashBytes(const void* data, size_t size);
+	static uint64_t hashFile(const std::string& path);
+
+	// Current mtime/size of a file, false if it cannot be stat'ed
+	static bool statFile(const std::string& path, int64_t& mtime, int64_t& size);
+
+	/**
+	 * Map a plan file
+	 * @return nullptr if the file is missing, truncated, from another version
+	 *         or written on a machine with a different byte order
+	 */
+	static std::unique_ptr<RenderPlan> load(const std::string& planPath);
+
+	/**
+	 * Write a plan file (via a temporary file and rename, so readers never
+	 * see a partial plan)
+	 * @param sources One record per timeline source, in timeline order,
+	 *        optionally followed by records for other probed files
+	 * @throws std::runtime_error on I/O failure or mismatched sources
+	 */
+	static void write(const std::string& planPath, uint64_t edlHash,
+		const compositor::CompiledTimeline& timeline, const std::vector<Source>& sources);
+
+	uint64_t getEDLHash() const;
+
+	// Rebuild the compiled timeline from the mapped sections
+	compositor::CompiledTimeline getTimeline() const;
+
+	// All source records in the plan
+	std::vector<Source> getSources() const;
+
+	/**
+	 * Probe for a file, if the plan has one and the file on disk still has
+	 * the recorded mtime and size
+	 */
+	std::shared_ptr<const media::SourceProbe> findProbe(const std::string& path) const;
+
+private:
+	RenderPlan() = default;
+
+	bool validate() const;
+	Source readSource(size_t index) const;
+	std::string readString(uint64_t offset, uint64_t length) const;
+
+	const uint8_t* data = nullptr;
+	size_t dataSize = 0;
+	bool mapped = false;            // data is an mmap'ed region (otherwise owned buffer)
+	std::vector<uint8_t> buffer;    // Fallback storage where mmap is not available
+};
+
+} // namespace cache
\ No newline at end of file
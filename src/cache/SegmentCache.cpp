@@ -0,0 +1,417 @@
+#include "cache/SegmentCache.h"
+#include "cache/ContentHash.h"
+#include "media/FFmpegCompat.h"
+#include "media/FFmpegEncoder.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cache {
+
+namespace {
+
+constexpr char SEGMENT_MAGIC[8] = {'E', '2', 'F', 'S', 'E', 'G', '\0', '\0'};
+constexpr uint32_t SEGMENT_VERSION = 1;
+
+struct SegmentFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t packetCount;
+	int64_t frameCount;
+	uint64_t hash;
+};
+
+struct PacketHeader {
+	int64_t pts;
+	int64_t dts;
+	int64_t duration;
+	int32_t flags;
+	uint32_t size;
+};
+
+// Temporary file next to path that no other writer (thread or process) uses
+std::string uniqueTempPath(const std::string& path) {
+	static std::atomic<uint64_t> counter{0};
+#ifndef _WIN32
+	long pid = static_cast<long>(::getpid());
+#else
+	long pid = static_cast<long>(::_getpid());
+#endif
+	return path + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
+int64_t fileTimeToInt(fs::file_time_type time) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+SegmentCache::SegmentCache(const Config& config)
+	: config(config) {
+	
+	std::error_code ec;
+	fs::create_directories(config.directory, ec);
+	if (ec) {
+		throw std::runtime_error("Cannot create segment cache directory: " + config.directory);
+	}
+	
+	scanDirectory();
+	
+	utils::Logger::info("Segment cache: {} ({} segments, {} MB of {} MB)",
+		config.directory, entries.size(), totalBytes / (1024 * 1024), config.maxBytes / (1024 * 1024));
+}
+
+std::vector<SegmentCache::Segment> SegmentCache::planSegments(const compositor::CompiledTimeline& timeline,
+	int maxSegmentFrames, int minSegmentFrames) {
+	
+	maxSegmentFrames = std::max(1, maxSegmentFrames);
+	
+	std::vector<Segment> segments;
+	for (const auto& span : timeline.spans) {
+		// Cut at every span boundary, splitting long spans
+		for (int start = span.startFrame; start < span.endFrame; start += maxSegmentFrames) {
+			int end = std::min(start + maxSegmentFrames, static_cast<int>(span.endFrame));
+			
+			// Very short pieces (transitions, flash frames) would cost an IDR
+			// frame each; fold them into their neighbour instead
+			if (!segments.empty() &&
+				(end - start < minSegmentFrames ||
+				 segments.back().endFrame - segments.back().startFrame < minSegmentFrames)) {
+				segments.back().endFrame = end;
+				continue;
+			}
+			
+			Segment segment;
+			segment.startFrame = start;
+			segment.endFrame = end;
+			segments.push_back(segment);
+		}
+	}
+	
+	return segments;
+}
+
+void SegmentCache::hashSegments(std::vector<Segment>& segments, compositor::InstructionGenerator& generator,
+	uint64_t encoderKey, const std::unordered_map<std::string, std::string>& sourceIdentities) {
+	
+	for (auto& segment : segments) {
+		ContentHash hash;
+		hash.add(SEGMENT_VERSION);
+		hash.add(encoderKey);
+		hash.add(segment.endFrame - segment.startFrame);
+		
+		// Everything that affects the rendered pixels, but not the position on
+		// the timeline
+		for (int frame = segment.startFrame; frame < segment.endFrame; ++frame) {
+			const auto instruction = generator.getInstructionForFrame(frame);
+			hash.add(static_cast<int32_t>(instruction.type));
+			if (instruction.type == compositor::CompositorInstruction::DrawFrame) {
+				auto it = sourceIdentities.find(instruction.uri);
+				hash.add(it != sourceIdentities.end() ? it->second : instruction.uri);
+				hash.add(instruction.sourceFrameNumber);
+			}
+			hash.add(instruction.panX);
+			hash.add(instruction.panY);
+			hash.add(instruction.zoomX);
+			hash.add(instruction.zoomY);
+			hash.add(instruction.rotation);
+			hash.add(instruction.flip);
+			hash.add(instruction.fade);
+			hash.add(instruction.color.r);
+			hash.add(instruction.color.g);
+			hash.add(instruction.color.b);
+			hash.add(static_cast<int32_t>(instruction.transition.type));
+			hash.add(instruction.transition.progress);
+			hash.add(static_cast<uint64_t>(instruction.effects.size()));
+			for (const auto& effect : instruction.effects) {
+				hash.add(static_cast<int32_t>(effect.type));
+				hash.add(effect.strength);
+				hash.update(effect.parameters.data(), effect.parameters.size() * sizeof(float));
+			}
+		}
+		
+		segment.hash = hash.value();
+	}
+}
+
+uint64_t SegmentCache::encoderKey(const media::FFmpegEncoder& encoder, const std::string& settings) {
+	const AVCodecContext* codecCtx = encoder.getCodecContext();
+	
+	ContentHash hash;
+	hash.add(settings);
+	hash.add(static_cast<uint32_t>(LIBAVCODEC_VERSION_INT));
+	hash.add(static_cast<int32_t>(codecCtx->codec_id));
+	hash.add(codecCtx->width);
+	hash.add(codecCtx->height);
+	hash.add(static_cast<int32_t>(codecCtx->pix_fmt));
+	hash.add(codecCtx->time_base.num);
+	hash.add(codecCtx->time_base.den);
+	// Spliced packets must match the stream headers written for this output
+	if (codecCtx->extradata_size > 0) {
+		hash.update(codecCtx->extradata, codecCtx->extradata_size);
+	}
+	return hash.value();
+}
+
+bool SegmentCache::contains(const Segment& segment) const {
+	return entries.count(segment.hash) > 0;
+}
+
+bool SegmentCache::splice(const Segment& segment, media::FFmpegEncoder& encoder) {
+	auto entryIt = entries.find(segment.hash);
+	if (entryIt == entries.end()) {
+		stats.misses++;
+		return false;
+	}
+	
+	std::string path = entryPath(segment.hash);
+	std::ifstream file(path, std::ios::binary);
+	std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	
+	// Validate the whole entry before muxing anything
+	SegmentFileHeader header;
+	bool valid = contents.size() >= sizeof(header);
+	if (valid) {
+		std::memcpy(&header, contents.data(), sizeof(header));
+		valid = std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0 &&
+			header.version == SEGMENT_VERSION &&
+			header.hash == segment.hash &&
+			header.frameCount == segment.endFrame - segment.startFrame;
+	}
+	
+	std::vector<std::pair<PacketHeader, size_t>> packets;
+	size_t offset = sizeof(header);
+	for (uint32_t i = 0; valid && i < header.packetCount; ++i) {
+		PacketHeader packetHeader;
+		if (contents.size() - offset < sizeof(packetHeader)) {
+			valid = false;
+			break;
+		}
+		std::memcpy(&packetHeader, contents.data() + offset, sizeof(packetHeader));
+		offset += sizeof(packetHeader);
+		if (contents.size() - offset < packetHeader.size) {
+			valid = false;
+			break;
+		}
+		packets.emplace_back(packetHeader, offset);
+		offset += packetHeader.size;
+	}
+	
+	if (!valid) {
+		utils::Logger::warn("Discarding corrupt segment cache entry: {}", path);
+		std::error_code ec;
+		fs::remove(path, ec);
+		totalBytes -= entryIt->second.size;
+		entries.erase(entryIt);
+		stats.misses++;
+		return false;
+	}
+	
+	AVPacket* packet = media::FFmpegCompat::allocPacket();
+	if (!packet) {
+		throw std::runtime_error("Failed to allocate packet");
+	}
+	for (const auto& [packetHeader, dataOffset] : packets) {
+		if (av_new_packet(packet, static_cast<int>(packetHeader.size)) < 0) {
+			media::FFmpegCompat::freePacket(&packet);
+			throw std::runtime_error("Failed to allocate packet data");
+		}
+		std::memcpy(packet->data, contents.data() + dataOffset, packetHeader.size);
+		packet->pts = packetHeader.pts + segment.startFrame;
+		packet->dts = packetHeader.dts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE : packetHeader.dts + segment.startFrame;
+		packet->duration = packetHeader.duration;
+		packet->flags = packetHeader.flags;
+		
+		bool written = encoder.writeEncodedPacket(packet);
+		av_packet_unref(packet);
+		if (!written) {
+			media::FFmpegCompat::freePacket(&packet);
+			throw std::runtime_error("Failed to write cached segment packet");
+		}
+	}
+	media::FFmpegCompat::freePacket(&packet);
+	encoder.advancePts(segment.endFrame - segment.startFrame);
+	
+	// Mark as recently used, on disk too so the LRU order survives restarts
+	std::error_code ec;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+	entryIt->second.lastUse = fileTimeToInt(fs::file_time_type::clock::now());
+	
+	stats.hits++;
+	stats.framesSpliced += segment.endFrame - segment.startFrame;
+	stats.bytesSpliced += static_cast<int64_t>(contents.size());
+	return true;
+}
+
+void SegmentCache::beginSegment(const Segment& segment) {
+	Pending entry;
+	entry.segment = segment;
+	pending.push_back(std::move(entry));
+}
+
+void SegmentCache::recordPacket(const AVPacket* packet) {
+	if (pending.empty() || packet->pts == AV_NOPTS_VALUE) {
+		return;
+	}
+	
+	// Find the pending segment this packet belongs to (usually the last one)
+	auto match = std::find_if(pending.rbegin(), pending.rend(), [packet](const Pending& entry) {
+		return packet->pts >= entry.segment.startFrame && packet->pts < entry.segment.endFrame;
+	});
+	if (match == pending.rend()) {
+		return;
+	}
+	auto it = std::prev(match.base());
+	
+	// Segments start with an IDR frame and GOPs are closed, so once a later
+	// segment's keyframe comes out, every earlier segment is complete
+	if ((packet->flags & AV_PKT_FLAG_KEY) && it != pending.begin()) {
+		for (auto done = pending.begin(); done != it; ++done) {
+			store(*done);
+		}
+		it = pending.erase(pending.begin(), it);
+	}
+	
+	StoredPacket stored;
+	stored.pts = packet->pts - it->segment.startFrame;
+	stored.dts = packet->dts == AV_NOPTS_VALUE ? packet->dts : packet->dts - it->segment.startFrame;
+	stored.duration = packet->duration;
+	stored.flags = packet->flags;
+	stored.data.assign(packet->data, packet->data + packet->size);
+	it->packets.push_back(std::move(stored));
+}
+
+void SegmentCache::commitPending() {
+	for (const auto& entry : pending) {
+		store(entry);
+	}
+	pending.clear();
+}
+
+void SegmentCache::store(const Pending& entry) {
+	const Segment& segment = entry.segment;
+	int64_t frames = segment.endFrame - segment.startFrame;
+	
+	// Only self-contained segments can be spliced: one packet per frame,
+	// starting with the forced keyframe
+	if (static_cast<int64_t>(entry.packets.size()) != frames ||
+		!(entry.packets.front().flags & AV_PKT_FLAG_KEY) ||
+		entry.packets.front().pts != 0) {
+		utils::Logger::debug("Not caching segment at frame {}: not self-contained", segment.startFrame);
+		stats.rejected++;
+		return;
+	}
+	
+	if (entries.count(segment.hash)) {
+		return;
+	}
+	
+	SegmentFileHeader header{};
+	std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+	header.version = SEGMENT_VERSION;
+	header.packetCount = static_cast<uint32_t>(entry.packets.size());
+	header.frameCount = frames;
+	header.hash = segment.hash;
+	
+	std::string path = entryPath(segment.hash);
+	// Jobs sharing the cache directory may store the same segment at once
+	std::string tempPath = uniqueTempPath(path);
+	uint64_t size = sizeof(header);
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const auto& packet : entry.packets) {
+			PacketHeader packetHeader{packet.pts, packet.dts, packet.duration, packet.flags,
+				static_cast<uint32_t>(packet.data.size())};
+			file.write(reinterpret_cast<const char*>(&packetHeader), sizeof(packetHeader));
+			file.write(reinterpret_cast<const char*>(packet.data.data()), static_cast<std::streamsize>(packet.data.size()));
+			size += sizeof(packetHeader) + packet.data.size();
+		}
+		if (!file) {
+			utils::Logger::warn("Failed to write segment cache entry: {}", tempPath);
+			std::error_code ec;
+			fs::remove(tempPath, ec);
+			return;
+		}
+	}
+	
+	std::error_code ec;
+	fs::rename(tempPath, path, ec);
+	if (ec) {
+		fs::remove(tempPath, ec);
+		return;
+	}
+	
+	entries[segment.hash] = Entry{size, fileTimeToInt(fs::file_time_type::clock::now())};
+	totalBytes += size;
+	stats.stored++;
+	stats.bytesStored += static_cast<int64_t>(size);
+	
+	evict();
+}
+
+void SegmentCache::evict() {
+	while (totalBytes > config.maxBytes && !entries.empty()) {
+		auto oldest = std::min_element(entries.begin(), entries.end(),
+			[](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+		
+		std::error_code ec;
+		fs::remove(entryPath(oldest->first), ec);
+		totalBytes -= oldest->second.size;
+		entries.erase(oldest);
+		stats.evictions++;
+	}
+}
+
+void SegmentCache::scanDirectory() {
+	std::error_code ec;
+	for (const auto& file : fs::directory_iterator(config.directory, ec)) {
+		if (!file.is_regular_file() || file.path().extension() != ".seg") {
+			continue;
+		}
+		
+		uint64_t hash = 0;
+		try {
+			hash = std::stoull(file.path().stem().string(), nullptr, 16);
+		} catch (const std::exception&) {
+			continue;
+		}
+		
+		Entry entry;
+		entry.size = file.file_size(ec);
+		entry.lastUse = fileTimeToInt(file.last_write_time(ec));
+		entries[hash] = entry;
+		totalBytes += entry.size;
+	}
+	
+	// The limit may have been lowered since the last run
+	evict();
+}
+
+std::string SegmentCache::entryPath(uint64_t hash) const {
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << hash << ".seg";
+	return (fs::path(config.directory) / name.str()).string();
+}
+
+void SegmentCache::logStats() const {
+	int total = stats.hits + stats.misses;
+	utils::Logger::info("Segment cache: {}/{} segments reused ({} frames, {} KB), {} stored ({} KB), {} rejected, {} evicted",
+		stats.hits, total, stats.framesSpliced, stats.bytesSpliced / 1024,
+		stats.stored, stats.bytesStored / 1024, stats.rejected, stats.evictions);
+}
+
+} // namespace cache
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "compositor/InstructionGenerator.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace media {
+class FFmpegEncoder;
+}
+
+namespace cache {
+
+/**
+ * Content-addressed cache of encoded output segments.
+ *
+ * The timeline is cut into segments at span boundaries, and every segment
+ * starts with a forced IDR frame. Each segment is keyed by a hash of its
+ * resolved instructions, the identity (path, mtime, size) of the sources it
+ * reads, and the encoder configuration. A segment's position on the timeline
+ * is not part of the key, so moved material is still found. On re-render,
+ * cached segments are muxed as-is and only dirty segments are encoded.
+ *
+ * Packets are stored in the encoder time base (frames) relative to the
+ * segment start. Eviction is least-recently-used and bounded by total size.
+ */
+class SegmentCache {
+public:
+	struct Config {
+		std::string directory;
+		uint64_t maxBytes = 10ULL * 1024 * 1024 * 1024;  // 10 GiB
+		int maxSegmentFrames = 300;   // Split longer spans (one GOP by default)
+		int minSegmentFrames = 30;    // Merge shorter spans into the previous segment
+	};
+
+	struct Segment {
+		int startFrame = 0;
+		int endFrame = 0;             // Exclusive
+		uint64_t hash = 0;
+	};
+
+	struct Stats {
+		int hits = 0;
+		int misses = 0;
+		int stored = 0;
+		int rejected = 0;             // Encoded segments that could not be cached
+		int evictions = 0;
+		int64_t framesSpliced = 0;
+		int64_t bytesSpliced = 0;
+		int64_t bytesStored = 0;
+	};
+
+	explicit SegmentCache(const Config& config);
+
+	// Cut a compiled timeline into cacheable segments
+	static std::vector<Segment> planSegments(const compositor::CompiledTimeline& timeline,
+		int maxSegmentFrames, int minSegmentFrames);
+	std::vector<Segment> planSegments(const compositor::CompiledTimeline& timeline) const {
+		return planSegments(timeline, config.maxSegmentFrames, config.minSegmentFrames);
+	}
+
+	/**
+	 * Key every segment by its content
+	 * @param encoderKey Hash of everything about the encoder that affects the bitstream
+	 * @param sourceIdentities URI -> identity string of the file it resolves to
+	 */
+	static void hashSegments(std::vector<Segment>& segments, compositor::InstructionGenerator& generator,
+		uint64_t encoderKey, const std::unordered_map<std::string, std::string>& sourceIdentities);
+
+	// Hash of the encoder settings and stream headers
+	static uint64_t encoderKey(const media::FFmpegEncoder& encoder, const std::string& settings);
+
+	bool contains(const Segment& segment) const;
+
+	/**
+	 * Mux a cached segment through the encoder
+	 * @return false on a miss or unreadable entry (nothing was written)
+	 */
+	bool splice(const Segment& segment, media::FFmpegEncoder& encoder);
+
+	// Recording of freshly encoded segments (fed from the encoder's packet tap)
+	void beginSegment(const Segment& segment);
+	void recordPacket(const AVPacket* packet);
+	void commitPending();
+
+	const Stats& getStats() const { return stats; }
+	void logStats() const;
+
+private:
+	struct Entry {
+		uint64_t size = 0;
+		int64_t lastUse = 0;
+	};
+
+	struct StoredPacket {
+		int64_t pts;
+		int64_t dts;
+		int64_t duration;
+		int32_t flags;
+		std::vector<uint8_t> data;
+	};
+
+	struct Pending {
+		Segment segment;
+		std::vector<StoredPacket> packets;
+	};
+
+	std::string entryPath(uint64_t hash) const;
+	void scanDirectory();
+	void store(const Pending& pending);
+	void evict();
+
+	Config config;
+	std::map<uint64_t, Entry> entries;
+	uint64_t totalBytes = 0;
+	std::vector<Pending> pending;   // Segments being encoded, in timeline order
+	Stats stats;
+};
+
+} // namespace cache
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "server/JsonChannel.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// Exit codes of a render: done, failed, cancelled
+constexpr int EXIT_DONE = 0;
+constexpr int EXIT_FAILED = 1;
+constexpr int EXIT_CANCELLED = 2;
+
+void printUsage(const char* programName) {
+	std::cout << "Usage: " << programName << " [--socket <path>] [--json] <command>\n";
+	std::cout << "\nCommands:\n";
+	std::cout << "  render <edl_file> <output_file> [key=value...]\n";
+	std::cout << "                           Render on the daemon and wait for it; keys are job options\n";
+	std::cout << "                           (codec, bitrate, crf, preset, threads, audio, hw_accel, ...),\n";
+	std::cout << "                           output=<spec> adds an output as with --output. Interrupting\n";
+	std::cout << "                           the client cancels the job.\n";
+	std::cout << "  cancel <job_id>          Cancel a queued or running job\n";
+	std::cout << "  status                   List the jobs and the warm decoder cache\n";
+	std::cout << "  shutdown                 Cancel all jobs and stop the daemon\n";
+	std::cout << "\nOptions:\n";
+	std::cout << "  --socket <path>          Daemon socket (default: " << server::DEFAULT_SOCKET_PATH << ")\n";
+	std::cout << "  --id <job_id>            Job id for render (default: assigned by the daemon)\n";
+	std::cout << "  --json                   Print the daemon's events as JSON lines\n";
+	std::cout << "\nExit status of render: 0 done, 1 failed, 2 cancelled\n";
+}
+
+// "true", "false" and numbers become JSON values, anything else a string
+nlohmann::json parseValue(const std::string& text) {
+	if (text == "true" || text == "false") {
+		return text == "true";
+	}
+	try {
+		size_t used = 0;
+		long long integer = std::stoll(text, &used);
+		if (used == text.size()) {
+			return integer;
+		}
+		double number = std::stod(text, &used);
+		if (used == text.size()) {
+			return number;
+		}
+	} catch (const std::exception&) {
+	}
+	return text;
+}
+
+// The daemon runs in another directory; hand it absolute paths
+std::string absolutePath(const std::string& path) {
+	return fs::absolute(path).lexically_normal().string();
+}
+
+void printEvent(const nlohmann::json& event) {
+	std::string type = event.value("event", "");
+	if (type == "progress") {
+		int total = event.value("total_frames", 0);
+		double percent = total > 0 ? 100.0 * event.value("frame", 0) / total : 0.0;
+		std::cerr << "\r" << event.value("id", "") << ": " << std::fixed << std::setprecision(1) << percent << "% ("
+			<< event.value("frame", 0) << "/" << total << " frames) FPS: " << event.value("fps", 0.0) << "   "
+			<< std::flush;
+	} else if (type == "done" || type == "cancelled") {
+		std::cerr << "\n" << event.value("id", "") << ": " << type << ", " << event.value("frames", 0)
+			<< " frames in " << std::setprecision(2) << event.value("seconds", 0.0) << " s\n";
+	} else if (type == "error") {
+		std::cerr << "\nError: " << event.value("message", "") << "\n";
+	} else if (type == "status") {
+		std::cout << "Workers: " << event.value("workers", 0) << ", warm decoders: "
+			<< event.value("warm_decoders", 0) << " (" << event.value("decoder_hits", 0) << " hits, "
+			<< event.value("decoder_misses", 0) << " misses, " << event.value("probe_hits", 0) << " probe hits)\n";
+		for (const auto& job : event["jobs"]) {
+			std::cout << "  " << job.value("id", "") << "  " << job.value("state", "") << "  "
+				<< job.value("frame", 0) << "/" << job.value("total_frames", 0) << "\n";
+		}
+	} else if (type == "cancel_requested") {
+		std::cerr << event.value("id", "") << ": cancelling\n";
+	} else if (type == "shutdown") {
+		std::cerr << "Daemon shutting down\n";
+	} else if (type == "queued") {
+		std::cerr << event.value("id", "") << ": queued at position " << event.value("position", 0) << "\n";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::string socketPath = server::DEFAULT_SOCKET_PATH;
+	std::string jobId;
+	bool json = false;
+	
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			return 0;
+		} else if (arg == "--socket" && i + 1 < argc) {
+			socketPath = argv[++i];
+		} else if (arg == "--id" && i + 1 < argc) {
+			jobId = argv[++i];
+		} else if (arg == "--json") {
+			json = true;
+		} else {
+			std::cerr << "Unknown option: " << arg << "\n";
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (i >= argc) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	
+	std::string command = argv[i++];
+	nlohmann::json request;
+	if (command == "render" && argc - i >= 2) {
+		request = {{"type", "render"}, {"edl", absolutePath(argv[i])}, {"output", absolutePath(argv[i + 1])}};
+		if (!jobId.empty()) {
+			request["id"] = jobId;
+		}
+		nlohmann::json options = nlohmann::json::object();
+		for (i += 2; i < argc; ++i) {
+			std::string setting = argv[i];
+			size_t equals = setting.find('=');
+			if (equals == std::string::npos || equals == 0) {
+				std::cerr << "Error: Expected key=value: " << setting << "\n";
+				return 1;
+			}
+			std::string key = setting.substr(0, equals);
+			std::string value = setting.substr(equals + 1);
+			if (key == "output") {
+				// Only the file name of an output spec is a path
+				size_t comma = value.find(',');
+				std::string file = absolutePath(value.substr(0, comma));
+				options["outputs"].push_back(comma == std::string::npos ? file : file + value.substr(comma));
+			} else {
+				options[key] = parseValue(value);
+			}
+		}
+		request["options"] = options;
+	} else if (command == "cancel" && argc - i == 1) {
+		request = {{"type", "cancel"}, {"id", argv[i]}};
+	} else if ((command == "status" || command == "shutdown") && argc == i) {
+		request = {{"type", command}};
+	} else {
+		printUsage(argv[0]);
+		return 1;
+	}
+	
+	try {
+		server::JsonChannel channel(server::JsonChannel::connectTo(socketPath));
+		if (!channel.write(request)) {
+			std::cerr << "Error: The daemon closed the connection\n";
+			return EXIT_FAILED;
+		}
+		
+		// A render ends with done, cancelled or error, every other command
+		// with its single reply
+		nlohmann::json event;
+		while (channel.read(event)) {
+			if (json) {
+				std::cout << event.dump() << std::endl;
+			} else {
+				printEvent(event);
+			}
+			
+			std::string type = event.value("event", "");
+			if (type == "error") {
+				return EXIT_FAILED;
+			} else if (type == "cancelled") {
+				return EXIT_CANCELLED;
+			} else if (type == "done" || command != "render") {
+				return EXIT_DONE;
+			}
+		}
+		
+		std::cerr << "Error: The daemon closed the connection\n";
+		return EXIT_FAILED;
+	} catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		return EXIT_FAILED;
+	}
+}
\ No newline at end of file
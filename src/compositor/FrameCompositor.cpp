@@ -1,6 +1,7 @@
 #include "compositor/FrameCompositor.h"
 #include "utils/Logger.h"
 #include "utils/PixelFormatUtils.h"
+#include "utils/Timer.h"
 #include <cmath>
 #include <algorithm>
 #include <cstring>
@@ -12,18 +13,20 @@ extern "C" {
 
 namespace compositor {
 
-FrameCompositor::FrameCompositor(int width, int height, AVPixelFormat format)
+FrameCompositor::FrameCompositor(int width, int height, AVPixelFormat format, int threads)
 	: width(width)
 	, height(height)
 	, format(format)
-	, outputPool(width, height, format) {
+	, outputPool(width, height, format)
+	, scaleFlags(SWS_BILINEAR)
+	, workers(threads) {
 	
 	// Allocate temporary buffer for effects processing
 	tempBufferSize = av_image_get_buffer_size(format, width, height, 32);
 	tempBuffer = std::make_unique<uint8_t[]>(tempBufferSize);
 	
-	utils::Logger::info("Frame compositor initialized: {}x{}, format: {}",
-		width, height, format);
+	utils::Logger::info("Frame compositor initialized: {}x{}, format: {}, threads: {}",
+		width, height, format, workers.getThreadCount());
 }
 
 FrameCompositor::~FrameCompositor() {
@@ -32,10 +35,16 @@ FrameCompositor::~FrameCompositor() {
 	}
 }
 
+void FrameCompositor::setFastScaling(bool fast) {
+	scaleFlags = fast ? SWS_FAST_BILINEAR : SWS_BILINEAR;
+}
+
 std::shared_ptr<AVFrame> FrameCompositor::processFrame(
 	const std::shared_ptr<AVFrame>& input,
 	const CompositorInstruction& instruction) {
 	
+	TIME_BLOCK("composite_frame");
+	
 	if (!input) {
 		// Generate black frame if no input
 		return generateColorFrame(0.0f, 0.0f, 0.0f);
@@ -50,17 +59,16 @@ std::shared_ptr<AVFrame> FrameCompositor::processFrame(
 	if (input->width != width || input->height != height ||
 		input->format != format) {
 		
-		// Need to scale/convert
+		// Need to scale/convert; sources may differ in size and format, so
+		// the context is rebuilt whenever the input changes
+		swsCtx = sws_getCachedContext(swsCtx,
+			input->width, input->height, (AVPixelFormat)input->format,
+			width, height, format,
+			scaleFlags, nullptr, nullptr, nullptr);
+		
 		if (!swsCtx) {
-			swsCtx = sws_getContext(
-				input->width, input->height, (AVPixelFormat)input->format,
-				width, height, format,
-				SWS_BILINEAR, nullptr, nullptr, nullptr);
-			
-			if (!swsCtx) {
-				utils::Logger::error("Failed to create scaling context");
-				return output;
-			}
+			utils::Logger::error("Failed to create scaling context");
+			return output;
 		}
 		
 		sws_scale(swsCtx,
@@ -125,9 +133,11 @@ void FrameCompositor::fillWithColor(AVFrame* frame, float r, float g, float b) {
 		v = std::max(0, std::min(255, v));
 		
 		// Fill Y plane
-		for (int row = 0; row < frame->height; ++row) {
-			std::memset(frame->data[0] + row * frame->linesize[0], y, frame->width);
-		}
+		workers.parallelFor(frame->height, [&](int begin, int end) {
+			for (int row = begin; row < end; ++row) {
+				std::memset(frame->data[0] + row * frame->linesize[0], y, frame->width);
+			}
+		});
 		
 		// Fill U and V planes (handle different subsampling)
 		int chromaHeight = frame->height;
@@ -140,10 +150,12 @@ void FrameCompositor::fillWithColor(AVFrame* frame, float r, float g, float b) {
 			chromaWidth /= 2;
 		}
 		
-		for (int row = 0; row < chromaHeight; ++row) {
-			std::memset(frame->data[1] + row * frame->linesize[1], u, chromaWidth);
-			std::memset(frame->data[2] + row * frame->linesize[2], v, chromaWidth);
-		}
+		workers.parallelFor(chromaHeight, [&](int begin, int end) {
+			for (int row = begin; row < end; ++row) {
+				std::memset(frame->data[1] + row * frame->linesize[1], u, chromaWidth);
+				std::memset(frame->data[2] + row * frame->linesize[2], v, chromaWidth);
+			}
+		});
 	} else if (format == AV_PIX_FMT_RGB24 || format == AV_PIX_FMT_BGR24) {
 		// RGB format
 		uint8_t rgb[3];
@@ -174,12 +186,14 @@ void FrameCompositor::applyFade(AVFrame* frame, float fade) {
 	// Apply fade to Y plane (luminance)
 	if (utils::PixelFormatUtils::isPlanarYUVFormat(format)) {
 		
-		for (int row = 0; row < frame->height; ++row) {
-			uint8_t* data = frame->data[0] + row * frame->linesize[0];
-			for (int col = 0; col < frame->width; ++col) {
-				data[col] = static_cast<uint8_t>(data[col] * fade);
+		workers.parallelFor(frame->height, [&](int begin, int end) {
+			for (int row = begin; row < end; ++row) {
+				uint8_t* data = frame->data[0] + row * frame->linesize[0];
+				for (int col = 0; col < frame->width; ++col) {
+					data[col] = static_cast<uint8_t>(data[col] * fade);
+				}
 			}
-		}
+		});
 		
 		// Optionally fade chroma planes towards neutral (128)
 		// This creates a more natural fade to black
@@ -193,16 +207,18 @@ void FrameCompositor::applyFade(AVFrame* frame, float fade) {
 			chromaWidth /= 2;
 		}
 		
-		for (int plane = 1; plane <= 2; ++plane) {
-			for (int row = 0; row < chromaHeight; ++row) {
-				uint8_t* data = frame->data[plane] + row * frame->linesize[plane];
-				for (int col = 0; col < chromaWidth; ++col) {
-					int value = data[col];
-					value = 128 + static_cast<int>((value - 128) * fade);
-					data[col] = static_cast<uint8_t>(std::max(0, std::min(255, value)));
+		workers.parallelFor(chromaHeight, [&](int begin, int end) {
+			for (int plane = 1; plane <= 2; ++plane) {
+				for (int row = begin; row < end; ++row) {
+					uint8_t* data = frame->data[plane] + row * frame->linesize[plane];
+					for (int col = 0; col < chromaWidth; ++col) {
+						int value = data[col];
+						value = 128 + static_cast<int>((value - 128) * fade);
+						data[col] = static_cast<uint8_t>(std::max(0, std::min(255, value)));
+					}
 				}
 			}
-		}
+		});
 	}
 }
 
@@ -303,27 +319,29 @@ void FrameCompositor::applyBrightnessLUT(AVFrame* frame, const uint8_t* lut) {
 		format == AV_PIX_FMT_YUV444P) {
 		
 		// Process Y (luminance) plane with LUT
-		for (int row = 0; row < frame->height; ++row) {
-			uint8_t* data = frame->data[0] + row * frame->linesize[0];
-			
-			// Process 8 pixels at a time for better cache utilization
-			int col = 0;
-			for (; col < frame->width - 7; col += 8) {
-				data[col + 0] = lut[data[col + 0]];
-				data[col + 1] = lut[data[col + 1]];
-				data[col + 2] = lut[data[col + 2]];
-				data[col + 3] = lut[data[col + 3]];
-				data[col + 4] = lut[data[col + 4]];
-				data[col + 5] = lut[data[col + 5]];
-				data[col + 6] = lut[data[col + 6]];
-				data[col + 7] = lut[data[col + 7]];
-			}
-			
-			// Handle remaining pixels
-			for (; col < frame->width; ++col) {
-				data[col] = lut[data[col]];
+		workers.parallelFor(frame->height, [&](int begin, int end) {
+			for (int row = begin; row < end; ++row) {
+				uint8_t* data = frame->data[0] + row * frame->linesize[0];
+				
+				// Process 8 pixels at a time for better cache utilization
+				int col = 0;
+				for (; col < frame->width - 7; col += 8) {
+					data[col + 0] = lut[data[col + 0]];
+					data[col + 1] = lut[data[col + 1]];
+					data[col + 2] = lut[data[col + 2]];
+					data[col + 3] = lut[data[col + 3]];
+					data[col + 4] = lut[data[col + 4]];
+					data[col + 5] = lut[data[col + 5]];
+					data[col + 6] = lut[data[col + 6]];
+					data[col + 7] = lut[data[col + 7]];
+				}
+				
+				// Handle remaining pixels
+				for (; col < frame->width; ++col) {
+					data[col] = lut[data[col]];
+				}
 			}
-		}
+		});
 	}
 }
 
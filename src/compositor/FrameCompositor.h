@@ -3,13 +3,15 @@
 #include "compositor/CompositorInstruction.h"
 #include "media/MediaTypes.h"
 #include "utils/FrameBuffer.h"
+#include "utils/ThreadPool.h"
 #include <memory>
 
 namespace compositor {
 
 class FrameCompositor {
 public:
-	FrameCompositor(int width, int height, AVPixelFormat format);
+	// threads: worker count for per-pixel kernels, including the calling thread
+	FrameCompositor(int width, int height, AVPixelFormat format, int threads = 1);
 	~FrameCompositor();
 	
 	// Process single frame with instruction
@@ -23,6 +25,9 @@ public:
 		float r, float g, float b
 	);
 	
+	// Cheaper, lower quality scaling of the inputs (proxy renders)
+	void setFastScaling(bool fast);
+	
 private:
 	void applyTransform(AVFrame* frame, const CompositorInstruction& instruction);
 	void applyFade(AVFrame* frame, float fade);
@@ -40,6 +45,10 @@ private:
 	AVPixelFormat format;
 	utils::FrameBufferPool outputPool;
 	SwsContext* swsCtx = nullptr;
+	int scaleFlags;
+	
+	// Kernels are split into bands of rows across these workers
+	utils::ThreadPool workers;
 	
 	// Temporary buffers for effects
 	std::unique_ptr<uint8_t[]> tempBuffer;
@@ -2,6 +2,7 @@
 #include "utils/Logger.h"
 #include <algorithm>
 #include <cmath>
+#include <map>
 #include <variant>
 
 namespace compositor {
@@ -19,8 +20,44 @@ InstructionGenerator::InstructionGenerator(const edl::EDL& edl)
 	
 	totalFrames = timeToFrame(maxTime);
 	
-	utils::Logger::info("Instruction generator initialized: {} total frames @ {} fps",
-		totalFrames, edl.fps);
+	// Effect clips are looked up for every frame, so keep them separate,
+	// grouped by effects track and sorted by time for a binary search
+	std::map<std::pair<int, int>, std::vector<const edl::Clip*>> effectsByTrack;
+	for (const auto& clip : this->edl.clips) {
+		if (clip.track.type == edl::Track::Video && clip.track.subtype == "effects") {
+			effectsByTrack[{clip.track.number, clip.track.subnumber}].push_back(&clip);
+		}
+	}
+	for (auto& [track, clips] : effectsByTrack) {
+		std::stable_sort(clips.begin(), clips.end(), [](const edl::Clip* a, const edl::Clip* b) {
+			return a->in < b->in;
+		});
+		EffectTrack effectTrack;
+		for (const edl::Clip* clip : clips) {
+			effectTrack.maxOut.push_back(std::max(clip->out,
+				effectTrack.maxOut.empty() ? clip->out : effectTrack.maxOut.back()));
+		}
+		effectTrack.clips = std::move(clips);
+		effectTracks.push_back(std::move(effectTrack));
+	}
+	
+	compileTimeline();
+	
+	utils::Logger::info("Instruction generator initialized: {} total frames @ {} fps, {} spans",
+		totalFrames, edl.fps, timeline.spans.size());
+}
+
+InstructionGenerator::InstructionGenerator(CompiledTimeline compiled)
+	: timeline(std::move(compiled))
+	, totalFrames(timeline.totalFrames)
+	, frameDuration(1.0 / timeline.fps) {
+	
+	edl.fps = timeline.fps;
+	edl.width = timeline.width;
+	edl.height = timeline.height;
+	
+	utils::Logger::info("Instruction generator initialized from compiled timeline: {} total frames @ {} fps, {} spans",
+		totalFrames, timeline.fps, timeline.spans.size());
 }
 
 InstructionGenerator::Iterator::Iterator(InstructionGenerator* generator, int frameNumber)
@@ -55,11 +92,10 @@ InstructionGenerator::Iterator InstructionGenerator::end() {
 }
 
 CompositorInstruction InstructionGenerator::getInstructionForFrame(int frameNumber) {
-	// Find the clip that should be displayed at this frame
-	const edl::Clip* clip = findClipAtFrame(frameNumber);
+	const TimelineSpan* span = findSpan(frameNumber);
 	
-	if (!clip) {
-		// No clip at this frame, return a NoOp or black frame
+	if (!span) {
+		// Outside the timeline, return a black frame
 		CompositorInstruction instruction;
 		instruction.type = CompositorInstruction::GenerateColor;
 		instruction.color.r = 0.0f;
@@ -68,153 +104,300 @@ CompositorInstruction InstructionGenerator::getInstructionForFrame(int frameNumb
 		return instruction;
 	}
 	
-	auto instruction = createInstruction(*clip, frameNumber);
-	
-	// Look for effect clips on the same track
-	const edl::Clip* effectClip = findEffectClipAtFrame(frameNumber, clip->track.number);
-	if (effectClip) {
-		applyEffectClip(instruction, *effectClip, frameNumber);
+	return createInstruction(*span, frameNumber);
+}
+
+const TimelineSpan* InstructionGenerator::findSpan(int frameNumber) const {
+	const auto& spans = timeline.spans;
+	if (frameNumber < 0 || spans.empty() || frameNumber >= spans.back().endFrame) {
+		return nullptr;
 	}
 	
-	return instruction;
+	// Spans are sorted and contiguous: find the last span starting at or before the frame
+	auto it = std::upper_bound(spans.begin(), spans.end(), frameNumber,
+		[](int frame, const TimelineSpan& span) { return frame < span.startFrame; });
+	if (it == spans.begin()) {
+		return nullptr;
+	}
+	--it;
+	return frameNumber < it->endFrame ? &*it : nullptr;
+}
+
+// ============================================================================
+// Timeline compilation
+// ============================================================================
+
+void InstructionGenerator::compileTimeline() {
+	timeline.fps = edl.fps;
+	timeline.width = edl.width;
+	timeline.height = edl.height;
+	timeline.totalFrames = totalFrames;
+	
+	// Walk the timeline once, starting a new span whenever the clip or
+	// effect clip under the playhead changes
+	const edl::Clip* currentClip = nullptr;
+	const edl::Clip* currentEffect = nullptr;
+	
+	for (int frame = 0; frame < totalFrames; ++frame) {
+		const edl::Clip* clip = findClipAtFrame(frame);
+		const edl::Clip* effectClip = clip ? findEffectClipAtFrame(frame, clip->track.number) : nullptr;
+		
+		if (!timeline.spans.empty() && clip == currentClip && effectClip == currentEffect) {
+			timeline.spans.back().endFrame = frame + 1;
+			continue;
+		}
+		
+		timeline.spans.push_back(makeSpan(clip, effectClip, frame));
+		currentClip = clip;
+		currentEffect = effectClip;
+	}
 }
 
-CompositorInstruction InstructionGenerator::createInstruction(const edl::Clip& clip,
+TimelineSpan InstructionGenerator::makeSpan(const edl::Clip* clip, const edl::Clip* effectClip,
 	int frameNumber) {
 	
-	CompositorInstruction instruction;
-	instruction.trackNumber = clip.track.number;
+	TimelineSpan span;
+	span.startFrame = frameNumber;
+	span.endFrame = frameNumber + 1;
 	
-	// Handle null clips (track alignment)
-	if (clip.isNullClip) {
-		instruction.type = CompositorInstruction::GenerateColor;
-		instruction.color.r = 0.0f;
-		instruction.color.g = 0.0f;
-		instruction.color.b = 0.0f;
-		return instruction;
+	if (!clip) {
+		// No clip at this frame - black
+		span.kind = TimelineSpan::Gap;
+		return span;
 	}
 	
-	// Handle different source types
-	if (clip.source.has_value()) {
-		const auto& source = clip.source.value();
+	span.trackNumber = clip->track.number;
+	span.clipIn = clip->in;
+	span.clipOut = clip->out;
+	
+	if (clip->isNullClip) {
+		// Null clips (track alignment) are black
+		span.kind = TimelineSpan::NullClip;
+	} else {
+		// Check source or sources array (only single element supported)
+		const edl::Source* sourcePtr = nullptr;
+		if (clip->source.has_value()) {
+			sourcePtr = &clip->source.value();
+		} else if (!clip->sources.empty()) {
+			sourcePtr = &clip->sources[0];
+		}
 		
-		if (std::holds_alternative<edl::MediaSource>(source)) {
+		span.kind = TimelineSpan::Other;
+		if (!sourcePtr) {
+			// No source - should not happen with proper validation
+		} else if (std::holds_alternative<edl::MediaSource>(*sourcePtr)) {
 			// Media source - regular video/audio file
-			const auto& mediaSource = std::get<edl::MediaSource>(source);
-			instruction.type = CompositorInstruction::DrawFrame;
-			instruction.uri = mediaSource.uri;
 			// Note: gamma parameter is parsed but not applied as an effect
-		} else if (std::holds_alternative<edl::GenerateSource>(source)) {
+			const auto& mediaSource = std::get<edl::MediaSource>(*sourcePtr);
+			span.kind = TimelineSpan::Media;
+			span.sourceIndex = sourceIndexFor(mediaSource.uri);
+			span.sourceIn = mediaSource.in;
+			// If source has different fps, use it; otherwise use EDL fps
+			span.sourceFps = mediaSource.fps > 0 ? mediaSource.fps : edl.fps;
+		} else if (std::holds_alternative<edl::GenerateSource>(*sourcePtr)) {
 			// Generated source (black, color, test pattern)
-			const auto& genSource = std::get<edl::GenerateSource>(source);
-			if (genSource.type == edl::GenerateSource::Black) {
-				instruction.type = CompositorInstruction::GenerateColor;
-				instruction.color.r = 0.0f;
-				instruction.color.g = 0.0f;
-				instruction.color.b = 0.0f;
-			} else {
+			const auto& genSource = std::get<edl::GenerateSource>(*sourcePtr);
+			if (genSource.type != edl::GenerateSource::Black) {
 				// Other generate types not yet implemented
 				utils::Logger::warn("Unsupported generate type, using black");
-				instruction.type = CompositorInstruction::GenerateColor;
-				instruction.color.r = 0.0f;
-				instruction.color.g = 0.0f;
-				instruction.color.b = 0.0f;
 			}
-		} else if (std::holds_alternative<edl::EffectSource>(source)) {
-			// Effect source - handled separately
-			instruction.type = CompositorInstruction::NoOp;
-			instruction.uri = "";
-		} else if (std::holds_alternative<edl::TransformSource>(source)) {
-			// Transform source - handled as overlay
-			instruction.type = CompositorInstruction::NoOp;
-			instruction.uri = "";
-		} else if (std::holds_alternative<edl::SubtitleSource>(source)) {
+			span.kind = TimelineSpan::Generate;
+		} else if (std::holds_alternative<edl::SubtitleSource>(*sourcePtr)) {
 			// Subtitle - not yet rendered
-			instruction.type = CompositorInstruction::NoOp;
-			instruction.uri = "";
 			utils::Logger::debug("Subtitle rendering not yet implemented");
-		} else {
-			// Unknown source type
-			instruction.type = CompositorInstruction::NoOp;
-			instruction.uri = "";
 		}
-	} else if (!clip.sources.empty()) {
-		// Handle sources array (only single element supported)
-		const auto& source = clip.sources[0];
 		
-		if (std::holds_alternative<edl::MediaSource>(source)) {
-			const auto& mediaSource = std::get<edl::MediaSource>(source);
-			instruction.type = CompositorInstruction::DrawFrame;
-			instruction.uri = mediaSource.uri;
-			// Note: gamma parameter is parsed but not applied as an effect
-		} else if (std::holds_alternative<edl::GenerateSource>(source)) {
-			const auto& genSource = std::get<edl::GenerateSource>(source);
-			if (genSource.type == edl::GenerateSource::Black) {
-				instruction.type = CompositorInstruction::GenerateColor;
-				instruction.color.r = 0.0f;
-				instruction.color.g = 0.0f;
-				instruction.color.b = 0.0f;
+		// Motion parameters
+		span.panX = clip->motion.panX;
+		span.panY = clip->motion.panY;
+		span.zoomX = clip->motion.zoomX;
+		span.zoomY = clip->motion.zoomY;
+		span.rotation = clip->motion.rotation;
+		
+		span.topFade = clip->topFade;
+		span.tailFade = clip->tailFade;
+		
+		// Transition
+		if (clip->transition.has_value() && !clip->transition->type.empty() && clip->transition->duration > 0) {
+			span.transitionDuration = clip->transition->duration;
+			
+			if (clip->transition->type == "dissolve") {
+				span.transitionType = TransitionInfo::Dissolve;
+			} else if (clip->transition->type == "wipe") {
+				span.transitionType = TransitionInfo::Wipe;
+			} else if (clip->transition->type == "slide") {
+				span.transitionType = TransitionInfo::Slide;
 			}
-		} else {
-			instruction.type = CompositorInstruction::NoOp;
-			instruction.uri = "";
 		}
-	} else {
-		// No source - should not happen with proper validation
-		instruction.type = CompositorInstruction::NoOp;
-		instruction.uri = "";
 	}
 	
-	// Calculate source frame number (only for media sources)
-	instruction.sourceFrameNumber = getSourceFrameNumber(clip, frameNumber);
+	if (effectClip) {
+		addEffects(span, *effectClip);
+	}
+	
+	return span;
+}
+
+void InstructionGenerator::addEffects(TimelineSpan& span, const edl::Clip& effectClip) {
+	span.effectOffset = static_cast<int32_t>(timeline.effects.size());
 	
-	// Apply motion parameters
-	instruction.panX = clip.motion.panX;
-	instruction.panY = clip.motion.panY;
-	instruction.zoomX = clip.motion.zoomX;
-	instruction.zoomY = clip.motion.zoomY;
-	instruction.rotation = clip.motion.rotation;
+	// Check source or sources array for EffectSource
+	const edl::Source* sourcePtr = nullptr;
+	if (effectClip.source.has_value()) {
+		sourcePtr = &effectClip.source.value();
+	} else if (!effectClip.sources.empty()) {
+		sourcePtr = &effectClip.sources[0];
+	}
 	
-	// Calculate fade
-	double frameTime = frameToTime(frameNumber);
-	double clipDuration = clip.out - clip.in;
-	double positionInClip = frameTime - clip.in;
+	if (!sourcePtr || !std::holds_alternative<edl::EffectSource>(*sourcePtr)) {
+		return;
+	}
 	
-	instruction.fade = 1.0f;
+	const auto& effectSource = std::get<edl::EffectSource>(*sourcePtr);
 	
-	// Apply top fade
-	if (clip.topFade > 0 && positionInClip < clip.topFade) {
-		instruction.fade = static_cast<float>(positionInClip / clip.topFade);
+	// Handle simple effects with "value" field (brightness, contrast)
+	auto valueIt = effectSource.data.find("value");
+	if (valueIt != effectSource.data.end() && std::holds_alternative<double>(valueIt->second)) {
+		EffectEntry entry;
+		entry.strength = static_cast<float>(std::get<double>(valueIt->second));
+		
+		bool known = true;
+		if (effectSource.type == "brightness") {
+			entry.type = Effect::Brightness;
+		} else if (effectSource.type == "contrast") {
+			entry.type = Effect::Contrast;
+		} else if (effectSource.type == "saturation") {
+			entry.type = Effect::Saturation;
+		} else {
+			known = false;
+			utils::Logger::debug("Unsupported effect type: {}", effectSource.type);
+		}
+		
+		if (known) {
+			timeline.effects.push_back(entry);
+		}
 	}
 	
-	// Apply tail fade
-	double tailStart = clipDuration - clip.tailFade;
-	if (clip.tailFade > 0 && positionInClip > tailStart) {
-		float tailFade = static_cast<float>((clipDuration - positionInClip) / clip.tailFade);
-		instruction.fade = std::min(instruction.fade, tailFade);
+	// Handle filters if present (stored as JSON string in data map)
+	if (effectSource.data.count("filters_json")) {
+		// Filters would need to be parsed from JSON string
+		// For now, log that filters are present but not implemented
+		utils::Logger::debug("Effect has filters which are not yet implemented");
 	}
 	
-	// Handle transition
-	if (clip.transition.has_value() && !clip.transition->type.empty() && clip.transition->duration > 0) {
-		if (positionInClip < clip.transition->duration) {
-			instruction.transition.duration = static_cast<float>(clip.transition->duration);
-			instruction.transition.progress = static_cast<float>(positionInClip / clip.transition->duration);
-			
-			if (clip.transition->type == "dissolve") {
-				instruction.transition.type = TransitionInfo::Dissolve;
-			} else if (clip.transition->type == "wipe") {
-				instruction.transition.type = TransitionInfo::Wipe;
-			} else if (clip.transition->type == "slide") {
-				instruction.transition.type = TransitionInfo::Slide;
-			}
+	// Note: Complex filter processing with linear mappings would go here
+	// For now we support simple value-based effects
+	span.effectCount = static_cast<int32_t>(timeline.effects.size()) - span.effectOffset;
+}
+
+int32_t InstructionGenerator::sourceIndexFor(const std::string& uri) {
+	auto [it, added] = sourceIndices.try_emplace(uri, static_cast<int32_t>(timeline.sources.size()));
+	if (added) {
+		timeline.sources.push_back(uri);
+	}
+	return it->second;
+}
+
+// ============================================================================
+// Per-frame evaluation
+// ============================================================================
+
+CompositorInstruction InstructionGenerator::createInstruction(const TimelineSpan& span,
+	int frameNumber) const {
+	
+	CompositorInstruction instruction;
+	
+	switch (span.kind) {
+		case TimelineSpan::Gap:
+			// No clip at this frame, return a black frame
+			instruction.type = CompositorInstruction::GenerateColor;
+			return instruction;
+		case TimelineSpan::Media:
+			instruction.type = CompositorInstruction::DrawFrame;
+			instruction.uri = timeline.sources[span.sourceIndex];
+			break;
+		case TimelineSpan::NullClip:
+		case TimelineSpan::Generate:
+			instruction.type = CompositorInstruction::GenerateColor;
+			instruction.color.r = 0.0f;
+			instruction.color.g = 0.0f;
+			instruction.color.b = 0.0f;
+			break;
+		default:
+			// Effect, transform and subtitle sources are handled separately
+			instruction.type = CompositorInstruction::NoOp;
+			break;
+	}
+	
+	instruction.trackNumber = span.trackNumber;
+	
+	if (span.kind != TimelineSpan::NullClip) {
+		// Calculate source frame number (only for media sources)
+		instruction.sourceFrameNumber = getSourceFrameNumber(span, frameNumber);
+		
+		// Apply motion parameters
+		instruction.panX = span.panX;
+		instruction.panY = span.panY;
+		instruction.zoomX = span.zoomX;
+		instruction.zoomY = span.zoomY;
+		instruction.rotation = span.rotation;
+		
+		// Calculate fade
+		double frameTime = frameToTime(frameNumber);
+		double clipDuration = span.clipOut - span.clipIn;
+		double positionInClip = frameTime - span.clipIn;
+		
+		instruction.fade = 1.0f;
+		
+		// Apply top fade
+		if (span.topFade > 0 && positionInClip < span.topFade) {
+			instruction.fade = static_cast<float>(positionInClip / span.topFade);
+		}
+		
+		// Apply tail fade
+		double tailStart = clipDuration - span.tailFade;
+		if (span.tailFade > 0 && positionInClip > tailStart) {
+			float tailFade = static_cast<float>((clipDuration - positionInClip) / span.tailFade);
+			instruction.fade = std::min(instruction.fade, tailFade);
+		}
+		
+		// Handle transition
+		if (span.transitionDuration > 0 && positionInClip < span.transitionDuration) {
+			instruction.transition.type = static_cast<TransitionInfo::Type>(span.transitionType);
+			instruction.transition.duration = static_cast<float>(span.transitionDuration);
+			instruction.transition.progress = static_cast<float>(positionInClip / span.transitionDuration);
 		}
 	}
 	
-
+	// Effects from the effect clip on the same track
+	for (int32_t i = 0; i < span.effectCount; ++i) {
+		const EffectEntry& entry = timeline.effects[span.effectOffset + i];
+		Effect effect;
+		effect.type = static_cast<Effect::Type>(entry.type);
+		effect.strength = entry.strength;
+		instruction.effects.push_back(effect);
+	}
 	
 	return instruction;
 }
 
+int64_t InstructionGenerator::getSourceFrameNumber(const TimelineSpan& span,
+	int timelineFrame) const {
+	
+	if (span.kind == TimelineSpan::Media) {
+		// Calculate source time from the position within the clip
+		double positionInClip = frameToTime(timelineFrame) - span.clipIn;
+		double sourceTime = span.sourceIn + positionInClip;
+		// Convert to source frame number
+		return static_cast<int64_t>(sourceTime * span.sourceFps);
+	} else if (span.kind == TimelineSpan::Generate) {
+		// Generated sources use timeline frame directly
+		return timelineFrame;
+	}
+	
+	return 0;  // Effect sources and others don't have frame numbers
+}
+
 const edl::Clip* InstructionGenerator::findClipAtFrame(int frameNumber,
 	int trackNumber) const {
 	
@@ -226,9 +409,22 @@ const edl::Clip* InstructionGenerator::findClipAtFrame(int frameNumber,
 		std::string trackKey = "video_" + std::to_string(trackNumber);
 		auto it = edl.tracks.find(trackKey);
 		if (it != edl.tracks.end()) {
-			for (const auto& clip : it->second) {
-				if (frameTime >= clip.in && frameTime < clip.out) {
-					return &clip;
+			// Track clips are sorted and non-overlapping, and lookups are
+			// mostly sequential, so resume from the last hit
+			const auto& clips = it->second;
+			for (size_t i = std::min(clipCursor, clips.size()); i < clips.size(); ++i) {
+				if (frameTime >= clips[i].in && frameTime < clips[i].out) {
+					clipCursor = i;
+					return &clips[i];
+				}
+				if (clips[i].in > frameTime) {
+					break;
+				}
+			}
+			for (size_t i = 0; i < std::min(clipCursor, clips.size()); ++i) {
+				if (frameTime >= clips[i].in && frameTime < clips[i].out) {
+					clipCursor = i;
+					return &clips[i];
 				}
 			}
 		}
@@ -248,42 +444,6 @@ const edl::Clip* InstructionGenerator::findClipAtFrame(int frameNumber,
 	return nullptr;
 }
 
-int64_t InstructionGenerator::getSourceFrameNumber(const edl::Clip& clip,
-	int timelineFrame) const {
-	
-	// Convert timeline frame to time
-	double timelineTime = frameToTime(timelineFrame);
-	
-	// Calculate position within the clip
-	double positionInClip = timelineTime - clip.in;
-	
-	// Check source or sources array
-	const edl::Source* sourcePtr = nullptr;
-	if (clip.source.has_value()) {
-		sourcePtr = &clip.source.value();
-	} else if (!clip.sources.empty()) {
-		sourcePtr = &clip.sources[0];
-	}
-	
-	if (sourcePtr) {
-		// Check if source is a MediaSource (only media sources have frame numbers)
-		if (std::holds_alternative<edl::MediaSource>(*sourcePtr)) {
-			const auto& mediaSource = std::get<edl::MediaSource>(*sourcePtr);
-			// Calculate source time
-			double sourceTime = mediaSource.in + positionInClip;
-			// Convert to source frame number
-			// If source has different fps, use it; otherwise use EDL fps
-			int sourceFps = mediaSource.fps > 0 ? mediaSource.fps : edl.fps;
-			return static_cast<int64_t>(sourceTime * sourceFps);
-		} else if (std::holds_alternative<edl::GenerateSource>(*sourcePtr)) {
-			// Generated sources use timeline frame directly
-			return timelineFrame;
-		}
-	}
-	
-	return 0;  // Effect sources and others don't have frame numbers
-}
-
 double InstructionGenerator::frameToTime(int frameNumber) const {
 	return frameNumber * frameDuration;
 }
@@ -297,69 +457,28 @@ const edl::Clip* InstructionGenerator::findEffectClipAtFrame(int frameNumber,
 	
 	double frameTime = frameToTime(frameNumber);
 	
-	for (const auto& clip : edl.clips) {
-		if (clip.track.type == edl::Track::Video &&
-			clip.track.number == trackNumber &&
-			clip.track.subtype == "effects" &&
-			frameTime >= clip.in &&
-			frameTime < clip.out) {
-			return &clip;
+	// Where effect clips overlap, on one effects track or across tracks, the
+	// clip first in the EDL wins
+	const edl::Clip* found = nullptr;
+	for (const auto& track : effectTracks) {
+		const auto& clips = track.clips;
+		if (clips.front()->track.number != trackNumber) {
+			continue;
 		}
-	}
-	
-	return nullptr;
-}
-
-void InstructionGenerator::applyEffectClip(CompositorInstruction& instruction,
-	const edl::Clip& effectClip, int frameNumber) {
-	
-	// Check source or sources array for EffectSource
-	const edl::Source* sourcePtr = nullptr;
-	if (effectClip.source.has_value()) {
-		sourcePtr = &effectClip.source.value();
-	} else if (!effectClip.sources.empty()) {
-		sourcePtr = &effectClip.sources[0];
-	}
-	
-	if (!sourcePtr || !std::holds_alternative<edl::EffectSource>(*sourcePtr)) {
-		return;
-	}
-	
-	const auto& effectSource = std::get<edl::EffectSource>(*sourcePtr);
-	double frameTime = frameToTime(frameNumber);
-	[[maybe_unused]] double timeInClip = frameTime - effectClip.in;
-	
-	// Handle simple effects with "value" field (brightness, contrast)
-	auto valueIt = effectSource.data.find("value");
-	if (valueIt != effectSource.data.end()) {
-		if (std::holds_alternative<double>(valueIt->second)) {
-			double value = std::get<double>(valueIt->second);
-			
-			Effect effect;
-			if (effectSource.type == "brightness") {
-				effect.type = Effect::Brightness;
-				effect.strength = static_cast<float>(value);
-			} else if (effectSource.type == "contrast") {
-				effect.type = Effect::Contrast;
-				effect.strength = static_cast<float>(value);
-			} else if (effectSource.type == "saturation") {
-				effect.type = Effect::Saturation;
-				effect.strength = static_cast<float>(value);
+		
+		// Clips starting after the frame cannot cover it; of the others, walk
+		// back only while an earlier clip may still reach past the frame
+		size_t end = std::upper_bound(clips.begin(), clips.end(), frameTime,
+			[](double time, const edl::Clip* clip) { return time < clip->in; }) - clips.begin();
+		for (size_t i = end; i > 0 && frameTime < track.maxOut[i - 1]; i--) {
+			const edl::Clip* clip = clips[i - 1];
+			if (frameTime < clip->out && (!found || clip < found)) {
+				found = clip;
 			}
-			instruction.effects.push_back(effect);
 		}
 	}
 	
-	// Handle filters if present (stored as JSON string in data map)
-	auto filtersIt = effectSource.data.find("filters_json");
-	if (filtersIt != effectSource.data.end()) {
-		// Filters would need to be parsed from JSON string
-		// For now, log that filters are present but not implemented
-		utils::Logger::debug("Effect has filters which are not yet implemented");
-	}
-	
-	// Note: Complex filter processing with linear mappings would go here
-	// For now we support simple value-based effects
+	return found;
 }
 
 // Filter interpolation not yet implemented
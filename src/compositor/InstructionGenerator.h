@@ -1,8 +1,11 @@
 #pragma once
 
 #include "compositor/CompositorInstruction.h"
+#include "compositor/TimelineSpan.h"
 #include "edl/EDLTypes.h"
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace compositor {
@@ -10,42 +13,65 @@ namespace compositor {
 class InstructionGenerator {
 public:
 	InstructionGenerator(const edl::EDL& edl);
-	
+
+	// Build from an already compiled timeline (e.g. a cached render plan)
+	explicit InstructionGenerator(CompiledTimeline timeline);
+
 	// Iterator for lazy evaluation
 	class Iterator {
 	public:
 		Iterator(InstructionGenerator* generator, int frameNumber);
-		
+
 		CompositorInstruction operator*() const;
 		Iterator& operator++();
 		bool operator!=(const Iterator& other) const;
-		
+
 	private:
 		InstructionGenerator* generator;
 		int frameNumber;
 		mutable CompositorInstruction current;
 		mutable bool currentValid = false;
 	};
-	
+
 	Iterator begin();
 	Iterator end();
-	
+
 	// Direct access
 	CompositorInstruction getInstructionForFrame(int frameNumber);
-	
+
 	int getTotalFrames() const { return totalFrames; }
-	
+
+	// Resolved timeline (spans, effect table, referenced media URIs)
+	const CompiledTimeline& getTimeline() const { return timeline; }
+
+	// Span covering a frame, or nullptr if out of range
+	const TimelineSpan* findSpan(int frameNumber) const;
+
 private:
 	double frameToTime(int frameNumber) const;
 	int timeToFrame(double time) const;
-	int64_t getSourceFrameNumber(const edl::Clip& clip, int timelineFrame) const;
-	CompositorInstruction createInstruction(const edl::Clip& clip, int frameNumber);
+	void compileTimeline();
+	TimelineSpan makeSpan(const edl::Clip* clip, const edl::Clip* effectClip, int frameNumber);
+	void addEffects(TimelineSpan& span, const edl::Clip& effectClip);
+	int32_t sourceIndexFor(const std::string& uri);
+	CompositorInstruction createInstruction(const TimelineSpan& span, int frameNumber) const;
+	int64_t getSourceFrameNumber(const TimelineSpan& span, int timelineFrame) const;
 	const edl::Clip* findClipAtFrame(int frameNumber, int trackNumber = 1) const;
 	const edl::Clip* findEffectClipAtFrame(int frameNumber, int trackNumber = 1) const;
-	void applyEffectClip(CompositorInstruction& instruction, const edl::Clip& effectClip, int frameNumber);
 	// std::vector<LinearMapping> interpolateLinearMapping(const edl::Filter& filter, double timeInClip);
-	
+
 	edl::EDL edl;
+	CompiledTimeline timeline;
+	// Effect clips of one effects track sorted by in point, with the latest
+	// out point of each prefix, so overlapping clips are found too
+	struct EffectTrack {
+		std::vector<const edl::Clip*> clips;
+		std::vector<double> maxOut;
+	};
+	
+	std::vector<EffectTrack> effectTracks;                    // Per effects track
+	std::unordered_map<std::string, int32_t> sourceIndices;   // Index of each URI in timeline.sources
+	mutable size_t clipCursor = 0;                            // Last track clip hit, for sequential lookups
 	int totalFrames;
 	double frameDuration;  // Duration of one frame in seconds
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace compositor {
+
+/**
+ * A run of consecutive output frames that resolve to the same clip (and the
+ * same effect clip). Everything needed to rebuild a CompositorInstruction for
+ * any frame in the run is stored here, so the timeline can be evaluated
+ * without the EDL and serialized as-is into a render plan.
+ *
+ * Must stay trivially copyable: spans are written to and mapped from disk.
+ */
+struct TimelineSpan {
+	enum Kind : int32_t {
+		Gap,        // No clip on the timeline (black)
+		NullClip,   // Alignment null clip (black)
+		Media,      // Frame from a media source
+		Generate,   // Generated source (black)
+		Other       // Effect/transform/subtitle source (NoOp)
+	};
+
+	int32_t startFrame = 0;     // First output frame (inclusive)
+	int32_t endFrame = 0;       // Last output frame (exclusive)
+	int32_t kind = Gap;
+	int32_t trackNumber = 0;
+	int32_t sourceIndex = -1;   // Index into CompiledTimeline::sources (Media only)
+	int32_t sourceFps = 0;      // Source frame rate used for frame mapping
+	int32_t effectOffset = 0;   // First entry in CompiledTimeline::effects
+	int32_t effectCount = 0;
+
+	double clipIn = 0.0;        // Timeline in/out of the clip (seconds)
+	double clipOut = 0.0;
+	double sourceIn = 0.0;      // Media source in point (seconds)
+
+	float topFade = 0.0f;
+	float tailFade = 0.0f;
+	float panX = 0.0f;
+	float panY = 0.0f;
+	float zoomX = 1.0f;
+	float zoomY = 1.0f;
+	float rotation = 0.0f;
+	int32_t transitionType = 0; // TransitionInfo::Type
+	double transitionDuration = 0.0;
+};
+
+// Effect resolved from an effect clip, referenced by TimelineSpan::effectOffset
+struct EffectEntry {
+	int32_t type = 0;           // Effect::Type
+	float strength = 1.0f;
+};
+
+static_assert(std::is_trivially_copyable_v<TimelineSpan>, "TimelineSpan is serialized as raw bytes");
+static_assert(std::is_trivially_copyable_v<EffectEntry>, "EffectEntry is serialized as raw bytes");
+
+/**
+ * Fully resolved timeline: the output of InstructionGenerator's compile pass
+ * and the payload of a cached render plan.
+ */
+struct CompiledTimeline {
+	int fps = 30;
+	int width = 1920;
+	int height = 1080;
+	int totalFrames = 0;
+
+	std::vector<TimelineSpan> spans;    // Sorted, contiguous, covering [0, totalFrames)
+	std::vector<EffectEntry> effects;
+	std::vector<std::string> sources;   // Media URIs referenced by spans
+};
+
+} // namespace compositor
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <limits>
 
 namespace edl {
 
@@ -392,6 +393,18 @@ ShapeControlPoint EDLParser::parseShapeControlPoint(const nlohmann::json& j) {
 	getIfExists(j, "zoomy", cp.zoomy);
 	getIfExists(j, "rotate", cp.rotate);
 	getIfExists(j, "shape", cp.shape);
+	getIfExists(j, "pan", cp.pan);
+	
+	// Level is a number or the string "-Infinity" (silence)
+	if (hasNonNullKey(j, "db")) {
+		if (j["db"].is_number()) {
+			cp.db = j["db"].get<float>();
+		} else if (j["db"].is_string() && j["db"].get<std::string>() == "-Infinity") {
+			cp.db = -std::numeric_limits<float>::infinity();
+		} else {
+			throw InvalidEdlException("Control point db must be a number or \"-Infinity\"");
+		}
+	}
 	
 	return cp;
 }
@@ -622,11 +635,8 @@ void EDLParser::alignTracksWithNullClips(EDL& edl) {
 		
 		auto& track = edl.tracks[trackKey];
 		
-		// Calculate current track duration
-		double trackDuration = 0.0;
-		for (const auto& existingClip : track) {
-			trackDuration = existingClip.out; // Last clip's out point
-		}
+		// Current track duration is the last clip's out point
+		double trackDuration = track.empty() ? 0.0 : track.back().out;
 		
 		// Add null clip if there's a gap
 		if (trackDuration < clip.in) {
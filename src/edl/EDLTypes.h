@@ -66,6 +66,10 @@ struct ShapeControlPoint {
 	float zoomy = 1.0f;      // Zoom Y factor
 	float rotate = 0.0f;     // Rotation in degrees
 	float shape = 1.0f;      // Shape parameter (1 = rectangle)
+	
+	// Audio level/pan tracks
+	float db = 0.0f;         // Volume in decibels (-infinity = silence)
+	float pan = 0.0f;        // Pan position (-1 = left, 1 = right)
 };
 
 // Media source (from file/URI)
@@ -0,0 +1,280 @@
+#include "ipc/ExternalCompositor.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace ipc {
+
+namespace {
+
+// Row alignment of planes packed into a slot
+constexpr int PLANE_ALIGNMENT = 64;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// Packed row size and row count of each plane; returns the plane count
+int planeLayout(AVPixelFormat format, int width, int height, int linesize[4], int rows[4]) {
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+	int planes = av_pix_fmt_count_planes(format);
+	if (!desc || planes <= 0) {
+		return 0;
+	}
+	for (int plane = 0; plane < planes; plane++) {
+		linesize[plane] = static_cast<int>(alignUp(av_image_get_linesize(format, width, plane), PLANE_ALIGNMENT));
+		bool chroma = plane == 1 || plane == 2;
+		rows[plane] = chroma ? -((-height) >> desc->log2_chroma_h) : height;
+	}
+	return planes;
+}
+
+const char* transitionName(compositor::TransitionInfo::Type type) {
+	switch (type) {
+		case compositor::TransitionInfo::Dissolve: return "dissolve";
+		case compositor::TransitionInfo::Wipe: return "wipe";
+		case compositor::TransitionInfo::Slide: return "slide";
+		default: return "none";
+	}
+}
+
+const char* effectName(compositor::Effect::Type type) {
+	switch (type) {
+		case compositor::Effect::Brightness: return "brightness";
+		case compositor::Effect::Contrast: return "contrast";
+		case compositor::Effect::Saturation: return "saturation";
+		case compositor::Effect::Blur: return "blur";
+		case compositor::Effect::Sharpen: return "sharpen";
+		default: return "unknown";
+	}
+}
+
+// "0xYYUUVV" with the conversion FrameCompositor uses for colour frames
+std::string yuvHex(float r, float g, float b) {
+	r = std::clamp(r, 0.0f, 1.0f);
+	g = std::clamp(g, 0.0f, 1.0f);
+	b = std::clamp(b, 0.0f, 1.0f);
+	int y = std::clamp(static_cast<int>(0.299f * r * 255 + 0.587f * g * 255 + 0.114f * b * 255), 0, 255);
+	int u = std::clamp(static_cast<int>(-0.147f * r * 255 - 0.289f * g * 255 + 0.436f * b * 255 + 128), 0, 255);
+	int v = std::clamp(static_cast<int>(0.615f * r * 255 - 0.515f * g * 255 - 0.100f * b * 255 + 128), 0, 255);
+	char hex[16];
+	std::snprintf(hex, sizeof(hex), "0x%02x%02x%02x", y, u, v);
+	return hex;
+}
+
+}
+
+ExternalCompositor::ExternalCompositor(const Config& config)
+	: config(config)
+	, returnPool(config.width, config.height, AV_PIX_FMT_YUV420P, config.slotCount + 2) {
+	
+	// Room for the parameters next to the largest layer
+	SharedFrameRing::Config exportConfig;
+	exportConfig.slotCount = config.slotCount;
+	exportConfig.slotBytes = 64 * 1024 + std::max(config.maxLayerBytes,
+		layerBytes(config.width, config.height, AV_PIX_FMT_YUV420P));
+	exportRing = std::make_unique<SharedFrameRing>(config.exportName, exportConfig);
+	
+	if (!config.returnName.empty()) {
+		SharedFrameRing::Config returnConfig;
+		returnConfig.slotCount = config.slotCount;
+		returnConfig.slotBytes = layerBytes(config.width, config.height, AV_PIX_FMT_YUV420P);
+		returnRing = std::make_unique<SharedFrameRing>(config.returnName, returnConfig);
+	}
+	
+	utils::Logger::info("External compositor rings: {} ({} slots of {} bytes){}", config.exportName,
+		exportConfig.slotCount, exportConfig.slotBytes,
+		returnRing ? ", composited frames from " + config.returnName : std::string());
+}
+
+ExternalCompositor::~ExternalCompositor() {
+	close();
+}
+
+uint64_t ExternalCompositor::layerBytes(int width, int height, AVPixelFormat format) {
+	int linesize[4] = {};
+	int rows[4] = {};
+	int planes = planeLayout(format, width, height, linesize, rows);
+	uint64_t bytes = 0;
+	for (int plane = 0; plane < planes; plane++) {
+		bytes += static_cast<uint64_t>(linesize[plane]) * rows[plane];
+	}
+	return bytes;
+}
+
+std::string ExternalCompositor::layerParameters(const compositor::CompositorInstruction& instruction,
+	const AVFrame* layer) {
+	
+	nlohmann::json params;
+	params["track"] = instruction.trackNumber + 1;
+	
+	if (layer) {
+		params["type"] = "yuv";
+		params["width"] = layer->width;
+		params["height"] = layer->height;
+		params["format"] = av_get_pix_fmt_name(static_cast<AVPixelFormat>(layer->format));
+	} else {
+		params["type"] = "generated";
+		params["generate"] = {
+			{"type", "colour"},
+			{"yuv", yuvHex(instruction.color.r, instruction.color.g, instruction.color.b)}
+		};
+	}
+	params["alpha"] = false;
+	
+	params["panx"] = instruction.panX;
+	params["pany"] = instruction.panY;
+	params["zoomx"] = instruction.zoomX;
+	params["zoomy"] = instruction.zoomY;
+	params["rotate"] = instruction.rotation;
+	params["flip"] = instruction.flip;
+	params["fade"] = instruction.fade;
+	
+	if (!instruction.effects.empty()) {
+		nlohmann::json effects = nlohmann::json::array();
+		for (const auto& effect : instruction.effects) {
+			nlohmann::json entry = {{"type", effectName(effect.type)}, {"strength", effect.strength}};
+			if (!effect.parameters.empty()) {
+				entry["parameters"] = effect.parameters;
+			}
+			if (effect.useLinearMapping) {
+				nlohmann::json mapping = nlohmann::json::array();
+				for (const auto& point : effect.linearMapping) {
+					mapping.push_back({{"src", point.src}, {"dst", point.dst}});
+				}
+				entry["linear"] = mapping;
+			}
+			effects.push_back(entry);
+		}
+		params["imageEffects"] = effects;
+	}
+	
+	if (instruction.transition.type != compositor::TransitionInfo::None) {
+		params["transition"] = {
+			{"type", transitionName(instruction.transition.type)},
+			{"duration", instruction.transition.duration}
+		};
+		params["transitionProgress"] = instruction.transition.progress;
+	}
+	
+	return nlohmann::json::array({params}).dump();
+}
+
+bool ExternalCompositor::exportFrame(int64_t frameNumber, const compositor::CompositorInstruction& instruction,
+	const AVFrame* layer) {
+	
+	SharedFrameRing::Slot slot;
+	if (!exportRing->acquireWrite(slot, config.timeoutMs)) {
+		utils::Logger::error("External compositor did not take frame {} within {} ms", frameNumber,
+			config.timeoutMs);
+		return false;
+	}
+	
+	std::string params = layerParameters(instruction, layer);
+	SharedFrameRing::SlotHeader& header = *slot.header;
+	header.frameNumber = frameNumber;
+	header.layerCount = 0;
+	header.paramsBytes = static_cast<uint32_t>(params.size());
+	uint64_t offset = alignUp(params.size(), PLANE_ALIGNMENT);
+	if (offset > slot.capacity) {
+		utils::Logger::error("Frame {} parameters do not fit the export slot", frameNumber);
+		return false;
+	}
+	
+	// Pack the planes behind the parameters, rows aligned for the reader
+	if (layer) {
+		AVPixelFormat format = static_cast<AVPixelFormat>(layer->format);
+		SharedFrameRing::Layer& desc = header.layers[0];
+		int rows[4] = {};
+		desc.width = layer->width;
+		desc.height = layer->height;
+		desc.format = layer->format;
+		desc.planeCount = planeLayout(format, layer->width, layer->height, desc.linesize, rows);
+		
+		// The slot is left unpublished, so the next frame reuses it
+		uint64_t needed = offset + layerBytes(layer->width, layer->height, format);
+		if (desc.planeCount == 0 || needed > slot.capacity) {
+			utils::Logger::error("Frame {} layer ({}x{}) does not fit the export slot", frameNumber,
+				layer->width, layer->height);
+			return false;
+		}
+		
+		for (int plane = 0; plane < desc.planeCount; plane++) {
+			desc.offset[plane] = offset;
+			av_image_copy_plane(slot.payload + offset, desc.linesize[plane], layer->data[plane],
+				layer->linesize[plane], av_image_get_linesize(format, layer->width, plane), rows[plane]);
+			offset += static_cast<uint64_t>(desc.linesize[plane]) * rows[plane];
+		}
+		header.layerCount = 1;
+	}
+	
+	std::memcpy(slot.payload, params.data(), params.size());
+	header.payloadBytes = offset;
+	exportRing->commitWrite();
+	exportedFrames++;
+	return true;
+}
+
+std::shared_ptr<AVFrame> ExternalCompositor::receiveFrame(int64_t frameNumber) {
+	if (!returnRing) {
+		return nullptr;
+	}
+	
+	SharedFrameRing::Slot slot;
+	if (!returnRing->acquireRead(slot, config.timeoutMs)) {
+		utils::Logger::error("External compositor did not return frame {} within {} ms", frameNumber,
+			config.timeoutMs);
+		return nullptr;
+	}
+	
+	const SharedFrameRing::SlotHeader& header = *slot.header;
+	const SharedFrameRing::Layer& desc = header.layers[0];
+	if (header.frameNumber != frameNumber || header.layerCount < 1 || desc.width != config.width ||
+		desc.height != config.height || desc.format != AV_PIX_FMT_YUV420P || desc.planeCount != 3) {
+		utils::Logger::error("External compositor returned frame {} ({}x{}), expected frame {}",
+			header.frameNumber, desc.width, desc.height, frameNumber);
+		returnRing->releaseRead();
+		return nullptr;
+	}
+	
+	// The planes must lie inside the slot
+	int packed[4] = {};
+	int rows[4] = {};
+	planeLayout(AV_PIX_FMT_YUV420P, config.width, config.height, packed, rows);
+	const uint8_t* planes[4] = {};
+	int linesizes[4] = {};
+	for (int plane = 0; plane < desc.planeCount; plane++) {
+		int rowBytes = av_image_get_linesize(AV_PIX_FMT_YUV420P, config.width, plane);
+		// Checked so that an untrusted offset cannot wrap the sum around
+		if (desc.linesize[plane] < rowBytes || desc.offset[plane] > slot.capacity ||
+			static_cast<uint64_t>(desc.linesize[plane]) * rows[plane] > slot.capacity - desc.offset[plane]) {
+			utils::Logger::error("External compositor returned frame {} with an invalid layout", frameNumber);
+			returnRing->releaseRead();
+			return nullptr;
+		}
+		planes[plane] = slot.payload + desc.offset[plane];
+		linesizes[plane] = desc.linesize[plane];
+	}
+	
+	// Copied out so the slot can be reused while the encoder holds the frame
+	auto frame = returnPool.getFrame();
+	av_image_copy(frame->data, frame->linesize, planes, linesizes, AV_PIX_FMT_YUV420P,
+		config.width, config.height);
+	returnRing->releaseRead();
+	return frame;
+}
+
+void ExternalCompositor::close() {
+	if (exportRing) {
+		exportRing->close();
+	}
+}
+
+} // namespace ipc
\ No newline at end of file
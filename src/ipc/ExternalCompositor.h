@@ -0,0 +1,79 @@
+#pragma once
+
+#include "compositor/CompositorInstruction.h"
+#include "ipc/SharedFrameRing.h"
+#include "media/MediaTypes.h"
+#include "utils/FrameBuffer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ipc {
+
+/**
+ * Hands the decoded layers of each output frame to an external compositor
+ * through shared memory, and optionally takes the composited frame back.
+ *
+ * Each exported slot carries the layer images (planes packed into the slot)
+ * and a JSON array with one IExportImageParameters object per layer, as
+ * described in docs/EXTERNAL-COMPOSITOR-FORMAT.md. The compositor answers on
+ * the return ring with one YUV 4:2:0 layer of the output size and the same
+ * frame number.
+ */
+class ExternalCompositor {
+public:
+	struct Config {
+		std::string exportName;         // Ring for layers and parameters
+		std::string returnName;         // Ring for composited frames (none if empty)
+		int width = 1920;               // Output frame size
+		int height = 1080;
+		uint64_t maxLayerBytes = 0;     // Largest layer image; sizes the export slots
+		uint32_t slotCount = 4;
+		int timeoutMs = 10000;          // Longest wait for the compositor
+	};
+	
+	/**
+	 * Create the rings; the external compositor attaches to them by name
+	 * @throws std::runtime_error if shared memory cannot be created
+	 */
+	explicit ExternalCompositor(const Config& config);
+	~ExternalCompositor();
+	
+	ExternalCompositor(const ExternalCompositor&) = delete;
+	ExternalCompositor& operator=(const ExternalCompositor&) = delete;
+	
+	/**
+	 * Publish one output frame
+	 * @param layer Decoded source frame, or nullptr for generated content
+	 * @return false if the compositor did not free a slot in time
+	 */
+	bool exportFrame(int64_t frameNumber, const compositor::CompositorInstruction& instruction,
+		const AVFrame* layer);
+	
+	/**
+	 * Wait for the composited frame
+	 * @return nullptr on timeout or if the compositor answered out of order
+	 */
+	std::shared_ptr<AVFrame> receiveFrame(int64_t frameNumber);
+	
+	bool hasReturn() const { return returnRing != nullptr; }
+	
+	// Tell the compositor no more frames follow
+	void close();
+	
+	// IExportImageParameters array for an instruction (exposed for tests)
+	static std::string layerParameters(const compositor::CompositorInstruction& instruction,
+		const AVFrame* layer);
+	
+	// Slot payload needed for a layer of the given size
+	static uint64_t layerBytes(int width, int height, AVPixelFormat format);
+
+private:
+	Config config;
+	std::unique_ptr<SharedFrameRing> exportRing;
+	std::unique_ptr<SharedFrameRing> returnRing;
+	utils::FrameBufferPool returnPool;
+	int64_t exportedFrames = 0;
+};
+
+} // namespace ipc
\ No newline at end of file
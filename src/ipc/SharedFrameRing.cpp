@@ -0,0 +1,289 @@
+#include "ipc/SharedFrameRing.h"
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ipc {
+
+namespace {
+
+constexpr uint32_t RING_MAGIC = 0x45444c52;  // "EDLR"
+constexpr uint32_t RING_VERSION = 1;
+constexpr uint64_t SLOT_ALIGNMENT = 4096;
+
+// Spins before the waiting side starts sleeping, and the sleep step
+constexpr int SPIN_COUNT = 256;
+constexpr auto SLEEP_STEP = std::chrono::microseconds(50);
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+// Start of the shared memory object; the counters sit on their own cache
+// lines so the two sides do not invalidate each other's
+struct SharedFrameRing::SharedHeader {
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t reserved;
+	uint64_t slotBytes;
+	uint64_t slotStride;
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+	alignas(64) std::atomic<uint32_t> closed;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Frame ring needs lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Frame ring needs lock-free 32-bit atomics");
+
+#ifdef _WIN32
+
+SharedFrameRing::SharedFrameRing(const std::string& name, const Config&) : name(name) {
+	throw std::runtime_error("Shared frame rings are not supported on this platform");
+}
+
+SharedFrameRing::SharedFrameRing(const std::string& name) : name(name) {
+	throw std::runtime_error("Shared frame rings are not supported on this platform");
+}
+
+SharedFrameRing::~SharedFrameRing() = default;
+
+void SharedFrameRing::map(size_t) {}
+
+#else
+
+SharedFrameRing::SharedFrameRing(const std::string& name, const Config& config)
+	: name(name)
+	, owner(true)
+	, slotCount(config.slotCount)
+	, slotBytes(config.slotBytes) {
+	
+	if (slotCount == 0 || slotBytes == 0) {
+		throw std::invalid_argument("Frame ring needs at least one slot of non-zero size");
+	}
+	
+	// Slots start on page boundaries, payloads on cache lines
+	slotStride = alignUp(alignUp(sizeof(SlotHeader), 64) + slotBytes, SLOT_ALIGNMENT);
+	size_t size = alignUp(sizeof(SharedHeader), SLOT_ALIGNMENT) + slotStride * slotCount;
+	
+	fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 && errno == EEXIST) {
+		// Left behind by a process that did not exit cleanly
+		shm_unlink(name.c_str());
+		fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	}
+	if (fd < 0) {
+		throw std::runtime_error("Failed to create shared memory " + name);
+	}
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		::close(fd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Failed to size shared memory " + name);
+	}
+	
+	try {
+		map(size);
+	} catch (...) {
+		::close(fd);
+		shm_unlink(name.c_str());
+		throw;
+	}
+	
+	shared = new (base) SharedHeader();
+	shared->version = RING_VERSION;
+	shared->slotCount = slotCount;
+	shared->slotBytes = slotBytes;
+	shared->slotStride = slotStride;
+	shared->head.store(0, std::memory_order_relaxed);
+	shared->tail.store(0, std::memory_order_relaxed);
+	shared->closed.store(0, std::memory_order_relaxed);
+	
+	// Published last: an attaching process sees a complete header
+	shared->magic.store(RING_MAGIC, std::memory_order_release);
+}
+
+SharedFrameRing::SharedFrameRing(const std::string& name)
+	: name(name) {
+	
+	fd = shm_open(name.c_str(), O_RDWR, 0600);
+	if (fd < 0) {
+		throw std::runtime_error("Shared memory " + name + " does not exist");
+	}
+	
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SharedHeader)) {
+		::close(fd);
+		throw std::runtime_error("Shared memory " + name + " is not a frame ring");
+	}
+	
+	try {
+		map(static_cast<size_t>(info.st_size));
+	} catch (...) {
+		::close(fd);
+		throw;
+	}
+	
+	shared = reinterpret_cast<SharedHeader*>(base);
+	if (shared->magic.load(std::memory_order_acquire) != RING_MAGIC || shared->version != RING_VERSION) {
+		munmap(base, mappedBytes);
+		::close(fd);
+		throw std::runtime_error("Shared memory " + name + " is not a frame ring");
+	}
+	
+	slotCount = shared->slotCount;
+	slotBytes = shared->slotBytes;
+	slotStride = shared->slotStride;
+	if (slotCount == 0 || slotBytes > mappedBytes || slotStride < alignUp(sizeof(SlotHeader), 64) + slotBytes) {
+		munmap(base, mappedBytes);
+		::close(fd);
+		throw std::runtime_error("Shared memory " + name + " has an invalid slot layout");
+	}
+	size_t headerBytes = alignUp(sizeof(SharedHeader), SLOT_ALIGNMENT);
+	if (headerBytes > mappedBytes || slotCount > (mappedBytes - headerBytes) / slotStride) {
+		munmap(base, mappedBytes);
+		::close(fd);
+		throw std::runtime_error("Shared memory " + name + " is truncated");
+	}
+}
+
+SharedFrameRing::~SharedFrameRing() {
+	if (shared && owner) {
+		close();
+	}
+	if (base) {
+		munmap(base, mappedBytes);
+	}
+	if (fd >= 0) {
+		::close(fd);
+	}
+	if (owner) {
+		shm_unlink(name.c_str());
+	}
+}
+
+void SharedFrameRing::map(size_t size) {
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		throw std::runtime_error("Failed to map shared memory " + name);
+	}
+	base = static_cast<uint8_t*>(address);
+	mappedBytes = size;
+}
+
+#endif
+
+SharedFrameRing::Slot SharedFrameRing::slotAt(uint64_t index) const {
+	uint8_t* start = base + alignUp(sizeof(SharedHeader), SLOT_ALIGNMENT) + (index % slotCount) * slotStride;
+	Slot slot;
+	slot.header = reinterpret_cast<SlotHeader*>(start);
+	slot.payload = start + alignUp(sizeof(SlotHeader), 64);
+	slot.capacity = slotBytes;
+	return slot;
+}
+
+bool SharedFrameRing::acquireWrite(Slot& slot, int timeoutMs) {
+	if (!started) {
+		position = shared->head.load(std::memory_order_relaxed);
+		cachedLimit = shared->tail.load(std::memory_order_acquire);
+		started = true;
+	}
+	
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	int spins = 0;
+	
+	// Full while the consumer is a whole ring behind
+	while (position - cachedLimit >= slotCount) {
+		cachedLimit = shared->tail.load(std::memory_order_acquire);
+		if (position - cachedLimit < slotCount) {
+			break;
+		}
+		if (isClosed()) {
+			return false;
+		}
+		if (spins < SPIN_COUNT) {
+			spins++;
+			std::this_thread::yield();
+			continue;
+		}
+		if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(SLEEP_STEP);
+	}
+	if (isClosed()) {
+		return false;
+	}
+	
+	slot = slotAt(position);
+	return true;
+}
+
+void SharedFrameRing::commitWrite() {
+	position++;
+	shared->head.store(position, std::memory_order_release);
+}
+
+bool SharedFrameRing::acquireRead(Slot& slot, int timeoutMs) {
+	if (!started) {
+		position = shared->tail.load(std::memory_order_relaxed);
+		cachedLimit = shared->head.load(std::memory_order_acquire);
+		started = true;
+	}
+	
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	int spins = 0;
+	
+	while (position >= cachedLimit) {
+		cachedLimit = shared->head.load(std::memory_order_acquire);
+		if (position < cachedLimit) {
+			break;
+		}
+		// Checked after head, so frames published before close() are drained
+		if (isClosed()) {
+			cachedLimit = shared->head.load(std::memory_order_acquire);
+			if (position < cachedLimit) {
+				break;
+			}
+			return false;
+		}
+		if (spins < SPIN_COUNT) {
+			spins++;
+			std::this_thread::yield();
+			continue;
+		}
+		if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+		std::this_thread::sleep_for(SLEEP_STEP);
+	}
+	
+	slot = slotAt(position);
+	return true;
+}
+
+void SharedFrameRing::releaseRead() {
+	position++;
+	shared->tail.store(position, std::memory_order_release);
+}
+
+void SharedFrameRing::close() {
+	shared->closed.store(1, std::memory_order_release);
+}
+
+bool SharedFrameRing::isClosed() const {
+	return shared->closed.load(std::memory_order_acquire) != 0;
+}
+
+} // namespace ipc
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ipc {
+
+/**
+ * Ring of fixed-size frame slots in POSIX shared memory, passed between
+ * exactly one producer process and one consumer process.
+ *
+ * The creating side sizes the ring and removes it again on destruction; the
+ * other side attaches by name. Slots are handed over with two counters in
+ * the shared header (head, advanced by the producer after a slot is filled,
+ * and tail, advanced by the consumer after it is done with one), so no lock
+ * or system call is involved while both sides keep up. A side that has to
+ * wait spins briefly, then sleeps in short steps.
+ *
+ * Each instance is used from one thread as either the producer or the
+ * consumer; a pair of rings gives a round trip.
+ *
+ * A slot is a SlotHeader describing up to MAX_LAYERS planar images, followed
+ * by the payload: paramsBytes of parameters (JSON) at offset 0, then the
+ * planes at the offsets given in each Layer. The ring itself does not
+ * interpret either.
+ */
+class SharedFrameRing {
+public:
+	static constexpr uint32_t MAX_LAYERS = 8;
+	static constexpr uint32_t MAX_PLANES = 4;
+	
+	struct Config {
+		uint32_t slotCount = 4;
+		uint64_t slotBytes = 0;         // Payload bytes per slot
+	};
+	
+	// One image in a slot; format is an AVPixelFormat value
+	struct Layer {
+		int32_t width = 0;
+		int32_t height = 0;
+		int32_t format = -1;
+		int32_t planeCount = 0;
+		int32_t linesize[MAX_PLANES] = {};
+		uint64_t offset[MAX_PLANES] = {};  // From the start of the payload
+	};
+	
+	struct SlotHeader {
+		int64_t frameNumber = 0;
+		uint32_t layerCount = 0;
+		uint32_t paramsBytes = 0;       // Parameters at the start of the payload
+		uint64_t payloadBytes = 0;      // Payload bytes in use
+		Layer layers[MAX_LAYERS];
+	};
+	
+	// View of a slot owned by the caller between acquire and commit/release
+	struct Slot {
+		SlotHeader* header = nullptr;
+		uint8_t* payload = nullptr;
+		uint64_t capacity = 0;
+	};
+	
+	/**
+	 * Create the ring (replacing a stale one of the same name)
+	 * @param name Shared memory object name, e.g. "/edl2ffmpeg-export"
+	 * @throws std::runtime_error if it cannot be created
+	 */
+	SharedFrameRing(const std::string& name, const Config& config);
+	
+	/**
+	 * Attach to a ring created by another process
+	 * @throws std::runtime_error if it does not exist or is not a frame ring
+	 */
+	explicit SharedFrameRing(const std::string& name);
+	
+	~SharedFrameRing();
+	
+	SharedFrameRing(const SharedFrameRing&) = delete;
+	SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+	
+	/**
+	 * Producer: wait for a free slot
+	 * @param timeoutMs Longest wait, -1 to wait until the ring is closed
+	 * @return false on timeout or once the ring is closed
+	 */
+	bool acquireWrite(Slot& slot, int timeoutMs = -1);
+	
+	// Producer: publish the slot from acquireWrite()
+	void commitWrite();
+	
+	/**
+	 * Consumer: wait for the next filled slot
+	 * @return false on timeout, or once the ring is closed and drained
+	 */
+	bool acquireRead(Slot& slot, int timeoutMs = -1);
+	
+	// Consumer: hand the slot from acquireRead() back to the producer
+	void releaseRead();
+	
+	// Either side: no more frames; the consumer still drains filled slots
+	void close();
+	bool isClosed() const;
+	
+	const std::string& getName() const { return name; }
+	uint32_t getSlotCount() const { return slotCount; }
+	uint64_t getSlotBytes() const { return slotBytes; }
+
+private:
+	struct SharedHeader;
+	
+	void map(size_t size);
+	Slot slotAt(uint64_t index) const;
+	
+	std::string name;
+	bool owner = false;
+	int fd = -1;
+	uint8_t* base = nullptr;
+	size_t mappedBytes = 0;
+	SharedHeader* shared = nullptr;
+	
+	uint32_t slotCount = 0;
+	uint64_t slotBytes = 0;
+	uint64_t slotStride = 0;
+	
+	// Local copies of the counters, so the other side's cache line is only
+	// read when the ring looks full (producer) or empty (consumer)
+	bool started = false;
+	uint64_t position = 0;
+	uint64_t cachedLimit = 0;
+};
+
+} // namespace ipc
\ No newline at end of file
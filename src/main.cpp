@@ -1,26 +1,22 @@
-#include "edl/EDLParser.h"
-#include "compositor/InstructionGenerator.h"
-#include "compositor/FrameCompositor.h"
-#include "media/FFmpegDecoder.h"
-#include "media/FFmpegEncoder.h"
-#include "media/HardwareAcceleration.h"
 #include "media/HardwareContextManager.h"
+#include "media/RawFrameWriter.h"
+#include "render/BatchRunner.h"
+#include "render/Renderer.h"
+#include "server/RenderServer.h"
+#include "utils/FrameArena.h"
 #include "utils/Logger.h"
+#include "utils/MemoryBudget.h"
 #include "utils/Timer.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
-#include <libavcodec/avcodec.h>
 }
 
+#include <cctype>
+#include <csignal>
 #include <iostream>
-#include <unordered_map>
-#include <memory>
-#include <filesystem>
-#include <chrono>
-#include <thread>
+#include <string>
 #include <iomanip>
-#include <variant>
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -28,10 +24,10 @@ extern "C" {
 #include <unistd.h>
 #endif
 
-namespace fs = std::filesystem;
-
 void printUsage(const char* programName) {
 	std::cout << "Usage: " << programName << " <edl_file> <output_file> [options]\n";
+	std::cout << "       " << programName << " --daemon [<socket>] [daemon options]\n";
+	std::cout << "       " << programName << " --batch <jobs.json> [batch options]\n";
 	std::cout << "\nOptions:\n";
 	std::cout << "  -c, --codec <codec>      Video codec (default: libx264)\n";
 	std::cout << "  -b, --bitrate <bitrate>  Video bitrate (default: 446464 / 436Ki)\n";
@@ -41,36 +37,73 @@ void printUsage(const char* programName) {
 	std::cout << "  --hw-device <device>     Hardware device index (default: 0)\n";
 	std::cout << "  --hw-decode              Enable hardware decoding (default: auto)\n";
 	std::cout << "  --hw-encode              Enable hardware encoding (default: auto)\n";
-	std::cout << "  -v, --verbose            Enable verbose logging\n";
+	std::cout << "  -j, --threads <n>        Total threads for decoding, compositing and encoding (default: all cores)\n";
+	std::cout << "  --max-open-decoders <n>  Maximum number of source decoders open at once (default: 16)\n";
+	std::cout << "  --decoder-memory <MB>    Close idle decoders above this estimated memory use (default: unlimited)\n";
+	std::cout << "  --max-memory <MB>        Memory budget for frames, caches, queues and decoders; above it caches\n";
+	std::cout << "                           shrink first, then queues, then idle decoders close (default: unlimited)\n";
+	std::cout << "  --no-plan-cache          Do not read or write the compiled render plan (<edl_file>.plan)\n";
+	std::cout << "  --segment-cache <dir>    Reuse encoded segments from <dir> and only re-encode changed ones\n";
+	std::cout << "  --segment-cache-size <MB> Maximum size of the segment cache (default: 10240)\n";
+	std::cout << "  --segment-format <fmt>   Segmented output: hls (TS), hls-fmp4 or fmp4 (fragmented MP4);\n";
+	std::cout << "                           each segment is published as soon as it is complete\n";
+	std::cout << "  --segment-duration <s>   Longest segment in seconds, cut at clip boundaries (default: 6)\n";
+	std::cout << "  --no-audio               Render video only, even if the EDL has audio tracks\n";
+	std::cout << "  --audio-codec <codec>    Audio codec (default: aac)\n";
+	std::cout << "  --audio-bitrate <bitrate> Audio bitrate (default: 128000)\n";
+	std::cout << "  --no-audio-passthrough   Re-encode all audio, even untouched stretches\n";
+	std::cout << "  --output <file>[,opts]   Encode an additional output from the same render; opts are\n";
+	std::cout << "                           codec=, bitrate=, crf=, preset= and size=<W>x<H> or <H>\n";
+	std::cout << "  --proxy [factor]         Preview render at 1/factor of the EDL size (default: 4) with\n";
+	std::cout << "                           reduced-resolution decoding and a fast encoder preset\n";
+	std::cout << "  --raw <y4m|nut>          Write uncompressed frames instead of encoding; <output_file>\n";
+	std::cout << "                           may be a named pipe or - for stdout\n";
+	std::cout << "  --shm-export <name>      Publish decoded layers and their parameters to an external\n";
+	std::cout << "                           compositor through shared memory ring <name>\n";
+	std::cout << "  --shm-return <name>      Encode the frames the external compositor returns on <name>\n";
+	std::cout << "  --benchmark <stage>      Stop after decode, composite or encode (null muxer) and write a\n";
+	std::cout << "                           JSON throughput report to <output_file> (- for stdout)\n";
+	std::cout << "  --hugepages              Allocate frames from an arena backed by huge pages where\n";
+	std::cout << "                           available (falls back to normal pages)\n";
+	std::cout << "  --prefault               Map and touch the frame arena at startup so rendering causes\n";
+	std::cout << "                           no page faults (implies --hugepages)\n";
+	std::cout << "  --trace <file>           Write a Chrome trace-event JSON timeline of every timed zone\n";
+	std::cout << "                           (open in chrome://tracing or ui.perfetto.dev)\n";
+	std::cout << "  -v, --verbose            Enable verbose logging and the timing report\n";
 	std::cout << "  -q, --quiet              Suppress all non-error output\n";
+	std::cout << "  --log-format <text|json> Log line format; json writes one object per line (default: text)\n";
 	std::cout << "  -h, --help               Show this help message\n";
+	std::cout << "\nDaemon options (render jobs sent by edl2ffmpeg-client to <socket>,\n";
+	std::cout << "default " << server::DEFAULT_SOCKET_PATH << "):\n";
+	std::cout << "  --workers <n>            Jobs rendered at the same time (default: 1)\n";
+	std::cout << "  --max-idle-decoders <n>  Open decoders kept warm between jobs (default: 16)\n";
+	std::cout << "  -j, --threads <n>        Threads per job (default: all cores / workers)\n";
+	std::cout << "  --max-memory <MB>, --hugepages, -v, -q, --log-format\n";
+	std::cout << "                           As for a single render, for the whole daemon\n";
+	std::cout << "\nBatch options (render every job of <jobs.json>, sharing open decoders):\n";
+	std::cout << "  --jobs <n>               Jobs rendered at the same time (default: cores / 4, 1 to 4)\n";
+	std::cout << "  -j, --threads <n>        Threads of the whole batch, split between jobs (default: all cores)\n";
+	std::cout << "  --max-idle-decoders <n>  Open decoders kept warm between jobs (default: 16)\n";
+	std::cout << "  --max-memory <MB>, --hugepages, -v, -q, --log-format\n";
+	std::cout << "                           As for a single render, for the whole batch\n";
 	std::cout << "\nExamples:\n";
 	std::cout << "  " << programName << " input.json output.mp4\n";
 	std::cout << "  " << programName << " input.json output.mp4 --codec libx265 --crf 28\n";
 	std::cout << "  " << programName << " input.json output.mp4 -b 8000000 -p fast\n";
 	std::cout << "  " << programName << " input.json output.mp4 --hw-accel nvenc --hw-encode\n";
 	std::cout << "  " << programName << " input.json output.mp4 --hw-accel auto --hw-encode --hw-decode\n";
+	std::cout << "  " << programName << " input.json output.mp4 --segment-cache ~/.cache/edl2ffmpeg\n";
+	std::cout << "  " << programName << " input.json out/playlist.m3u8 --segment-format hls --segment-duration 4\n";
+	std::cout << "  " << programName << " input.json master.mp4 --output proxy.mp4,size=360,bitrate=800000\n";
+	std::cout << "  " << programName << " input.json preview.mp4 --proxy\n";
+	std::cout << "  " << programName << " input.json - --raw y4m | x265 --y4m - -o output.hevc\n";
+	std::cout << "  " << programName << " input.json report.json --benchmark composite\n";
+	std::cout << "  " << programName << " --daemon /run/edl2ffmpeg.sock --workers 2\n";
+	std::cout << "  " << programName << " --batch jobs.json --jobs 2\n";
 }
 
-struct Options {
-	std::string edlFile;
-	std::string outputFile;
-	std::string codec = "libx264";
-	int bitrate = 446464;  // 436Ki (436 * 1024) - matching ftv_toffmpeg default
-	std::string preset = "faster";  // matching ftv_toffmpeg default
-	int crf = 23;
-	bool verbose = false;
-	bool quiet = false;
-	
-	// Hardware acceleration options
-	std::string hwAccelType = "auto";
-	int hwDevice = 0;
-	bool hwDecode = false;
-	bool hwEncode = false;
-};
-
-Options parseCommandLine(int argc, char* argv[]) {
-	Options opts;
+render::Options parseCommandLine(int argc, char* argv[]) {
+	render::Options opts;
 	
 	if (argc < 3) {
 		printUsage(argv[0]);
@@ -131,6 +164,156 @@ Options parseCommandLine(int argc, char* argv[]) {
 			opts.hwDecode = true;
 		} else if (arg == "--hw-encode") {
 			opts.hwEncode = true;
+		} else if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+			try {
+				opts.threads = std::stoi(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid thread count: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Thread count out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+			if (opts.threads < 0) {
+				std::cerr << "Error: Thread count must not be negative: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--max-open-decoders" && i + 1 < argc) {
+			try {
+				opts.maxOpenDecoders = std::stoi(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid decoder count: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Decoder count out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+			if (opts.maxOpenDecoders < 2) {
+				std::cerr << "Error: At least 2 open decoders are required: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--max-memory" && i + 1 < argc) {
+			try {
+				opts.maxMemoryMB = std::stoull(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid memory limit: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Memory limit out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--decoder-memory" && i + 1 < argc) {
+			try {
+				opts.decoderMemoryMB = std::stoull(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid decoder memory limit: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Decoder memory limit out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--no-plan-cache") {
+			opts.usePlanCache = false;
+		} else if (arg == "--segment-cache" && i + 1 < argc) {
+			opts.segmentCacheDir = argv[++i];
+		} else if (arg == "--segment-format" && i + 1 < argc) {
+			opts.segmentFormat = argv[++i];
+			if (opts.segmentFormat != "hls" && opts.segmentFormat != "hls-fmp4" && opts.segmentFormat != "fmp4") {
+				std::cerr << "Error: Unknown segment format: " << opts.segmentFormat << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--segment-duration" && i + 1 < argc) {
+			try {
+				opts.segmentDuration = std::stod(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid segment duration: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Segment duration out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+			if (opts.segmentDuration <= 0.0) {
+				std::cerr << "Error: Segment duration must be positive: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--segment-cache-size" && i + 1 < argc) {
+			try {
+				opts.segmentCacheSizeMB = std::stoull(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid segment cache size: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Segment cache size out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--no-audio") {
+			opts.audio = false;
+		} else if (arg == "--output" && i + 1 < argc) {
+			try {
+				opts.extraOutputs.push_back(render::parseOutputSpec(argv[++i]));
+			} catch (const std::exception& e) {
+				std::cerr << "Error: Invalid output " << argv[i] << ": " << e.what() << "\n";
+				std::exit(1);
+			}
+		} else if (arg == "--proxy") {
+			opts.proxy = 4;
+			if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+				try {
+					opts.proxy = std::stoi(argv[++i]);
+				} catch (const std::exception& e) {
+					std::cerr << "Error: Invalid proxy factor: " << argv[i] << "\n";
+					std::exit(1);
+				}
+				if (opts.proxy < 2 || opts.proxy > 16) {
+					std::cerr << "Error: Proxy factor must be between 2 and 16: " << argv[i] << "\n";
+					std::exit(1);
+				}
+			}
+		} else if (arg == "--raw" && i + 1 < argc) {
+			opts.rawFormat = argv[++i];
+			media::RawFrameWriter::Format format;
+			if (!media::RawFrameWriter::parseFormat(opts.rawFormat, format)) {
+				std::cerr << "Error: Unknown raw format: " << opts.rawFormat << " (expected y4m or nut)\n";
+				std::exit(1);
+			}
+		} else if (arg == "--shm-export" && i + 1 < argc) {
+			opts.shmExport = argv[++i];
+		} else if (arg == "--shm-return" && i + 1 < argc) {
+			opts.shmReturn = argv[++i];
+		} else if (arg == "--benchmark" && i + 1 < argc) {
+			opts.benchmark = argv[++i];
+			if (opts.benchmark != "decode" && opts.benchmark != "composite" && opts.benchmark != "encode") {
+				std::cerr << "Error: Unknown benchmark stage: " << opts.benchmark
+					<< " (expected decode, composite or encode)\n";
+				std::exit(1);
+			}
+		} else if (arg == "--log-format" && i + 1 < argc) {
+			std::string format = argv[++i];
+			if (format != "text" && format != "json") {
+				std::cerr << "Error: Unknown log format: " << format << " (expected text or json)\n";
+				std::exit(1);
+			}
+			opts.jsonLog = format == "json";
+		} else if (arg == "--trace" && i + 1 < argc) {
+			opts.traceFile = argv[++i];
+		} else if (arg == "--hugepages") {
+			opts.hugePages = true;
+		} else if (arg == "--prefault") {
+			opts.prefault = true;
+		} else if (arg == "--no-audio-passthrough") {
+			opts.audioPassthrough = false;
+		} else if (arg == "--audio-codec" && i + 1 < argc) {
+			opts.audioCodec = argv[++i];
+		} else if (arg == "--audio-bitrate" && i + 1 < argc) {
+			try {
+				opts.audioBitrate = std::stoi(argv[++i]);
+			} catch (const std::invalid_argument& e) {
+				std::cerr << "Error: Invalid audio bitrate value: " << argv[i] << "\n";
+				std::exit(1);
+			} catch (const std::out_of_range& e) {
+				std::cerr << "Error: Audio bitrate value out of range: " << argv[i] << "\n";
+				std::exit(1);
+			}
 		} else {
 			std::cerr << "Unknown option: " << arg << "\n";
 			printUsage(argv[0]);
@@ -138,64 +321,31 @@ Options parseCommandLine(int argc, char* argv[]) {
 		}
 	}
 	
-	return opts;
-}
-
-std::string getMediaPath(const std::string& uri, const std::string& edlPath) {
-	// First, check if uri is already a full path
-	if (fs::exists(uri)) {
-		return uri;
-	}
-	
-	// Try relative to EDL file directory
-	fs::path edlDir = fs::path(edlPath).parent_path();
-	fs::path mediaPath = edlDir / uri;
-	if (fs::exists(mediaPath)) {
-		return mediaPath.string();
-	}
-	
-	// Try in current directory
-	if (fs::exists(fs::path(uri))) {
-		return uri;
-	}
-	
-	// Return as-is and let FFmpeg handle it
-	return uri;
-}
-
-// Check if instruction requires CPU processing (effects, transforms, etc.)
-bool requiresCPUProcessing(const compositor::CompositorInstruction& instruction) {
-	// Check for effects
-	if (!instruction.effects.empty()) {
-		return true;
-	}
-	
-	// Check for fade
-	if (instruction.fade < 1.0f) {
-		return true;
-	}
-	
-	// Check for transforms
-	if (std::abs(instruction.panX) > 0.001f ||
-		std::abs(instruction.panY) > 0.001f ||
-		std::abs(instruction.zoomX - 1.0f) > 0.001f ||
-		std::abs(instruction.zoomY - 1.0f) > 0.001f ||
-		std::abs(instruction.rotation) > 0.001f ||
-		instruction.flip) {
-		return true;
+	if (!opts.shmReturn.empty() && opts.shmExport.empty()) {
+		std::cerr << "Error: --shm-return requires --shm-export\n";
+		std::exit(1);
 	}
-	
-	// Check for transitions
-	if (instruction.transition.type != compositor::TransitionInfo::None) {
-		return true;
+	if (opts.proxy > 0 && !opts.shmExport.empty()) {
+		std::cerr << "Error: --proxy cannot be combined with --shm-export\n";
+		std::exit(1);
 	}
 	
-	// Check if it's not a simple draw frame
-	if (instruction.type != compositor::CompositorInstruction::DrawFrame) {
-		return true;
+	// A benchmark measures the video pipeline alone, and writes nothing but
+	// its report
+	if (!opts.benchmark.empty()) {
+		opts.audio = false;
+		opts.extraOutputs.clear();
+		opts.rawFormat.clear();
+		opts.segmentFormat.clear();
+		opts.segmentCacheDir.clear();
+		opts.shmExport.clear();
+		opts.shmReturn.clear();
+		if (opts.outputFile == "-") {
+			opts.quiet = true;
+		}
 	}
 	
-	return false;
+	return opts;
 }
 
 int getTerminalWidth() {
@@ -253,17 +403,233 @@ void printProgress(int current, int total, double fps, double /*elapsed*/) {
 	std::cout << std::flush;
 }
 
+// Settings of the whole process in daemon and batch mode
+struct ProcessOptions {
+	bool verbose = false;
+	bool quiet = false;
+	bool jsonLog = false;
+	bool hugePages = false;
+	uint64_t maxMemoryMB = 0;
+};
+
+// Settings of the render daemon (--daemon)
+struct DaemonOptions {
+	server::RenderServer::Config server;
+	ProcessOptions process;
+};
+
+// Settings of a batch render (--batch)
+struct BatchOptions {
+	std::string jobsFile;
+	render::BatchRunner::Config batch;
+	ProcessOptions process;
+};
+
+// Parse the number following an option, exiting on a bad value
+int parseCount(const std::string& option, const char* value, int minimum) {
+	int count = 0;
+	try {
+		count = std::stoi(value);
+	} catch (const std::exception& e) {
+		std::cerr << "Error: Invalid value for " << option << ": " << value << "\n";
+		std::exit(1);
+	}
+	if (count < minimum) {
+		std::cerr << "Error: " << option << " must be at least " << minimum << ": " << value << "\n";
+		std::exit(1);
+	}
+	return count;
+}
+
+// Parse a process option at argv[i], advancing i past its value
+bool parseProcessOption(int argc, char* argv[], int& i, ProcessOptions& opts) {
+	std::string arg = argv[i];
+	if (arg == "-v" || arg == "--verbose") {
+		opts.verbose = true;
+	} else if (arg == "-q" || arg == "--quiet") {
+		opts.quiet = true;
+	} else if (arg == "--max-memory" && i + 1 < argc) {
+		opts.maxMemoryMB = parseCount(arg, argv[++i], 0);
+	} else if (arg == "--hugepages") {
+		opts.hugePages = true;
+	} else if (arg == "--log-format" && i + 1 < argc) {
+		std::string format = argv[++i];
+		if (format != "text" && format != "json") {
+			std::cerr << "Error: Unknown log format: " << format << " (expected text or json)\n";
+			std::exit(1);
+		}
+		opts.jsonLog = format == "json";
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void applyProcessOptions(const ProcessOptions& opts) {
+	if (opts.quiet) {
+		utils::Logger::setLevel(utils::Logger::ERROR);
+	} else if (opts.verbose) {
+		utils::Logger::setLevel(utils::Logger::DEBUG);
+	} else {
+		utils::Logger::setLevel(utils::Logger::INFO);
+	}
+	if (opts.jsonLog) {
+		utils::Logger::setFormat(utils::Logger::JSON);
+	}
+	
+	utils::MemoryBudget::getInstance().setLimit(opts.maxMemoryMB * 1024 * 1024);
+	if (opts.hugePages) {
+		utils::FrameArena::getInstance().enable(utils::FrameArena::Config());
+	}
+}
+
+DaemonOptions parseDaemonCommandLine(int argc, char* argv[]) {
+	DaemonOptions opts;
+	
+	int i = 2;
+	if (i < argc && argv[i][0] != '-') {
+		opts.server.socketPath = argv[i++];
+	}
+	
+	for (; i < argc; ++i) {
+		std::string arg = argv[i];
+		
+		if (arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			std::exit(0);
+		} else if (parseProcessOption(argc, argv, i, opts.process)) {
+			continue;
+		} else if (arg == "--workers" && i + 1 < argc) {
+			opts.server.workers = parseCount(arg, argv[++i], 1);
+		} else if (arg == "--max-idle-decoders" && i + 1 < argc) {
+			opts.server.maxIdleDecoders = parseCount(arg, argv[++i], 0);
+		} else if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+			opts.server.threadsPerJob = parseCount(arg, argv[++i], 0);
+		} else {
+			std::cerr << "Unknown daemon option: " << arg << "\n";
+			printUsage(argv[0]);
+			std::exit(1);
+		}
+	}
+	
+	// Jobs never draw a progress bar; their progress goes to the client
+	opts.server.defaults.quiet = true;
+	return opts;
+}
+
+BatchOptions parseBatchCommandLine(int argc, char* argv[]) {
+	BatchOptions opts;
+	if (argc < 3 || argv[2][0] == '-') {
+		std::cerr << "Error: --batch needs a jobs file\n";
+		printUsage(argv[0]);
+		std::exit(1);
+	}
+	opts.jobsFile = argv[2];
+	
+	for (int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		
+		if (arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			std::exit(0);
+		} else if (parseProcessOption(argc, argv, i, opts.process)) {
+			continue;
+		} else if (arg == "--jobs" && i + 1 < argc) {
+			opts.batch.concurrency = parseCount(arg, argv[++i], 1);
+		} else if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+			opts.batch.threads = parseCount(arg, argv[++i], 0);
+		} else if (arg == "--max-idle-decoders" && i + 1 < argc) {
+			opts.batch.maxIdleDecoders = parseCount(arg, argv[++i], 0);
+		} else {
+			std::cerr << "Unknown batch option: " << arg << "\n";
+			printUsage(argv[0]);
+			std::exit(1);
+		}
+	}
+	return opts;
+}
+
+server::RenderServer* runningServer = nullptr;
+render::BatchRunner* runningBatch = nullptr;
+
+void stopServer(int) {
+	if (runningServer) {
+		runningServer->stop();
+	}
+}
+
+void stopBatch(int) {
+	if (runningBatch) {
+		runningBatch->cancel();
+	}
+}
+
+int runDaemon(int argc, char* argv[]) {
+	DaemonOptions opts = parseDaemonCommandLine(argc, argv);
+	applyProcessOptions(opts.process);
+	
+	server::RenderServer server(opts.server);
+	runningServer = &server;
+	std::signal(SIGINT, stopServer);
+	std::signal(SIGTERM, stopServer);
+	
+	server.run();
+	
+	runningServer = nullptr;
+	
+	// Warm decoders are closed; the hardware context they shared can go
+	media::HardwareContextManager::getInstance().reset();
+	return 0;
+}
+
+int runBatch(int argc, char* argv[]) {
+	BatchOptions opts = parseBatchCommandLine(argc, argv);
+	applyProcessOptions(opts.process);
+	utils::Timer::getInstance().setEnabled(opts.process.verbose);
+	
+	std::vector<render::Options> jobs = render::BatchRunner::loadJobs(opts.jobsFile);
+	
+	render::BatchRunner batch(opts.batch);
+	runningBatch = &batch;
+	std::signal(SIGINT, stopBatch);
+	std::signal(SIGTERM, stopBatch);
+	
+	render::BatchRunner::Result result = batch.run(std::move(jobs));
+	
+	runningBatch = nullptr;
+	
+	utils::Logger::info("Batch complete: {} done, {} failed, {} cancelled; {} frames in {} seconds ({} fps)",
+		result.done, result.failed, result.cancelled, result.frames, result.seconds,
+		result.seconds > 0.0 ? result.frames / result.seconds : 0.0);
+	if (opts.process.verbose) {
+		utils::Logger::flush();
+		utils::Timer::getInstance().printReport();
+		utils::MemoryBudget::getInstance().printReport();
+	}
+	
+	media::HardwareContextManager::getInstance().reset();
+	return result.failed == 0 && result.cancelled == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
 	try {
-		TIME_BLOCK("main_total");
+		auto& timer = utils::Timer::getInstance();
+		const int64_t mainStart = utils::Timer::now();
 		
 		// Initialize FFmpeg (required for older versions)
 #if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
 		av_register_all();
 #endif
 		
+		if (argc >= 2 && std::string(argv[1]) == "--daemon") {
+			return runDaemon(argc, argv);
+		}
+		if (argc >= 2 && std::string(argv[1]) == "--batch") {
+			return runBatch(argc, argv);
+		}
+		
 		// Parse command line
-		Options opts = parseCommandLine(argc, argv);
+		render::Options opts = parseCommandLine(argc, argv);
 		
 		// Set logging level
 		if (opts.quiet) {
@@ -273,280 +639,63 @@ int main(int argc, char* argv[]) {
 		} else {
 			utils::Logger::setLevel(utils::Logger::INFO);
 		}
-		
-		// Parse EDL file
-		{
-			TIME_BLOCK("edl_parsing");
-			utils::Logger::info("Parsing EDL file: {}", opts.edlFile);
-			edl::EDL edl = edl::EDLParser::parse(opts.edlFile);
-		
-			utils::Logger::info("EDL: {}x{} @ {} fps, {} clips",
-				edl.width, edl.height, edl.fps, edl.clips.size());
+		if (opts.jsonLog) {
+			utils::Logger::setFormat(utils::Logger::JSON);
 		}
 		
-		// Re-parse EDL after timing block
-		edl::EDL edl = edl::EDLParser::parse(opts.edlFile);
+		// Zones are only timed when someone will look at them
+		timer.setEnabled(opts.verbose);
+		timer.setTracing(!opts.traceFile.empty());
+		timer.setThreadName("main");
 		
-		// Initialize shared hardware context if hardware acceleration is requested
-		AVBufferRef* sharedHwContext = nullptr;
-		if (opts.hwDecode || opts.hwEncode) {
-			media::HWConfig hwConfig;
-			hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
-			hwConfig.deviceIndex = opts.hwDevice;
-			hwConfig.allowFallback = true;
-			
-			if (media::HardwareContextManager::getInstance().initialize(hwConfig)) {
-				sharedHwContext = media::HardwareContextManager::getInstance().getSharedContext();
-				utils::Logger::info("Shared hardware context initialized for GPU passthrough");
-			} else {
-				utils::Logger::warn("Failed to initialize shared hardware context, components will create their own");
-			}
-		}
+		utils::MemoryBudget::getInstance().setLimit(opts.maxMemoryMB * 1024 * 1024);
 		
-		// Initialize decoders for all unique media files
-		std::unordered_map<std::string, std::unique_ptr<media::FFmpegDecoder>> decoders;
-		
-		{
-			TIME_BLOCK("decoder_initialization");
-			for (const auto& clip : edl.clips) {
-				if (clip.track.type != edl::Track::Video) {
-					continue;
-				}
-				
-				// Check if this is a media source (skip effect sources)
-				if (!clip.source.has_value() || !std::holds_alternative<edl::MediaSource>(clip.source.value())) {
-					continue;
-				}
-				
-				const auto& mediaSource = std::get<edl::MediaSource>(clip.source.value());
-				const std::string& uri = mediaSource.uri;
-				if (decoders.find(uri) == decoders.end()) {
-					std::string mediaPath = getMediaPath(uri, opts.edlFile);
-					utils::Logger::info("Loading media: {} -> {}", uri, mediaPath);
-					
-					try {
-						TIME_BLOCK(std::string("decoder_init_") + uri);
-						// Configure decoder with hardware acceleration if requested
-						media::FFmpegDecoder::Config decoderConfig;
-						decoderConfig.useHardwareDecoder = opts.hwDecode;
-						decoderConfig.hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
-						decoderConfig.hwConfig.deviceIndex = opts.hwDevice;
-						decoderConfig.hwConfig.allowFallback = true;
-						// Enable GPU passthrough if both decode and encode use hardware
-						decoderConfig.keepHardwareFrames = opts.hwDecode && opts.hwEncode;
-						// Use shared hardware context if available
-						decoderConfig.externalHwDeviceCtx = sharedHwContext;
-						
-						decoders[uri] = std::make_unique<media::FFmpegDecoder>(mediaPath, decoderConfig);
-					} catch (const std::exception& e) {
-						utils::Logger::error("Failed to load media {}: {}", mediaPath, e.what());
-						throw;
-					}
-				}
-			}
+		// Must happen before the first frame is allocated; pre-faulting waits
+		// until the frame size is known
+		if (opts.hugePages || opts.prefault) {
+			utils::FrameArena::Config arenaConfig;
+			arenaConfig.prefault = opts.prefault;
+			utils::FrameArena::getInstance().enable(arenaConfig);
 		}
 		
-		// Setup encoder
-		media::FFmpegEncoder encoder(opts.outputFile, [&]() {
-			TIME_BLOCK("encoder_initialization");
-			media::FFmpegEncoder::Config encoderConfig;
-			encoderConfig.width = edl.width;
-			encoderConfig.height = edl.height;
-			encoderConfig.frameRate = {edl.fps, 1};
-			encoderConfig.codec = opts.codec;
-			encoderConfig.bitrate = opts.bitrate;
-			encoderConfig.preset = opts.preset;
-			encoderConfig.crf = opts.crf;
-			encoderConfig.useHardwareEncoder = opts.hwEncode;
-			encoderConfig.hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
-			encoderConfig.hwConfig.deviceIndex = opts.hwDevice;
-			encoderConfig.hwConfig.allowFallback = true;
-			// Use shared hardware context if available
-			encoderConfig.externalHwDeviceCtx = sharedHwContext;
-			// Enable GPU passthrough mode when both decode and encode use hardware
-			encoderConfig.expectHardwareFrames = opts.hwDecode && opts.hwEncode;
-			
-			utils::Logger::info("Creating output file: {}", opts.outputFile);
-			return encoderConfig;
-		}());
-		
-		// Setup compositor
-		compositor::FrameCompositor compositor(edl.width, edl.height, AV_PIX_FMT_YUV420P);
-		
-		// Setup instruction generator
-		compositor::InstructionGenerator generator(edl);
-		int totalFrames = generator.getTotalFrames();
-		
-		utils::Logger::info("Processing {} frames...", totalFrames);
-		
-		// Analyze if GPU passthrough is possible
-		// Check if all decoders actually have hardware enabled (not just the command line flags)
-		bool allDecodersHaveHardware = !decoders.empty();
-		for (const auto& [uri, decoder] : decoders) {
-			if (decoder && !decoder->isUsingHardware()) {
-				allDecodersHaveHardware = false;
-				break;
-			}
+		// Frames written to stdout must not share it with log output
+		bool rawOutput = !opts.rawFormat.empty();
+		if (rawOutput && opts.outputFile == "-") {
+			media::RawFrameWriter::detachStdout();
 		}
 		
-		bool canUseGPUPassthrough = allDecodersHaveHardware && opts.hwEncode;
-		if (canUseGPUPassthrough) {
-			// Check if any frame needs CPU processing
-			bool needsCPU = false;
-			for (const auto& instruction : generator) {
-				if (requiresCPUProcessing(instruction)) {
-					needsCPU = true;
-					break;
-				}
-			}
-			
-			if (!needsCPU) {
-				utils::Logger::info("GPU passthrough enabled - zero-copy pipeline active");
-			} else {
-				utils::Logger::info("GPU acceleration enabled but some frames require CPU processing");
-			}
-		}
-		
-		// Process frames
-		auto startTime = std::chrono::high_resolution_clock::now();
-		int frameCount = 0;
-		int progressUpdateInterval = edl.fps / 2;  // Update twice per second
-		
-		// Track timing for first few frames
-		bool trackFirstFrames = true;
-		int firstFramesToTrack = 10;
-		
-		for (const auto& instruction : generator) {
-			std::shared_ptr<AVFrame> outputFrame;
-			
-			// Time the first few frames individually
-			if (trackFirstFrames && frameCount < firstFramesToTrack) {
-				TIME_BLOCK(std::string("frame_") + std::to_string(frameCount));
-			}
-			
-			// Check if we can use GPU passthrough (no effects, transforms, or color generation)
-			// Must check if decoder actually has hardware enabled, not just command line flags
-			bool useGPUPassthrough = false;
-			if (instruction.type == compositor::CompositorInstruction::DrawFrame) {
-				auto it = decoders.find(instruction.uri);
-				if (it != decoders.end() && it->second) {
-					useGPUPassthrough = it->second->isUsingHardware() && opts.hwEncode && 
-										!requiresCPUProcessing(instruction);
-				}
-			}
-			
-			if (useGPUPassthrough) {
-				// GPU passthrough path - no CPU processing needed
-				auto& decoder = decoders[instruction.uri];
-				if (decoder) {
-					// Get hardware frame directly from decoder
-					auto hwFrame = decoder->getHardwareFrame(instruction.sourceFrameNumber);
-					if (hwFrame) {
-						// Write hardware frame directly to encoder
-						if (!encoder.writeHardwareFrame(hwFrame.get())) {
-							utils::Logger::error("Failed to write hardware frame {} to encoder", frameCount);
-							// Try to continue with next frame
-						}
-						frameCount++;
-						
-						// Update progress
-						if (!opts.quiet && (frameCount % progressUpdateInterval == 0 || frameCount == totalFrames)) {
-							auto currentTime = std::chrono::high_resolution_clock::now();
-							std::chrono::duration<double> elapsed = currentTime - startTime;
-							double fps = frameCount / elapsed.count();
-							printProgress(frameCount, totalFrames, fps, elapsed.count());
-						}
-						continue;
-					} else {
-						// Hardware frame failed - assume we've reached EOF or encountered an error
-						utils::Logger::info("Failed to get hardware frame at output frame {} (source frame {}), stopping", 
-							frameCount, instruction.sourceFrameNumber);
-						// Stop processing
-						break;
-					}
-				}
-			}
-			
-			// CPU processing path (original code)
-			if (instruction.type == compositor::CompositorInstruction::DrawFrame) {
-				// Get the decoder for this media
-				auto& decoder = decoders[instruction.uri];
-				if (decoder) {
-					// Get the source frame
-					auto inputFrame = decoder->getFrame(instruction.sourceFrameNumber);
-					
-					if (!inputFrame) {
-						utils::Logger::info("Failed to get frame at output frame {} (source frame {}), stopping", 
-							frameCount, instruction.sourceFrameNumber);
-						// Stop processing
-						break;
-					}
-					
-					// Process through compositor
-					outputFrame = compositor.processFrame(inputFrame, instruction);
+		// Render, drawing the progress bar unless quiet
+		render::Renderer renderer(opts);
+		if (!opts.quiet) {
+			renderer.setProgressCallback([](const render::Renderer::Progress& progress) {
+				if (progress.done) {
+					std::cout << "\n";
 				} else {
-					utils::Logger::warn("Decoder not found for media: {}", instruction.uri);
-					outputFrame = compositor.generateColorFrame(0, 0, 0);
+					printProgress(progress.frame, progress.totalFrames, progress.fps, 0.0);
 				}
-			} else if (instruction.type == compositor::CompositorInstruction::GenerateColor) {
-				// Generate color frame
-				outputFrame = compositor.generateColorFrame(
-					instruction.color.r,
-					instruction.color.g,
-					instruction.color.b
-				);
-			} else {
-				// NoOp or unknown - generate black frame
-				outputFrame = compositor.generateColorFrame(0, 0, 0);
-			}
-			
-			// Write frame to encoder
-			if (outputFrame) {
-				encoder.writeFrame(outputFrame.get());
-			}
-			
-			frameCount++;
-			
-			// Update progress
-			if (!opts.quiet && (frameCount % progressUpdateInterval == 0 || frameCount == totalFrames)) {
-				auto currentTime = std::chrono::high_resolution_clock::now();
-				std::chrono::duration<double> elapsed = currentTime - startTime;
-				double fps = frameCount / elapsed.count();
-				printProgress(frameCount, totalFrames, fps, elapsed.count());
-			}
-		}
-		
-		if (!opts.quiet) {
-			std::cout << "\n";
+			});
 		}
+		renderer.render();
 		
-		// Finalize encoder
-		encoder.finalize();
-		
-		// Calculate and report statistics
-		auto endTime = std::chrono::high_resolution_clock::now();
-		std::chrono::duration<double> totalTime = endTime - startTime;
-		double avgFps = frameCount / totalTime.count();
-		
-		utils::Logger::info("Rendering complete!");
-		utils::Logger::info("Total frames: {}", frameCount);
-		utils::Logger::info("Total time: {} seconds", totalTime.count());
-		utils::Logger::info("Average FPS: {}", avgFps);
-		utils::Logger::info("Output file: {}", opts.outputFile);
+		timer.record(timer.zone("main_total"), mainStart, utils::Timer::now() - mainStart);
 		
 		// Print timing report if verbose mode is enabled
 		if (opts.verbose) {
-			utils::Timer::getInstance().printReport();
+			utils::Logger::flush();
+			timer.printReport();
+			utils::MemoryBudget::getInstance().printReport();
+			if (utils::FrameArena::isEnabled()) {
+				utils::FrameArena::Stats arenaStats = utils::FrameArena::getInstance().getStats();
+				utils::Logger::info("Frame arena: {} MB mapped ({} MB explicit huge pages, {} MB transparent), {} buffers, {} reused",
+					arenaStats.mappedBytes >> 20, arenaStats.explicitHugeBytes >> 20,
+					arenaStats.transparentHugeBytes >> 20, arenaStats.allocations, arenaStats.reused);
+			}
 		}
-		
-		// Explicit cleanup to ensure proper destruction order
-		// Clear decoders first (they may reference the shared hardware context)
-		decoders.clear();
-		
-		// For hardware encoding, add a small delay to ensure GPU operations complete
-		if (opts.hwEncode || opts.hwDecode) {
-			// Give GPU time to finish any pending operations
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (!opts.traceFile.empty()) {
+			if (!timer.writeTrace(opts.traceFile)) {
+				throw std::runtime_error("Failed to write trace: " + opts.traceFile);
+			}
+			utils::Logger::info("Trace written to {}", opts.traceFile);
 		}
 		
 		// Reset the shared hardware context manager
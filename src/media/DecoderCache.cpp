@@ -0,0 +1,170 @@
+#include "media/DecoderCache.h"
+#include "utils/Logger.h"
+#include <chrono>
+#include <filesystem>
+
+namespace media {
+
+DecoderCache::DecoderCache(const Config& config)
+	: config(config)
+	, memory("warm decoders", utils::MemoryBudget::CACHE) {
+}
+
+DecoderCache::~DecoderCache() {
+	clear();
+}
+
+DecoderCache::FileIdentity DecoderCache::identify(const std::string& path) {
+	FileIdentity identity;
+	std::error_code ec;
+	auto fileSize = std::filesystem::file_size(path, ec);
+	if (ec) {
+		return identity;
+	}
+	auto writeTime = std::filesystem::last_write_time(path, ec);
+	if (ec) {
+		return identity;
+	}
+	identity.size = static_cast<int64_t>(fileSize);
+	identity.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(writeTime.time_since_epoch()).count();
+	return identity;
+}
+
+std::string DecoderCache::keyFor(const std::string& path, const FFmpegDecoder::Config& decoderConfig) {
+	// Everything a decoder keeps from its config after the open
+	const HWConfig& hw = decoderConfig.hwConfig;
+	return path + "|" + std::to_string(decoderConfig.threadCount) + "|" +
+		std::to_string(decoderConfig.useHardwareDecoder) + std::to_string(decoderConfig.keepHardwareFrames) + "|" +
+		std::to_string(static_cast<int>(hw.type)) + ":" + std::to_string(hw.deviceIndex) + "|" +
+		std::to_string(reinterpret_cast<uintptr_t>(decoderConfig.externalHwDeviceCtx)) + "|" +
+		std::to_string(decoderConfig.lowres) + std::to_string(decoderConfig.fastDecode);
+}
+
+std::shared_ptr<const SourceProbe> DecoderCache::findProbe(const std::string& path) {
+	FileIdentity identity = identify(path);
+	if (identity.size < 0) {
+		// Not a local file (e.g. a URL); the probe cannot be validated
+		return nullptr;
+	}
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = probes.find(path);
+	if (it == probes.end()) {
+		return nullptr;
+	}
+	if (!(it->second.identity == identity)) {
+		utils::Logger::debug("Warm probe for {} is stale", path);
+		probes.erase(it);
+		return nullptr;
+	}
+	stats.probeHits++;
+	return it->second.probe;
+}
+
+void DecoderCache::storeProbe(const std::string& path, std::shared_ptr<const SourceProbe> probe) {
+	FileIdentity identity = identify(path);
+	if (identity.size < 0 || !probe || !probe->isValid()) {
+		return;
+	}
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	if (probes.size() >= config.maxProbes && probes.find(path) == probes.end()) {
+		// Probes are small; starting over is simpler than tracking their use
+		probes.clear();
+	}
+	probes[path] = {identity, std::move(probe)};
+}
+
+std::unique_ptr<FFmpegDecoder> DecoderCache::take(const std::string& path,
+	const FFmpegDecoder::Config& decoderConfig) {
+	std::string key = keyFor(path, decoderConfig);
+	FileIdentity identity = identify(path);
+	
+	std::unique_ptr<FFmpegDecoder> decoder;
+	std::unique_ptr<FFmpegDecoder> stale;
+	std::list<Idle> closed;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = trim();
+		for (auto it = idle.begin(); it != idle.end(); ++it) {
+			if (it->key != key) {
+				continue;
+			}
+			if (it->identity == identity) {
+				decoder = std::move(it->decoder);
+			} else {
+				stale = std::move(it->decoder);
+			}
+			memory.add(-static_cast<int64_t>(it->memoryBytes), -static_cast<int64_t>(it->memoryBytes));
+			idle.erase(it);
+			break;
+		}
+		
+		if (decoder) {
+			stats.decoderHits++;
+		} else {
+			stats.decoderMisses++;
+		}
+	}
+	
+	if (stale) {
+		utils::Logger::debug("Warm decoder for {} is stale", path);
+	}
+	return decoder;
+}
+
+void DecoderCache::put(const std::string& path, const FFmpegDecoder::Config& decoderConfig,
+	std::unique_ptr<FFmpegDecoder> decoder, uint64_t memoryBytes) {
+	if (!decoder || config.maxIdleDecoders == 0) {
+		return;
+	}
+	
+	Idle entry;
+	entry.key = keyFor(path, decoderConfig);
+	entry.identity = identify(path);
+	entry.decoder = std::move(decoder);
+	entry.memoryBytes = memoryBytes;
+	
+	std::list<Idle> closed;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		memory.add(static_cast<int64_t>(memoryBytes), static_cast<int64_t>(memoryBytes));
+		idle.push_front(std::move(entry));
+		closed = trim();
+	}
+}
+
+std::list<DecoderCache::Idle> DecoderCache::trim() {
+	std::list<Idle> closed;
+	while (!idle.empty() && (idle.size() > config.maxIdleDecoders || memory.pressure() > 0)) {
+		Idle& oldest = idle.back();
+		memory.add(-static_cast<int64_t>(oldest.memoryBytes), -static_cast<int64_t>(oldest.memoryBytes));
+		if (idle.size() <= config.maxIdleDecoders) {
+			memory.released(oldest.memoryBytes);
+		}
+		stats.evictions++;
+		closed.splice(closed.begin(), idle, std::prev(idle.end()));
+	}
+	return closed;
+}
+
+void DecoderCache::clear() {
+	std::list<Idle> closed;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed.swap(idle);
+		memory.set(0, 0);
+	}
+}
+
+size_t DecoderCache::getIdleCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return idle.size();
+}
+
+DecoderCache::Stats DecoderCache::getStats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+} // namespace media
\ No newline at end of file
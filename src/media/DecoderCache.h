@@ -0,0 +1,110 @@
+#pragma once
+
+#include "media/FFmpegDecoder.h"
+#include "media/SourceProbe.h"
+#include "utils/MemoryBudget.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace media {
+
+/**
+ * Probes and idle decoders kept warm between renders of one process (the
+ * render daemon).
+ *
+ * A DecoderPool configured with a cache looks up probes here before opening
+ * a source, takes an idle decoder instead of opening a new one, and hands
+ * its decoders back instead of closing them. Entries are keyed by file and
+ * validated against its size and modification time, so a replaced file is
+ * opened again. Idle decoders are also keyed by the decoder settings they
+ * were opened with; the least recently returned is closed beyond
+ * maxIdleDecoders, or when the memory budget asks caches to give back.
+ *
+ * All methods are thread-safe; pools of concurrent renders share one cache.
+ */
+class DecoderCache {
+public:
+	struct Config {
+		size_t maxIdleDecoders = 16;
+		size_t maxProbes = 4096;
+	};
+	
+	struct Stats {
+		int probeHits = 0;
+		int decoderHits = 0;
+		int decoderMisses = 0;
+		int evictions = 0;
+	};
+	
+	explicit DecoderCache(const Config& config);
+	~DecoderCache();
+	
+	DecoderCache(const DecoderCache&) = delete;
+	DecoderCache& operator=(const DecoderCache&) = delete;
+	
+	// Probe of an unchanged file from an earlier render, or null
+	std::shared_ptr<const SourceProbe> findProbe(const std::string& path);
+	void storeProbe(const std::string& path, std::shared_ptr<const SourceProbe> probe);
+	
+	/**
+	 * Take an idle decoder of the file opened with the same settings
+	 * @return null if there is none (or the file changed since)
+	 */
+	std::unique_ptr<FFmpegDecoder> take(const std::string& path, const FFmpegDecoder::Config& decoderConfig);
+	
+	/**
+	 * Keep a decoder for a later take()
+	 * @param memoryBytes Estimated memory the decoder holds
+	 */
+	void put(const std::string& path, const FFmpegDecoder::Config& decoderConfig,
+		std::unique_ptr<FFmpegDecoder> decoder, uint64_t memoryBytes);
+	
+	// Close every idle decoder (probes are kept)
+	void clear();
+	
+	size_t getIdleCount() const;
+	Stats getStats() const;
+
+private:
+	struct FileIdentity {
+		int64_t mtime = 0;
+		int64_t size = -1;
+		
+		bool operator==(const FileIdentity& other) const {
+			return mtime == other.mtime && size == other.size;
+		}
+	};
+	
+	struct Probe {
+		FileIdentity identity;
+		std::shared_ptr<const SourceProbe> probe;
+	};
+	
+	struct Idle {
+		std::string key;
+		FileIdentity identity;
+		std::unique_ptr<FFmpegDecoder> decoder;
+		uint64_t memoryBytes = 0;
+	};
+	
+	static FileIdentity identify(const std::string& path);
+	static std::string keyFor(const std::string& path, const FFmpegDecoder::Config& decoderConfig);
+	
+	// Close idle decoders beyond the cap or while the budget asks for memory;
+	// the decoders are returned so they are destroyed outside the lock
+	std::list<Idle> trim();
+	
+	Config config;
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, Probe> probes;
+	std::list<Idle> idle;                     // Most recently returned first
+	Stats stats;
+	utils::MemoryBudget::Consumer memory;
+};
+
+} // namespace media
\ No newline at end of file
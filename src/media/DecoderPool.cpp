@@ -0,0 +1,368 @@
+#include "media/DecoderPool.h"
+#include "utils/Logger.h"
+#include "utils/Timer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+namespace media {
+
+namespace {
+
+// Frames a software decoder keeps besides its own thread buffers: the output
+// frame pool (see FFmpegDecoder::setupDecoder) and typical reference frames
+constexpr int OUTPUT_POOL_FRAMES = 10;
+constexpr int REFERENCE_FRAMES = 4;
+
+uint32_t decoderOpenZone() {
+	static const uint32_t zone = utils::Timer::getInstance().zone("decoder_open");
+	return zone;
+}
+
+}
+
+DecoderPool::DecoderPool(const Config& config)
+	: config(config)
+	, memory("decoders", utils::MemoryBudget::DECODER) {
+	this->config.maxOpenDecoders = std::max<size_t>(2, config.maxOpenDecoders);
+}
+
+DecoderPool::~DecoderPool() {
+	closeAll();
+}
+
+void DecoderPool::addSource(const std::string& uri, const std::string& path,
+	std::shared_ptr<const SourceProbe> probe) {
+	Source& source = sources[uri];
+	source.path = path;
+	source.probe = std::move(probe);
+	if (!source.probe && config.cache) {
+		source.probe = config.cache->findProbe(path);
+	}
+}
+
+FFmpegDecoder* DecoderPool::acquire(const std::string& uri) {
+	auto it = sources.find(uri);
+	if (it == sources.end()) {
+		return nullptr;
+	}
+	
+	Source& source = it->second;
+	current = uri;
+	if (source.decoder) {
+		touch(source);
+		updateBudget();
+	} else {
+		open(uri, source);
+	}
+	if (memory.pressure() > 0) {
+		evict(uri);
+	}
+	return source.decoder.get();
+}
+
+void DecoderPool::prefetch(const std::string& uri) {
+	auto it = sources.find(uri);
+	if (it == sources.end() || it->second.decoder) {
+		return;
+	}
+	
+	try {
+		open(uri, it->second);
+	} catch (const std::exception& e) {
+		utils::Logger::debug("Prefetch of {} failed: {}", uri, e.what());
+	}
+}
+
+std::shared_ptr<const SourceProbe> DecoderPool::getProbe(const std::string& uri) const {
+	auto it = sources.find(uri);
+	return it != sources.end() ? it->second.probe : nullptr;
+}
+
+void DecoderPool::closeAll() {
+	for (auto& [uri, source] : sources) {
+		retire(source);
+		source.memoryEstimate = 0;
+		source.codecMemory = 0;
+	}
+	lru.clear();
+	current.clear();
+	memoryEstimate = 0;
+	codecMemory = 0;
+	updateBudget();
+}
+
+std::unique_ptr<FFmpegDecoder> DecoderPool::createDecoder(const std::string& uri, const Source& source) const {
+	if (config.cache) {
+		if (auto decoder = config.cache->take(source.path, config.decoderConfig)) {
+			utils::Logger::debug("Reusing warm decoder for {}", uri);
+			return decoder;
+		}
+	}
+	
+	FFmpegDecoder::Config decoderConfig = config.decoderConfig;
+	decoderConfig.probe = source.probe;
+	
+	utils::Logger::debug("Opening decoder for {}", uri);
+	try {
+		return std::make_unique<FFmpegDecoder>(source.path, decoderConfig);
+	} catch (const std::exception& e) {
+		utils::Logger::error("Failed to load media {}: {}", source.path, e.what());
+		throw;
+	}
+}
+
+void DecoderPool::adopt(const std::string& uri, Source& source, std::unique_ptr<FFmpegDecoder> decoder,
+	double seconds) {
+	source.decoder = std::move(decoder);
+	source.openCount++;
+	source.openSeconds += seconds;
+	utils::Timer::getInstance().addTiming(decoderOpenZone(), seconds);
+	
+	// Keep the probe so a reopen after eviction is cheap
+	source.probe = std::make_shared<const SourceProbe>(source.decoder->getProbe());
+	if (config.cache) {
+		config.cache->storeProbe(source.path, source.probe);
+	}
+	source.memoryEstimate = estimateMemory(*source.decoder);
+	memoryEstimate += source.memoryEstimate;
+	source.codecMemory = estimateCodecMemory(*source.decoder);
+	codecMemory += source.codecMemory;
+	
+	lru.push_front(uri);
+	source.lruPosition = lru.begin();
+	
+	stats.opens++;
+	if (source.openedBefore) {
+		stats.reopens++;
+	}
+	source.openedBefore = true;
+	
+	updateBudget();
+	evict(uri);
+	
+	stats.peakOpen = std::max(stats.peakOpen, lru.size());
+	stats.peakMemoryBytes = std::max(stats.peakMemoryBytes, memoryEstimate);
+}
+
+void DecoderPool::open(const std::string& uri, Source& source) {
+	auto start = std::chrono::steady_clock::now();
+	auto decoder = createDecoder(uri, source);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	adopt(uri, source, std::move(decoder), elapsed.count());
+}
+
+void DecoderPool::openConcurrently(const std::vector<std::string>& uris, utils::ThreadPool& workers) {
+	struct Pending {
+		const std::string* uri;
+		Source* source;
+		bool keep;                            // Stays open, rather than only being probed
+		std::unique_ptr<FFmpegDecoder> decoder;
+		std::shared_ptr<const SourceProbe> probe;
+		double seconds = 0.0;
+	};
+	
+	// Only the sources needed first stay open. The rest are only opened when
+	// they have no probe yet (render plan or warm cache), and closed again
+	// right away, so at most one decoder per worker is held beyond the cap.
+	size_t keepOpen = config.maxOpenDecoders > lru.size() ? config.maxOpenDecoders - lru.size() : 0;
+	std::vector<Pending> pending;
+	size_t unopened = 0;
+	for (const auto& uri : uris) {
+		auto it = sources.find(uri);
+		if (it == sources.end() || it->second.decoder) {
+			continue;
+		}
+		bool keep = unopened++ < keepOpen;
+		if (keep || !it->second.probe) {
+			pending.push_back({&it->first, &it->second, keep, nullptr, nullptr});
+		}
+	}
+	if (pending.empty()) {
+		return;
+	}
+	
+	// Every worker pulls the next unopened source, so one slow source does not
+	// hold up the others
+	std::atomic<size_t> next{0};
+	workers.parallelFor(workers.getThreadCount(), [&](int, int) {
+		for (size_t i = next++; i < pending.size(); i = next++) {
+			auto start = std::chrono::steady_clock::now();
+			try {
+				auto decoder = createDecoder(*pending[i].uri, *pending[i].source);
+				pending[i].probe = std::make_shared<const SourceProbe>(decoder->getProbe());
+				if (pending[i].keep) {
+					pending[i].decoder = std::move(decoder);
+				} else {
+					release(*pending[i].source, std::move(decoder));
+				}
+			} catch (const std::exception&) {
+				// Already logged; acquire() retries and reports it
+			}
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			pending[i].seconds = elapsed.count();
+		}
+	}, 1);
+	
+	for (auto& item : pending) {
+		if (item.decoder && hasRoomFor(estimateMemory(*item.decoder))) {
+			adopt(*item.uri, *item.source, std::move(item.decoder), item.seconds);
+			continue;
+		}
+		if (!item.probe) {
+			continue;
+		}
+		
+		// Probed but not kept open: the source reopens cheaply when needed
+		release(*item.source, std::move(item.decoder));
+		item.source->probe = item.probe;
+		if (config.cache) {
+			config.cache->storeProbe(item.source->path, item.probe);
+		}
+		item.source->openCount++;
+		item.source->openSeconds += item.seconds;
+		item.source->openedBefore = true;
+		utils::Timer::getInstance().addTiming(decoderOpenZone(), item.seconds);
+		stats.opens++;
+	}
+}
+
+void DecoderPool::release(const Source& source, std::unique_ptr<FFmpegDecoder> decoder) const {
+	if (config.cache && decoder) {
+		uint64_t bytes = estimateMemory(*decoder);
+		config.cache->put(source.path, config.decoderConfig, std::move(decoder), bytes);
+	}
+}
+
+void DecoderPool::close(const std::string& uri, Source& source) {
+	utils::Logger::debug("Closing decoder for {}", uri);
+	lru.erase(source.lruPosition);
+	retire(source);
+	memoryEstimate -= source.memoryEstimate;
+	source.memoryEstimate = 0;
+	codecMemory -= source.codecMemory;
+	source.codecMemory = 0;
+	stats.evictions++;
+	updateBudget();
+}
+
+void DecoderPool::retire(Source& source) {
+	if (config.cache && source.decoder) {
+		config.cache->put(source.path, config.decoderConfig, std::move(source.decoder), source.memoryEstimate);
+	}
+	source.decoder.reset();
+}
+
+void DecoderPool::touch(Source& source) {
+	lru.splice(lru.begin(), lru, source.lruPosition);
+	source.lruPosition = lru.begin();
+}
+
+void DecoderPool::evict(const std::string& keep) {
+	auto overLimit = [this]() {
+		return lru.size() > config.maxOpenDecoders ||
+			(config.maxMemoryBytes > 0 && memoryEstimate > config.maxMemoryBytes);
+	};
+	
+	// Walk from the least recently used end, sparing the decoder just opened
+	// and the one the render loop is currently reading from
+	auto it = lru.end();
+	while (it != lru.begin()) {
+		bool overCap = overLimit();
+		if (!overCap && memory.pressure() == 0) {
+			break;
+		}
+		--it;
+		if (*it == keep || *it == current) {
+			continue;
+		}
+		std::string uri = *it;
+		it = std::next(it);
+		Source& source = sources[uri];
+		if (!overCap) {
+			// Its output frame pool goes with it
+			memory.released(source.memoryEstimate);
+		}
+		close(uri, source);
+	}
+}
+
+void DecoderPool::updateBudget() {
+	uint64_t inUse = 0;
+	auto it = sources.find(current);
+	if (it != sources.end()) {
+		inUse = it->second.codecMemory;
+	}
+	memory.set(codecMemory, codecMemory - inUse);
+}
+
+bool DecoderPool::hasRoomFor(uint64_t bytes) const {
+	return config.maxMemoryBytes == 0 || memoryEstimate + bytes <= config.maxMemoryBytes;
+}
+
+uint64_t DecoderPool::estimateMemory(const FFmpegDecoder& decoder) const {
+	int frameBytes = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, decoder.getWidth(), decoder.getHeight(), 32);
+	if (frameBytes <= 0) {
+		return 0;
+	}
+	return static_cast<uint64_t>(frameBytes) * OUTPUT_POOL_FRAMES + estimateCodecMemory(decoder);
+}
+
+uint64_t DecoderPool::estimateCodecMemory(const FFmpegDecoder& decoder) const {
+	int frameBytes = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, decoder.getWidth(), decoder.getHeight(), 32);
+	if (frameBytes <= 0) {
+		return 0;
+	}
+	
+	// Frame threading holds one frame in flight per thread
+	int threads = std::max(1, config.decoderConfig.threadCount);
+	return static_cast<uint64_t>(frameBytes) * (REFERENCE_FRAMES + threads);
+}
+
+void DecoderPool::logStats() const {
+	utils::Logger::info("Decoder pool: {} opens ({} reopens), {} evictions, peak {} open, peak ~{} MB",
+		stats.opens, stats.reopens, stats.evictions, stats.peakOpen,
+		stats.peakMemoryBytes / (1024 * 1024));
+}
+
+void DecoderPool::printOpenTimes() const {
+	std::vector<std::pair<std::string, const Source*>> opened;
+	for (const auto& [uri, source] : sources) {
+		if (source.openCount > 0) {
+			opened.emplace_back(uri, &source);
+		}
+	}
+	if (opened.empty()) {
+		return;
+	}
+	
+	// Slowest first: these bound the time to the first frame
+	std::sort(opened.begin(), opened.end(), [](const auto& a, const auto& b) {
+		return a.second->openSeconds > b.second->openSeconds;
+	});
+	
+	std::cout << "\n=== Source Open Times ===\n";
+	std::cout << std::setw(60) << std::left << "Source"
+			  << std::setw(10) << std::right << "Opens"
+			  << std::setw(12) << "Total (ms)"
+			  << std::setw(12) << "Avg (ms)" << "\n";
+	std::cout << std::string(94, '-') << "\n";
+	
+	for (const auto& [uri, source] : opened) {
+		std::string name = uri.size() > 58 ? "..." + uri.substr(uri.size() - 55) : uri;
+		std::cout << std::setw(60) << std::left << name
+				  << std::setw(10) << std::right << source->openCount
+				  << std::setw(12) << std::fixed << std::setprecision(1) << source->openSeconds * 1000.0
+				  << std::setw(12) << source->openSeconds * 1000.0 / source->openCount << "\n";
+	}
+	std::cout << std::string(94, '-') << "\n";
+}
+
+} // namespace media
\ No newline at end of file
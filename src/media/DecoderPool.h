@@ -0,0 +1,145 @@
+#pragma once
+
+#include "media/DecoderCache.h"
+#include "media/FFmpegDecoder.h"
+#include "media/SourceProbe.h"
+#include "utils/MemoryBudget.h"
+#include "utils/ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace media {
+
+/**
+ * Owns the decoders for all sources of a render and keeps only a bounded
+ * number of them open.
+ *
+ * Sources are registered up front but opened on first use, or earlier via
+ * prefetch() when the render loop sees a clip coming up. Once the open count
+ * or the estimated decoder memory exceeds its cap, the least recently used
+ * decoder is closed, as it is when the process memory budget asks decoders
+ * to give memory back. The probe taken on the first open is kept, so
+ * reopening an evicted source skips stream info discovery.
+ *
+ * At startup, openConcurrently() opens sources in parallel, so the time to
+ * the first frame follows the slowest source rather than the sum of all.
+ *
+ * With a DecoderCache (the render daemon), probes and decoders outlive the
+ * pool: sources are opened from the cache where possible, and closed
+ * decoders go back to it.
+ */
+class DecoderPool {
+public:
+	struct Config {
+		FFmpegDecoder::Config decoderConfig;  // Applied to every decoder the pool opens
+		size_t maxOpenDecoders = 16;          // At least 2 (current and next source)
+		uint64_t maxMemoryBytes = 0;          // Estimated decoder memory cap, 0 = unlimited
+		std::shared_ptr<DecoderCache> cache;  // Warm probes and decoders of earlier renders, may be null
+	};
+	
+	struct Stats {
+		int opens = 0;
+		int reopens = 0;                      // Opens of a previously evicted source
+		int evictions = 0;
+		size_t peakOpen = 0;
+		uint64_t peakMemoryBytes = 0;
+	};
+	
+	explicit DecoderPool(const Config& config);
+	~DecoderPool();
+	
+	DecoderPool(const DecoderPool&) = delete;
+	DecoderPool& operator=(const DecoderPool&) = delete;
+	
+	/**
+	 * Register a source without opening it
+	 * @param probe Known probe (e.g. from a render plan), may be null
+	 */
+	void addSource(const std::string& uri, const std::string& path,
+		std::shared_ptr<const SourceProbe> probe = nullptr);
+	
+	/**
+	 * Get the decoder for a source, opening it if needed. The pointer stays
+	 * valid until the next acquire() or prefetch() of another source.
+	 * @return nullptr for an unknown URI
+	 * @throws std::runtime_error if the source cannot be opened
+	 */
+	FFmpegDecoder* acquire(const std::string& uri);
+	
+	/**
+	 * Open a source ahead of its first frame, without making it the
+	 * current decoder. Failures are left for acquire() to report.
+	 */
+	void prefetch(const std::string& uri);
+	
+	/**
+	 * Open (probe) sources in parallel on the given workers. Sources are
+	 * adopted in the order given, so list them in order of first use. Those
+	 * beyond the open or memory cap are only opened when they have no probe
+	 * yet, and are closed again (back to the cache, if any) keeping the probe.
+	 * Failures are logged and left for acquire() to report.
+	 */
+	void openConcurrently(const std::vector<std::string>& uris, utils::ThreadPool& workers);
+	
+	// Probe of a source, from its last open or the one it was registered with
+	std::shared_ptr<const SourceProbe> getProbe(const std::string& uri) const;
+	
+	// Close every decoder (registered sources and probes are kept)
+	void closeAll();
+	
+	size_t getOpenCount() const { return lru.size(); }
+	uint64_t getMemoryEstimate() const { return memoryEstimate; }
+	const Stats& getStats() const { return stats; }
+	void logStats() const;
+	
+	// Per-source open times (verbose timing report)
+	void printOpenTimes() const;
+
+private:
+	struct Source {
+		std::string path;
+		std::shared_ptr<const SourceProbe> probe;
+		std::unique_ptr<FFmpegDecoder> decoder;
+		std::list<std::string>::iterator lruPosition;
+		uint64_t memoryEstimate = 0;
+		uint64_t codecMemory = 0;             // Part of memoryEstimate outside the output frame pool
+		bool openedBefore = false;
+		int openCount = 0;
+		double openSeconds = 0.0;             // Total time spent opening this source
+	};
+	
+	// Construct a decoder; touches no pool state, so it may run on any thread
+	std::unique_ptr<FFmpegDecoder> createDecoder(const std::string& uri, const Source& source) const;
+	void adopt(const std::string& uri, Source& source, std::unique_ptr<FFmpegDecoder> decoder, double seconds);
+	void open(const std::string& uri, Source& source);
+	// Hand a decoder that is not kept open back to the cache (or close it);
+	// thread-safe like createDecoder()
+	void release(const Source& source, std::unique_ptr<FFmpegDecoder> decoder) const;
+	void close(const std::string& uri, Source& source);
+	void retire(Source& source);
+	void touch(Source& source);
+	void evict(const std::string& keep);
+	uint64_t estimateMemory(const FFmpegDecoder& decoder) const;
+	uint64_t estimateCodecMemory(const FFmpegDecoder& decoder) const;
+	bool hasRoomFor(uint64_t bytes) const;
+	
+	// Report the open decoders to the memory budget; all but the current one
+	// could be closed
+	void updateBudget();
+	
+	Config config;
+	std::unordered_map<std::string, Source> sources;
+	std::list<std::string> lru;               // Open sources, most recently used first
+	std::string current;                      // Source returned by the last acquire()
+	uint64_t memoryEstimate = 0;
+	uint64_t codecMemory = 0;
+	utils::MemoryBudget::Consumer memory;   // Output frames are counted by their pools
+	Stats stats;
+};
+
+} // namespace media
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "media/EncoderFanout.h"
+#include "utils/FrameArena.h"
+#include "utils/Logger.h"
+#include "utils/Timer.h"
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace media {
+
+EncoderFanout::EncoderFanout(int width, int height, AVPixelFormat format, std::vector<Output> outputs)
+	: EncoderFanout(width, height, format, std::move(outputs), Config()) {
+}
+
+EncoderFanout::EncoderFanout(int width, int height, AVPixelFormat format, std::vector<Output> outputs,
+	const Config& config)
+	: width(width)
+	, height(height)
+	, format(format)
+	, config(config)
+	, memory("encoder queues", utils::MemoryBudget::QUEUE)
+	, queueDepth(std::max<size_t>(1, config.queueDepth)) {
+	
+	std::vector<std::pair<int, int>> sizes;
+	try {
+		for (auto& output : outputs) {
+			auto worker = std::make_unique<Worker>();
+			worker->filename = output.filename;
+			worker->encoder = std::make_unique<FFmpegEncoder>(output.filename, output.config);
+			worker->queue = std::make_unique<utils::BoundedQueue<QueuedFrame>>(config.queueDepth);
+			workers.push_back(std::move(worker));
+			sizes.emplace_back(output.config.width, output.config.height);
+		}
+		buildRungs(sizes);
+		for (auto& worker : workers) {
+			int rungWidth = worker->rung < 0 ? width : rungs[worker->rung].width;
+			int rungHeight = worker->rung < 0 ? height : rungs[worker->rung].height;
+			worker->frameBytes = static_cast<int64_t>(utils::FrameArena::frameBytes(format, rungWidth, rungHeight));
+		}
+	} catch (...) {
+		stopWorkers();
+		throw;
+	}
+	
+	for (auto& worker : workers) {
+		worker->thread = std::thread(&EncoderFanout::encodeLoop, this, std::ref(*worker));
+	}
+	
+	utils::Logger::info("Encoder fan-out: {} additional outputs, {} scaled sizes", workers.size(), rungs.size());
+}
+
+EncoderFanout::~EncoderFanout() {
+	if (!finalized) {
+		finalize();
+	}
+	stopWorkers();
+}
+
+void EncoderFanout::buildRungs(const std::vector<std::pair<int, int>>& sizes) {
+	// Distinct sizes other than the input, largest first
+	std::vector<std::pair<int, int>> distinct;
+	for (const auto& size : sizes) {
+		if (size != std::make_pair(width, height) &&
+			std::find(distinct.begin(), distinct.end(), size) == distinct.end()) {
+			distinct.push_back(size);
+		}
+	}
+	std::sort(distinct.begin(), distinct.end(), [](const auto& a, const auto& b) {
+		return static_cast<int64_t>(a.first) * a.second > static_cast<int64_t>(b.first) * b.second;
+	});
+	
+	for (const auto& size : distinct) {
+		Rung rung;
+		rung.width = size.first;
+		rung.height = size.second;
+		
+		// Scale from the smallest larger rung that covers both dimensions
+		int sourceWidth = width;
+		int sourceHeight = height;
+		for (int i = static_cast<int>(rungs.size()) - 1; i >= 0; i--) {
+			if (rungs[i].width >= rung.width && rungs[i].height >= rung.height) {
+				rung.source = i;
+				sourceWidth = rungs[i].width;
+				sourceHeight = rungs[i].height;
+				break;
+			}
+		}
+		
+		rung.swsCtx = sws_getContext(sourceWidth, sourceHeight, format,
+			rung.width, rung.height, format, SWS_BILINEAR, nullptr, nullptr, nullptr);
+		int bufferSize = av_image_get_buffer_size(format, rung.width, rung.height, 32);
+		rung.bufferPool = bufferSize > 0 ? av_buffer_pool_init(bufferSize, nullptr) : nullptr;
+		rungs.push_back(rung);
+		if (!rung.swsCtx || !rung.bufferPool) {
+			throw std::runtime_error("Failed to set up scaling to " + std::to_string(rung.width) + "x" +
+				std::to_string(rung.height));
+		}
+		
+		utils::Logger::debug("Fan-out rung {}x{} scaled from {}x{}", rung.width, rung.height,
+			sourceWidth, sourceHeight);
+	}
+	
+	for (size_t i = 0; i < workers.size(); i++) {
+		for (size_t r = 0; r < rungs.size(); r++) {
+			if (sizes[i] == std::make_pair(rungs[r].width, rungs[r].height)) {
+				workers[i]->rung = static_cast<int>(r);
+			}
+		}
+	}
+}
+
+AVFrame* EncoderFanout::allocRungFrame(const Rung& rung) {
+	AVFrame* frame = av_frame_alloc();
+	if (!frame) {
+		return nullptr;
+	}
+	
+	frame->buf[0] = av_buffer_pool_get(rung.bufferPool);
+	if (!frame->buf[0]) {
+		av_frame_free(&frame);
+		return nullptr;
+	}
+	av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, format,
+		rung.width, rung.height, 32);
+	frame->format = format;
+	frame->width = rung.width;
+	frame->height = rung.height;
+	return frame;
+}
+
+bool EncoderFanout::writeFrame(const AVFrame* frame) {
+	if (!frame || finalized) {
+		return false;
+	}
+	
+	adjustQueueDepth();
+	
+	// Build the pyramid for this frame, each rung from its source rung
+	std::vector<AVFrame*> scaled(rungs.size(), nullptr);
+	bool ok = true;
+	for (size_t i = 0; i < rungs.size(); i++) {
+		const Rung& rung = rungs[i];
+		const AVFrame* source = rung.source < 0 ? frame : scaled[rung.source];
+		if (!source) {
+			ok = false;
+			continue;
+		}
+		
+		AVFrame* output = allocRungFrame(rung);
+		if (!output) {
+			utils::Logger::error("Failed to allocate {}x{} frame", rung.width, rung.height);
+			ok = false;
+			continue;
+		}
+		sws_scale(rung.swsCtx, source->data, source->linesize, 0, source->height,
+			output->data, output->linesize);
+		av_frame_copy_props(output, frame);
+		scaled[i] = output;
+	}
+	
+	// Each encoder gets its own reference, since it stamps the pts
+	for (auto& worker : workers) {
+		const AVFrame* source = worker->rung < 0 ? frame : scaled[worker->rung];
+		AVFrame* copy = source ? av_frame_clone(source) : nullptr;
+		if (!copy) {
+			ok = false;
+			continue;
+		}
+		QueuedFrame item{copy, keyframePending, worker->rung < 0 ? 0 : worker->frameBytes, worker->frameBytes};
+		memory.add(item.scaledBytes, item.frameBytes);
+		if (!worker->queue->push(item)) {
+			av_frame_free(&copy);
+			dequeued(item);
+			ok = false;
+		}
+		if (worker->failed) {
+			ok = false;
+		}
+	}
+	
+	keyframePending = false;
+	
+	for (AVFrame*& output : scaled) {
+		av_frame_free(&output);
+	}
+	return ok;
+}
+
+void EncoderFanout::adjustQueueDepth() {
+	size_t depth = queueDepth;
+	int64_t slotBytes = 0;
+	for (const auto& worker : workers) {
+		slotBytes += worker->frameBytes;
+	}
+	
+	// One frame per encoder at a time: down while the budget asks for memory,
+	// back up while there is room for another frame in every queue
+	if (memory.pressure() > 0) {
+		if (depth > 1) {
+			depth--;
+			memory.released(static_cast<uint64_t>(slotBytes));
+		}
+	} else if (depth < config.queueDepth &&
+		utils::MemoryBudget::getInstance().hasRoomFor(static_cast<uint64_t>(slotBytes))) {
+		depth++;
+	}
+	
+	if (depth != queueDepth) {
+		utils::Logger::debug("Encoder fan-out queue depth {} -> {}", queueDepth, depth);
+		queueDepth = depth;
+		for (auto& worker : workers) {
+			worker->queue->setCapacity(depth);
+		}
+	}
+}
+
+void EncoderFanout::dequeued(const QueuedFrame& item) {
+	memory.add(-item.scaledBytes, -item.frameBytes);
+}
+
+void EncoderFanout::encodeLoop(Worker& worker) {
+	utils::Timer::getInstance().setThreadName("encoder " + worker.filename);
+	
+	while (auto item = worker.queue->pop()) {
+		AVFrame* frame = item->frame;
+		if (item->keyframe) {
+			worker.encoder->forceKeyframe();
+		}
+		if (!worker.failed && !worker.encoder->writeFrame(frame)) {
+			utils::Logger::error("Failed to encode frame for {}", worker.filename);
+			worker.failed = true;
+		}
+		av_frame_free(&frame);
+		dequeued(*item);
+	}
+	
+	if (!worker.encoder->finalize()) {
+		worker.failed = true;
+	}
+}
+
+bool EncoderFanout::finalize() {
+	if (finalized) {
+		return false;
+	}
+	finalized = true;
+	
+	// Workers drain their queues, then flush and write the trailer in parallel
+	for (auto& worker : workers) {
+		worker->queue->close();
+	}
+	bool ok = true;
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+		if (worker->failed) {
+			utils::Logger::error("Output {} is incomplete", worker->filename);
+			ok = false;
+		} else {
+			utils::Logger::info("Output file: {}", worker->filename);
+		}
+	}
+	return ok;
+}
+
+void EncoderFanout::stopWorkers() {
+	for (auto& worker : workers) {
+		worker->queue->close();
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+		
+		// Frames left behind if the worker never started
+		while (auto item = worker->queue->pop()) {
+			AVFrame* frame = item->frame;
+			av_frame_free(&frame);
+			dequeued(*item);
+		}
+	}
+	
+	for (auto& rung : rungs) {
+		if (rung.swsCtx) {
+			sws_freeContext(rung.swsCtx);
+			rung.swsCtx = nullptr;
+		}
+		if (rung.bufferPool) {
+			av_buffer_pool_uninit(&rung.bufferPool);
+		}
+	}
+}
+
+} // namespace media
\ No newline at end of file
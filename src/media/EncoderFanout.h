@@ -0,0 +1,121 @@
+#pragma once
+
+#include "media/FFmpegEncoder.h"
+#include "media/MediaTypes.h"
+#include "utils/BoundedQueue.h"
+#include "utils/MemoryBudget.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace media {
+
+/**
+ * Feeds one composited frame stream to several additional encoders, each
+ * with its own codec, bitrate and resolution.
+ *
+ * Every distinct output size is scaled once per frame, and smaller sizes are
+ * scaled from the next larger one rather than from the full frame, so a
+ * 1080p/540p/360p ladder costs one scale from 1080p plus one from 540p. Each
+ * encoder runs on its own thread behind a bounded queue; a full queue holds
+ * back the caller. Under memory budget pressure the queues get shallower, and
+ * they deepen again once there is room.
+ */
+class EncoderFanout {
+public:
+	struct Output {
+		std::string filename;
+		FFmpegEncoder::Config config;   // width/height select the rung
+	};
+	
+	struct Config {
+		size_t queueDepth = 8;          // Frames buffered per encoder (at most)
+	};
+	
+	/**
+	 * @param width, height, format Frames passed to writeFrame()
+	 * @throws std::runtime_error if an output cannot be opened
+	 */
+	EncoderFanout(int width, int height, AVPixelFormat format, std::vector<Output> outputs);
+	EncoderFanout(int width, int height, AVPixelFormat format, std::vector<Output> outputs,
+		const Config& config);
+	~EncoderFanout();
+	
+	EncoderFanout(const EncoderFanout&) = delete;
+	EncoderFanout& operator=(const EncoderFanout&) = delete;
+	
+	size_t size() const { return workers.size(); }
+	FFmpegEncoder& getEncoder(size_t index) { return *workers[index]->encoder; }
+	
+	/**
+	 * Queue a frame for every output, waiting while a queue is full. The frame
+	 * is not modified and may be reused once this returns.
+	 * @return false if an encoder has failed
+	 */
+	bool writeFrame(const AVFrame* frame);
+	
+	// Code the next frame as a keyframe in every output
+	void forceKeyframe() { keyframePending = true; }
+	
+	/**
+	 * Drain the queues, flush every encoder and write the trailers
+	 * @return false if any output failed
+	 */
+	bool finalize();
+
+private:
+	// One output size; source is the rung it is scaled from (-1 = input frame).
+	// Scaled frames come from a buffer pool and are shared by reference
+	// between the encoders of the rung.
+	struct Rung {
+		int width = 0;
+		int height = 0;
+		int source = -1;
+		SwsContext* swsCtx = nullptr;
+		AVBufferPool* bufferPool = nullptr;
+	};
+	
+	struct QueuedFrame {
+		AVFrame* frame = nullptr;
+		bool keyframe = false;
+		int64_t scaledBytes = 0;        // Held only by the queue (input frames belong to their pool)
+		int64_t frameBytes = 0;
+	};
+	
+	struct Worker {
+		std::unique_ptr<FFmpegEncoder> encoder;
+		std::string filename;
+		int rung = -1;                  // -1 = input size
+		int64_t frameBytes = 0;
+		std::unique_ptr<utils::BoundedQueue<QueuedFrame>> queue;
+		std::thread thread;
+		std::atomic<bool> failed{false};
+	};
+	
+	void buildRungs(const std::vector<std::pair<int, int>>& sizes);
+	AVFrame* allocRungFrame(const Rung& rung);
+	void encodeLoop(Worker& worker);
+	void adjustQueueDepth();
+	void dequeued(const QueuedFrame& item);
+	void stopWorkers();
+	
+	int width;
+	int height;
+	AVPixelFormat format;
+	Config config;
+	
+	std::vector<Rung> rungs;            // Largest first
+	std::vector<std::unique_ptr<Worker>> workers;
+	bool keyframePending = false;
+	bool finalized = false;
+	
+	// Scaled frames waiting in the queues; every queued frame could be given
+	// back by a shallower queue
+	utils::MemoryBudget::Consumer memory;
+	size_t queueDepth;
+};
+
+} // namespace media
\ No newline at end of file
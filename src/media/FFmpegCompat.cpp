@@ -85,6 +85,28 @@ void FFmpegCompat::flushBuffers(AVCodecContext* codecCtx) {
 	avcodec_flush_buffers(codecCtx);
 }
 
+std::vector<int64_t> FFmpegCompat::getKeyframeTimestamps(AVStream* stream) {
+	std::vector<int64_t> keyframes;
+#if HAVE_INDEX_ENTRY_API
+	int count = avformat_index_get_entries_count(stream);
+	keyframes.reserve(count > 0 ? count : 0);
+	for (int i = 0; i < count; i++) {
+		const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+		if (entry && (entry->flags & AVINDEX_KEYFRAME)) {
+			keyframes.push_back(entry->timestamp);
+		}
+	}
+#else
+	keyframes.reserve(stream->nb_index_entries);
+	for (int i = 0; i < stream->nb_index_entries; i++) {
+		if (stream->index_entries[i].flags & AVINDEX_KEYFRAME) {
+			keyframes.push_back(stream->index_entries[i].timestamp);
+		}
+	}
+#endif
+	return keyframes;
+}
+
 // New API implementations (FFmpeg 3.1+)
 bool FFmpegCompat::decodeVideoFrameNew(AVCodecContext* codecCtx, AVFrame* frame, AVPacket* packet) {
 #if HAVE_SEND_RECEIVE_API
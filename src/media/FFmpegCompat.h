@@ -6,6 +6,8 @@ extern "C" {
 #include <libavutil/avutil.h>
 }
 
+#include <vector>
+
 namespace media {
 
 // Version detection macros
@@ -25,6 +27,14 @@ namespace media {
 // Hardware device API was added in FFmpeg 3.2 (libavcodec 57.60.100)
 #define HAVE_HWDEVICE_API (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 60, 100))
 #endif
+#ifndef HAVE_INDEX_ENTRY_API
+// AVStream index entries became private in FFmpeg 4.4 (libavformat 58.78.100)
+#define HAVE_INDEX_ENTRY_API (LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100))
+#endif
+#ifndef HAVE_CH_LAYOUT_API
+// AVChannelLayout replaced the channel_layout/channels pair in FFmpeg 5.1 (libavutil 57.28.100)
+#define HAVE_CH_LAYOUT_API (LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100))
+#endif
 
 /**
  * Compatibility wrapper for video frame decoding
@@ -92,6 +102,13 @@ public:
 	 * @param codecCtx Codec context to flush
 	 */
 	static void flushBuffers(AVCodecContext* codecCtx);
+	
+	/**
+	 * Get the keyframe timestamps known to the demuxer's index
+	 * @param stream The stream
+	 * @return Keyframe timestamps in stream time base, in index order (may be empty)
+	 */
+	static std::vector<int64_t> getKeyframeTimestamps(AVStream* stream);
 
 private:
 	// Helper functions for different API versions
@@ -1,6 +1,7 @@
 #include "media/FFmpegDecoder.h"
 #include "media/FFmpegCompat.h"
 #include "media/HardwareAcceleration.h"
+#include "utils/FrameArena.h"
 #include "utils/Logger.h"
 #include "utils/Timer.h"
 #include <stdexcept>
@@ -15,11 +16,41 @@ extern "C" {
 
 namespace media {
 
+namespace {
+
+// get_buffer2 callback that places decoded pictures in the frame arena.
+// Codecs without direct rendering support, and formats the arena cannot lay
+// out, use FFmpeg's own buffer pools.
+int getArenaBuffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+	if (!(ctx->codec->capabilities & AV_CODEC_CAP_DR1)) {
+		return avcodec_default_get_buffer2(ctx, frame, flags);
+	}
+	
+	// Decoders write whole macroblocks and expect strides aligned for their
+	// SIMD code
+	int width = frame->width;
+	int height = frame->height;
+	int linesizeAlign[AV_NUM_DATA_POINTERS];
+	avcodec_align_dimensions2(ctx, &width, &height, linesizeAlign);
+	int align = 64;
+	for (int i = 0; i < 4; i++) {
+		align = std::max(align, linesizeAlign[i]);
+	}
+	
+	if (utils::FrameArena::getInstance().allocatePlanes(frame, width, height, align)) {
+		return 0;
+	}
+	return avcodec_default_get_buffer2(ctx, frame, flags);
+}
+
+}
+
 FFmpegDecoder::FFmpegDecoder(const std::string& filename) 
 	: decoderConfig{} {
 	openFile(filename);
 	findVideoStream();
 	setupDecoder();
+	buildProbe();
 }
 
 FFmpegDecoder::FFmpegDecoder(const std::string& filename, const Config& config) 
@@ -27,6 +58,7 @@ FFmpegDecoder::FFmpegDecoder(const std::string& filename, const Config& config)
 	openFile(filename);
 	findVideoStream();
 	setupDecoder();
+	buildProbe();
 }
 
 FFmpegDecoder::~FFmpegDecoder() {
@@ -48,6 +80,9 @@ FFmpegDecoder::FFmpegDecoder(FFmpegDecoder&& other) noexcept
 	, timeBase(other.timeBase)
 	, totalFrames(other.totalFrames)
 	, currentFrameNumber(other.currentFrameNumber)
+	, startPts(other.startPts)
+	, probeFromCache(other.probeFromCache)
+	, probe(std::move(other.probe))
 	, framePool(std::move(other.framePool)) {
 	
 	other.formatCtx = nullptr;
@@ -76,6 +111,9 @@ FFmpegDecoder& FFmpegDecoder::operator=(FFmpegDecoder&& other) noexcept {
 		timeBase = other.timeBase;
 		totalFrames = other.totalFrames;
 		currentFrameNumber = other.currentFrameNumber;
+		startPts = other.startPts;
+		probeFromCache = other.probeFromCache;
+		probe = std::move(other.probe);
 		framePool = std::move(other.framePool);
 		
 		other.formatCtx = nullptr;
@@ -97,12 +135,17 @@ void FFmpegDecoder::openFile(const std::string& filename) {
 		throw std::runtime_error("Failed to open input file: " + std::string(errbuf));
 	}
 	
-	{
+	// Stream info discovery decodes frames and dominates open time; skip it
+	// when a cached probe still describes this container
+	probeFromCache = matchesCachedProbe();
+	if (!probeFromCache) {
 		TIME_BLOCK("decoder_find_stream_info");
 		ret = avformat_find_stream_info(formatCtx, nullptr);
 		if (ret < 0) {
 			throw std::runtime_error("Failed to find stream info");
 		}
+	} else {
+		utils::Logger::debug("Using cached probe for {}", filename);
 	}
 	
 	packet = FFmpegCompat::allocPacket();
@@ -111,6 +154,31 @@ void FFmpegDecoder::openFile(const std::string& filename) {
 	}
 }
 
+bool FFmpegDecoder::matchesCachedProbe() const {
+	const SourceProbe* cached = decoderConfig.probe.get();
+	if (!cached || !cached->isValid()) {
+		return false;
+	}
+	
+#if HAVE_CODECPAR_API
+	// The container header alone must already agree with the cached values
+	for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+		const AVStream* stream = formatCtx->streams[i];
+		if (stream->codecpar->codec_type != AVMEDIA_TYPE_VIDEO) {
+			continue;
+		}
+		return stream->codecpar->codec_id != AV_CODEC_ID_NONE &&
+			stream->codecpar->codec_id == cached->codecId &&
+			(stream->codecpar->format == AV_PIX_FMT_NONE || stream->codecpar->format == cached->pixelFormat) &&
+			stream->codecpar->width == cached->width &&
+			stream->codecpar->height == cached->height &&
+			stream->time_base.num == cached->timeBaseNum &&
+			stream->time_base.den == cached->timeBaseDen;
+	}
+#endif
+	return false;
+}
+
 void FFmpegDecoder::findVideoStream() {
 	for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
 #if HAVE_CODECPAR_API
@@ -129,6 +197,15 @@ void FFmpegDecoder::findVideoStream() {
 	
 	AVStream* stream = formatCtx->streams[videoStreamIndex];
 	timeBase = stream->time_base;
+	startPts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+	
+	if (probeFromCache) {
+		const SourceProbe& cached = *decoderConfig.probe;
+		frameRate = {cached.frameRateNum, cached.frameRateDen};
+		totalFrames = cached.totalFrames;
+		return;
+	}
+	
 	frameRate = av_guess_frame_rate(formatCtx, stream, nullptr);
 	
 	// Calculate total frames
@@ -230,6 +307,12 @@ void FFmpegDecoder::setupDecoder() {
 		throw std::runtime_error("Failed to copy codec parameters");
 	}
 	
+	// Without stream info discovery, codecs such as H.264 only learn their
+	// pixel format from the first decoded picture; the frame pool needs it now
+	if (probeFromCache && codecCtx->pix_fmt == AV_PIX_FMT_NONE) {
+		codecCtx->pix_fmt = static_cast<AVPixelFormat>(decoderConfig.probe->pixelFormat);
+	}
+	
 	// Set up hardware acceleration context if needed
 	if (usingHardware) {
 		HWAccelType hwType = decoderConfig.hwConfig.type == HWAccelType::Auto ? 
@@ -277,6 +360,26 @@ void FFmpegDecoder::setupDecoder() {
 	codecCtx->thread_count = decoderConfig.threadCount; // 0 means auto-detect optimal thread count
 	codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; // Enable both frame and slice threading
 	
+	// Software decoders write straight into arena buffers when it is enabled.
+	// The callback is thread-safe, so frame threads may call it directly.
+	if (!usingHardware && utils::FrameArena::isEnabled()) {
+		codecCtx->get_buffer2 = getArenaBuffer;
+#if LIBAVCODEC_VERSION_MAJOR < 60
+		codecCtx->thread_safe_callbacks = 1;
+#endif
+	}
+	
+	// Reduced-resolution decoding is only offered by some codecs (MPEG-2,
+	// MPEG-4 part 2, MJPEG, ...); the others fall back to full size and only
+	// get the cheaper filtering
+	if (!usingHardware && decoderConfig.lowres > 0) {
+		codecCtx->lowres = std::min(decoderConfig.lowres, static_cast<int>(codec->max_lowres));
+	}
+	if (!usingHardware && decoderConfig.fastDecode) {
+		codecCtx->skip_loop_filter = AVDISCARD_ALL;
+		codecCtx->flags2 |= AV_CODEC_FLAG2_FAST;
+	}
+	
 	ret = avcodec_open2(codecCtx, codec, nullptr);
 	if (ret < 0) {
 		throw std::runtime_error("Failed to open codec");
@@ -305,6 +408,50 @@ void FFmpegDecoder::setupDecoder() {
 		width, height, (double)frameRate.num / frameRate.den,
 		codecCtx->thread_count == 0 ? "auto" : std::to_string(codecCtx->thread_count),
 		usingHardware ? "yes" : "no");
+	if (codecCtx->lowres > 0) {
+		utils::Logger::debug("Decoding at 1/{} resolution", 1 << codecCtx->lowres);
+	}
+}
+
+void FFmpegDecoder::buildProbe() {
+	probe.width = width;
+	probe.height = height;
+#if HAVE_CODECPAR_API
+	// Probes describe the source, not a reduced-resolution decode of it
+	if (codecCtx->lowres > 0) {
+		probe.width = formatCtx->streams[videoStreamIndex]->codecpar->width;
+		probe.height = formatCtx->streams[videoStreamIndex]->codecpar->height;
+	}
+#endif
+	// Probes hold the software format, which is what a later open decodes to
+	probe.pixelFormat = pixelFormat;
+#if HAVE_CODECPAR_API
+	if (usingHardware && HardwareAcceleration::isHardwarePixelFormat(pixelFormat)) {
+		probe.pixelFormat = formatCtx->streams[videoStreamIndex]->codecpar->format;
+	}
+#endif
+	probe.codecId = codecCtx->codec_id;
+	probe.frameRateNum = frameRate.num;
+	probe.frameRateDen = frameRate.den;
+	probe.timeBaseNum = timeBase.num;
+	probe.timeBaseDen = timeBase.den;
+	probe.totalFrames = totalFrames;
+	
+	if (probeFromCache) {
+		probe.keyframes = decoderConfig.probe->keyframes;
+		return;
+	}
+	
+	// Keyframe index from the demuxer (complete for MP4/MOV, may be partial
+	// or empty for formats that index lazily)
+	probe.keyframes.clear();
+	for (int64_t timestamp : FFmpegCompat::getKeyframeTimestamps(formatCtx->streams[videoStreamIndex])) {
+		probe.keyframes.push_back(ptsToFrameNumber(timestamp - startPts));
+	}
+	std::sort(probe.keyframes.begin(), probe.keyframes.end());
+	probe.keyframes.erase(std::unique(probe.keyframes.begin(), probe.keyframes.end()), probe.keyframes.end());
+	
+	utils::Logger::debug("Keyframe index: {} entries", probe.keyframes.size());
 }
 
 void FFmpegDecoder::cleanup() {
@@ -347,28 +494,10 @@ bool FFmpegDecoder::seekToFrame(int64_t frameNumber) {
 		return true;
 	}
 	
-	// Check if we need to seek backward or if we're too far ahead
-	// Only seek if we need to go backward or if we're more than 60 frames ahead
-	// (seeking forward through 60+ frames is slower than seeking)
-	if (currentFrameNumber > frameNumber || currentFrameNumber < frameNumber - 60) {
-		// Seek to a keyframe before the target
-		int64_t targetPts = frameNumberToPts(frameNumber);
-		int ret = av_seek_frame(formatCtx, videoStreamIndex, targetPts,
-			AVSEEK_FLAG_BACKWARD);
-		
-		if (ret < 0) {
-			utils::Logger::error("Failed to seek to frame {}", frameNumber);
-			return false;
-		}
-		
-		// Flush codec buffers to clear decoder state
-		FFmpegCompat::flushBuffers(codecCtx);
-		
-		// Clear any cached packets
-		av_packet_unref(packet);
-		
-		// Reset frame position
-		currentFrameNumber = -1;
+	int64_t seekTarget = findSeekTarget(frameNumber);
+	if (seekTarget >= 0 && !seekToKeyframe(seekTarget)) {
+		utils::Logger::error("Failed to seek to frame {}", frameNumber);
+		return false;
 	}
 	
 	// Decode frames until we reach the target
@@ -393,29 +522,13 @@ bool FFmpegDecoder::seekToFrameHardware(int64_t frameNumber) {
 		return true;
 	}
 	
-	// Check if we need to seek backward or if we're too far ahead
-	// Only seek if we need to go backward or if we're more than 60 frames ahead
-	// (seeking forward through 60+ frames is slower than seeking)
-	if (currentFrameNumber > frameNumber || currentFrameNumber < frameNumber - 60) {
-		// Seek to a keyframe before the target
-		int64_t targetPts = frameNumberToPts(frameNumber);
-		int ret = av_seek_frame(formatCtx, videoStreamIndex, targetPts,
-			AVSEEK_FLAG_BACKWARD);
-		
-		if (ret < 0) {
-			utils::Logger::error("Failed to seek to frame {} (PTS: {})", frameNumber, targetPts);
+	int64_t seekTarget = findSeekTarget(frameNumber);
+	if (seekTarget >= 0) {
+		if (!seekToKeyframe(seekTarget)) {
+			utils::Logger::error("Failed to seek to frame {} (PTS: {})", frameNumber, frameNumberToPts(seekTarget));
 			return false;
 		}
 		
-		// Flush codec buffers to clear decoder state
-		FFmpegCompat::flushBuffers(codecCtx);
-		
-		// Clear any cached packets
-		av_packet_unref(packet);
-		
-		// Reset frame position
-		currentFrameNumber = -1;
-		
 		utils::Logger::debug("Hardware seek: jumped to keyframe before frame {} (current: {})", 
 			frameNumber, currentFrameNumber);
 	}
@@ -433,6 +546,52 @@ bool FFmpegDecoder::seekToFrameHardware(int64_t frameNumber) {
 	return true;
 }
 
+int64_t FFmpegDecoder::findSeekTarget(int64_t frameNumber) const {
+	const auto& keyframes = probe.keyframes;
+	
+	if (keyframes.empty()) {
+		// No index: only seek if we need to go backward or if we're more than
+		// 60 frames ahead (seeking forward through 60+ frames is slower than seeking)
+		if (currentFrameNumber > frameNumber || currentFrameNumber < frameNumber - 60) {
+			return frameNumber;
+		}
+		return -1;
+	}
+	
+	// Nearest keyframe at or before the target
+	auto it = std::upper_bound(keyframes.begin(), keyframes.end(), frameNumber);
+	int64_t keyframe = it == keyframes.begin() ? 0 : *(it - 1);
+	
+	// Going forward, a seek only pays off if it skips decoding frames, i.e.
+	// there is a keyframe past the next frame we would decode anyway
+	if (currentFrameNumber > frameNumber || keyframe > currentFrameNumber + 1) {
+		return keyframe;
+	}
+	return -1;
+}
+
+bool FFmpegDecoder::seekToKeyframe(int64_t keyframe) {
+	// Seek to a keyframe at or before the target
+	int64_t targetPts = frameNumberToPts(keyframe) + (probe.keyframes.empty() ? 0 : startPts);
+	int ret = av_seek_frame(formatCtx, videoStreamIndex, targetPts,
+		AVSEEK_FLAG_BACKWARD);
+	
+	if (ret < 0) {
+		return false;
+	}
+	
+	// Flush codec buffers to clear decoder state
+	FFmpegCompat::flushBuffers(codecCtx);
+	
+	// Clear any cached packets
+	av_packet_unref(packet);
+	
+	// Reset frame position. With an index we know exactly which keyframe we
+	// landed on; without one, decoding restarts the count from the beginning
+	currentFrameNumber = probe.keyframes.empty() ? -1 : keyframe - 1;
+	return true;
+}
+
 std::shared_ptr<AVFrame> FFmpegDecoder::getFrame(int64_t frameNumber) {
 	if (!seekToFrame(frameNumber)) {
 		return nullptr;
@@ -537,11 +696,7 @@ bool FFmpegDecoder::decodeNextHardwareFrame(AVFrame* frame) {
 }
 
 bool FFmpegDecoder::decodeNextFrame(AVFrame* frame) {
-	// Add timing only for first 10 frames
-	static int decodeCount = 0;
-	if (decodeCount < 10) {
-		TIME_BLOCK(std::string("decode_frame_") + std::to_string(decodeCount++));
-	}
+	TIME_BLOCK("decode_frame");
 	
 	// Use a temporary frame for hardware decoding
 	AVFrame* decodedFrame = frame;
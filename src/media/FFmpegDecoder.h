@@ -2,6 +2,7 @@
 
 #include "media/MediaTypes.h"
 #include "media/HardwareAcceleration.h"
+#include "media/SourceProbe.h"
 #include "utils/FrameBuffer.h"
 #include <string>
 #include <memory>
@@ -18,9 +19,19 @@ public:
 		bool useHardwareDecoder = false;  // Enable hardware decoding
 		bool keepHardwareFrames = false;  // Keep frames on GPU (for passthrough)
 		
+		// Preview decoding (software decoders only): decode at 1/2^lowres of
+		// the size where the codec supports it, and trade exactness for speed
+		// (no loop filter, fast non-compliant shortcuts)
+		int lowres = 0;
+		bool fastDecode = false;
+		
 		// External hardware context (optional)
 		// If provided, this context will be used instead of creating a new one
 		AVBufferRef* externalHwDeviceCtx = nullptr;
+		
+		// Probe result from a previous open (e.g. a cached render plan)
+		// If it still matches the container header, stream info discovery is skipped
+		std::shared_ptr<const SourceProbe> probe;
 	};
 	
 	FFmpegDecoder(const std::string& filename);
@@ -53,9 +64,19 @@ public:
 	int64_t getTotalFrames() const { return totalFrames; }
 	bool isUsingHardware() const { return usingHardware; }
 	
+	// Stream properties and keyframe index, suitable for caching
+	const SourceProbe& getProbe() const { return probe; }
+	
+	// Whether the open trusted Config::probe instead of discovering stream info
+	bool usedCachedProbe() const { return probeFromCache; }
+	
 private:
 	void openFile(const std::string& filename);
+	bool matchesCachedProbe() const;
 	void findVideoStream();
+	void buildProbe();
+	int64_t findSeekTarget(int64_t frameNumber) const;
+	bool seekToKeyframe(int64_t keyframe);
 	void setupDecoder();
 	void cleanup();
 	bool decodeNextFrame(AVFrame* frame);
@@ -86,6 +107,9 @@ private:
 	AVRational timeBase = {0, 1};
 	int64_t totalFrames = 0;
 	int64_t currentFrameNumber = -1;
+	int64_t startPts = 0;             // Stream start time (time base units)
+	bool probeFromCache = false;      // Stream info discovery was skipped
+	SourceProbe probe;
 	
 	Config decoderConfig;
 	utils::FrameBufferPool framePool;
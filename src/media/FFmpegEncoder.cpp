@@ -1,8 +1,12 @@
 #include "media/FFmpegEncoder.h"
 #include "media/FFmpegCompat.h"
 #include "media/HardwareAcceleration.h"
+#include "utils/FrameArena.h"
 #include "utils/Logger.h"
 #include "utils/Timer.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <stdexcept>
 #include <thread>
 #include <chrono>
@@ -10,6 +14,7 @@
 extern "C" {
 #include <libavutil/opt.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/channel_layout.h>
 #if HAVE_HWDEVICE_API
 #include <libavutil/hwcontext.h>
 #endif
@@ -59,6 +64,7 @@ FFmpegEncoder::FFmpegEncoder(FFmpegEncoder&& other) noexcept
 	, packet(other.packet)
 	, swsCtx(other.swsCtx)
 	, convertedFrame(other.convertedFrame)
+	, memory(std::move(other.memory))
 	, hwDeviceCtx(other.hwDeviceCtx)
 	, hwFrame(other.hwFrame)
 	, usingHardware(other.usingHardware)
@@ -66,10 +72,22 @@ FFmpegEncoder::FFmpegEncoder(FFmpegEncoder&& other) noexcept
 	, frameCount(other.frameCount)
 	, pts(other.pts)
 	, finalized(other.finalized)
+	, keyframePending(other.keyframePending)
+	, colorPropertiesSet(other.colorPropertiesSet)
+	, packetTap(std::move(other.packetTap))
 	, asyncMode(other.asyncMode)
 	, codecName(std::move(other.codecName))
 	, framesInFlight(other.framesInFlight)
-	, ownHwDeviceCtx(other.ownHwDeviceCtx) {
+	, ownHwDeviceCtx(other.ownHwDeviceCtx)
+	, audioCodecCtx(other.audioCodecCtx)
+	, audioStream(other.audioStream)
+	, audioPacket(other.audioPacket)
+	, audioFrame(other.audioFrame)
+	, audioFrameSize(other.audioFrameSize)
+	, audioPts(other.audioPts)
+	, audioKeepFrom(other.audioKeepFrom)
+	, audioKeepUntil(other.audioKeepUntil)
+	, audioFinished(other.audioFinished) {
 	
 	other.formatCtx = nullptr;
 	other.codecCtx = nullptr;
@@ -81,6 +99,10 @@ FFmpegEncoder::FFmpegEncoder(FFmpegEncoder&& other) noexcept
 	other.usingHardware = false;
 	other.ownHwDeviceCtx = false;
 	other.convertedFrame = nullptr;
+	other.audioCodecCtx = nullptr;
+	other.audioStream = nullptr;
+	other.audioPacket = nullptr;
+	other.audioFrame = nullptr;
 }
 
 FFmpegEncoder& FFmpegEncoder::operator=(FFmpegEncoder&& other) noexcept {
@@ -96,14 +118,27 @@ FFmpegEncoder& FFmpegEncoder::operator=(FFmpegEncoder&& other) noexcept {
 		hwFrame = other.hwFrame;
 		usingHardware = other.usingHardware;
 		convertedFrame = other.convertedFrame;
+		memory = std::move(other.memory);
 		config = other.config;
 		frameCount = other.frameCount;
 		pts = other.pts;
 		finalized = other.finalized;
+		keyframePending = other.keyframePending;
+		colorPropertiesSet = other.colorPropertiesSet;
+		packetTap = std::move(other.packetTap);
 		asyncMode = other.asyncMode;
 		codecName = std::move(other.codecName);
 		framesInFlight = other.framesInFlight;
 		ownHwDeviceCtx = other.ownHwDeviceCtx;
+		audioCodecCtx = other.audioCodecCtx;
+		audioStream = other.audioStream;
+		audioPacket = other.audioPacket;
+		audioFrame = other.audioFrame;
+		audioFrameSize = other.audioFrameSize;
+		audioPts = other.audioPts;
+		audioKeepFrom = other.audioKeepFrom;
+		audioKeepUntil = other.audioKeepUntil;
+		audioFinished = other.audioFinished;
 		
 		other.formatCtx = nullptr;
 		other.codecCtx = nullptr;
@@ -115,6 +150,10 @@ FFmpegEncoder& FFmpegEncoder::operator=(FFmpegEncoder&& other) noexcept {
 		other.usingHardware = false;
 		other.ownHwDeviceCtx = false;
 		other.convertedFrame = nullptr;
+		other.audioCodecCtx = nullptr;
+		other.audioStream = nullptr;
+		other.audioPacket = nullptr;
+		other.audioFrame = nullptr;
 	}
 	return *this;
 }
@@ -122,8 +161,18 @@ FFmpegEncoder& FFmpegEncoder::operator=(FFmpegEncoder&& other) noexcept {
 void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& config) {
 	int ret;
 	
-	// Allocate output format context
-	ret = avformat_alloc_output_context2(&formatCtx, nullptr, nullptr, filename.c_str());
+	// Allocate output format context (guessed from the file name unless segmented)
+	const char* formatName = nullptr;
+	if (!config.containerFormat.empty()) {
+		formatName = config.containerFormat.c_str();
+	} else if (config.segmentFormat == "hls" || config.segmentFormat == "hls-fmp4") {
+		formatName = "hls";
+	} else if (config.segmentFormat == "fmp4") {
+		formatName = "mp4";
+	} else if (!config.segmentFormat.empty()) {
+		throw std::runtime_error("Unknown segment format: " + config.segmentFormat);
+	}
+	ret = avformat_alloc_output_context2(&formatCtx, nullptr, formatName, filename.c_str());
 	if (ret < 0 || !formatCtx) {
 		throw std::runtime_error("Failed to allocate output context");
 	}
@@ -319,6 +368,14 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 	codecCtx->bit_rate = config.bitrate;
 	codecCtx->gop_size = 300; // 300 frames GOP - matching ftv_toffmpeg default
 	
+	// Segmented output is cut at every keyframe, so the encoder must not add
+	// keyframes of its own between the forced ones
+	int segmentFrames = 0;
+	if (!config.segmentFormat.empty() && config.forcedIdr) {
+		segmentFrames = static_cast<int>(std::lround(config.segmentDuration * av_q2d(config.frameRate)));
+		codecCtx->gop_size = std::max(codecCtx->gop_size, 2 * segmentFrames + 1);
+	}
+	
 	// Set default color properties to avoid warnings and ensure proper output
 	// These will be overridden when we receive the first frame with actual color properties
 	codecCtx->color_range = AVCOL_RANGE_MPEG; // Use MPEG/limited range by default
@@ -429,6 +486,18 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 		}
 	}
 	
+	// Forced keyframes must be IDR frames to be usable as splice points
+	if (config.forcedIdr && (codecName == "libx264" || codecName == "libx265")) {
+		av_opt_set(codecCtx->priv_data, "forced-idr", "1", 0);
+	}
+	if (segmentFrames > 0) {
+		if (codecName == "libx264") {
+			av_opt_set_int(codecCtx->priv_data, "sc_threshold", 0, 0);
+		} else if (codecName == "libx265") {
+			av_opt_set(codecCtx->priv_data, "x265-params", "scenecut=0", 0);
+		}
+	}
+	
 	// Some formats want stream headers to be separate
 	if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(56, 60, 100)
@@ -472,6 +541,11 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 		throw std::runtime_error("Failed to copy codec parameters");
 	}
 	
+	// All streams must exist before the header is written
+	if (config.audioEnabled) {
+		setupAudio(config);
+	}
+	
 	// Open output file
 	if (!(formatCtx->oformat->flags & AVFMT_NOFILE)) {
 		ret = avio_open(&formatCtx->pb, filename.c_str(), AVIO_FLAG_WRITE);
@@ -481,7 +555,13 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 	}
 	
 	// Write file header
-	ret = avformat_write_header(formatCtx, nullptr);
+	AVDictionary* muxerOptions = segmentMuxerOptions(filename);
+	if (muxerOptions) {
+		// Hand every fragment to the file as soon as it is complete
+		formatCtx->flush_packets = 1;
+	}
+	ret = avformat_write_header(formatCtx, &muxerOptions);
+	av_dict_free(&muxerOptions);
 	if (ret < 0) {
 		char errbuf[AV_ERROR_MAX_STRING_SIZE];
 		av_strerror(ret, errbuf, sizeof(errbuf));
@@ -504,11 +584,19 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 	convertedFrame->width = config.width;
 	convertedFrame->height = config.height;
 	
-	ret = av_frame_get_buffer(convertedFrame, 32);
+	ret = utils::FrameArena::getInstance().getFrameBuffer(convertedFrame, 32);
 	if (ret < 0) {
 		throw std::runtime_error("Failed to allocate conversion frame buffer");
 	}
 	
+	// Software encoders hold their lookahead plus a frame per thread; hardware
+	// encoders keep theirs in GPU memory
+	int64_t frameBytes = static_cast<int64_t>(
+		utils::FrameArena::frameBytes(config.pixelFormat, config.width, config.height));
+	int heldFrames = 1 + (usingHardware ? 0 : LOOKAHEAD_FRAMES + std::max(1, codecCtx->thread_count));
+	memory = utils::MemoryBudget::Consumer("encoders", utils::MemoryBudget::FIXED);
+	memory.add(frameBytes * heldFrames);
+	
 	// Log async mode status
 	if (asyncMode) {
 		utils::Logger::info("Async encoding enabled for {}", codecName);
@@ -524,6 +612,41 @@ void FFmpegEncoder::setupEncoder(const std::string& filename, const Config& conf
 		codecCtx->max_b_frames);
 }
 
+AVDictionary* FFmpegEncoder::segmentMuxerOptions(const std::string& filename) const {
+	if (config.segmentFormat.empty()) {
+		return nullptr;
+	}
+	
+	AVDictionary* options = nullptr;
+	if (config.segmentFormat == "fmp4") {
+		// A moof/mdat fragment per keyframe, readable before the file is finished
+		av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+		return options;
+	}
+	
+	// HLS: segments named after the playlist, listed in an EVENT playlist that
+	// is rewritten after every segment. Segments are written to a temporary
+	// file and renamed when complete, so readers never see partial segments.
+	bool fmp4 = config.segmentFormat == "hls-fmp4";
+	std::filesystem::path base(filename);
+	base.replace_extension();
+	std::string segmentPattern = base.string() + (fmp4 ? "_%05d.m4s" : "_%05d.ts");
+	
+	// Any segment length passes, so every keyframe starts a segment
+	double frameTime = av_q2d(av_inv_q(config.frameRate));
+	av_dict_set(&options, "hls_time", std::to_string(frameTime / 2).c_str(), 0);
+	av_dict_set(&options, "hls_list_size", "0", 0);
+	av_dict_set(&options, "hls_playlist_type", "event", 0);
+	av_dict_set(&options, "hls_flags", "independent_segments+temp_file", 0);
+	av_dict_set(&options, "hls_segment_type", fmp4 ? "fmp4" : "mpegts", 0);
+	av_dict_set(&options, "hls_segment_filename", segmentPattern.c_str(), 0);
+	if (fmp4) {
+		std::string initName = base.filename().string() + "_init.mp4";
+		av_dict_set(&options, "hls_fmp4_init_filename", initName.c_str(), 0);
+	}
+	return options;
+}
+
 void FFmpegEncoder::cleanup() {
 	if (swsCtx) {
 		sws_freeContext(swsCtx);
@@ -542,6 +665,18 @@ void FFmpegEncoder::cleanup() {
 		FFmpegCompat::freePacket(&packet);
 	}
 	
+	if (audioFrame) {
+		av_frame_free(&audioFrame);
+	}
+	
+	if (audioPacket) {
+		FFmpegCompat::freePacket(&audioPacket);
+	}
+	
+	if (audioCodecCtx) {
+		avcodec_free_context(&audioCodecCtx);
+	}
+	
 	if (codecCtx) {
 		// CRITICAL: For hardware codecs, we must call avcodec_close() before freeing
 		// This ensures all GPU operations are completed and resources are released
@@ -572,11 +707,7 @@ void FFmpegEncoder::cleanup() {
 }
 
 bool FFmpegEncoder::writeFrame(AVFrame* frame) {
-	// Time the first 10 frame encodes
-	static int encodeCount = 0;
-	if (encodeCount < 10) {
-		TIME_BLOCK(std::string("encode_frame_") + std::to_string(encodeCount++));
-	}
+	TIME_BLOCK("encode_frame");
 	
 	if (!frame || finalized) {
 		return false;
@@ -586,7 +717,6 @@ bool FFmpegEncoder::writeFrame(AVFrame* frame) {
 	
 	// Copy color properties from source frame to encoder on first frame
 	// This ensures the encoder uses the correct color range from the source
-	static bool colorPropertiesSet = false;
 	if (!colorPropertiesSet && frame->color_range != AVCOL_RANGE_UNSPECIFIED) {
 		codecCtx->color_range = frame->color_range;
 		codecCtx->color_primaries = frame->color_primaries;
@@ -638,6 +768,13 @@ bool FFmpegEncoder::writeFrame(AVFrame* frame) {
 	// The encoder will handle DTS generation for B-frames
 	frameToEncode->pts = pts++;
 	
+	if (config.forcedIdr) {
+		// Frames may come straight from a decoder or a pool, so clear any
+		// picture type they carry and only force the requested keyframes
+		frameToEncode->pict_type = keyframePending ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+		keyframePending = false;
+	}
+	
 	bool result = encodeFrame(frameToEncode);
 	
 	// Process async queue frequently to maintain flow and prevent queue overflow
@@ -660,13 +797,12 @@ bool FFmpegEncoder::writeHardwareFrame(AVFrame* frame) {
 	
 	// Copy color properties from source frame to encoder on first frame
 	// This ensures the encoder uses the correct color range from the source
-	static bool hwColorPropertiesSet = false;
-	if (!hwColorPropertiesSet && frame->color_range != AVCOL_RANGE_UNSPECIFIED) {
+	if (!colorPropertiesSet && frame->color_range != AVCOL_RANGE_UNSPECIFIED) {
 		codecCtx->color_range = frame->color_range;
 		codecCtx->color_primaries = frame->color_primaries;
 		codecCtx->color_trc = frame->color_trc;
 		codecCtx->colorspace = frame->colorspace;
-		hwColorPropertiesSet = true;
+		colorPropertiesSet = true;
 		
 		const char* rangeStr = (frame->color_range == AVCOL_RANGE_JPEG) ? "full" : "limited";
 		utils::Logger::debug("Set hardware encoder color properties from source - range: {}, primaries: {}, trc: {}, space: {}",
@@ -823,12 +959,7 @@ bool FFmpegEncoder::encodeHardwareFrame(AVFrame* frame) {
 			return false;
 		}
 		
-		// Rescale timestamps
-		av_packet_rescale_ts(packet, codecCtx->time_base, videoStream->time_base);
-		packet->stream_index = videoStream->index;
-		
-		// Write packet
-		int writeRet = av_interleaved_write_frame(formatCtx, packet);
+		int writeRet = writePacket(packet);
 		av_packet_unref(packet);
 		
 		if (writeRet < 0) {
@@ -880,12 +1011,7 @@ bool FFmpegEncoder::encodeFrame(AVFrame* frame) {
 			return false;
 		}
 		
-		// Rescale timestamps
-		av_packet_rescale_ts(packet, codecCtx->time_base, videoStream->time_base);
-		packet->stream_index = videoStream->index;
-		
-		// Write packet
-		int writeRet = av_interleaved_write_frame(formatCtx, packet);
+		int writeRet = writePacket(packet);
 		av_packet_unref(packet);
 		
 		if (writeRet < 0) {
@@ -900,9 +1026,7 @@ bool FFmpegEncoder::encodeFrame(AVFrame* frame) {
 #else
 	// Use FFmpegCompat for legacy API
 	if (FFmpegCompat::encodeVideoFrame(codecCtx, frame, packet)) {
-		av_packet_rescale_ts(packet, codecCtx->time_base, videoStream->time_base);
-		packet->stream_index = videoStream->index;
-		int writeRet = av_interleaved_write_frame(formatCtx, packet);
+		int writeRet = writePacket(packet);
 		av_packet_unref(packet);
 		if (writeRet < 0) {
 			utils::Logger::error("Error writing packet");
@@ -933,24 +1057,21 @@ bool FFmpegEncoder::flushEncoder() {
 			return false;
 		}
 		
-		av_packet_rescale_ts(packet, codecCtx->time_base, videoStream->time_base);
-		packet->stream_index = videoStream->index;
-		
-		int writeRet = av_interleaved_write_frame(formatCtx, packet);
+		int writeRet = writePacket(packet);
 		av_packet_unref(packet);
 		
 		if (writeRet < 0) {
 			return false;
 		}
+		
+		frameCount++;
 	}
 	
 	return true;
 #else
 	// Flush using legacy API
 	while (FFmpegCompat::encodeVideoFrame(codecCtx, nullptr, packet)) {
-		av_packet_rescale_ts(packet, codecCtx->time_base, videoStream->time_base);
-		packet->stream_index = videoStream->index;
-		int writeRet = av_interleaved_write_frame(formatCtx, packet);
+		int writeRet = writePacket(packet);
 		av_packet_unref(packet);
 		if (writeRet < 0) {
 			return false;
@@ -961,6 +1082,113 @@ bool FFmpegEncoder::flushEncoder() {
 #endif
 }
 
+int FFmpegEncoder::writePacket(AVPacket* pkt) {
+	if (packetTap) {
+		packetTap(pkt);
+	}
+	
+	// Rescale timestamps
+	av_packet_rescale_ts(pkt, codecCtx->time_base, videoStream->time_base);
+	pkt->stream_index = videoStream->index;
+	
+	std::lock_guard<std::mutex> lock(muxMutex);
+	return av_interleaved_write_frame(formatCtx, pkt);
+}
+
+bool FFmpegEncoder::writeEncodedPacket(AVPacket* pkt) {
+	if (finalized) {
+		return false;
+	}
+	
+	// Spliced packets bypass the tap: they are already cached
+	av_packet_rescale_ts(pkt, codecCtx->time_base, videoStream->time_base);
+	pkt->stream_index = videoStream->index;
+	
+	int ret;
+	{
+		std::lock_guard<std::mutex> lock(muxMutex);
+		ret = av_interleaved_write_frame(formatCtx, pkt);
+	}
+	if (ret < 0) {
+		char errbuf[AV_ERROR_MAX_STRING_SIZE];
+		av_strerror(ret, errbuf, sizeof(errbuf));
+		utils::Logger::error("Error writing spliced packet: {}", errbuf);
+		return false;
+	}
+	
+	frameCount++;
+	return true;
+}
+
+bool FFmpegEncoder::restartSession() {
+	if (!supportsSessionRestart()) {
+		utils::Logger::error("Encoder session restart is not supported for {}", codecName);
+		return false;
+	}
+	
+	if (!flushEncoder()) {
+		utils::Logger::error("Failed to drain encoder before restart");
+		return false;
+	}
+	
+	// A flushed codec cannot accept more frames; open a new one with the
+	// same settings and private options
+	const AVCodec* codec = codecCtx->codec;
+	AVCodecContext* fresh = avcodec_alloc_context3(codec);
+	if (!fresh) {
+		utils::Logger::error("Failed to allocate codec context for restart");
+		return false;
+	}
+	
+	fresh->codec_id = codecCtx->codec_id;
+	fresh->codec_type = codecCtx->codec_type;
+	fresh->width = codecCtx->width;
+	fresh->height = codecCtx->height;
+	fresh->pix_fmt = codecCtx->pix_fmt;
+	fresh->time_base = codecCtx->time_base;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 37, 100)
+	fresh->framerate = codecCtx->framerate;
+#endif
+	fresh->bit_rate = codecCtx->bit_rate;
+	fresh->bit_rate_tolerance = codecCtx->bit_rate_tolerance;
+	fresh->gop_size = codecCtx->gop_size;
+	fresh->max_b_frames = codecCtx->max_b_frames;
+	fresh->color_range = codecCtx->color_range;
+	fresh->color_primaries = codecCtx->color_primaries;
+	fresh->color_trc = codecCtx->color_trc;
+	fresh->colorspace = codecCtx->colorspace;
+	fresh->sample_aspect_ratio = codecCtx->sample_aspect_ratio;
+	fresh->thread_count = codecCtx->thread_count;
+	fresh->thread_type = codecCtx->thread_type;
+	fresh->flags = codecCtx->flags;
+	
+	if (codecCtx->priv_data && fresh->priv_data) {
+		av_opt_copy(fresh->priv_data, codecCtx->priv_data);
+	}
+	
+	int ret = avcodec_open2(fresh, codec, nullptr);
+	if (ret < 0) {
+		char errbuf[AV_ERROR_MAX_STRING_SIZE];
+		av_strerror(ret, errbuf, sizeof(errbuf));
+		utils::Logger::error("Failed to reopen codec: {}", errbuf);
+		avcodec_free_context(&fresh);
+		return false;
+	}
+	
+	// The stream header was written from the first session's extradata
+	if (fresh->extradata_size != codecCtx->extradata_size ||
+		(fresh->extradata_size > 0 &&
+		 memcmp(fresh->extradata, codecCtx->extradata, fresh->extradata_size) != 0)) {
+		utils::Logger::warn("Encoder extradata changed after restart, output may not be decodable");
+	}
+	
+	avcodec_free_context(&codecCtx);
+	codecCtx = fresh;
+	
+	utils::Logger::debug("Encoder session restarted at frame {}", pts);
+	return true;
+}
+
 bool FFmpegEncoder::sendFrameAsync(AVFrame* frame) {
 #if HAVE_SEND_RECEIVE_API
 	// Send frame to encoder without waiting for packet
@@ -1030,10 +1258,7 @@ bool FFmpegEncoder::receivePacketsAsync() {
 		}
 		
 		// Got a packet, write it
-		av_packet_rescale_ts(pkt, codecCtx->time_base, videoStream->time_base);
-		pkt->stream_index = videoStream->index;
-		
-		ret = av_interleaved_write_frame(formatCtx, pkt);
+		ret = writePacket(pkt);
 		av_packet_free(&pkt);
 		
 		if (ret < 0) {
@@ -1111,10 +1336,7 @@ bool FFmpegEncoder::finalize() {
 				av_packet_free(&pkt);
 			} else {
 				// Successfully received a packet
-				av_packet_rescale_ts(pkt, codecCtx->time_base, videoStream->time_base);
-				pkt->stream_index = videoStream->index;
-				
-				if (av_interleaved_write_frame(formatCtx, pkt) < 0) {
+				if (writePacket(pkt) < 0) {
 					utils::Logger::error("Error writing packet during flush");
 				}
 				frameCount++;
@@ -1136,8 +1358,17 @@ bool FFmpegEncoder::finalize() {
 	flushEncoder();
 #endif
 	
+	// Audio normally finishes on its own thread before this point
+	if (audioCodecCtx && !audioFinished) {
+		finishAudio();
+	}
+	
 	// Write trailer
-	int ret = av_write_trailer(formatCtx);
+	int ret;
+	{
+		std::lock_guard<std::mutex> lock(muxMutex);
+		ret = av_write_trailer(formatCtx);
+	}
 	if (ret < 0) {
 		utils::Logger::error("Failed to write trailer");
 		return false;
@@ -1148,4 +1379,249 @@ bool FFmpegEncoder::finalize() {
 	return true;
 }
 
+void FFmpegEncoder::setupAudio(const Config& config) {
+#if HAVE_SEND_RECEIVE_API && HAVE_CODECPAR_API
+	const AVCodec* codec = avcodec_find_encoder_by_name(config.audioCodec.c_str());
+	if (!codec) {
+		throw std::runtime_error("Audio encoder not found: " + config.audioCodec);
+	}
+	
+	// The mixer produces planar float, which AAC and Opus take natively
+	bool planarFloat = false;
+	for (const AVSampleFormat* fmt = codec->sample_fmts; fmt && *fmt != AV_SAMPLE_FMT_NONE; fmt++) {
+		planarFloat = planarFloat || *fmt == AV_SAMPLE_FMT_FLTP;
+	}
+	if (!planarFloat) {
+		throw std::runtime_error("Audio encoder " + config.audioCodec + " does not accept planar float samples");
+	}
+	
+	audioStream = avformat_new_stream(formatCtx, nullptr);
+	if (!audioStream) {
+		throw std::runtime_error("Failed to create audio stream");
+	}
+	
+	openAudioCodec(codec);
+	
+	int ret = FFmpegCompat::copyCodecParametersToStream(audioStream, audioCodecCtx);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to copy audio codec parameters");
+	}
+	audioStream->time_base = audioCodecCtx->time_base;
+	
+	// Encoders with variable frame size take any block size; use AAC's
+	audioFrameSize = audioCodecCtx->frame_size > 0 ? audioCodecCtx->frame_size : 1024;
+	
+	audioPacket = FFmpegCompat::allocPacket();
+	audioFrame = av_frame_alloc();
+	if (!audioPacket || !audioFrame) {
+		throw std::runtime_error("Failed to allocate audio packet/frame");
+	}
+	
+	audioFrame->format = AV_SAMPLE_FMT_FLTP;
+	audioFrame->nb_samples = audioFrameSize;
+	audioFrame->sample_rate = config.audioSampleRate;
+#if HAVE_CH_LAYOUT_API
+	av_channel_layout_copy(&audioFrame->ch_layout, &audioCodecCtx->ch_layout);
+#else
+	audioFrame->channels = config.audioChannels;
+	audioFrame->channel_layout = audioCodecCtx->channel_layout;
+#endif
+	
+	ret = av_frame_get_buffer(audioFrame, 0);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to allocate audio frame buffer");
+	}
+	
+	utils::Logger::info("Audio encoder initialized: {}, {} Hz, {} channels, {} kbps, frame size {}",
+		config.audioCodec, config.audioSampleRate, config.audioChannels,
+		config.audioBitrate / 1000, audioFrameSize);
+#else
+	(void)config;
+	throw std::runtime_error("Audio encoding requires FFmpeg 3.1+");
+#endif
+}
+
+void FFmpegEncoder::openAudioCodec(const AVCodec* codec) {
+	audioCodecCtx = avcodec_alloc_context3(codec);
+	if (!audioCodecCtx) {
+		throw std::runtime_error("Failed to allocate audio codec context");
+	}
+	
+	audioCodecCtx->sample_fmt = AV_SAMPLE_FMT_FLTP;
+	audioCodecCtx->sample_rate = config.audioSampleRate;
+	audioCodecCtx->bit_rate = config.audioBitrate;
+	audioCodecCtx->time_base = {1, config.audioSampleRate};
+#if HAVE_CH_LAYOUT_API
+	av_channel_layout_default(&audioCodecCtx->ch_layout, config.audioChannels);
+#else
+	audioCodecCtx->channels = config.audioChannels;
+	audioCodecCtx->channel_layout = av_get_default_channel_layout(config.audioChannels);
+#endif
+	
+	if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+		audioCodecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	}
+	
+	int ret = avcodec_open2(audioCodecCtx, codec, nullptr);
+	if (ret < 0) {
+		char errbuf[AV_ERROR_MAX_STRING_SIZE];
+		av_strerror(ret, errbuf, sizeof(errbuf));
+		throw std::runtime_error("Failed to open audio codec: " + std::string(errbuf));
+	}
+}
+
+bool FFmpegEncoder::writeAudioSamples(const float* const* planes, int samples) {
+	if (!audioCodecCtx || audioFinished || samples <= 0 || samples > audioFrameSize) {
+		return false;
+	}
+	
+	// The encoder may still reference the previous frame's buffer
+	if (av_frame_make_writable(audioFrame) < 0) {
+		utils::Logger::error("Failed to make audio frame writable");
+		return false;
+	}
+	
+	// A short last frame is padded with silence unless the encoder takes it as is
+	int frameSamples = samples;
+	if (samples < audioFrameSize && !(audioCodecCtx->codec->capabilities &
+		(AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_VARIABLE_FRAME_SIZE))) {
+		frameSamples = audioFrameSize;
+	}
+	
+	audioFrame->nb_samples = frameSamples;
+	for (int ch = 0; ch < config.audioChannels; ch++) {
+		std::memcpy(audioFrame->data[ch], planes[ch], samples * sizeof(float));
+		std::memset(reinterpret_cast<float*>(audioFrame->data[ch]) + samples, 0,
+			(frameSamples - samples) * sizeof(float));
+	}
+	audioFrame->pts = audioPts;
+	audioPts += frameSamples;
+	
+	return encodeAudioFrame(audioFrame);
+}
+
+bool FFmpegEncoder::finishAudio() {
+	if (!audioCodecCtx || audioFinished) {
+		return true;
+	}
+	
+	audioFinished = true;
+	return encodeAudioFrame(nullptr);
+}
+
+bool FFmpegEncoder::encodeAudioFrame(AVFrame* frame) {
+#if HAVE_SEND_RECEIVE_API
+	int ret = avcodec_send_frame(audioCodecCtx, frame);
+	if (ret < 0 && ret != AVERROR_EOF) {
+		char errbuf[AV_ERROR_MAX_STRING_SIZE];
+		av_strerror(ret, errbuf, sizeof(errbuf));
+		utils::Logger::error("Error sending audio frame to encoder: {}", errbuf);
+		return false;
+	}
+	
+	while (true) {
+		ret = avcodec_receive_packet(audioCodecCtx, audioPacket);
+		if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+			break;
+		}
+		if (ret < 0) {
+			utils::Logger::error("Error receiving audio packet from encoder");
+			return false;
+		}
+		
+		// Pre-roll and post-roll of a passthrough session
+		if (audioPacket->pts < audioKeepFrom || audioPacket->pts >= audioKeepUntil) {
+			av_packet_unref(audioPacket);
+			continue;
+		}
+		if (audioPacket->pts + audioPacket->duration > audioKeepUntil) {
+			trimAudioPacket(audioPacket, audioKeepUntil);
+		}
+		
+		av_packet_rescale_ts(audioPacket, audioCodecCtx->time_base, audioStream->time_base);
+		audioPacket->stream_index = audioStream->index;
+		
+		int writeRet;
+		{
+			std::lock_guard<std::mutex> lock(muxMutex);
+			writeRet = av_interleaved_write_frame(formatCtx, audioPacket);
+		}
+		av_packet_unref(audioPacket);
+		
+		if (writeRet < 0) {
+			utils::Logger::error("Error writing audio packet");
+			return false;
+		}
+	}
+	
+	return true;
+#else
+	(void)frame;
+	return false;
+#endif
+}
+
+void FFmpegEncoder::setAudioPosition(int64_t position, int64_t keepFrom) {
+	audioPts = position;
+	audioKeepFrom = keepFrom;
+}
+
+bool FFmpegEncoder::restartAudioSession(int64_t keepUntil) {
+	if (!audioCodecCtx || audioFinished) {
+		return false;
+	}
+	
+	audioKeepUntil = keepUntil;
+	bool drained = encodeAudioFrame(nullptr);
+	audioKeepUntil = std::numeric_limits<int64_t>::max();
+	
+	// A drained encoder takes no more frames; open a fresh one
+	const AVCodec* codec = audioCodecCtx->codec;
+	avcodec_free_context(&audioCodecCtx);
+	try {
+		openAudioCodec(codec);
+	} catch (const std::exception& e) {
+		utils::Logger::error("Failed to restart audio encoder: {}", e.what());
+		return false;
+	}
+	return drained;
+}
+
+void FFmpegEncoder::trimAudioPacket(AVPacket* pkt, int64_t end) {
+	int64_t discard = pkt->pts + pkt->duration - end;
+	pkt->duration -= discard;
+	
+	// Decoders that honour skip samples drop the tail (layout: skip at start,
+	// discard at end as little-endian 32-bit values, then two reason bytes)
+	uint8_t* side = av_packet_new_side_data(pkt, AV_PKT_DATA_SKIP_SAMPLES, 10);
+	if (side) {
+		std::memset(side, 0, 10);
+		for (int i = 0; i < 4; i++) {
+			side[4 + i] = static_cast<uint8_t>((discard >> (8 * i)) & 0xff);
+		}
+	}
+}
+
+bool FFmpegEncoder::writeAudioPacket(AVPacket* pkt) {
+	if (!audioCodecCtx || audioFinished || finalized) {
+		return false;
+	}
+	
+	pkt->dts = pkt->pts;
+	av_packet_rescale_ts(pkt, audioCodecCtx->time_base, audioStream->time_base);
+	pkt->stream_index = audioStream->index;
+	pkt->pos = -1;
+	
+	int ret;
+	{
+		std::lock_guard<std::mutex> lock(muxMutex);
+		ret = av_interleaved_write_frame(formatCtx, pkt);
+	}
+	if (ret < 0) {
+		utils::Logger::error("Error writing copied audio packet");
+		return false;
+	}
+	return true;
+}
+
 } // namespace media
\ No newline at end of file
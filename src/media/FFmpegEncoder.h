@@ -1,12 +1,17 @@
 #pragma once
 
+#include "media/FrameSink.h"
 #include "media/MediaTypes.h"
 #include "media/HardwareAcceleration.h"
+#include "utils/MemoryBudget.h"
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <string>
 
 namespace media {
 
-class FFmpegEncoder {
+class FFmpegEncoder : public FrameSink {
 public:
 	struct Config {
 		std::string codec = "libx264";
@@ -29,10 +34,38 @@ public:
 		
 		// GPU passthrough mode - expect hardware frames from decoder
 		bool expectHardwareFrames = false;
+		
+		// Code frames marked with forceKeyframe() as IDR frames (x264/x265), so
+		// the stream can be cut and spliced there
+		bool forcedIdr = false;
+		
+		// Segmented output instead of a single file: "hls" (MPEG-TS segments),
+		// "hls-fmp4" (fMP4 segments) or "fmp4" (one fragmented MP4). Segments
+		// and fragments are cut at every keyframe, so with forcedIdr they follow
+		// the forced keyframes only and each is published as soon as the next
+		// one starts.
+		std::string segmentFormat;
+		double segmentDuration = 6.0;  // Longest planned segment, in seconds
+		
+		// Muxer name; guessed from the file name when empty ("null" discards
+		// the packets, for benchmarking the encoder alone)
+		std::string containerFormat;
+		
+		// Optional audio stream, fed with planar float samples through
+		// writeAudioSamples()
+		bool audioEnabled = false;
+		std::string audioCodec = "aac";
+		int audioBitrate = 128000;
+		int audioSampleRate = 48000;
+		int audioChannels = 2;
 	};
 	
+	// Receives every encoded packet (encoder time base, i.e. frame units)
+	// before it is muxed
+	using PacketTap = std::function<void(const AVPacket* packet)>;
+	
 	FFmpegEncoder(const std::string& filename, const Config& config);
-	~FFmpegEncoder();
+	~FFmpegEncoder() override;
 	
 	// Disable copy
 	FFmpegEncoder(const FFmpegEncoder&) = delete;
@@ -42,18 +75,63 @@ public:
 	FFmpegEncoder(FFmpegEncoder&& other) noexcept;
 	FFmpegEncoder& operator=(FFmpegEncoder&& other) noexcept;
 	
-	bool writeFrame(AVFrame* frame);
+	bool writeFrame(AVFrame* frame) override;
 	bool writeHardwareFrame(AVFrame* frame);  // Direct GPU frame encoding
-	bool finalize();
+	bool finalize() override;
 	
 	int64_t getFrameCount() const { return frameCount; }
+	const AVCodecContext* getCodecContext() const { return codecCtx; }
+	
+	// Segment splicing support (software encoders only)
+	bool supportsSessionRestart() const { return !usingHardware && !asyncMode; }
+	void setPacketTap(PacketTap tap) { packetTap = std::move(tap); }
+	void forceKeyframe() { keyframePending = true; }
+	
+	// Drain the encoder and reopen it, so the next frame starts a new
+	// independently decodable run
+	bool restartSession();
+	
+	// Mux an already encoded packet (encoder time base) and account for
+	// the frames it replaces
+	bool writeEncodedPacket(AVPacket* packet);
+	void advancePts(int64_t frames) { pts += frames; }
+	
+	// Audio stream support. Audio may be written from another thread than
+	// video; muxing of both streams is serialised internally.
+	bool hasAudio() const { return audioCodecCtx != nullptr; }
+	int getAudioFrameSize() const { return audioFrameSize; }
+	int getAudioSampleRate() const { return config.audioSampleRate; }
+	int getAudioChannels() const { return config.audioChannels; }
+	
+	// Encode one frame of getAudioFrameSize() samples (fewer only for the last frame)
+	bool writeAudioSamples(const float* const* planes, int samples);
+	
+	// Flush the audio encoder after the last samples
+	bool finishAudio();
+	
+	// Audio passthrough: copied packets are muxed between encoder sessions.
+	// Each session starts at a sample position and drops its packets before
+	// keepFrom (pre-roll); restarting drains the session, keeping packets
+	// before keepUntil and trimming the one that crosses it.
+	const AVCodecContext* getAudioCodecContext() const { return audioCodecCtx; }
+	void setAudioPosition(int64_t position, int64_t keepFrom);
+	bool restartAudioSession(int64_t keepUntil);
+	
+	// Mux an already encoded audio packet (pts and duration in samples)
+	bool writeAudioPacket(AVPacket* packet);
 	
 private:
 	void setupEncoder(const std::string& filename, const Config& config);
+	AVDictionary* segmentMuxerOptions(const std::string& filename) const;
 	void cleanup();
 	bool encodeFrame(AVFrame* frame);
 	bool encodeHardwareFrame(AVFrame* frame);
 	bool flushEncoder();
+	int writePacket(AVPacket* packet);
+	void setupAudio(const Config& config);
+	void openAudioCodec(const AVCodec* codec);
+	void trimAudioPacket(AVPacket* packet, int64_t end);
+	bool encodeAudioFrame(AVFrame* frame);
 	
 	// Async encoding support
 	bool sendFrameAsync(AVFrame* frame);
@@ -66,6 +144,7 @@ private:
 	AVPacket* packet = nullptr;
 	SwsContext* swsCtx = nullptr;
 	AVFrame* convertedFrame = nullptr;
+	utils::MemoryBudget::Consumer memory;  // Estimated frames held by the codec
 	
 	// Hardware acceleration members
 	AVBufferRef* hwDeviceCtx = nullptr;
@@ -76,6 +155,9 @@ private:
 	int64_t frameCount = 0;
 	int64_t pts = 0;
 	bool finalized = false;
+	bool keyframePending = false;
+	bool colorPropertiesSet = false;  // Taken from the first frame with a known range
+	PacketTap packetTap;
 	
 	// Async encoding state
 	bool asyncMode = false;
@@ -83,8 +165,25 @@ private:
 	int framesInFlight = 0;
 	static constexpr int ASYNC_QUEUE_SIZE = 16;
 	
+	// Frames x264/x265 buffer for rate control lookahead at the usual presets
+	static constexpr int LOOKAHEAD_FRAMES = 40;
+	
 	// Track if we created hwDeviceCtx ourselves
 	bool ownHwDeviceCtx = false;
+	
+	// Audio stream state
+	AVCodecContext* audioCodecCtx = nullptr;
+	AVStream* audioStream = nullptr;
+	AVPacket* audioPacket = nullptr;
+	AVFrame* audioFrame = nullptr;
+	int audioFrameSize = 0;
+	int64_t audioPts = 0;
+	int64_t audioKeepFrom = std::numeric_limits<int64_t>::min();
+	int64_t audioKeepUntil = std::numeric_limits<int64_t>::max();
+	bool audioFinished = false;
+	
+	// Serialises av_interleaved_write_frame() between video and audio
+	std::mutex muxMutex;
 };
 
 } // namespace media
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+
+namespace media {
+
+/**
+ * Destination of the rendered video frames: an encoder and container
+ * (FFmpegEncoder) or a raw frame stream for another program (RawFrameWriter).
+ */
+class FrameSink {
+public:
+	virtual ~FrameSink() = default;
+	
+	// Write the next frame in presentation order
+	virtual bool writeFrame(AVFrame* frame) = 0;
+	
+	// Flush and close the output after the last frame
+	virtual bool finalize() = 0;
+};
+
+} // namespace media
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include "media/RawFrameWriter.h"
+#include "media/FFmpegCompat.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <climits>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace media {
+
+namespace {
+
+// Bytes handed to the kernel in one go; the pipe buffer is sized to match
+constexpr int PIPE_BUFFER_SIZE = 1 << 20;
+
+struct Chunk {
+	const uint8_t* data;
+	size_t size;
+};
+
+// Write every chunk, resuming after partial writes
+bool writeChunks(int fd, std::vector<Chunk>& chunks) {
+	size_t index = 0;
+#ifdef _WIN32
+	for (; index < chunks.size(); index++) {
+		const uint8_t* data = chunks[index].data;
+		size_t left = chunks[index].size;
+		while (left > 0) {
+			int written = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(left, INT32_MAX)));
+			if (written <= 0) {
+				return false;
+			}
+			data += written;
+			left -= written;
+		}
+	}
+	return true;
+#else
+	std::vector<iovec> vectors;
+	while (index < chunks.size()) {
+		size_t count = std::min<size_t>(chunks.size() - index, IOV_MAX);
+		vectors.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			vectors[i].iov_base = const_cast<uint8_t*>(chunks[index + i].data);
+			vectors[i].iov_len = chunks[index + i].size;
+		}
+		
+		ssize_t written = writev(fd, vectors.data(), static_cast<int>(count));
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		
+		// Skip what went out, trimming a partially written chunk
+		size_t remaining = static_cast<size_t>(written);
+		while (remaining > 0 && index < chunks.size()) {
+			if (remaining >= chunks[index].size) {
+				remaining -= chunks[index].size;
+				index++;
+			} else {
+				chunks[index].data += remaining;
+				chunks[index].size -= remaining;
+				remaining = 0;
+			}
+		}
+	}
+	return true;
+#endif
+}
+
+// Descriptor of the original stdout once detachStdout() has run
+int detachedStdout = -1;
+
+// Y4M colour space tag for a pixel format, nullptr if Y4M cannot carry it
+const char* y4mColorspace(AVPixelFormat format) {
+	switch (format) {
+		case AV_PIX_FMT_YUV420P:
+		case AV_PIX_FMT_YUVJ420P:
+			return "C420jpeg XYSCSS=420JPEG";
+		case AV_PIX_FMT_YUV422P:
+		case AV_PIX_FMT_YUVJ422P:
+			return "C422 XYSCSS=422";
+		case AV_PIX_FMT_YUV444P:
+		case AV_PIX_FMT_YUVJ444P:
+			return "C444 XYSCSS=444";
+		case AV_PIX_FMT_GRAY8:
+			return "Cmono";
+		default:
+			return nullptr;
+	}
+}
+
+}
+
+RawFrameWriter::RawFrameWriter(const std::string& filename, const Config& config)
+	: config(config) {
+	
+	if (config.format == Format::Y4M && !y4mColorspace(config.pixelFormat)) {
+		throw std::runtime_error("Pixel format not supported by Y4M");
+	}
+	
+	try {
+		openOutput(filename);
+		if (config.format == Format::NUT) {
+			setupMuxer();
+		}
+	} catch (...) {
+		cleanup();
+		throw;
+	}
+	
+	utils::Logger::info("Raw {} output: {} ({}x{})", config.format == Format::Y4M ? "Y4M" : "NUT",
+		filename == "-" ? "stdout" : filename, config.width, config.height);
+}
+
+RawFrameWriter::~RawFrameWriter() {
+	if (!finalized) {
+		finalize();
+	}
+	cleanup();
+}
+
+bool RawFrameWriter::parseFormat(const std::string& name, Format& format) {
+	if (name == "y4m") {
+		format = Format::Y4M;
+		return true;
+	}
+	if (name == "nut") {
+		format = Format::NUT;
+		return true;
+	}
+	return false;
+}
+
+void RawFrameWriter::detachStdout() {
+	if (detachedStdout >= 0) {
+		return;
+	}
+	std::cout.flush();
+	std::fflush(stdout);
+	
+#ifdef _WIN32
+	detachedStdout = _dup(_fileno(stdout));
+	if (detachedStdout >= 0) {
+		_setmode(detachedStdout, _O_BINARY);
+		_dup2(_fileno(stderr), _fileno(stdout));
+	}
+#else
+	detachedStdout = dup(STDOUT_FILENO);
+	if (detachedStdout >= 0) {
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+	}
+#endif
+}
+
+void RawFrameWriter::openOutput(const std::string& filename) {
+	if (filename == "-") {
+		detachStdout();
+		fd = detachedStdout;
+		detachedStdout = -1;
+	} else {
+#ifdef _WIN32
+		fd = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+		// Opening a named pipe waits for its reader
+		fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+	}
+	
+#ifndef _WIN32
+	// A reader that goes away should fail the write, not kill the process
+	std::signal(SIGPIPE, SIG_IGN);
+
+#ifdef F_SETPIPE_SZ
+	if (fd >= 0) {
+		fcntl(fd, F_SETPIPE_SZ, PIPE_BUFFER_SIZE);
+	}
+#endif
+#endif
+
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open raw output: " + filename);
+	}
+	ownFd = true;
+}
+
+void RawFrameWriter::setupMuxer() {
+	int ret = avformat_alloc_output_context2(&formatCtx, nullptr, "nut", nullptr);
+	if (ret < 0 || !formatCtx) {
+		throw std::runtime_error("Failed to allocate NUT muxer");
+	}
+	
+	stream = avformat_new_stream(formatCtx, nullptr);
+	if (!stream) {
+		throw std::runtime_error("Failed to create NUT stream");
+	}
+	stream->time_base = av_inv_q(config.frameRate);
+	stream->avg_frame_rate = config.frameRate;
+	stream->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+	stream->codecpar->codec_id = AV_CODEC_ID_RAWVIDEO;
+	stream->codecpar->codec_tag = avcodec_pix_fmt_to_codec_tag(config.pixelFormat);
+	stream->codecpar->format = config.pixelFormat;
+	stream->codecpar->width = config.width;
+	stream->codecpar->height = config.height;
+	
+	// The pipe protocol writes to the descriptor opened above
+	std::string url = "pipe:" + std::to_string(fd);
+	ret = avio_open(&formatCtx->pb, url.c_str(), AVIO_FLAG_WRITE);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to open NUT output");
+	}
+	
+	ret = avformat_write_header(formatCtx, nullptr);
+	if (ret < 0) {
+		throw std::runtime_error("Failed to write NUT header");
+	}
+	
+	frameBytes = av_image_get_buffer_size(config.pixelFormat, config.width, config.height, 1);
+	packet = FFmpegCompat::allocPacket();
+	if (frameBytes <= 0 || !packet) {
+		throw std::runtime_error("Failed to allocate NUT packet");
+	}
+	headerWritten = true;
+}
+
+bool RawFrameWriter::writeFrame(AVFrame* frame) {
+	if (!frame || finalized) {
+		return false;
+	}
+	
+	if (frame->width != config.width || frame->height != config.height ||
+		frame->format != config.pixelFormat) {
+		utils::Logger::error("Raw output expects {}x{} frames in format {}", config.width, config.height,
+			static_cast<int>(config.pixelFormat));
+		return false;
+	}
+	
+	bool ok = config.format == Format::Y4M ? writeY4MFrame(frame) : writeNUTFrame(frame);
+	if (!ok) {
+		utils::Logger::error("Failed to write raw frame {}", frameCount);
+		return false;
+	}
+	frameCount++;
+	return true;
+}
+
+bool RawFrameWriter::writeY4MHeader(const AVFrame* frame) {
+	std::string header = "YUV4MPEG2 W" + std::to_string(config.width) + " H" + std::to_string(config.height) +
+		" F" + std::to_string(config.frameRate.num) + ":" + std::to_string(config.frameRate.den) +
+		" Ip A1:1 " + y4mColorspace(config.pixelFormat);
+	if (frame->color_range == AVCOL_RANGE_JPEG) {
+		header += " XCOLORRANGE=FULL";
+	} else if (frame->color_range == AVCOL_RANGE_MPEG) {
+		header += " XCOLORRANGE=LIMITED";
+	}
+	header += "\n";
+	
+	std::vector<Chunk> chunks{{reinterpret_cast<const uint8_t*>(header.data()), header.size()}};
+	headerWritten = writeChunks(fd, chunks);
+	return headerWritten;
+}
+
+bool RawFrameWriter::writeY4MFrame(const AVFrame* frame) {
+	// The header carries the colour range of the first frame
+	if (!headerWritten && !writeY4MHeader(frame)) {
+		return false;
+	}
+	
+	static const char marker[] = "FRAME\n";
+	std::vector<Chunk> chunks;
+	chunks.push_back({reinterpret_cast<const uint8_t*>(marker), sizeof(marker) - 1});
+	
+	// Point straight at the planes: one chunk per plane when rows are packed,
+	// one per row when the frame is padded
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(config.pixelFormat);
+	int planes = av_pix_fmt_count_planes(config.pixelFormat);
+	for (int plane = 0; plane < planes; plane++) {
+		int rowBytes = av_image_get_linesize(config.pixelFormat, config.width, plane);
+		bool chroma = plane == 1 || plane == 2;
+		int rows = chroma ? -((-config.height) >> desc->log2_chroma_h) : config.height;
+		
+		if (frame->linesize[plane] == rowBytes) {
+			chunks.push_back({frame->data[plane], static_cast<size_t>(rowBytes) * rows});
+			continue;
+		}
+		for (int row = 0; row < rows; row++) {
+			chunks.push_back({frame->data[plane] + static_cast<ptrdiff_t>(row) * frame->linesize[plane],
+				static_cast<size_t>(rowBytes)});
+		}
+	}
+	
+	return writeChunks(fd, chunks);
+}
+
+bool RawFrameWriter::writeNUTFrame(const AVFrame* frame) {
+	if (av_new_packet(packet, frameBytes) < 0) {
+		return false;
+	}
+	av_image_copy_to_buffer(packet->data, frameBytes, frame->data, frame->linesize,
+		config.pixelFormat, config.width, config.height, 1);
+	
+	packet->pts = frameCount;
+	packet->dts = frameCount;
+	packet->duration = 1;
+	av_packet_rescale_ts(packet, av_inv_q(config.frameRate), stream->time_base);
+	packet->stream_index = stream->index;
+	packet->flags |= AV_PKT_FLAG_KEY;
+	
+	int ret = av_write_frame(formatCtx, packet);
+	av_packet_unref(packet);
+	return ret >= 0;
+}
+
+bool RawFrameWriter::finalize() {
+	if (finalized) {
+		return false;
+	}
+	finalized = true;
+	
+	bool ok = true;
+	if (formatCtx && headerWritten) {
+		ok = av_write_trailer(formatCtx) >= 0;
+	}
+	cleanup();
+	
+	utils::Logger::info("Raw output complete: {} frames", frameCount);
+	return ok;
+}
+
+void RawFrameWriter::cleanup() {
+	if (packet) {
+		FFmpegCompat::freePacket(&packet);
+	}
+	if (formatCtx) {
+		if (formatCtx->pb) {
+			avio_closep(&formatCtx->pb);
+		}
+		avformat_free_context(formatCtx);
+		formatCtx = nullptr;
+		stream = nullptr;
+	}
+	if (ownFd && fd >= 0) {
+#ifdef _WIN32
+		_close(fd);
+#else
+		close(fd);
+#endif
+		fd = -1;
+	}
+}
+
+} // namespace media
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "media/FrameSink.h"
+#include "media/MediaTypes.h"
+#include <cstdint>
+#include <string>
+
+namespace media {
+
+/**
+ * Streams rendered frames uncompressed to a file, a named pipe or standard
+ * output ("-"), for tools that post-process the render without an encode
+ * and decode in between.
+ *
+ * Y4M is written directly: each frame goes out in one vectored write that
+ * points at the frame's planes (row by row where they are padded), so no
+ * pixel is copied in user space. On Linux the pipe buffer is enlarged to
+ * keep the reader busy at 4K60 rates. NUT (rawvideo) goes through the
+ * libavformat muxer with one plane-packing copy per frame.
+ *
+ * When writing to standard output, the original stdout is kept for the frames
+ * and file descriptor 1 is pointed at stderr, so log lines and progress
+ * output cannot end up in the stream.
+ */
+class RawFrameWriter : public FrameSink {
+public:
+	enum class Format {
+		Y4M,
+		NUT
+	};
+	
+	struct Config {
+		Format format = Format::Y4M;
+		int width = 1920;
+		int height = 1080;
+		AVRational frameRate = {30, 1};
+		AVPixelFormat pixelFormat = AV_PIX_FMT_YUV420P;
+	};
+	
+	/**
+	 * @param filename Output path, or "-" for standard output
+	 * @throws std::runtime_error if the output cannot be opened or the pixel
+	 *         format has no Y4M name
+	 */
+	RawFrameWriter(const std::string& filename, const Config& config);
+	~RawFrameWriter() override;
+	
+	RawFrameWriter(const RawFrameWriter&) = delete;
+	RawFrameWriter& operator=(const RawFrameWriter&) = delete;
+	
+	bool writeFrame(AVFrame* frame) override;
+	bool finalize() override;
+	
+	int64_t getFrameCount() const { return frameCount; }
+	
+	// Parse "y4m" or "nut"
+	static bool parseFormat(const std::string& name, Format& format);
+	
+	/**
+	 * Move standard output out of the way before anything is logged: the
+	 * stream keeps a private copy for a later "-" writer, and stdout from
+	 * here on goes to stderr
+	 */
+	static void detachStdout();
+
+private:
+	void openOutput(const std::string& filename);
+	void setupMuxer();
+	bool writeY4MFrame(const AVFrame* frame);
+	bool writeNUTFrame(const AVFrame* frame);
+	bool writeY4MHeader(const AVFrame* frame);
+	void cleanup();
+	
+	Config config;
+	int fd = -1;
+	bool ownFd = false;
+	bool headerWritten = false;
+	bool finalized = false;
+	int64_t frameCount = 0;
+	
+	// NUT muxer state
+	AVFormatContext* formatCtx = nullptr;
+	AVStream* stream = nullptr;
+	AVPacket* packet = nullptr;
+	int frameBytes = 0;
+};
+
+} // namespace media
\ No newline at end of file
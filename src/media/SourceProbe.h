@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace media {
+
+/**
+ * Stream properties discovered when a source is opened. Kept free of FFmpeg
+ * types so it can be cached on disk (see cache::RenderPlan) and handed back to
+ * a decoder to skip stream info discovery on the next open.
+ */
+struct SourceProbe {
+	int width = 0;
+	int height = 0;
+	int pixelFormat = -1;           // AVPixelFormat
+	int codecId = 0;                // AVCodecID
+	int frameRateNum = 0;
+	int frameRateDen = 1;
+	int timeBaseNum = 0;
+	int timeBaseDen = 1;
+	int64_t totalFrames = 0;
+	std::vector<int64_t> keyframes; // Keyframe frame numbers, ascending
+
+	// A decoder opened from the probe takes its pixel format from it, so an
+	// unknown format makes the probe unusable
+	bool isValid() const {
+		return width > 0 && height > 0 && pixelFormat >= 0 && frameRateNum > 0 &&
+			frameRateDen > 0 && timeBaseNum > 0 && timeBaseDen > 0;
+	}
+};
+
+} // namespace media
\ No newline at end of file
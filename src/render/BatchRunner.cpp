@@ -0,0 +1,234 @@
+#include "render/BatchRunner.h"
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include "media/DecoderCache.h"
+#include "render/BatchScheduler.h"
+#include "render/Renderer.h"
+#include "utils/Logger.h"
+#include "utils/ThreadBudget.h"
+#include "utils/Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace render {
+
+namespace {
+
+// Relative paths of a job are relative to the batch file
+void resolvePath(std::string& path, const fs::path& base) {
+	if (!path.empty() && path != "-" && fs::path(path).is_relative()) {
+		path = (base / path).lexically_normal().string();
+	}
+}
+
+// Where a job reads its sources; empty if its EDL cannot be read, in which
+// case the render reports why
+BatchScheduler::Footprint footprintOf(const Options& job) {
+	try {
+		edl::EDL edl = job.edlJson.empty() ? edl::EDLParser::parse(job.edlFile) :
+			edl::EDLParser::parseJSON(nlohmann::json::parse(job.edlJson));
+		compositor::InstructionGenerator generator(edl);
+		const fs::path mediaDir = mediaDirectory(job);
+		return BatchScheduler::footprintOf(generator.getTimeline(), [&mediaDir](const std::string& uri) {
+			return resolveMediaPath(uri, mediaDir);
+		});
+	} catch (const std::exception& e) {
+		utils::Logger::debug("No footprint for {}: {}", job.outputFile, e.what());
+		return BatchScheduler::Footprint();
+	}
+}
+
+}
+
+BatchRunner::BatchRunner(const Config& config)
+	: config(config) {
+}
+
+std::vector<Options> BatchRunner::loadJobs(const std::string& path, const Options& defaults) {
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("Cannot open batch file: " + path);
+	}
+	nlohmann::json batch;
+	try {
+		batch = nlohmann::json::parse(file);
+	} catch (const nlohmann::json::exception& e) {
+		throw std::runtime_error("Invalid batch file " + path + ": " + e.what());
+	}
+	
+	Options common = defaults;
+	nlohmann::json jobList = batch;
+	if (batch.is_object()) {
+		if (batch.contains("options")) {
+			if (!batch["options"].is_object()) {
+				throw std::invalid_argument("options must be an object");
+			}
+			for (const auto& [key, value] : batch["options"].items()) {
+				applyJobOption(common, key, value);
+			}
+		}
+		jobList = batch.value("jobs", nlohmann::json());
+	}
+	if (!jobList.is_array() || jobList.empty()) {
+		throw std::invalid_argument("Batch file has no jobs: " + path);
+	}
+	
+	const fs::path base = fs::absolute(path).parent_path();
+	std::vector<Options> jobs;
+	std::set<std::string> outputs;
+	for (size_t i = 0; i < jobList.size(); i++) {
+		Options job;
+		try {
+			job = parseJobOptions(jobList[i], common);
+		} catch (const std::invalid_argument& e) {
+			throw std::invalid_argument("job " + std::to_string(i + 1) + ": " + e.what());
+		}
+		if (job.outputFile == "-") {
+			throw std::invalid_argument("job " + std::to_string(i + 1) + ": batch jobs cannot write to stdout");
+		}
+		
+		resolvePath(job.edlFile, base);
+		resolvePath(job.outputFile, base);
+		resolvePath(job.mediaDir, base);
+		resolvePath(job.segmentCacheDir, base);
+		for (auto& extra : job.extraOutputs) {
+			resolvePath(extra.file, base);
+		}
+		if (!job.edlJson.empty() && job.mediaDir.empty()) {
+			job.mediaDir = base.string();
+		}
+		
+		if (!outputs.insert(job.outputFile).second) {
+			throw std::invalid_argument("job " + std::to_string(i + 1) + ": " + job.outputFile +
+				" is written by an earlier job");
+		}
+		jobs.push_back(std::move(job));
+	}
+	return jobs;
+}
+
+BatchRunner::Result BatchRunner::run(std::vector<Options> jobs) {
+	Result result;
+	if (jobs.empty()) {
+		return result;
+	}
+	auto startTime = std::chrono::steady_clock::now();
+	
+	// Order the jobs by the sources they read
+	std::vector<BatchScheduler::Footprint> footprints;
+	{
+		TIME_BLOCK("batch_scheduling");
+		for (const auto& job : jobs) {
+			footprints.push_back(footprintOf(job));
+		}
+	}
+	BatchScheduler scheduler(footprints);
+	std::set<std::string> sources;
+	for (const auto& footprint : footprints) {
+		for (const auto& range : footprint) {
+			sources.insert(range.source);
+		}
+	}
+	
+	// Jobs split the thread budget evenly; a job's own "threads" wins
+	int concurrency = config.concurrency > 0 ? config.concurrency :
+		std::clamp(utils::ThreadBudget::hardwareThreads() / 4, 1, 4);
+	concurrency = std::min<int>(concurrency, jobs.size());
+	int totalThreads = config.threads > 0 ? config.threads : utils::ThreadBudget::hardwareThreads();
+	int threadsPerJob = std::max(1, totalThreads / concurrency);
+	for (auto& job : jobs) {
+		if (job.threads == 0) {
+			job.threads = threadsPerJob;
+		}
+		job.quiet = true;
+	}
+	utils::Logger::info("Batch: {} jobs reading {} sources, {} at a time with {} threads each",
+		jobs.size(), sources.size(), concurrency, threadsPerJob);
+	
+	media::DecoderCache::Config cacheConfig;
+	cacheConfig.maxIdleDecoders = config.maxIdleDecoders;
+	auto decoderCache = std::make_shared<media::DecoderCache>(cacheConfig);
+	
+	std::mutex mutex;
+	int finished = 0;
+	auto worker = [&](int index) {
+		utils::Timer::getInstance().setThreadName("batch worker " + std::to_string(index));
+		while (true) {
+			int job = -1;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!cancelled.load(std::memory_order_relaxed)) {
+					job = scheduler.next();
+				}
+			}
+			if (job < 0) {
+				return;
+			}
+			
+			const Options& options = jobs[job];
+			utils::Logger::info("Job {} started: {} -> {}", job + 1,
+				options.edlJson.empty() ? options.edlFile : std::string("(inline EDL)"), options.outputFile);
+			
+			Renderer renderer(options);
+			renderer.setDecoderCache(decoderCache);
+			renderer.setProgressCallback([this, &renderer](const Renderer::Progress&) {
+				if (cancelled.load(std::memory_order_relaxed)) {
+					renderer.cancel();
+				}
+			});
+			
+			Renderer::Result jobResult;
+			bool failed = false;
+			try {
+				jobResult = renderer.render();
+			} catch (const std::exception& e) {
+				utils::Logger::error("Job {} failed: {}", job + 1, e.what());
+				failed = true;
+			}
+			
+			std::lock_guard<std::mutex> lock(mutex);
+			scheduler.finished(job);
+			finished++;
+			if (failed) {
+				result.failed++;
+			} else if (jobResult.cancelled) {
+				result.cancelled++;
+			} else {
+				result.done++;
+				result.frames += jobResult.frames;
+				utils::Logger::info("Job {} done ({}/{}): {} frames in {} seconds", job + 1, finished,
+					jobs.size(), jobResult.frames, jobResult.seconds);
+			}
+		}
+	};
+	
+	std::vector<std::thread> workers;
+	for (int i = 0; i < concurrency; i++) {
+		workers.emplace_back(worker, i);
+	}
+	for (auto& thread : workers) {
+		thread.join();
+	}
+	
+	// Jobs never started count as cancelled
+	result.cancelled += static_cast<int>(jobs.size()) - finished;
+	
+	media::DecoderCache::Stats cacheStats = decoderCache->getStats();
+	utils::Logger::info("Decoder cache: {} warm decoders reused, {} opened, {} probes reused",
+		cacheStats.decoderHits, cacheStats.decoderMisses, cacheStats.probeHits);
+	decoderCache->clear();
+	
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	result.seconds = elapsed.count();
+	return result;
+}
+
+} // namespace render
\ No newline at end of file
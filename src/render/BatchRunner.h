@@ -0,0 +1,58 @@
+#pragma once
+
+#include "render/RenderOptions.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace render {
+
+/**
+ * Renders many EDLs in one process (--batch). All jobs share one
+ * DecoderCache, so a source is probed once for the whole batch and a job
+ * picks up the decoders earlier jobs left open. BatchScheduler orders the
+ * jobs so that the jobs reading one source follow each other. Jobs run
+ * several at a time within one thread budget.
+ *
+ * A job that fails is reported and the batch goes on.
+ */
+class BatchRunner {
+public:
+	struct Config {
+		int concurrency = 0;            // Jobs rendered at the same time, 0 = cores / 4 (1 to 4)
+		int threads = 0;                // Threads of the whole batch, 0 = all cores
+		size_t maxIdleDecoders = 16;    // Warm decoders kept between jobs
+	};
+	
+	struct Result {
+		int done = 0;
+		int failed = 0;
+		int cancelled = 0;
+		int frames = 0;
+		double seconds = 0.0;
+	};
+	
+	explicit BatchRunner(const Config& config);
+	
+	/**
+	 * Read the jobs of a batch file: a list of jobs as taken by
+	 * parseJobOptions(), or {"options": {...}, "jobs": [...]} with options
+	 * every job starts from. Relative paths are relative to the file.
+	 * @throws std::runtime_error if the file cannot be read
+	 * @throws std::invalid_argument on a malformed job or two jobs writing one file
+	 */
+	static std::vector<Options> loadJobs(const std::string& path, const Options& defaults = Options());
+	
+	// Render all jobs; returns when the last one has ended
+	Result run(std::vector<Options> jobs);
+	
+	// Start no more jobs and cancel the running ones; async-signal-safe
+	void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+private:
+	Config config;
+	std::atomic<bool> cancelled{false};
+};
+
+} // namespace render
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "render/BatchScheduler.h"
+#include "compositor/TimelineSpan.h"
+#include <algorithm>
+#include <limits>
+
+namespace render {
+
+BatchScheduler::BatchScheduler(const std::vector<Footprint>& jobs)
+	: mainSources(jobs.size()), started(jobs.size(), false) {
+	// Main source and where reading it starts, per job
+	std::vector<double> starts(jobs.size(), 0.0);
+	std::unordered_map<std::string, double> groupSeconds;
+	for (size_t job = 0; job < jobs.size(); job++) {
+		std::unordered_map<std::string, double> seconds;
+		for (const auto& range : jobs[job]) {
+			seconds[range.source] += range.end - range.start;
+		}
+		
+		double most = -1.0;
+		for (const auto& [source, total] : seconds) {
+			// Ties go to the smaller name, so the order does not depend on hashing
+			if (total > most || (total == most && source < mainSources[job])) {
+				most = total;
+				mainSources[job] = source;
+			}
+		}
+		
+		double start = std::numeric_limits<double>::max();
+		for (const auto& range : jobs[job]) {
+			if (range.source == mainSources[job]) {
+				start = std::min(start, range.start);
+			}
+		}
+		starts[job] = mainSources[job].empty() ? 0.0 : start;
+		groupSeconds[mainSources[job]] += std::max(0.0, most);
+	}
+	
+	// Largest groups first, jobs without media last; within a group by start
+	order.resize(jobs.size());
+	for (size_t job = 0; job < jobs.size(); job++) {
+		order[job] = static_cast<int>(job);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		const std::string& sourceA = mainSources[a];
+		const std::string& sourceB = mainSources[b];
+		if (sourceA != sourceB) {
+			if (sourceA.empty() || sourceB.empty()) {
+				return sourceB.empty();
+			}
+			if (groupSeconds[sourceA] != groupSeconds[sourceB]) {
+				return groupSeconds[sourceA] > groupSeconds[sourceB];
+			}
+			return sourceA < sourceB;
+		}
+		return starts[a] < starts[b];
+	});
+}
+
+BatchScheduler::Footprint BatchScheduler::footprintOf(const compositor::CompiledTimeline& timeline,
+	const std::function<std::string(const std::string&)>& resolve) {
+	std::vector<std::string> paths;
+	paths.reserve(timeline.sources.size());
+	for (const auto& uri : timeline.sources) {
+		paths.push_back(resolve(uri));
+	}
+	
+	Footprint footprint;
+	for (const auto& span : timeline.spans) {
+		if (span.kind != compositor::TimelineSpan::Media || span.sourceIndex < 0 ||
+			span.sourceIndex >= static_cast<int32_t>(paths.size())) {
+			continue;
+		}
+		// A span can be part of a clip; read from where the span starts
+		double offset = static_cast<double>(span.startFrame) / timeline.fps - span.clipIn;
+		double length = static_cast<double>(span.endFrame - span.startFrame) / timeline.fps;
+		Range range;
+		range.source = paths[span.sourceIndex];
+		range.start = span.sourceIn + std::max(0.0, offset);
+		range.end = range.start + length;
+		footprint.push_back(std::move(range));
+	}
+	return footprint;
+}
+
+int BatchScheduler::next() {
+	while (firstPending < order.size() && started[order[firstPending]]) {
+		firstPending++;
+	}
+	if (firstPending == order.size()) {
+		return -1;
+	}
+	
+	int chosen = order[firstPending];
+	for (size_t i = firstPending; i < order.size(); i++) {
+		int job = order[i];
+		if (started[job]) {
+			continue;
+		}
+		const std::string& source = mainSources[job];
+		if (source.empty() || readers[source] == 0) {
+			chosen = job;
+			break;
+		}
+	}
+	
+	started[chosen] = true;
+	if (!mainSources[chosen].empty()) {
+		readers[mainSources[chosen]]++;
+	}
+	return chosen;
+}
+
+void BatchScheduler::finished(int job) {
+	const std::string& source = mainSources[job];
+	if (!source.empty() && readers[source] > 0) {
+		readers[source]--;
+	}
+}
+
+} // namespace render
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace compositor {
+struct CompiledTimeline;
+}
+
+namespace render {
+
+/**
+ * Order in which the jobs of a batch run, so jobs cutting from the same
+ * sources follow each other and reuse warm decoders.
+ *
+ * Each job is filed under its main source, the one it reads the most of.
+ * Jobs of one source run one after another in order of where they start
+ * reading it, so the decoder a job leaves behind in the DecoderCache only
+ * seeks forward for the next one. Jobs running at the same time are kept on
+ * different sources where possible: two jobs reading one source at once
+ * need two decoders, and neither leaves the other a warm one.
+ *
+ * Not thread-safe; the batch runner calls it under its own lock.
+ */
+class BatchScheduler {
+public:
+	// Stretch of a source a job reads, in seconds of the source
+	struct Range {
+		std::string source;     // Resolved path, so jobs in different directories match
+		double start = 0.0;
+		double end = 0.0;
+	};
+	
+	// Everything a job reads; empty for jobs without media
+	using Footprint = std::vector<Range>;
+	
+	explicit BatchScheduler(const std::vector<Footprint>& jobs);
+	
+	/**
+	 * Footprint of a compiled timeline
+	 * @param resolve Maps a media URI of the timeline to the file it reads
+	 */
+	static Footprint footprintOf(const compositor::CompiledTimeline& timeline,
+		const std::function<std::string(const std::string&)>& resolve);
+	
+	/**
+	 * Start the next job: the first in order whose main source no running job
+	 * reads, otherwise the first in order
+	 * @return Index of the job, -1 when all have started
+	 */
+	int next();
+	
+	// A job started by next() has ended
+	void finished(int job);
+	
+	// All jobs in the order they are tried
+	const std::vector<int>& getOrder() const { return order; }
+	
+	// Main source of a job ("" without media)
+	const std::string& getMainSource(int job) const { return mainSources[job]; }
+
+private:
+	std::vector<int> order;
+	std::vector<std::string> mainSources;
+	std::vector<bool> started;
+	std::unordered_map<std::string, int> readers;   // Running jobs per main source
+	size_t firstPending = 0;                        // Jobs before it in order have all started
+};
+
+} // namespace render
\ No newline at end of file
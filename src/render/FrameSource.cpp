@@ -0,0 +1,86 @@
+#include "render/FrameSource.h"
+#include "compositor/FrameCompositor.h"
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include "media/DecoderPool.h"
+#include "media/HardwareAcceleration.h"
+#include "utils/Logger.h"
+#include "utils/ThreadBudget.h"
+#include <stdexcept>
+
+namespace render {
+
+FrameSource::FrameSource(const Options& options, std::shared_ptr<media::DecoderCache> cache) {
+	edl::EDL edl = options.edlJson.empty() ? edl::EDLParser::parse(options.edlFile) :
+		edl::EDLParser::parseJSON(nlohmann::json::parse(options.edlJson));
+	generator = std::make_unique<compositor::InstructionGenerator>(edl);
+	
+	const compositor::CompiledTimeline& timeline = generator->getTimeline();
+	width = renderDimension(timeline.width, options.proxy);
+	height = renderDimension(timeline.height, options.proxy);
+	frameRate = timeline.fps;
+	
+	// Frames are handed out in system memory, so hardware decoders download
+	// every frame
+	media::DecoderPool::Config poolConfig;
+	poolConfig.decoderConfig.threadCount = options.threads;
+	poolConfig.decoderConfig.useHardwareDecoder = options.hwDecode;
+	poolConfig.decoderConfig.hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(options.hwAccelType);
+	poolConfig.decoderConfig.hwConfig.deviceIndex = options.hwDevice;
+	poolConfig.decoderConfig.hwConfig.allowFallback = true;
+	if (options.proxy > 0) {
+		poolConfig.decoderConfig.lowres = proxyLowres(options.proxy);
+		poolConfig.decoderConfig.fastDecode = true;
+	}
+	poolConfig.maxOpenDecoders = options.maxOpenDecoders;
+	poolConfig.maxMemoryBytes = options.decoderMemoryMB * 1024 * 1024;
+	poolConfig.cache = std::move(cache);
+	decoders = std::make_unique<media::DecoderPool>(poolConfig);
+	
+	const std::filesystem::path mediaDir = mediaDirectory(options);
+	for (const std::string& uri : timeline.sources) {
+		decoders->addSource(uri, resolveMediaPath(uri, mediaDir));
+	}
+	
+	int compositorThreads = options.threads > 0 ? options.threads : utils::ThreadBudget::hardwareThreads();
+	compositor = std::make_unique<compositor::FrameCompositor>(width, height, AV_PIX_FMT_YUV420P,
+		compositorThreads);
+	compositor->setFastScaling(options.proxy > 0);
+}
+
+FrameSource::~FrameSource() {
+	// Decoders go back to the warm cache, if any
+	decoders->closeAll();
+}
+
+int FrameSource::getTotalFrames() const {
+	return generator->getTotalFrames();
+}
+
+std::shared_ptr<AVFrame> FrameSource::getFrame(int frame) {
+	if (frame < 0 || frame >= generator->getTotalFrames()) {
+		throw std::out_of_range("Frame " + std::to_string(frame) + " is outside the timeline");
+	}
+	
+	const auto instruction = generator->getInstructionForFrame(frame);
+	if (instruction.type == compositor::CompositorInstruction::GenerateColor) {
+		return compositor->generateColorFrame(instruction.color.r, instruction.color.g, instruction.color.b);
+	}
+	if (instruction.type != compositor::CompositorInstruction::DrawFrame) {
+		return compositor->generateColorFrame(0, 0, 0);
+	}
+	
+	media::FFmpegDecoder* decoder = decoders->acquire(instruction.uri);
+	if (!decoder) {
+		utils::Logger::warn("Decoder not found for media: {}", instruction.uri);
+		return compositor->generateColorFrame(0, 0, 0);
+	}
+	std::shared_ptr<AVFrame> inputFrame = decoder->getFrame(instruction.sourceFrameNumber);
+	if (!inputFrame) {
+		throw std::runtime_error("Failed to decode frame " + std::to_string(instruction.sourceFrameNumber) +
+			" of " + instruction.uri);
+	}
+	return compositor->processFrame(inputFrame, instruction);
+}
+
+} // namespace render
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "render/RenderOptions.h"
+#include <memory>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace compositor {
+class InstructionGenerator;
+class FrameCompositor;
+}
+
+namespace media {
+class DecoderCache;
+class DecoderPool;
+}
+
+namespace render {
+
+/**
+ * Composited frames of an EDL on request, in any order: the decode and
+ * composite stages of a render without an output, for previews and for
+ * applications pulling frames through the library API.
+ *
+ * Frames are YUV 4:2:0 in system memory, also with hardware decoding.
+ * Sources open when their first frame is asked for and close under the
+ * same caps as in a render. Not thread-safe.
+ */
+class FrameSource {
+public:
+	/**
+	 * Parse and compile the EDL of options; sources are registered, not opened
+	 * @param cache Warm probes and decoders shared with other renders, may be null
+	 * @throws std::runtime_error if the EDL cannot be read
+	 */
+	explicit FrameSource(const Options& options, std::shared_ptr<media::DecoderCache> cache = nullptr);
+	~FrameSource();
+	
+	FrameSource(const FrameSource&) = delete;
+	FrameSource& operator=(const FrameSource&) = delete;
+	
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getFrameRate() const { return frameRate; }
+	int getTotalFrames() const;
+	
+	/**
+	 * Composite one output frame
+	 * @throws std::out_of_range for a frame outside the timeline
+	 * @throws std::runtime_error if a source frame cannot be decoded
+	 */
+	std::shared_ptr<AVFrame> getFrame(int frame);
+
+private:
+	std::unique_ptr<compositor::InstructionGenerator> generator;
+	std::unique_ptr<media::DecoderPool> decoders;
+	std::unique_ptr<compositor::FrameCompositor> compositor;
+	int width = 0;
+	int height = 0;
+	int frameRate = 0;
+};
+
+} // namespace render
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "render/RenderOptions.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace render {
+
+namespace {
+
+template<typename T>
+T getValue(const nlohmann::json& value, const std::string& key) {
+	try {
+		return value.get<T>();
+	} catch (const nlohmann::json::exception&) {
+		throw std::invalid_argument("invalid value for " + key + ": " + value.dump());
+	}
+}
+
+}
+
+ExtraOutput parseOutputSpec(const std::string& spec) {
+	ExtraOutput output;
+	size_t comma = spec.find(',');
+	output.file = spec.substr(0, comma);
+	if (output.file.empty()) {
+		throw std::invalid_argument("missing file name");
+	}
+	
+	while (comma != std::string::npos) {
+		size_t next = spec.find(',', comma + 1);
+		std::string option = spec.substr(comma + 1, next == std::string::npos ? std::string::npos : next - comma - 1);
+		comma = next;
+		
+		size_t equals = option.find('=');
+		if (equals == std::string::npos) {
+			throw std::invalid_argument("expected key=value: " + option);
+		}
+		std::string key = option.substr(0, equals);
+		std::string value = option.substr(equals + 1);
+		
+		if (key == "codec") {
+			output.codec = value;
+		} else if (key == "bitrate") {
+			output.bitrate = std::stoi(value);
+		} else if (key == "crf") {
+			output.crf = std::stoi(value);
+			output.bitrate = 0;
+		} else if (key == "preset") {
+			output.preset = value;
+		} else if (key == "size") {
+			size_t x = value.find('x');
+			if (x == std::string::npos) {
+				output.height = std::stoi(value);
+			} else {
+				output.width = std::stoi(value.substr(0, x));
+				output.height = std::stoi(value.substr(x + 1));
+			}
+			if (output.height <= 0 || output.width < 0) {
+				throw std::invalid_argument("invalid size: " + value);
+			}
+		} else {
+			throw std::invalid_argument("unknown option: " + key);
+		}
+	}
+	return output;
+}
+
+Options parseJobOptions(const nlohmann::json& job, const Options& defaults) {
+	if (!job.is_object()) {
+		throw std::invalid_argument("job must be an object");
+	}
+	Options opts = defaults;
+	
+	if (!job.contains("edl")) {
+		throw std::invalid_argument("missing edl");
+	}
+	const nlohmann::json& edl = job["edl"];
+	if (edl.is_string()) {
+		opts.edlFile = edl.get<std::string>();
+	} else if (edl.is_object()) {
+		opts.edlJson = edl.dump();
+		opts.edlFile.clear();
+	} else {
+		throw std::invalid_argument("edl must be a file name or an EDL object");
+	}
+	if (job.contains("media_dir")) {
+		opts.mediaDir = getValue<std::string>(job["media_dir"], "media_dir");
+	}
+	if (!job.contains("output")) {
+		throw std::invalid_argument("missing output");
+	}
+	opts.outputFile = getValue<std::string>(job["output"], "output");
+	
+	if (!job.contains("options")) {
+		return opts;
+	}
+	const nlohmann::json& options = job["options"];
+	if (!options.is_object()) {
+		throw std::invalid_argument("options must be an object");
+	}
+	
+	for (const auto& [key, value] : options.items()) {
+		applyJobOption(opts, key, value);
+	}
+	return opts;
+}
+
+void applyJobOption(Options& options, const std::string& key, const nlohmann::json& value) {
+	if (key == "codec") {
+		options.codec = getValue<std::string>(value, key);
+	} else if (key == "bitrate") {
+		options.bitrate = getValue<int>(value, key);
+	} else if (key == "crf") {
+		options.crf = getValue<int>(value, key);
+		options.bitrate = 0;
+	} else if (key == "preset") {
+		options.preset = getValue<std::string>(value, key);
+	} else if (key == "hw_accel") {
+		options.hwAccelType = getValue<std::string>(value, key);
+	} else if (key == "hw_device") {
+		options.hwDevice = getValue<int>(value, key);
+	} else if (key == "hw_decode") {
+		options.hwDecode = getValue<bool>(value, key);
+	} else if (key == "hw_encode") {
+		options.hwEncode = getValue<bool>(value, key);
+	} else if (key == "threads") {
+		options.threads = getValue<int>(value, key);
+		if (options.threads < 0) {
+			throw std::invalid_argument("threads must not be negative");
+		}
+	} else if (key == "max_open_decoders") {
+		options.maxOpenDecoders = getValue<int>(value, key);
+		if (options.maxOpenDecoders < 2) {
+			throw std::invalid_argument("at least 2 open decoders are required");
+		}
+	} else if (key == "decoder_memory") {
+		options.decoderMemoryMB = getValue<uint64_t>(value, key);
+	} else if (key == "plan_cache") {
+		options.usePlanCache = getValue<bool>(value, key);
+	} else if (key == "segment_cache") {
+		options.segmentCacheDir = getValue<std::string>(value, key);
+	} else if (key == "segment_cache_size") {
+		options.segmentCacheSizeMB = getValue<uint64_t>(value, key);
+	} else if (key == "segment_format") {
+		options.segmentFormat = getValue<std::string>(value, key);
+		if (options.segmentFormat != "hls" && options.segmentFormat != "hls-fmp4" && options.segmentFormat != "fmp4") {
+			throw std::invalid_argument("unknown segment format: " + options.segmentFormat);
+		}
+	} else if (key == "segment_duration") {
+		options.segmentDuration = getValue<double>(value, key);
+		if (options.segmentDuration <= 0.0) {
+			throw std::invalid_argument("segment duration must be positive");
+		}
+	} else if (key == "audio") {
+		options.audio = getValue<bool>(value, key);
+	} else if (key == "audio_codec") {
+		options.audioCodec = getValue<std::string>(value, key);
+	} else if (key == "audio_bitrate") {
+		options.audioBitrate = getValue<int>(value, key);
+	} else if (key == "audio_passthrough") {
+		options.audioPassthrough = getValue<bool>(value, key);
+	} else if (key == "outputs") {
+		if (!value.is_array()) {
+			throw std::invalid_argument("outputs must be a list of output specs");
+		}
+		for (const auto& spec : value) {
+			options.extraOutputs.push_back(parseOutputSpec(getValue<std::string>(spec, key)));
+		}
+	} else if (key == "proxy") {
+		options.proxy = getValue<int>(value, key);
+		if (options.proxy != 0 && (options.proxy < 2 || options.proxy > 16)) {
+			throw std::invalid_argument("proxy factor must be between 2 and 16");
+		}
+	} else if (key == "raw") {
+		options.rawFormat = getValue<std::string>(value, key);
+		if (options.rawFormat != "y4m" && options.rawFormat != "nut") {
+			throw std::invalid_argument("unknown raw format: " + options.rawFormat);
+		}
+	} else {
+		throw std::invalid_argument("unknown option: " + key);
+	}
+}
+
+int renderDimension(int edlDimension, int proxy) {
+	if (proxy <= 1) {
+		return edlDimension;
+	}
+	return std::max(2, (edlDimension / proxy) & ~1);
+}
+
+int proxyLowres(int proxy) {
+	int lowres = 0;
+	while (lowres < 3 && (2 << lowres) <= proxy) {
+		lowres++;
+	}
+	return lowres;
+}
+
+std::filesystem::path mediaDirectory(const Options& options) {
+	if (!options.mediaDir.empty()) {
+		return options.mediaDir;
+	}
+	return std::filesystem::path(options.edlFile).parent_path();
+}
+
+std::string resolveMediaPath(const std::string& uri, const std::filesystem::path& mediaDir) {
+	// First, check if uri is already a full path
+	if (std::filesystem::exists(uri)) {
+		return uri;
+	}
+	
+	// Try relative to EDL file directory
+	std::filesystem::path mediaPath = mediaDir / uri;
+	if (std::filesystem::exists(mediaPath)) {
+		return mediaPath.string();
+	}
+	
+	// Return as-is and let FFmpeg handle it
+	return uri;
+}
+
+} // namespace render
\ No newline at end of file
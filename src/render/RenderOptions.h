@@ -0,0 +1,145 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace render {
+
+// Additional output encoded from the same frames; unset fields follow the
+// main output
+struct ExtraOutput {
+	std::string file;
+	std::string codec;
+	int bitrate = -1;
+	int crf = -1;
+	std::string preset;
+	int width = 0;          // 0 = keep aspect ratio (or the EDL size)
+	int height = 0;
+};
+
+struct Options {
+	std::string edlFile;
+	std::string outputFile;
+	std::string codec = "libx264";
+	int bitrate = 446464;  // 436Ki (436 * 1024) - matching ftv_toffmpeg default
+	std::string preset = "faster";  // matching ftv_toffmpeg default
+	int crf = 23;
+	bool verbose = false;
+	bool quiet = false;
+	
+	// EDL document given inline instead of read from edlFile (render daemon
+	// jobs), and the directory relative media paths are resolved against
+	// (default: the directory of edlFile)
+	std::string edlJson;
+	std::string mediaDir;
+	
+	// Hardware acceleration options
+	std::string hwAccelType = "auto";
+	int hwDevice = 0;
+	bool hwDecode = false;
+	bool hwEncode = false;
+	
+	// Thread limit for the whole process (0 = all cores)
+	int threads = 0;
+	
+	// Decoder pool limits
+	int maxOpenDecoders = 16;
+	uint64_t decoderMemoryMB = 0;  // 0 = unlimited
+	
+	// Process-wide memory budget (0 = unlimited)
+	uint64_t maxMemoryMB = 0;
+	
+	// Compiled render plan cache next to the EDL
+	bool usePlanCache = true;
+	
+	// Content-addressed cache of encoded segments (disabled when empty)
+	std::string segmentCacheDir;
+	uint64_t segmentCacheSizeMB = 10240;
+	
+	// Segmented output (HLS or fragmented MP4, single file when empty)
+	std::string segmentFormat;
+	double segmentDuration = 6.0;
+	
+	// Audio tracks of the EDL (rendered when present)
+	bool audio = true;
+	std::string audioCodec = "aac";
+	int audioBitrate = 128000;
+	bool audioPassthrough = true;
+	
+	// Fan-out to further encodes of the same render
+	std::vector<ExtraOutput> extraOutputs;
+	
+	// Preview render at 1/proxy of the EDL size, with cheap decoding and a
+	// fast encoder preset (full render when 0)
+	int proxy = 0;
+	
+	// Uncompressed output instead of the encoder ("y4m" or "nut", encoded when empty)
+	std::string rawFormat;
+	
+	// Shared memory rings for an external compositor (disabled when empty)
+	std::string shmExport;
+	std::string shmReturn;
+	
+	// Last pipeline stage of a benchmark run ("decode", "composite" or
+	// "encode"); outputFile is then the JSON report
+	std::string benchmark;
+	
+	// Chrome trace-event JSON of every timed zone (disabled when empty)
+	std::string traceFile;
+	
+	// One JSON object per log line instead of text
+	bool jsonLog = false;
+	
+	// Frame planes from the huge-page arena, optionally faulted in up front
+	bool hugePages = false;
+	bool prefault = false;
+};
+
+/**
+ * Parse "<file>[,key=value...]" as given to --output
+ * @throws std::invalid_argument on an unknown key or malformed value
+ */
+ExtraOutput parseOutputSpec(const std::string& spec);
+
+/**
+ * Options of a render job given as JSON (render daemon requests):
+ *
+ *   {"edl": "<file>" or {<EDL document>}, "media_dir": "<dir>",
+ *    "output": "<file>", "options": {"codec": "libx265", "crf": 28, ...}}
+ *
+ * The keys of "options" are the long command line options with '_' for
+ * '-' (codec, bitrate, crf, preset, threads, hw_accel, hw_decode, outputs,
+ * audio, ...); "outputs" is a list of --output specs. Settings of the whole
+ * process (logging, memory, tracing) are not job options.
+ *
+ * @param defaults Options the job starts from
+ * @throws std::invalid_argument on a missing field, unknown key or bad value
+ */
+Options parseJobOptions(const nlohmann::json& job, const Options& defaults = Options());
+
+/**
+ * Set one key of a job's "options" (see parseJobOptions())
+ * @throws std::invalid_argument on an unknown key or bad value
+ */
+void applyJobOption(Options& options, const std::string& key, const nlohmann::json& value);
+
+// Size of the rendered frames along one axis: the EDL size, or 1/proxy of
+// it rounded down to an even number of at least 2
+int renderDimension(int edlDimension, int proxy);
+
+// Reduced-resolution decoding (FFmpeg lowres) for a proxy factor: the
+// largest power of two it covers, up to the 1/8 decoders offer
+int proxyLowres(int proxy);
+
+// Directory relative media paths are resolved against: mediaDir, or the
+// directory of the EDL file
+std::filesystem::path mediaDirectory(const Options& options);
+
+// File a media URI of the EDL refers to; returned as is when no such file
+// exists (e.g. a URL), for FFmpeg to open
+std::string resolveMediaPath(const std::string& uri, const std::filesystem::path& mediaDir);
+
+} // namespace render
\ No newline at end of file
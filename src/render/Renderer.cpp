@@ -0,0 +1,863 @@
+#include "render/Renderer.h"
+#include "audio/AudioPacketReader.h"
+#include "audio/AudioPipeline.h"
+#include "cache/RenderPlan.h"
+#include "cache/SegmentCache.h"
+#include "edl/EDLParser.h"
+#include "ipc/ExternalCompositor.h"
+#include "compositor/InstructionGenerator.h"
+#include "compositor/FrameCompositor.h"
+#include "media/DecoderCache.h"
+#include "media/DecoderPool.h"
+#include "media/EncoderFanout.h"
+#include "media/FFmpegEncoder.h"
+#include "media/HardwareAcceleration.h"
+#include "media/HardwareContextManager.h"
+#include "media/RawFrameWriter.h"
+#include "utils/BenchmarkReport.h"
+#include "utils/FrameArena.h"
+#include "utils/Logger.h"
+#include "utils/ThreadBudget.h"
+#include "utils/ThreadPool.h"
+#include "utils/Timer.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace render {
+
+namespace {
+
+// Sources opened in parallel at startup (opening is mostly I/O latency)
+constexpr int MAX_CONCURRENT_OPENS = 8;
+
+// Output-sized frames pre-faulted in the frame arena: the decoder and
+// compositor pools, the encoder queue and the frames codecs hold on to
+constexpr size_t ARENA_PREFAULT_FRAMES = 48;
+
+// Check if instruction requires CPU processing (effects, transforms, etc.)
+bool requiresCPUProcessing(const compositor::CompositorInstruction& instruction) {
+	// Check for effects
+	if (!instruction.effects.empty()) {
+		return true;
+	}
+	
+	// Check for fade
+	if (instruction.fade < 1.0f) {
+		return true;
+	}
+	
+	// Check for transforms
+	if (std::abs(instruction.panX) > 0.001f ||
+		std::abs(instruction.panY) > 0.001f ||
+		std::abs(instruction.zoomX - 1.0f) > 0.001f ||
+		std::abs(instruction.zoomY - 1.0f) > 0.001f ||
+		std::abs(instruction.rotation) > 0.001f ||
+		instruction.flip) {
+		return true;
+	}
+	
+	// Check for transitions
+	if (instruction.transition.type != compositor::TransitionInfo::None) {
+		return true;
+	}
+	
+	// Check if it's not a simple draw frame
+	if (instruction.type != compositor::CompositorInstruction::DrawFrame) {
+		return true;
+	}
+	
+	return false;
+}
+
+// Encoder preset of a render: proxy renders swap the default preset of the
+// x264/x265 encoders for the fastest one
+std::string encoderPreset(const Options& opts, const std::string& codec, const std::string& preset) {
+	if (opts.proxy > 0 && preset == Options().preset && (codec == "libx264" || codec == "libx265")) {
+		return "ultrafast";
+	}
+	return preset;
+}
+
+}
+
+Renderer::Renderer(const Options& options)
+	: opts(options) {
+}
+
+Renderer::~Renderer() = default;
+
+void Renderer::setProgressCallback(ProgressCallback callback) {
+	progressCallback = std::move(callback);
+}
+
+void Renderer::setDecoderCache(std::shared_ptr<media::DecoderCache> cache) {
+	decoderCache = std::move(cache);
+}
+
+edl::EDL Renderer::parseEDL() const {
+	if (opts.edlJson.empty()) {
+		return edl::EDLParser::parse(opts.edlFile);
+	}
+	return edl::EDLParser::parseJSON(nlohmann::json::parse(opts.edlJson));
+}
+
+Renderer::Result Renderer::render() {
+	bool rawOutput = !opts.rawFormat.empty();
+	const fs::path mediaDir = mediaDirectory(opts);
+	
+	// Load the compiled render plan if it was built from this exact EDL,
+	// otherwise parse and compile the EDL. An inline EDL has no file to keep
+	// the plan next to.
+	bool usePlanCache = opts.usePlanCache && opts.edlJson.empty();
+	std::string planPath = cache::RenderPlan::planPathFor(opts.edlFile);
+	uint64_t edlHash = usePlanCache ? cache::RenderPlan::hashFile(opts.edlFile) : 0;
+	std::unique_ptr<cache::RenderPlan> plan;
+	if (usePlanCache) {
+		TIME_BLOCK("render_plan_load");
+		plan = cache::RenderPlan::load(planPath);
+	}
+	
+	bool planMatchesEDL = plan && plan->getEDLHash() == edlHash;
+	std::unique_ptr<compositor::InstructionGenerator> generator;
+	std::unique_ptr<audio::AudioTimeline> audioTimeline;
+	if (planMatchesEDL) {
+		TIME_BLOCK("render_plan_timeline");
+		utils::Logger::info("Using compiled render plan: {}", planPath);
+		generator = std::make_unique<compositor::InstructionGenerator>(plan->getTimeline());
+	} else {
+		TIME_BLOCK("edl_parsing");
+		if (opts.edlJson.empty()) {
+			utils::Logger::info("Parsing EDL file: {}", opts.edlFile);
+		}
+		edl::EDL edl = parseEDL();
+		
+		utils::Logger::info("EDL: {}x{} @ {} fps, {} clips",
+			edl.width, edl.height, edl.fps, edl.clips.size());
+		
+		generator = std::make_unique<compositor::InstructionGenerator>(edl);
+		if (opts.audio) {
+			audioTimeline = std::make_unique<audio::AudioTimeline>(edl);
+		}
+	}
+	
+	// The render plan only covers video, so audio still needs the EDL
+	if (opts.audio && !audioTimeline) {
+		TIME_BLOCK("audio_edl_parsing");
+		audioTimeline = std::make_unique<audio::AudioTimeline>(parseEDL());
+	}
+	if (audioTimeline && audioTimeline->empty()) {
+		audioTimeline.reset();
+	}
+	const compositor::CompiledTimeline& timeline = generator->getTimeline();
+	
+	// Proxy renders composite and encode at a fraction of the EDL size
+	const int outputWidth = renderDimension(timeline.width, opts.proxy);
+	const int outputHeight = renderDimension(timeline.height, opts.proxy);
+	if (opts.proxy > 0) {
+		if (!opts.shmExport.empty()) {
+			throw std::runtime_error("Proxy renders cannot export layers to an external compositor");
+		}
+		utils::Logger::info("Proxy render at 1/{}: {}x{}", opts.proxy, outputWidth, outputHeight);
+	}
+	
+	// Initialize shared hardware context if hardware acceleration is requested
+	AVBufferRef* sharedHwContext = nullptr;
+	if (opts.hwDecode || opts.hwEncode) {
+		media::HWConfig hwConfig;
+		hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
+		hwConfig.deviceIndex = opts.hwDevice;
+		hwConfig.allowFallback = true;
+		
+		if (media::HardwareContextManager::getInstance().initialize(hwConfig)) {
+			sharedHwContext = media::HardwareContextManager::getInstance().getSharedContext();
+			utils::Logger::info("Shared hardware context initialized for GPU passthrough");
+		} else {
+			utils::Logger::warn("Failed to initialize shared hardware context, components will create their own");
+		}
+	}
+	
+	// Split the thread budget between the pipeline stages. Every decoder the
+	// pool keeps open holds its threads, so all of them count; the audio
+	// pipeline runs on a thread of its own.
+	int budgetThreads = opts.threads > 0 ? opts.threads : utils::ThreadBudget::hardwareThreads();
+	if (audioTimeline && budgetThreads > 1) {
+		budgetThreads--;
+	}
+	int activeDecoders = static_cast<int>(std::clamp<size_t>(timeline.sources.size(), 1,
+		static_cast<size_t>(std::max(1, opts.maxOpenDecoders))));
+	utils::ThreadBudget::Allocation threadAllocation =
+		utils::ThreadBudget::configure(budgetThreads, activeDecoders, opts.hwEncode);
+	
+	if (opts.prefault) {
+		TIME_BLOCK("frame_arena_prefault");
+		size_t frameBytes = utils::FrameArena::frameBytes(AV_PIX_FMT_YUV420P, outputWidth, outputHeight);
+		utils::FrameArena::getInstance().reserve(frameBytes * ARENA_PREFAULT_FRAMES);
+	}
+	
+	// Register every source with the decoder pool. Decoders are opened
+	// lazily as their clips come up and closed again under the pool caps.
+	media::DecoderPool::Config poolConfig;
+	poolConfig.decoderConfig.useHardwareDecoder = opts.hwDecode;
+	poolConfig.decoderConfig.threadCount = threadAllocation.decoderThreads;
+	poolConfig.decoderConfig.hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
+	poolConfig.decoderConfig.hwConfig.deviceIndex = opts.hwDevice;
+	poolConfig.decoderConfig.hwConfig.allowFallback = true;
+	// Enable GPU passthrough if both decode and encode use hardware (proxy
+	// frames are scaled by the compositor, so they stay in system memory)
+	poolConfig.decoderConfig.keepHardwareFrames = opts.hwDecode && opts.hwEncode && opts.proxy == 0;
+	// Proxy renders decode at reduced resolution where the codec allows it;
+	// the compositor scales the rest down right after decoding
+	if (opts.proxy > 0) {
+		poolConfig.decoderConfig.lowres = proxyLowres(opts.proxy);
+		poolConfig.decoderConfig.fastDecode = true;
+	}
+	// Use shared hardware context if available
+	poolConfig.decoderConfig.externalHwDeviceCtx = sharedHwContext;
+	poolConfig.maxOpenDecoders = opts.maxOpenDecoders;
+	poolConfig.maxMemoryBytes = opts.decoderMemoryMB * 1024 * 1024;
+	poolConfig.cache = decoderCache;
+	media::DecoderPool decoders(poolConfig);
+	
+	std::vector<cache::RenderPlan::Source> planSources;
+	bool planSourcesChanged = !planMatchesEDL;
+	
+	for (const std::string& uri : timeline.sources) {
+		std::string mediaPath = resolveMediaPath(uri, mediaDir);
+		utils::Logger::info("Media: {} -> {}", uri, mediaPath);
+		
+		// Reuse the probe from the plan while the file is unchanged
+		// (also when the EDL itself was edited)
+		std::shared_ptr<const media::SourceProbe> probe;
+		if (plan) {
+			probe = plan->findProbe(mediaPath);
+		}
+		if (!probe) {
+			planSourcesChanged = true;
+		}
+		decoders.addSource(uri, mediaPath, probe);
+		
+		cache::RenderPlan::Source planSource;
+		planSource.uri = uri;
+		planSource.path = mediaPath;
+		if (!cache::RenderPlan::statFile(mediaPath, planSource.mtime, planSource.size)) {
+			// Not a local file (e.g. a URL); the probe cannot be validated later
+			planSource.path.clear();
+		}
+		planSources.push_back(std::move(planSource));
+	}
+	
+	// Open the sources needed first, and probe those without a cached probe,
+	// concurrently; time to the first frame then follows the slowest source
+	// instead of the sum. timeline.sources is in order of first use.
+	{
+		TIME_BLOCK("source_probing");
+		int probeThreads = std::clamp<int>(timeline.sources.size(), 1,
+			std::min(MAX_CONCURRENT_OPENS, threadAllocation.totalThreads));
+		utils::ThreadPool probePool(probeThreads);
+		decoders.openConcurrently(timeline.sources, probePool);
+	}
+	
+	// Segment boundaries are planned from the timeline alone (clip boundaries,
+	// split to the segment duration), so every render of an EDL, cached or
+	// not, cuts its segments at the same frames
+	if (rawOutput && !opts.segmentFormat.empty()) {
+		utils::Logger::warn("Segmented output does not apply to raw output, ignoring --segment-format");
+	}
+	bool segmented = !opts.segmentFormat.empty() && !rawOutput;
+	int segmentFrames = std::max(1, static_cast<int>(std::lround(opts.segmentDuration * timeline.fps)));
+	
+	// Every encoder gets an equal share of the encoder threads
+	int encoderThreads = std::max(1, threadAllocation.encoderThreads /
+		static_cast<int>(1 + opts.extraOutputs.size()));
+	
+	// Setup encoder
+	const media::FFmpegEncoder::Config encoderConfig = [&]() {
+		TIME_BLOCK("encoder_initialization");
+		media::FFmpegEncoder::Config encoderConfig;
+		encoderConfig.width = outputWidth;
+		encoderConfig.height = outputHeight;
+		encoderConfig.frameRate = {timeline.fps, 1};
+		encoderConfig.codec = opts.codec;
+		encoderConfig.bitrate = opts.bitrate;
+		encoderConfig.preset = encoderPreset(opts, opts.codec, opts.preset);
+		encoderConfig.crf = opts.crf;
+		encoderConfig.threadCount = encoderThreads;
+		encoderConfig.useHardwareEncoder = opts.hwEncode;
+		encoderConfig.hwConfig.type = media::HardwareAcceleration::stringToHWAccelType(opts.hwAccelType);
+		encoderConfig.hwConfig.deviceIndex = opts.hwDevice;
+		encoderConfig.hwConfig.allowFallback = true;
+		// Use shared hardware context if available
+		encoderConfig.externalHwDeviceCtx = sharedHwContext;
+		// Enable GPU passthrough mode when both decode and encode use hardware
+		encoderConfig.expectHardwareFrames = opts.hwDecode && opts.hwEncode;
+		// Cached segments can only be spliced in at IDR frames, and output
+		// segments must start with one
+		encoderConfig.forcedIdr = !opts.segmentCacheDir.empty() || segmented;
+		encoderConfig.segmentFormat = opts.segmentFormat;
+		encoderConfig.segmentDuration = opts.segmentDuration;
+		// Audio stream for the audio tracks of the EDL
+		encoderConfig.audioEnabled = audioTimeline != nullptr;
+		encoderConfig.audioCodec = opts.audioCodec;
+		encoderConfig.audioBitrate = opts.audioBitrate;
+		
+		// Packets can only be copied from sources in the output's format, so
+		// take the sample rate and channel count from the first source when
+		// it already uses the output codec
+		if (audioTimeline && opts.audioPassthrough) {
+			const auto& clip = audioTimeline->getClips().front();
+			try {
+				audio::AudioStreamInfo source = audio::AudioPacketReader::probe(
+					resolveMediaPath(clip.uri, mediaDir), clip.trackId);
+				const AVCodec* codec = avcodec_find_encoder_by_name(opts.audioCodec.c_str());
+				if (codec && source.isValid() && codec->id == source.codecId) {
+					encoderConfig.audioSampleRate = source.sampleRate;
+					encoderConfig.audioChannels = source.channels;
+				}
+			} catch (const std::exception& e) {
+				utils::Logger::debug("Audio passthrough probe failed: {}", e.what());
+			}
+		}
+		
+		return encoderConfig;
+	}();
+	
+	// Benchmarks of the earlier stages drop the frames before the encoder
+	std::unique_ptr<utils::BenchmarkReport> benchmark;
+	bool stopAfterDecode = opts.benchmark == "decode";
+	bool stopBeforeEncode = stopAfterDecode || opts.benchmark == "composite";
+	if (!opts.benchmark.empty()) {
+		benchmark = std::make_unique<utils::BenchmarkReport>(opts.benchmark);
+		utils::Logger::info("Benchmark: stopping after {}", opts.benchmark);
+	}
+	
+	// Frames go to the encoder, or uncompressed to a file or pipe
+	std::unique_ptr<media::FrameSink> output;
+	media::FFmpegEncoder* encoder = nullptr;
+	if (stopBeforeEncode) {
+		// No output
+	} else if (benchmark) {
+		// Encoded packets go to the null muxer; the output file is the report
+		media::FFmpegEncoder::Config benchmarkConfig = encoderConfig;
+		benchmarkConfig.containerFormat = "null";
+		auto ffmpegEncoder = std::make_unique<media::FFmpegEncoder>(opts.outputFile, benchmarkConfig);
+		encoder = ffmpegEncoder.get();
+		output = std::move(ffmpegEncoder);
+	} else if (rawOutput) {
+		media::RawFrameWriter::Config rawConfig;
+		media::RawFrameWriter::parseFormat(opts.rawFormat, rawConfig.format);
+		rawConfig.width = outputWidth;
+		rawConfig.height = outputHeight;
+		rawConfig.frameRate = {timeline.fps, 1};
+		rawConfig.pixelFormat = AV_PIX_FMT_YUV420P;
+		output = std::make_unique<media::RawFrameWriter>(opts.outputFile, rawConfig);
+	} else {
+		utils::Logger::info("Creating output file: {}", opts.outputFile);
+		auto ffmpegEncoder = std::make_unique<media::FFmpegEncoder>(opts.outputFile, encoderConfig);
+		encoder = ffmpegEncoder.get();
+		output = std::move(ffmpegEncoder);
+	}
+	
+	// Setup segment cache
+	std::unique_ptr<cache::SegmentCache> segmentCache;
+	std::vector<cache::SegmentCache::Segment> segments;
+	if (!opts.segmentCacheDir.empty()) {
+		if (!encoder) {
+			utils::Logger::warn("Segment cache only applies to encoded output, disabling it");
+		} else if (!opts.extraOutputs.empty()) {
+			utils::Logger::warn("Segment cache cannot feed additional outputs, disabling it");
+		} else if (!encoder->supportsSessionRestart()) {
+			utils::Logger::warn("Segment cache requires a synchronous software encoder, disabling it");
+		} else {
+			TIME_BLOCK("segment_cache_setup");
+			cache::SegmentCache::Config cacheConfig;
+			cacheConfig.directory = opts.segmentCacheDir;
+			cacheConfig.maxBytes = opts.segmentCacheSizeMB * 1024 * 1024;
+			if (segmented) {
+				cacheConfig.maxSegmentFrames = segmentFrames;
+				cacheConfig.minSegmentFrames = segmentFrames / 2;
+			}
+			segmentCache = std::make_unique<cache::SegmentCache>(cacheConfig);
+			segments = segmentCache->planSegments(timeline);
+			
+			// Sources are identified by the file they resolve to, so a replaced
+			// file invalidates every segment that reads it
+			std::unordered_map<std::string, std::string> sourceIdentities;
+			for (const auto& source : planSources) {
+				sourceIdentities[source.uri] = source.path.empty() ? source.uri :
+					source.path + ":" + std::to_string(source.mtime) + ":" + std::to_string(source.size);
+			}
+			
+			std::string settings = opts.codec + ":" + std::to_string(opts.bitrate) + ":" + encoderConfig.preset + ":" +
+				std::to_string(opts.crf) + ":" + std::to_string(outputWidth) + "x" +
+				std::to_string(outputHeight) + "@" + std::to_string(timeline.fps) +
+				(segmented ? ":keyframes=forced" : "");
+			cache::SegmentCache::hashSegments(segments, *generator,
+				cache::SegmentCache::encoderKey(*encoder, settings), sourceIdentities);
+			
+			encoder->setPacketTap([&segmentCache](const AVPacket* packet) {
+				segmentCache->recordPacket(packet);
+			});
+			utils::Logger::info("Segment cache: {} ({} segments)", opts.segmentCacheDir, segments.size());
+		}
+	}
+	if (segmented && !segmentCache) {
+		segments = cache::SegmentCache::planSegments(timeline, segmentFrames, segmentFrames / 2);
+	}
+	if (segmented) {
+		utils::Logger::info("Segmented output ({}): {} segments of up to {} frames", opts.segmentFormat,
+			segments.size(), segmentFrames);
+	}
+	
+	// Setup compositor
+	compositor::FrameCompositor compositor(outputWidth, outputHeight, AV_PIX_FMT_YUV420P,
+		threadAllocation.compositorThreads);
+	compositor.setFastScaling(opts.proxy > 0);
+	
+	// Decoded layers go to an external compositor, which may send back the
+	// composited frames in place of ours
+	std::unique_ptr<ipc::ExternalCompositor> externalCompositor;
+	if (!opts.shmExport.empty()) {
+		ipc::ExternalCompositor::Config externalConfig;
+		externalConfig.exportName = opts.shmExport;
+		externalConfig.returnName = opts.shmReturn;
+		externalConfig.width = timeline.width;
+		externalConfig.height = timeline.height;
+		for (const auto& uri : timeline.sources) {
+			auto probe = decoders.getProbe(uri);
+			if (probe && probe->pixelFormat >= 0) {
+				externalConfig.maxLayerBytes = std::max(externalConfig.maxLayerBytes,
+					ipc::ExternalCompositor::layerBytes(probe->width, probe->height,
+						static_cast<AVPixelFormat>(probe->pixelFormat)));
+			}
+		}
+		externalCompositor = std::make_unique<ipc::ExternalCompositor>(externalConfig);
+	}
+	
+	// Additional outputs share the composited frames and a scale pyramid
+	std::unique_ptr<media::EncoderFanout> fanout;
+	if (!opts.extraOutputs.empty()) {
+		TIME_BLOCK("fanout_initialization");
+		std::vector<media::EncoderFanout::Output> outputs;
+		for (const auto& extra : opts.extraOutputs) {
+			media::EncoderFanout::Output output;
+			output.filename = extra.file;
+			output.config = encoderConfig;
+			output.config.codec = extra.codec.empty() ? opts.codec : extra.codec;
+			output.config.preset = extra.preset.empty() ? encoderPreset(opts, output.config.codec, opts.preset) :
+				extra.preset;
+			output.config.bitrate = extra.bitrate >= 0 ? extra.bitrate : opts.bitrate;
+			output.config.crf = extra.crf >= 0 ? extra.crf : opts.crf;
+			// Its share of the encoder threads, like the main output
+			output.config.threadCount = encoderThreads;
+			if (extra.height > 0) {
+				output.config.height = extra.height & ~1;
+				output.config.width = extra.width > 0 ? extra.width & ~1 :
+					static_cast<int>(std::lround(static_cast<double>(extra.height) * outputWidth /
+						outputHeight / 2.0)) * 2;
+			}
+			
+			// Frames arrive in system memory from the compositor
+			output.config.useHardwareEncoder = false;
+			output.config.expectHardwareFrames = false;
+			output.config.externalHwDeviceCtx = nullptr;
+			// Segmented outputs cut at the same forced keyframes as the main one
+			output.config.forcedIdr = segmented;
+			
+			utils::Logger::info("Creating output file: {} ({}x{}, {})", output.filename,
+				output.config.width, output.config.height, output.config.codec);
+			outputs.push_back(std::move(output));
+		}
+		fanout = std::make_unique<media::EncoderFanout>(outputWidth, outputHeight, AV_PIX_FMT_YUV420P,
+			std::move(outputs));
+	}
+	
+	int totalFrames = generator->getTotalFrames();
+	
+	utils::Logger::info("Processing {} frames...", totalFrames);
+	
+	// Audio is mixed and encoded on its own thread, paced by the video
+	std::unique_ptr<audio::AudioPipeline> audioPipeline;
+	if (audioTimeline) {
+		double duration = static_cast<double>(totalFrames) / timeline.fps;
+		audio::AudioPipeline::Config audioConfig;
+		audioConfig.passthrough = opts.audioPassthrough;
+		std::vector<media::FFmpegEncoder*> audioEncoders;
+		if (encoder) {
+			audioEncoders.push_back(encoder);
+		}
+		for (size_t i = 0; fanout && i < fanout->size(); i++) {
+			audioEncoders.push_back(&fanout->getEncoder(i));
+		}
+		
+		// Raw output has no audio stream; the audio only goes to encoded outputs
+		if (!audioEncoders.empty()) {
+			audioPipeline = std::make_unique<audio::AudioPipeline>(std::move(*audioTimeline), audioEncoders,
+				duration, [mediaDir](const std::string& uri) { return resolveMediaPath(uri, mediaDir); }, audioConfig);
+			audioPipeline->start();
+		}
+	}
+	
+	// Analyze if GPU passthrough is possible
+	// Decoders open lazily, so whether each one actually got hardware
+	// decoding is checked per frame below. Proxy frames always go through
+	// the compositor to be scaled down.
+	bool canUseGPUPassthrough = opts.hwDecode && opts.hwEncode && opts.proxy == 0 && encoder && !fanout &&
+		!externalCompositor;
+	if (canUseGPUPassthrough) {
+		// Check if any frame needs CPU processing
+		bool needsCPU = false;
+		for (const auto& instruction : *generator) {
+			if (requiresCPUProcessing(instruction)) {
+				needsCPU = true;
+				break;
+			}
+		}
+		
+		if (!needsCPU) {
+			utils::Logger::info("GPU passthrough enabled - zero-copy pipeline active");
+		} else {
+			utils::Logger::info("GPU acceleration enabled but some frames require CPU processing");
+		}
+	}
+	
+	// Startup messages go before the progress bar
+	utils::Logger::flush();
+	
+	// Process frames
+	auto startTime = std::chrono::high_resolution_clock::now();
+	int frameCount = 0;
+	int progressUpdateInterval = std::max(1, timeline.fps / 2);  // Update twice per second
+	
+	auto reportProgress = [&](bool done) {
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+		Progress progress;
+		progress.frame = frameCount;
+		progress.totalFrames = totalFrames;
+		progress.fps = elapsed.count() > 0.0 ? frameCount / elapsed.count() : 0.0;
+		progress.done = done;
+		progressCallback(progress);
+	};
+	auto updateProgress = [&]() {
+		if (progressCallback && (frameCount % progressUpdateInterval == 0 || frameCount == totalFrames)) {
+			reportProgress(false);
+		}
+	};
+	
+	// Open decoders about two seconds before their first frame
+	int prefetchFrames = timeline.fps * 2;
+	size_t nextPrefetchSpan = 0;
+	
+	// Time spent in one pipeline stage, for the benchmark report
+	auto recordStage = [&benchmark](const char* stage, std::chrono::steady_clock::time_point start) {
+		if (benchmark) {
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			benchmark->record(stage, elapsed.count());
+		}
+	};
+	
+	size_t nextSegment = 0;
+	bool fanoutFailed = false;
+	bool sessionHasFrames = false;  // Frames encoded since the encoder session started
+	bool stoppedByCancel = false;
+	
+	for (int frame = 0; frame < totalFrames; ++frame) {
+		if (isCancelled()) {
+			utils::Logger::info("Render cancelled at frame {}", frameCount);
+			stoppedByCancel = true;
+			break;
+		}
+		
+		if (audioPipeline) {
+			audioPipeline->setVideoPosition(static_cast<double>(frame) / timeline.fps);
+		}
+		
+		// At a segment boundary, splice the cached segment or start recording a
+		// new one; either way the segment starts with a keyframe
+		if (nextSegment < segments.size() && segments[nextSegment].startFrame == frame) {
+			const auto& segment = segments[nextSegment++];
+			if (segmentCache && segmentCache->contains(segment) && sessionHasFrames) {
+				// Cached packets must not be interleaved with frames still in the encoder
+				if (!encoder->restartSession()) {
+					throw std::runtime_error("Failed to restart encoder session for segment splicing");
+				}
+				segmentCache->commitPending();
+				sessionHasFrames = false;
+			}
+			
+			if (segmentCache && segmentCache->splice(segment, *encoder)) {
+				frameCount += segment.endFrame - segment.startFrame;
+				frame = segment.endFrame - 1;
+				updateProgress();
+				continue;
+			}
+			
+			if (segmentCache) {
+				segmentCache->beginSegment(segment);
+			}
+			if (encoder) {
+				encoder->forceKeyframe();
+			}
+			if (fanout) {
+				fanout->forceKeyframe();
+			}
+			sessionHasFrames = true;
+		}
+		
+		while (nextPrefetchSpan < timeline.spans.size() &&
+			timeline.spans[nextPrefetchSpan].startFrame <= frame + prefetchFrames) {
+			const auto& span = timeline.spans[nextPrefetchSpan++];
+			if (span.kind == compositor::TimelineSpan::Media && span.endFrame > frame) {
+				decoders.prefetch(timeline.sources[span.sourceIndex]);
+			}
+		}
+		
+		const auto instruction = generator->getInstructionForFrame(frame);
+		std::shared_ptr<AVFrame> outputFrame;
+		
+		TIME_BLOCK("frame");
+		
+		// Check if we can use GPU passthrough (no effects, transforms, or color generation)
+		// Must check if decoder actually has hardware enabled, not just command line flags
+		auto decodeStart = std::chrono::steady_clock::now();
+		media::FFmpegDecoder* decoder = nullptr;
+		bool useGPUPassthrough = false;
+		if (instruction.type == compositor::CompositorInstruction::DrawFrame) {
+			decoder = decoders.acquire(instruction.uri);
+			if (decoder) {
+				useGPUPassthrough = canUseGPUPassthrough && decoder->isUsingHardware() &&
+									!requiresCPUProcessing(instruction);
+			}
+		}
+		
+		if (useGPUPassthrough) {
+			// GPU passthrough path - no CPU processing needed
+			{
+				// Get hardware frame directly from decoder
+				auto hwFrame = decoder->getHardwareFrame(instruction.sourceFrameNumber);
+				recordStage("decode", decodeStart);
+				if (hwFrame) {
+					// Write hardware frame directly to encoder
+					auto encodeStart = std::chrono::steady_clock::now();
+					if (!encoder->writeHardwareFrame(hwFrame.get())) {
+						utils::Logger::error("Failed to write hardware frame {} to encoder", frameCount);
+						// Try to continue with next frame
+					}
+					recordStage("encode", encodeStart);
+					frameCount++;
+					
+					// Update progress
+					updateProgress();
+					continue;
+				} else {
+					// Hardware frame failed - assume we've reached EOF or encountered an error
+					utils::Logger::info("Failed to get hardware frame at output frame {} (source frame {}), stopping", 
+						frameCount, instruction.sourceFrameNumber);
+					// Stop processing
+					break;
+				}
+			}
+		}
+		
+		// CPU processing path (original code)
+		std::shared_ptr<AVFrame> inputFrame;
+		if (instruction.type == compositor::CompositorInstruction::DrawFrame && decoder) {
+			// Decoder for this media was acquired above
+			inputFrame = decoder->getFrame(instruction.sourceFrameNumber);
+			
+			if (!inputFrame) {
+				utils::Logger::info("Failed to get frame at output frame {} (source frame {}), stopping", 
+					frameCount, instruction.sourceFrameNumber);
+				// Stop processing
+				break;
+			}
+			recordStage("decode", decodeStart);
+		}
+		
+		if (stopAfterDecode) {
+			frameCount++;
+			updateProgress();
+			continue;
+		}
+		
+		if (externalCompositor && !externalCompositor->exportFrame(frame, instruction, inputFrame.get())) {
+			throw std::runtime_error("External compositor stopped taking frames");
+		}
+		
+		auto compositeStart = std::chrono::steady_clock::now();
+		if (externalCompositor && externalCompositor->hasReturn()) {
+			outputFrame = externalCompositor->receiveFrame(frame);
+			if (!outputFrame) {
+				throw std::runtime_error("External compositor did not return frame " + std::to_string(frame));
+			}
+		} else if (instruction.type == compositor::CompositorInstruction::DrawFrame) {
+			if (inputFrame) {
+				// Process through compositor
+				outputFrame = compositor.processFrame(inputFrame, instruction);
+			} else {
+				utils::Logger::warn("Decoder not found for media: {}", instruction.uri);
+				outputFrame = compositor.generateColorFrame(0, 0, 0);
+			}
+		} else if (instruction.type == compositor::CompositorInstruction::GenerateColor) {
+			// Generate color frame
+			outputFrame = compositor.generateColorFrame(
+				instruction.color.r,
+				instruction.color.g,
+				instruction.color.b
+			);
+		} else {
+			// NoOp or unknown - generate black frame
+			outputFrame = compositor.generateColorFrame(0, 0, 0);
+		}
+		
+		recordStage("composite", compositeStart);
+		
+		// Write frame to the output (the fan-out first, as the encoder stamps the pts)
+		auto encodeStart = std::chrono::steady_clock::now();
+		if (outputFrame && output) {
+			if (fanout && !fanout->writeFrame(outputFrame.get()) && !fanoutFailed) {
+				utils::Logger::error("Additional outputs failed at frame {}", frameCount);
+				fanoutFailed = true;
+			}
+			if (!output->writeFrame(outputFrame.get()) && rawOutput) {
+				// The reader of a pipe has gone away
+				utils::Logger::error("Raw output failed at frame {}, stopping", frameCount);
+				break;
+			}
+			recordStage("encode", encodeStart);
+		}
+		
+		frameCount++;
+		
+		// Update progress
+		updateProgress();
+	}
+	
+	if (progressCallback) {
+		reportProgress(true);
+	}
+	
+	// Finish the audio before the trailer is written; a cancelled render
+	// drops the audio still to come instead of rendering it
+	if (audioPipeline && stoppedByCancel) {
+		audioPipeline.reset();
+	} else if (audioPipeline && !audioPipeline->finish()) {
+		utils::Logger::error("Audio track is incomplete");
+	}
+	
+	if (externalCompositor) {
+		externalCompositor->close();
+	}
+	
+	// Finalize encoder or raw output
+	if (output) {
+		auto flushStart = std::chrono::steady_clock::now();
+		output->finalize();
+		recordStage("encoder_flush", flushStart);
+	}
+	if (fanout && !fanout->finalize()) {
+		utils::Logger::error("Some additional outputs are incomplete");
+	}
+	
+	decoders.logStats();
+	if (opts.verbose) {
+		decoders.printOpenTimes();
+	}
+	
+	// Store the compiled timeline and the probes of this run for the next one
+	if (usePlanCache && planSourcesChanged) {
+		TIME_BLOCK("render_plan_write");
+		for (auto& planSource : planSources) {
+			// Incomplete probes (e.g. no known pixel format) are left out, so the
+			// next run discovers the stream info again
+			auto probe = decoders.getProbe(planSource.uri);
+			if (probe && probe->isValid()) {
+				planSource.probe = *probe;
+			}
+		}
+		try {
+			cache::RenderPlan::write(planPath, edlHash, timeline, planSources);
+			utils::Logger::debug("Render plan written: {}", planPath);
+		} catch (const std::exception& e) {
+			utils::Logger::warn("Could not write render plan: {}", e.what());
+		}
+	}
+	
+	// Store the segments that were encoded in this run
+	if (segmentCache) {
+		segmentCache->commitPending();
+		segmentCache->logStats();
+	}
+	
+	// Calculate and report statistics
+	auto endTime = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> totalTime = endTime - startTime;
+	double avgFps = frameCount / totalTime.count();
+	
+	if (stoppedByCancel) {
+		utils::Logger::info("Rendering cancelled");
+	} else {
+		utils::Logger::info("Rendering complete!");
+	}
+	utils::Logger::info("Total frames: {}", frameCount);
+	utils::Logger::info("Total time: {} seconds", totalTime.count());
+	utils::Logger::info("Average FPS: {}", avgFps);
+	utils::Logger::info("Output file: {}", opts.outputFile);
+	
+	if (benchmark) {
+		benchmark->setInfo("edl", opts.edlFile);
+		benchmark->setInfo("width", outputWidth);
+		benchmark->setInfo("height", outputHeight);
+		benchmark->setInfo("frame_rate", timeline.fps);
+		benchmark->setInfo("decoder_threads", threadAllocation.decoderThreads);
+		benchmark->setInfo("compositor_threads", threadAllocation.compositorThreads);
+		if (encoder) {
+			benchmark->setInfo("codec", opts.codec);
+			benchmark->setInfo("encoder_threads", encoderThreads);
+		}
+		
+		std::string report = benchmark->toJson(frameCount, totalTime.count());
+		if (opts.outputFile == "-") {
+			utils::Logger::flush();
+			std::cout << report << std::endl;
+		} else {
+			std::ofstream reportFile(opts.outputFile);
+			reportFile << report << "\n";
+			if (!reportFile) {
+				throw std::runtime_error("Failed to write benchmark report: " + opts.outputFile);
+			}
+		}
+	}
+	
+	// Decoders go back to the warm cache (or close) before the hardware
+	// context they may reference is released by the caller
+	decoders.closeAll();
+	
+	// For hardware encoding, add a small delay to ensure GPU operations complete
+	if (opts.hwEncode || opts.hwDecode) {
+		// Give GPU time to finish any pending operations
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	
+	Result result;
+	result.frames = frameCount;
+	result.totalFrames = totalFrames;
+	result.seconds = totalTime.count();
+	result.fps = avgFps;
+	result.cancelled = stoppedByCancel;
+	return result;
+}
+
+} // namespace render
\ No newline at end of file
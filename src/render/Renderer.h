@@ -0,0 +1,82 @@
+#pragma once
+
+#include "render/RenderOptions.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace edl {
+struct EDL;
+}
+
+namespace media {
+class DecoderCache;
+}
+
+namespace render {
+
+/**
+ * One render of an EDL to its outputs: loads or compiles the timeline, opens
+ * the sources, runs decode, composite and encode frame by frame and
+ * finalizes the outputs.
+ *
+ * The command line tool runs a single Renderer; the render daemon runs one
+ * per job, several at a time, all sharing a DecoderCache so probes and open
+ * decoders carry over from one job to the next. Process-wide settings
+ * (logging, timing, the memory budget, the frame arena) are left to the
+ * caller.
+ */
+class Renderer {
+public:
+	struct Progress {
+		int frame = 0;              // Frames rendered so far
+		int totalFrames = 0;
+		double fps = 0.0;
+		bool done = false;          // Last report, after the last frame
+	};
+	
+	struct Result {
+		int frames = 0;
+		int totalFrames = 0;
+		double seconds = 0.0;
+		double fps = 0.0;
+		bool cancelled = false;     // Stopped by cancel(); the outputs end early
+	};
+	
+	using ProgressCallback = std::function<void(const Progress&)>;
+	
+	explicit Renderer(const Options& options);
+	~Renderer();
+	
+	Renderer(const Renderer&) = delete;
+	Renderer& operator=(const Renderer&) = delete;
+	
+	// Called on the rendering thread about twice per second of output
+	void setProgressCallback(ProgressCallback callback);
+	
+	// Warm probes and decoders shared with other renders
+	void setDecoderCache(std::shared_ptr<media::DecoderCache> cache);
+	
+	/**
+	 * Stop the render after the current frame; the outputs are finalized
+	 * where it stopped. May be called from any thread, also before render().
+	 */
+	void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+	bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+	
+	/**
+	 * Run the render on the calling thread
+	 * @throws std::runtime_error if the EDL, a source or an output fails
+	 */
+	Result render();
+
+private:
+	edl::EDL parseEDL() const;
+	
+	Options opts;
+	ProgressCallback progressCallback;
+	std::shared_ptr<media::DecoderCache> decoderCache;
+	std::atomic<bool> cancelled{false};
+};
+
+} // namespace render
\ No newline at end of file
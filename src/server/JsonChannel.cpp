@@ -0,0 +1,166 @@
+#include "server/JsonChannel.h"
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace server {
+
+namespace {
+
+// Longest line accepted from a peer; an inline EDL can be large
+constexpr size_t MAX_MESSAGE_BYTES = 64 * 1024 * 1024;
+
+#ifndef _WIN32
+sockaddr_un socketAddress(const std::string& path) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("Invalid socket path: " + path);
+	}
+	std::memcpy(address.sun_path, path.c_str(), path.size());
+	return address;
+}
+#endif
+
+}
+
+JsonChannel::JsonChannel(int fd)
+	: fd(fd) {
+}
+
+JsonChannel::~JsonChannel() {
+#ifndef _WIN32
+	if (fd >= 0) {
+		::close(fd);
+	}
+#endif
+}
+
+#ifndef _WIN32
+
+int JsonChannel::connectTo(const std::string& path) {
+	sockaddr_un address = socketAddress(path);
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+	}
+	if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+		int error = errno;
+		::close(fd);
+		throw std::runtime_error("Failed to connect to " + path + ": " + std::strerror(error));
+	}
+	return fd;
+}
+
+int JsonChannel::listenOn(const std::string& path) {
+	sockaddr_un address = socketAddress(path);
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+	}
+	
+	// A socket file left by a daemon that did not shut down cleanly refuses
+	// connections; one that accepts them belongs to a running daemon
+	struct stat info;
+	if (::lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+		int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		bool inUse = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+		if (probe >= 0) {
+			::close(probe);
+		}
+		if (inUse) {
+			::close(fd);
+			throw std::runtime_error("Another daemon is listening on " + path);
+		}
+		::unlink(path.c_str());
+	}
+	
+	if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 16) != 0) {
+		int error = errno;
+		::close(fd);
+		throw std::runtime_error("Failed to listen on " + path + ": " + std::strerror(error));
+	}
+	return fd;
+}
+
+bool JsonChannel::read(nlohmann::json& message) {
+	size_t newline;
+	while ((newline = buffer.find('\n')) == std::string::npos) {
+		if (buffer.size() > MAX_MESSAGE_BYTES) {
+			throw std::runtime_error("Message too long");
+		}
+		char chunk[65536];
+		ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+		if (received < 0 && errno == EINTR) {
+			continue;
+		}
+		if (received <= 0) {
+			return false;
+		}
+		buffer.append(chunk, static_cast<size_t>(received));
+	}
+	
+	std::string line = buffer.substr(0, newline);
+	buffer.erase(0, newline + 1);
+	message = nlohmann::json::parse(line);
+	return true;
+}
+
+bool JsonChannel::write(const nlohmann::json& message) {
+	std::string line = message.dump() + "\n";
+	
+	std::lock_guard<std::mutex> lock(writeMutex);
+	size_t written = 0;
+	while (written < line.size()) {
+#ifdef MSG_NOSIGNAL
+		ssize_t sent = ::send(fd, line.data() + written, line.size() - written, MSG_NOSIGNAL);
+#else
+		ssize_t sent = ::send(fd, line.data() + written, line.size() - written, 0);
+#endif
+		if (sent < 0 && errno == EINTR) {
+			continue;
+		}
+		if (sent <= 0) {
+			return false;
+		}
+		written += static_cast<size_t>(sent);
+	}
+	return true;
+}
+
+void JsonChannel::shutdown() {
+	::shutdown(fd, SHUT_RDWR);
+}
+
+#else
+
+int JsonChannel::connectTo(const std::string&) {
+	throw std::runtime_error("The render daemon needs Unix domain sockets");
+}
+
+int JsonChannel::listenOn(const std::string&) {
+	throw std::runtime_error("The render daemon needs Unix domain sockets");
+}
+
+bool JsonChannel::read(nlohmann::json&) {
+	return false;
+}
+
+bool JsonChannel::write(const nlohmann::json&) {
+	return false;
+}
+
+void JsonChannel::shutdown() {
+}
+
+#endif
+
+} // namespace server
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <mutex>
+#include <string>
+
+namespace server {
+
+// Socket the daemon listens on and the client connects to by default
+constexpr const char* DEFAULT_SOCKET_PATH = "/tmp/edl2ffmpeg.sock";
+
+/**
+ * One connection between the render daemon and a client over a Unix domain
+ * socket. Every message is a JSON object on a line of its own.
+ *
+ * One thread reads while any number of threads write; writes are serialized
+ * so messages never interleave. Unix only.
+ */
+class JsonChannel {
+public:
+	// Takes ownership of a connected socket
+	explicit JsonChannel(int fd);
+	~JsonChannel();
+	
+	JsonChannel(const JsonChannel&) = delete;
+	JsonChannel& operator=(const JsonChannel&) = delete;
+	
+	/**
+	 * Connect to a listening daemon
+	 * @throws std::runtime_error if nobody listens on path
+	 */
+	static int connectTo(const std::string& path);
+	
+	/**
+	 * Bind and listen on path, replacing a stale socket file
+	 * @throws std::runtime_error if the socket cannot be created
+	 */
+	static int listenOn(const std::string& path);
+	
+	/**
+	 * Read the next message
+	 * @return false once the peer has closed the connection
+	 * @throws nlohmann::json::parse_error on a line that is not JSON
+	 */
+	bool read(nlohmann::json& message);
+	
+	// Write one message; false if the peer has gone away
+	bool write(const nlohmann::json& message);
+	
+	// Unblock a pending read() from another thread; later writes fail
+	void shutdown();
+
+private:
+	int fd;
+	std::string buffer;         // Bytes read past the last complete line
+	std::mutex writeMutex;
+};
+
+} // namespace server
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "server/RenderServer.h"
+#include "utils/Logger.h"
+#include "utils/ThreadBudget.h"
+#include "utils/Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace server {
+
+namespace {
+
+nlohmann::json errorEvent(const std::string& id, const std::string& message) {
+	nlohmann::json event = {{"event", "error"}, {"message", message}};
+	if (!id.empty()) {
+		event["id"] = id;
+	}
+	return event;
+}
+
+}
+
+RenderServer::RenderServer(const Config& config)
+	: config(config) {
+	this->config.workers = std::max(1, config.workers);
+	
+	media::DecoderCache::Config cacheConfig;
+	cacheConfig.maxIdleDecoders = config.maxIdleDecoders;
+	decoderCache = std::make_shared<media::DecoderCache>(cacheConfig);
+
+#ifndef _WIN32
+	if (::pipe(wakeFds) != 0) {
+		throw std::runtime_error("Failed to create wake-up pipe");
+	}
+#endif
+}
+
+RenderServer::~RenderServer() {
+#ifndef _WIN32
+	for (int fd : wakeFds) {
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+#endif
+}
+
+#ifndef _WIN32
+
+void RenderServer::run() {
+	// A client that disconnects mid-write must not take the daemon with it
+	std::signal(SIGPIPE, SIG_IGN);
+	
+	int listenFd = JsonChannel::listenOn(config.socketPath);
+	utils::Logger::info("Render daemon listening on {} ({} workers)", config.socketPath, config.workers);
+	
+	for (int i = 0; i < config.workers; i++) {
+		workers.emplace_back([this, i]() {
+			utils::Timer::getInstance().setThreadName("job worker " + std::to_string(i));
+			workerLoop();
+		});
+	}
+	
+	while (true) {
+		pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+		if (::poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			utils::Logger::error("Render daemon stopped polling: {}", std::strerror(errno));
+			break;
+		}
+		if (fds[1].revents != 0) {
+			break;
+		}
+		if ((fds[0].revents & POLLIN) == 0) {
+			continue;
+		}
+		
+		int fd = ::accept(listenFd, nullptr, nullptr);
+		if (fd < 0) {
+			continue;
+		}
+		auto connection = std::make_shared<Connection>(fd);
+		
+		std::lock_guard<std::mutex> lock(mutex);
+		// Readers of closed connections are done apart from returning
+		for (auto it = connections.begin(); it != connections.end();) {
+			if ((*it)->closed) {
+				(*it)->reader.join();
+				it = connections.erase(it);
+			} else {
+				++it;
+			}
+		}
+		connection->reader = std::thread(&RenderServer::serve, this, connection);
+		connections.push_back(std::move(connection));
+	}
+	
+	utils::Logger::info("Render daemon shutting down");
+	::close(listenFd);
+	::unlink(config.socketPath.c_str());
+	
+	// Take no more jobs and cancel the rest; workers finish their current
+	// frame and exit
+	std::vector<std::string> ids;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		for (const auto& [id, job] : jobs) {
+			ids.push_back(id);
+		}
+	}
+	for (const auto& id : ids) {
+		cancel(id);
+	}
+	jobAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	
+	// Readers no longer touch the job list once the workers are gone
+	std::vector<std::shared_ptr<Connection>> open;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		open.swap(connections);
+	}
+	for (auto& connection : open) {
+		connection->channel.shutdown();
+		connection->reader.join();
+	}
+	
+	decoderCache->clear();
+}
+
+void RenderServer::stop() {
+	char wake = 1;
+	ssize_t written = ::write(wakeFds[1], &wake, 1);
+	(void)written;
+}
+
+#else
+
+void RenderServer::run() {
+	throw std::runtime_error("The render daemon needs Unix domain sockets");
+}
+
+void RenderServer::stop() {
+}
+
+#endif
+
+void RenderServer::serve(std::shared_ptr<Connection> connection) {
+	while (true) {
+		nlohmann::json request;
+		try {
+			if (!connection->channel.read(request)) {
+				break;
+			}
+		} catch (const nlohmann::json::parse_error& e) {
+			connection->channel.write(errorEvent("", std::string("Invalid JSON: ") + e.what()));
+			continue;
+		} catch (const std::exception& e) {
+			connection->channel.write(errorEvent("", e.what()));
+			break;
+		}
+		handle(*connection, connection, request);
+	}
+	
+	// Nobody is left to receive the output of its jobs
+	cancelJobsOf(*connection);
+	connection->closed = true;
+}
+
+void RenderServer::handle(Connection& connection, const std::shared_ptr<Connection>& self,
+	const nlohmann::json& request) {
+	std::string type = request.is_object() ? request.value("type", "") : "";
+	std::string id;
+	if (request.is_object() && request.contains("id") && request["id"].is_string()) {
+		id = request["id"].get<std::string>();
+	}
+	
+	try {
+		if (type == "render") {
+			submit(self, request);
+		} else if (type == "cancel") {
+			if (!cancel(id)) {
+				connection.channel.write(errorEvent(id, "Unknown job: " + id));
+			} else {
+				// The job's own client gets "cancelled" once it has stopped
+				connection.channel.write({{"event", "cancel_requested"}, {"id", id}});
+			}
+		} else if (type == "status") {
+			connection.channel.write(status());
+		} else if (type == "shutdown") {
+			connection.channel.write({{"event", "shutdown"}});
+			stop();
+		} else {
+			connection.channel.write(errorEvent(id, "Unknown request type: " + type));
+		}
+	} catch (const std::exception& e) {
+		connection.channel.write(errorEvent(id, e.what()));
+	}
+}
+
+void RenderServer::submit(const std::shared_ptr<Connection>& client, const nlohmann::json& request) {
+	auto job = std::make_shared<Job>();
+	job->options = render::parseJobOptions(request, config.defaults);
+	job->client = client;
+	if (job->options.outputFile == "-") {
+		throw std::invalid_argument("Jobs cannot write to the daemon's stdout");
+	}
+	if (job->options.threads == 0) {
+		job->options.threads = config.threadsPerJob > 0 ? config.threadsPerJob :
+			std::max(1, utils::ThreadBudget::hardwareThreads() / config.workers);
+	}
+	
+	size_t position = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) {
+			throw std::runtime_error("The daemon is shutting down");
+		}
+		if (request.contains("id")) {
+			job->id = request["id"].get<std::string>();
+		} else {
+			job->id = "job-" + std::to_string(nextJobId++);
+		}
+		if (jobs.count(job->id) > 0) {
+			throw std::invalid_argument("Duplicate job id: " + job->id);
+		}
+		jobs[job->id] = job;
+		position = queue.size() + 1;
+	}
+	
+	// Reported before a worker can start it, so "queued" always comes first
+	client->channel.write({{"event", "queued"}, {"id", job->id}, {"position", position}});
+	utils::Logger::info("Job {} queued: {} -> {}", job->id,
+		job->options.edlJson.empty() ? job->options.edlFile : std::string("(inline EDL)"), job->options.outputFile);
+	
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job->cancelled) {
+			return;
+		}
+		queue.push_back(job);
+	}
+	jobAvailable.notify_one();
+}
+
+bool RenderServer::cancel(const std::string& id) {
+	std::shared_ptr<Job> job;
+	bool waiting = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = jobs.find(id);
+		if (it == jobs.end()) {
+			return false;
+		}
+		job = it->second;
+		if (job->cancelled) {
+			return true;
+		}
+		job->cancelled = true;
+		
+		if (job->renderer) {
+			// The worker reports it once the render has stopped
+			job->renderer->cancel();
+		} else {
+			// Not started yet: it never will be
+			auto queued = std::find(queue.begin(), queue.end(), job);
+			if (queued != queue.end()) {
+				queue.erase(queued);
+			}
+			jobs.erase(it);
+			waiting = true;
+		}
+	}
+	
+	utils::Logger::info("Job {} cancelled", id);
+	if (waiting) {
+		job->client->channel.write({{"event", "cancelled"}, {"id", id}, {"frames", 0}});
+	}
+	return true;
+}
+
+void RenderServer::cancelJobsOf(const Connection& connection) {
+	std::vector<std::string> ids;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& [id, job] : jobs) {
+			if (job->client.get() == &connection) {
+				ids.push_back(id);
+			}
+		}
+	}
+	for (const auto& id : ids) {
+		cancel(id);
+	}
+}
+
+nlohmann::json RenderServer::status() {
+	nlohmann::json list = nlohmann::json::array();
+	size_t queued = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& [id, job] : jobs) {
+			list.push_back({{"id", id}, {"state", job->running ? "running" : "queued"},
+				{"frame", job->frame}, {"total_frames", job->totalFrames}});
+			queued += job->running ? 0 : 1;
+		}
+	}
+	
+	media::DecoderCache::Stats cacheStats = decoderCache->getStats();
+	return {
+		{"event", "status"},
+		{"workers", config.workers},
+		{"queued", queued},
+		{"jobs", list},
+		{"warm_decoders", decoderCache->getIdleCount()},
+		{"probe_hits", cacheStats.probeHits},
+		{"decoder_hits", cacheStats.decoderHits},
+		{"decoder_misses", cacheStats.decoderMisses}
+	};
+}
+
+void RenderServer::workerLoop() {
+	while (true) {
+		std::shared_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = queue.front();
+			queue.pop_front();
+		}
+		runJob(job);
+	}
+}
+
+void RenderServer::runJob(const std::shared_ptr<Job>& job) {
+	render::Renderer renderer(job->options);
+	renderer.setDecoderCache(decoderCache);
+	
+	auto lastProgress = std::chrono::steady_clock::time_point();
+	renderer.setProgressCallback([&](const render::Renderer::Progress& progress) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job->frame = progress.frame;
+			job->totalFrames = progress.totalFrames;
+		}
+		
+		auto now = std::chrono::steady_clock::now();
+		if (progress.done || now - lastProgress < std::chrono::duration<double>(PROGRESS_INTERVAL)) {
+			return;
+		}
+		lastProgress = now;
+		job->client->channel.write({{"event", "progress"}, {"id", job->id}, {"frame", progress.frame},
+			{"total_frames", progress.totalFrames}, {"fps", progress.fps}});
+	});
+	
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job->cancelled) {
+			// Cancelled between leaving the queue and starting; already reported
+			return;
+		}
+		job->running = true;
+		job->renderer = &renderer;
+	}
+	
+	job->client->channel.write({{"event", "started"}, {"id", job->id}});
+	utils::Logger::info("Job {} started", job->id);
+	
+	nlohmann::json event;
+	try {
+		render::Renderer::Result result = renderer.render();
+		event = {
+			{"event", result.cancelled ? "cancelled" : "done"},
+			{"id", job->id},
+			{"frames", result.frames},
+			{"total_frames", result.totalFrames},
+			{"seconds", result.seconds},
+			{"fps", result.fps}
+		};
+		utils::Logger::info("Job {} {}: {} frames in {} seconds", job->id,
+			result.cancelled ? "cancelled" : "done", result.frames, result.seconds);
+	} catch (const std::exception& e) {
+		utils::Logger::error("Job {} failed: {}", job->id, e.what());
+		event = errorEvent(job->id, e.what());
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job->renderer = nullptr;
+		job->running = false;
+		jobs.erase(job->id);
+	}
+	job->client->channel.write(event);
+}
+
+} // namespace server
\ No newline at end of file
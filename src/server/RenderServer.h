@@ -0,0 +1,115 @@
+#pragma once
+
+#include "media/DecoderCache.h"
+#include "render/RenderOptions.h"
+#include "render/Renderer.h"
+#include "server/JsonChannel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+/**
+ * Render daemon: accepts render jobs on a Unix domain socket and runs them
+ * on a fixed set of workers, so process start-up, codec and hardware
+ * context initialization and source probing are paid once rather than per
+ * job.
+ *
+ * Clients send one JSON object per line:
+ *
+ *   {"type": "render", "id": "<optional>", "edl": ..., "output": ..., "options": {...}}
+ *   {"type": "cancel", "id": "<job>"}
+ *   {"type": "status"}
+ *   {"type": "shutdown"}
+ *
+ * (see render::parseJobOptions() for the job fields) and get events back on
+ * the same connection: "queued", "started", "progress" (at most every
+ * PROGRESS_INTERVAL), then one of "done", "cancelled" or "error". A cancel
+ * is answered with "cancel_requested", status with "status". A job is
+ * cancelled when its client disconnects. Sources are resolved and probed
+ * through one DecoderCache, so jobs reading the same media start with warm
+ * probes and open decoders.
+ */
+class RenderServer {
+public:
+	struct Config {
+		std::string socketPath = DEFAULT_SOCKET_PATH;
+		int workers = 1;                    // Jobs rendered at the same time
+		int threadsPerJob = 0;              // For jobs without "threads", 0 = cores / workers
+		size_t maxIdleDecoders = 16;        // Warm decoders kept between jobs
+		render::Options defaults;           // Options jobs start from
+	};
+	
+	static constexpr double PROGRESS_INTERVAL = 0.25;  // Seconds
+	
+	explicit RenderServer(const Config& config);
+	~RenderServer();
+	
+	RenderServer(const RenderServer&) = delete;
+	RenderServer& operator=(const RenderServer&) = delete;
+	
+	/**
+	 * Listen and serve until stop() or a shutdown request; running jobs are
+	 * cancelled on the way out
+	 * @throws std::runtime_error if the socket cannot be created
+	 */
+	void run();
+	
+	// Make run() return; async-signal-safe, so it may be called from a
+	// SIGINT/SIGTERM handler
+	void stop();
+
+private:
+	struct Connection;
+	
+	struct Job {
+		std::string id;
+		render::Options options;
+		std::shared_ptr<Connection> client;
+		render::Renderer* renderer = nullptr;   // Set while running
+		bool running = false;
+		bool cancelled = false;
+		int frame = 0;
+		int totalFrames = 0;
+	};
+	
+	struct Connection {
+		explicit Connection(int fd) : channel(fd) {}
+		
+		JsonChannel channel;
+		std::thread reader;
+		std::atomic<bool> closed{false};
+	};
+	
+	void serve(std::shared_ptr<Connection> connection);
+	void handle(Connection& connection, const std::shared_ptr<Connection>& self, const nlohmann::json& request);
+	void submit(const std::shared_ptr<Connection>& client, const nlohmann::json& request);
+	bool cancel(const std::string& id);
+	void cancelJobsOf(const Connection& connection);
+	nlohmann::json status();
+	
+	void workerLoop();
+	void runJob(const std::shared_ptr<Job>& job);
+	
+	Config config;
+	std::shared_ptr<media::DecoderCache> decoderCache;
+	int wakeFds[2] = {-1, -1};           // stop() writes here to wake run()
+	
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::deque<std::shared_ptr<Job>> queue;
+	std::unordered_map<std::string, std::shared_ptr<Job>> jobs;   // Queued and running
+	std::vector<std::shared_ptr<Connection>> connections;
+	std::vector<std::thread> workers;
+	uint64_t nextJobId = 1;
+	bool stopping = false;
+};
+
+} // namespace server
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "utils/BenchmarkReport.h"
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+// Four buckets per doubling
+constexpr double BUCKETS_PER_OCTAVE = 4.0;
+
+}
+
+double StageHistogram::bucketBound(int bucket) {
+	return std::exp2(bucket / BUCKETS_PER_OCTAVE) * 1e-6;
+}
+
+int StageHistogram::bucketFor(double seconds) {
+	double micros = seconds * 1e6;
+	int bucket = micros <= 1.0 ? 0 : static_cast<int>(std::ceil(std::log2(micros) * BUCKETS_PER_OCTAVE));
+	return std::min(bucket, BUCKETS - 1);
+}
+
+void StageHistogram::add(double seconds) {
+	seconds = std::max(0.0, seconds);
+	buckets[bucketFor(seconds)]++;
+	
+	min = count == 0 ? seconds : std::min(min, seconds);
+	max = std::max(max, seconds);
+	total += seconds;
+	count++;
+}
+
+void StageHistogram::merge(const uint64_t* bucketCounts, uint64_t samples, double totalSeconds,
+	double minSeconds, double maxSeconds) {
+	if (samples == 0) {
+		return;
+	}
+	for (int bucket = 0; bucket < BUCKETS; bucket++) {
+		buckets[bucket] += bucketCounts[bucket];
+	}
+	min = count == 0 ? minSeconds : std::min(min, minSeconds);
+	max = std::max(max, maxSeconds);
+	total += totalSeconds;
+	count += samples;
+}
+
+double StageHistogram::percentile(double p) const {
+	if (count == 0) {
+		return 0.0;
+	}
+	uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * count));
+	rank = std::max<uint64_t>(rank, 1);
+	
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < BUCKETS; bucket++) {
+		seen += buckets[bucket];
+		if (seen >= rank) {
+			return std::clamp(bucketBound(bucket), min, max);
+		}
+	}
+	return max;
+}
+
+void BenchmarkReport::record(const std::string& stage, double seconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	stages[stage].add(seconds);
+}
+
+void BenchmarkReport::setInfo(const std::string& key, const std::string& value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	textInfo[key] = value;
+}
+
+void BenchmarkReport::setInfo(const std::string& key, double value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	numberInfo[key] = value;
+}
+
+std::string BenchmarkReport::toJson(int64_t frames, double seconds) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	nlohmann::json report;
+	report["mode"] = mode;
+	for (const auto& [key, value] : textInfo) {
+		report[key] = value;
+	}
+	for (const auto& [key, value] : numberInfo) {
+		report[key] = value;
+	}
+	report["frames"] = frames;
+	report["seconds"] = seconds;
+	report["fps"] = seconds > 0.0 ? frames / seconds : 0.0;
+	
+	nlohmann::json stageReports = nlohmann::json::object();
+	for (const auto& [name, histogram] : stages) {
+		nlohmann::json buckets = nlohmann::json::array();
+		const auto& counts = histogram.getBuckets();
+		for (int bucket = 0; bucket < StageHistogram::BUCKETS; bucket++) {
+			if (counts[bucket] > 0) {
+				buckets.push_back({{"le_ms", StageHistogram::bucketBound(bucket) * 1000.0}, {"count", counts[bucket]}});
+			}
+		}
+		
+		stageReports[name] = {
+			{"count", histogram.getCount()},
+			{"total_ms", histogram.getTotal() * 1000.0},
+			{"mean_ms", histogram.mean() * 1000.0},
+			{"min_ms", histogram.getMin() * 1000.0},
+			{"max_ms", histogram.getMax() * 1000.0},
+			{"p50_ms", histogram.percentile(0.50) * 1000.0},
+			{"p90_ms", histogram.percentile(0.90) * 1000.0},
+			{"p99_ms", histogram.percentile(0.99) * 1000.0},
+			{"histogram", buckets}
+		};
+	}
+	report["stages"] = stageReports;
+	report["peak_rss_bytes"] = peakRssBytes();
+	
+	return report.dump(2);
+}
+
+uint64_t BenchmarkReport::peakRssBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);          // bytes
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+#endif
+}
+
+} // namespace utils
\ No newline at end of file
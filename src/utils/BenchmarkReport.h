@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace utils {
+
+/**
+ * Latency histogram with logarithmic buckets: bucket i holds samples up to
+ * 2^(i/4) microseconds, so each bucket is about 19% wider than the one
+ * before and 1 µs to about an hour fit in a fixed array. Percentiles are
+ * read from the bucket bounds and clamped to the observed range.
+ */
+class StageHistogram {
+public:
+	static constexpr int BUCKETS = 128;
+	
+	void add(double seconds);
+	
+	// Fold in counts kept elsewhere in the same bucket layout
+	void merge(const uint64_t* bucketCounts, uint64_t samples, double totalSeconds, double minSeconds,
+		double maxSeconds);
+	
+	uint64_t getCount() const { return count; }
+	double getTotal() const { return total; }
+	double getMin() const { return count > 0 ? min : 0.0; }
+	double getMax() const { return max; }
+	double mean() const { return count > 0 ? total / count : 0.0; }
+	
+	// Upper bound in seconds below which the fraction p (0..1) of samples fall
+	double percentile(double p) const;
+	
+	// Upper bound of bucket i, in seconds
+	static double bucketBound(int bucket);
+	
+	// Bucket that holds a sample
+	static int bucketFor(double seconds);
+	
+	const std::array<uint64_t, BUCKETS>& getBuckets() const { return buckets; }
+
+private:
+	std::array<uint64_t, BUCKETS> buckets{};
+	uint64_t count = 0;
+	double total = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+};
+
+/**
+ * Per-stage timings of a --benchmark run, written as JSON:
+ *
+ *   {"mode": "...", "frames": N, "seconds": T, "fps": N/T,
+ *    "stages": {"decode": {"count", "total_ms", "mean_ms", "min_ms", "max_ms",
+ *                          "p50_ms", "p90_ms", "p99_ms",
+ *                          "histogram": [{"le_ms": bound, "count": n}, ...]}, ...},
+ *    "peak_rss_bytes": ..., plus any values set with setInfo()}
+ *
+ * Only non-empty histogram buckets are listed.
+ */
+class BenchmarkReport {
+public:
+	explicit BenchmarkReport(const std::string& mode) : mode(mode) {}
+	
+	// Thread-safe
+	void record(const std::string& stage, double seconds);
+	
+	// Extra top-level values (source, resolution, thread counts, ...)
+	void setInfo(const std::string& key, const std::string& value);
+	void setInfo(const std::string& key, double value);
+	
+	std::string toJson(int64_t frames, double seconds) const;
+	
+	// Peak resident set size of this process, 0 if unknown
+	static uint64_t peakRssBytes();
+
+private:
+	std::string mode;
+	std::map<std::string, StageHistogram> stages;
+	std::map<std::string, std::string> textInfo;
+	std::map<std::string, double> numberInfo;
+	mutable std::mutex mutex;
+};
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace utils {
+
+/**
+ * Blocking FIFO of limited capacity between one or more producers and
+ * consumers. push() waits while the queue is full, so a slow consumer holds
+ * the producer back instead of letting frames pile up in memory.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+	
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+	
+	/**
+	 * Append an item, waiting for space
+	 * @return false if the queue was closed (the item is dropped)
+	 */
+	bool push(T item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+		if (closed) {
+			return false;
+		}
+		items.push_back(std::move(item));
+		lock.unlock();
+		notEmpty.notify_one();
+		return true;
+	}
+	
+	/**
+	 * Take the oldest item, waiting for one
+	 * @return std::nullopt once the queue is closed and empty
+	 */
+	std::optional<T> pop() {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+		if (items.empty()) {
+			return std::nullopt;
+		}
+		T item = std::move(items.front());
+		items.pop_front();
+		lock.unlock();
+		notFull.notify_one();
+		return item;
+	}
+	
+	// No more pushes; consumers drain what is left
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		notFull.notify_all();
+		notEmpty.notify_all();
+	}
+	
+	size_t size() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return items.size();
+	}
+	
+	// Items already queued above a lower capacity stay; push() waits until
+	// the queue is below it again
+	void setCapacity(size_t newCapacity) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			capacity = newCapacity > 0 ? newCapacity : 1;
+		}
+		notFull.notify_all();
+	}
+	
+	size_t getCapacity() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return capacity;
+	}
+
+private:
+	size_t capacity;
+	std::deque<T> items;
+	mutable std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+	bool closed = false;
+};
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "utils/FrameArena.h"
+#include "utils/Logger.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace utils {
+
+std::atomic<bool> FrameArena::enabled{false};
+
+namespace {
+
+constexpr size_t PAGE_BYTES = 4096;
+constexpr size_t BUFFER_ALIGN = 64;
+
+// Room after each plane for SIMD loops and decoders that read past the end
+constexpr size_t PLANE_PADDING = 64;
+
+enum class Backing {
+	NORMAL_PAGES,
+	TRANSPARENT_HUGE_PAGES,
+	EXPLICIT_HUGE_PAGES
+};
+
+const char* backingName(Backing backing) {
+	switch (backing) {
+		case Backing::EXPLICIT_HUGE_PAGES: return "explicit huge pages";
+		case Backing::TRANSPARENT_HUGE_PAGES: return "transparent huge pages";
+		default: return "normal pages";
+	}
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// Anonymous read/write memory of size bytes (a multiple of the huge page
+// size), starting on a huge page boundary, or nullptr
+uint8_t* mapMemory(size_t size, bool hugePages, Backing& backing) {
+	backing = Backing::NORMAL_PAGES;
+#ifdef _WIN32
+	// Large pages need the "Lock pages in memory" privilege; without it the
+	// call fails and normal pages are used
+	if (hugePages && GetLargePageMinimum() > 0 && size % GetLargePageMinimum() == 0) {
+		void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory) {
+			backing = Backing::EXPLICIT_HUGE_PAGES;
+			return static_cast<uint8_t*>(memory);
+		}
+	}
+	return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+#ifdef MAP_HUGETLB
+	// Only succeeds if enough pages are reserved in the hugetlb pool
+	if (hugePages) {
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (memory != MAP_FAILED) {
+			backing = Backing::EXPLICIT_HUGE_PAGES;
+			return static_cast<uint8_t*>(memory);
+		}
+	}
+#endif
+
+	// Map one huge page more and trim both ends so the region is aligned,
+	// which transparent huge pages need to back it from the first byte
+	size_t mapped = size + FrameArena::HUGE_PAGE_SIZE;
+	void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return nullptr;
+	}
+	uint8_t* raw = static_cast<uint8_t*>(memory);
+	uint8_t* base = raw + (alignUp(reinterpret_cast<uintptr_t>(raw), FrameArena::HUGE_PAGE_SIZE) -
+		reinterpret_cast<uintptr_t>(raw));
+	if (base > raw) {
+		munmap(raw, static_cast<size_t>(base - raw));
+	}
+	if (raw + mapped > base + size) {
+		munmap(base + size, static_cast<size_t>(raw + mapped - (base + size)));
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (hugePages && madvise(base, size, MADV_HUGEPAGE) == 0) {
+		backing = Backing::TRANSPARENT_HUGE_PAGES;
+	}
+#endif
+	return base;
+#endif
+}
+
+// Write one byte per page so the whole range is backed now rather than on
+// first use
+void touchPages(uint8_t* base, size_t size) {
+	volatile uint8_t* bytes = base;
+	for (size_t offset = 0; offset < size; offset += PAGE_BYTES) {
+		bytes[offset] = 0;
+	}
+}
+
+// Give the pages of a free block back to the system; the address range stays
+// mapped and faults in again (zeroed) on the next write
+void discardPages(uint8_t* block, size_t size) {
+#ifdef _WIN32
+	VirtualAlloc(block, size, MEM_RESET, PAGE_READWRITE);
+#elif defined(MADV_DONTNEED)
+	madvise(block, size, MADV_DONTNEED);
+#endif
+}
+
+// All planes of a frame in one buffer, each on a BUFFER_ALIGN boundary
+struct PlaneLayout {
+	int planes = 0;
+	int linesize[4] = {};
+	size_t offset[4] = {};
+	size_t size = 0;
+};
+
+// False for formats that are not plain planes in memory (hardware and
+// palette formats) or invalid sizes
+bool layoutPlanes(AVPixelFormat format, int width, int height, int align, PlaneLayout& layout) {
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+	if (!desc || width <= 0 || height <= 0 || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL))) {
+		return false;
+	}
+#ifdef AV_PIX_FMT_FLAG_PSEUDOPAL
+	if (desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
+		return false;
+	}
+#endif
+	if (av_image_fill_linesizes(layout.linesize, format, width) < 0) {
+		return false;
+	}
+	
+	align = std::max(align, 1);
+	size_t planeAlign = std::max<size_t>(BUFFER_ALIGN, static_cast<size_t>(align));
+	layout.planes = av_pix_fmt_count_planes(format);
+	size_t offset = 0;
+	for (int i = 0; i < layout.planes; i++) {
+		layout.linesize[i] = FFALIGN(layout.linesize[i], align);
+		int planeHeight = (i == 1 || i == 2) ? AV_CEIL_RSHIFT(height, desc->log2_chroma_h) : height;
+		layout.offset[i] = offset;
+		offset = alignUp(offset + static_cast<size_t>(layout.linesize[i]) * planeHeight + PLANE_PADDING, planeAlign);
+	}
+	layout.size = offset;
+	return true;
+}
+
+}
+
+FrameArena& FrameArena::getInstance() {
+	// Never destroyed: frames released by other static destructors at exit
+	// still return their buffers here
+	static FrameArena* instance = new FrameArena();
+	return *instance;
+}
+
+void FrameArena::enable(const Config& newConfig) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		config = newConfig;
+		config.regionBytes = alignUp(std::max<size_t>(config.regionBytes, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE);
+		if (!isEnabled()) {
+			memory = MemoryBudget::Consumer("frame arena", MemoryBudget::CACHE);
+		}
+	}
+	enabled.store(true, std::memory_order_relaxed);
+	Logger::debug("Frame arena enabled: {} MB regions, huge pages: {}, prefault: {}",
+		newConfig.regionBytes >> 20, newConfig.hugePages ? "yes" : "no", newConfig.prefault ? "yes" : "no");
+}
+
+void FrameArena::reserve(size_t bytes) {
+	if (!isEnabled()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t available = next ? static_cast<size_t>(end - next) : 0;
+	if (available < bytes) {
+		mapRegion(bytes);
+	}
+}
+
+size_t FrameArena::sizeClass(size_t size) {
+	return alignUp(size, size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : PAGE_BYTES);
+}
+
+bool FrameArena::mapRegion(size_t size) {
+	size = alignUp(std::max(size, config.regionBytes), HUGE_PAGE_SIZE);
+	Backing backing;
+	uint8_t* base = mapMemory(size, config.hugePages, backing);
+	if (!base) {
+		if (!mapFailed) {
+			Logger::warn("Frame arena could not map {} MB, falling back to the default allocator", size >> 20);
+			mapFailed = true;
+		}
+		return false;
+	}
+	if (config.prefault) {
+		touchPages(base, size);
+	}
+	
+	// The rest of the previous region is abandoned
+	regions.push_back({base, size});
+	next = base;
+	end = base + size;
+	
+	stats.mappedBytes += size;
+	if (backing == Backing::EXPLICIT_HUGE_PAGES) {
+		stats.explicitHugeBytes += size;
+	} else if (backing == Backing::TRANSPARENT_HUGE_PAGES) {
+		stats.transparentHugeBytes += size;
+	}
+	Logger::debug("Frame arena mapped {} MB region {} ({}{})", size >> 20, regions.size(),
+		backingName(backing), config.prefault ? ", prefaulted" : "");
+	return true;
+}
+
+uint8_t* FrameArena::takeBlock(size_t size) {
+	uint8_t* block = nullptr;
+	auto it = freeBlocks.find(size);
+	if (it != freeBlocks.end() && !it->second.empty()) {
+		block = it->second.back();
+		it->second.pop_back();
+		stats.freeBytes -= size;
+		stats.reused++;
+		memory.add(-static_cast<int64_t>(size), -static_cast<int64_t>(size));
+	} else if (auto discarded = discardedBlocks.find(size);
+		discarded != discardedBlocks.end() && !discarded->second.empty()) {
+		block = discarded->second.back();
+		discarded->second.pop_back();
+		stats.discardedBytes -= size;
+		stats.reused++;
+	} else {
+		// Large blocks start on a huge page boundary so they share no huge
+		// page with their neighbours
+		size_t skip = 0;
+		if (next && size >= HUGE_PAGE_SIZE) {
+			skip = alignUp(reinterpret_cast<uintptr_t>(next), HUGE_PAGE_SIZE) - reinterpret_cast<uintptr_t>(next);
+		}
+		if (!next || static_cast<size_t>(end - next) < skip + size) {
+			if (!mapRegion(size)) {
+				return nullptr;
+			}
+			skip = 0;
+		}
+		block = next + skip;
+		next = block + size;
+	}
+	stats.inUseBytes += size;
+	stats.allocations++;
+	return block;
+}
+
+void FrameArena::releaseBuffer(void* opaque, uint8_t* data) {
+	size_t size = static_cast<size_t>(reinterpret_cast<uintptr_t>(opaque));
+	FrameArena& arena = getInstance();
+	std::lock_guard<std::mutex> lock(arena.mutex);
+	arena.freeBlocks[size].push_back(data);
+	arena.stats.inUseBytes -= size;
+	arena.stats.freeBytes += size;
+	arena.memory.add(static_cast<int64_t>(size), static_cast<int64_t>(size));
+	if (arena.memory.pressure() > 0) {
+		arena.discardFreeBlocks();
+	}
+}
+
+void FrameArena::discardFreeBlocks() {
+	for (auto& [size, blocks] : freeBlocks) {
+		for (uint8_t* block : blocks) {
+			discardPages(block, size);
+			discardedBlocks[size].push_back(block);
+		}
+		uint64_t bytes = size * blocks.size();
+		stats.freeBytes -= bytes;
+		stats.discardedBytes += bytes;
+		memory.add(-static_cast<int64_t>(bytes), -static_cast<int64_t>(bytes));
+		memory.released(bytes);
+		blocks.clear();
+	}
+}
+
+AVBufferRef* FrameArena::allocate(size_t size) {
+	if (!isEnabled()) {
+		return nullptr;
+	}
+	
+	size_t blockSize = sizeClass(size);
+	uint8_t* block;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		block = takeBlock(blockSize);
+	}
+	if (!block) {
+		return nullptr;
+	}
+	
+	// The block size travels as the opaque pointer, so releasing needs no lookup
+	void* opaque = reinterpret_cast<void*>(static_cast<uintptr_t>(blockSize));
+	AVBufferRef* buffer = av_buffer_create(block, size, releaseBuffer, opaque, 0);
+	if (!buffer) {
+		releaseBuffer(opaque, block);
+	}
+	return buffer;
+}
+
+bool FrameArena::allocatePlanes(AVFrame* frame, int allocWidth, int allocHeight, int align) {
+	if (!isEnabled()) {
+		return false;
+	}
+	
+	PlaneLayout layout;
+	if (!layoutPlanes(static_cast<AVPixelFormat>(frame->format), std::max(allocWidth, frame->width),
+		std::max(allocHeight, frame->height), align, layout)) {
+		return false;
+	}
+	
+	AVBufferRef* buffer = allocate(layout.size);
+	if (!buffer) {
+		return false;
+	}
+	
+	frame->buf[0] = buffer;
+	for (int i = 0; i < layout.planes; i++) {
+		frame->data[i] = buffer->data + layout.offset[i];
+		frame->linesize[i] = layout.linesize[i];
+	}
+	frame->extended_data = frame->data;
+	return true;
+}
+
+int FrameArena::getFrameBuffer(AVFrame* frame, int align) {
+	if (allocatePlanes(frame, frame->width, frame->height, align)) {
+		return 0;
+	}
+	return av_frame_get_buffer(frame, align);
+}
+
+size_t FrameArena::frameBytes(AVPixelFormat format, int width, int height, int align) {
+	PlaneLayout layout;
+	if (layoutPlanes(format, width, height, align, layout)) {
+		return sizeClass(layout.size);
+	}
+	int size = av_image_get_buffer_size(format, width, height, align);
+	return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+FrameArena::Stats FrameArena::getStats() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+#include "utils/MemoryBudget.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Arena for frame plane buffers.
+ *
+ * At 4K a frame is 12-50 MB, and allocating it with 4 KB pages means
+ * thousands of page faults per frame and a TLB entry per page. The arena
+ * instead maps large regions once, backed by explicit huge pages
+ * (MAP_HUGETLB) when the system has them reserved, otherwise by transparent
+ * huge pages, otherwise by normal pages. Freed buffers go back to a free list
+ * per size and are handed out again, so memory is never returned to the
+ * system and a warm pipeline neither maps nor faults. Under memory budget
+ * pressure the pages of free buffers are discarded; the buffers stay in the
+ * arena and fault in again when reused.
+ *
+ * Disabled until enable() is called; getFrameBuffer() then behaves like
+ * av_frame_get_buffer(). Buffers are AVBufferRefs, so frames filled from the
+ * arena are used, referenced and freed like any other frame.
+ */
+class FrameArena {
+public:
+	struct Config {
+		bool hugePages = true;                    // Ask for explicit or transparent huge pages
+		bool prefault = false;                    // Touch every page of a region when it is mapped
+		size_t regionBytes = 256 * 1024 * 1024;   // Size of each mapping (larger buffers get their own)
+	};
+	
+	struct Stats {
+		size_t mappedBytes = 0;         // Address space mapped so far
+		size_t explicitHugeBytes = 0;   // ... of which backed by MAP_HUGETLB pages
+		size_t transparentHugeBytes = 0; // ... of which advised as transparent huge pages
+		size_t inUseBytes = 0;          // Handed out and not yet released
+		size_t freeBytes = 0;           // Released and waiting to be reused
+		size_t discardedBytes = 0;      // Free, with their pages given back to the system
+		uint64_t allocations = 0;       // Buffers handed out
+		uint64_t reused = 0;            // ... of which taken from a free list
+	};
+	
+	static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+	
+	/**
+	 * Get the singleton instance of the arena
+	 */
+	static FrameArena& getInstance();
+	
+	/**
+	 * Start serving buffers from the arena. Call before any frame is
+	 * allocated; buffers allocated earlier keep their own allocator.
+	 */
+	void enable(const Config& config);
+	
+	static bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+	
+	/**
+	 * Map (and with prefault, touch) at least bytes up front so the first
+	 * frames are served without mapping or faulting
+	 */
+	void reserve(size_t bytes);
+	
+	/**
+	 * Buffer of at least size bytes, 64-byte aligned, or nullptr if the arena
+	 * is disabled or out of address space
+	 */
+	AVBufferRef* allocate(size_t size);
+	
+	/**
+	 * Allocate the planes of a video frame whose format, width and height are
+	 * set, like av_frame_get_buffer(), which it falls back to when the arena
+	 * is disabled or cannot serve the frame
+	 * @return 0 on success, a negative AVERROR otherwise
+	 */
+	int getFrameBuffer(AVFrame* frame, int align);
+	
+	/**
+	 * Fill the planes of a video frame from the arena, sized for
+	 * allocWidth x allocHeight (at least the frame size) for decoders that
+	 * write past the visible picture
+	 * @return false, leaving the frame untouched, if the arena is disabled,
+	 *         the format is not a plain software format or nothing could be
+	 *         mapped
+	 */
+	bool allocatePlanes(AVFrame* frame, int allocWidth, int allocHeight, int align);
+	
+	/**
+	 * Bytes one frame takes in the arena, for sizing reserve()
+	 */
+	static size_t frameBytes(AVPixelFormat format, int width, int height, int align = 64);
+	
+	Stats getStats() const;
+
+private:
+	// Private constructor for singleton
+	FrameArena() = default;
+	
+	// Delete copy constructor and assignment operator
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	
+	struct Region {
+		uint8_t* base = nullptr;
+		size_t size = 0;
+	};
+	
+	// Size actually taken for a request: whole huge pages for large buffers
+	// so each starts on a huge page boundary, whole pages otherwise
+	static size_t sizeClass(size_t size);
+	
+	// Called by FFmpeg when the last reference to an arena buffer goes away
+	static void releaseBuffer(void* opaque, uint8_t* data);
+	
+	uint8_t* takeBlock(size_t size);
+	void discardFreeBlocks();
+	bool mapRegion(size_t size);
+	
+	static std::atomic<bool> enabled;
+	
+	Config config;
+	mutable std::mutex mutex;
+	std::vector<Region> regions;
+	uint8_t* next = nullptr;        // Unused part of the newest region
+	uint8_t* end = nullptr;
+	std::unordered_map<size_t, std::vector<uint8_t*>> freeBlocks;
+	std::unordered_map<size_t, std::vector<uint8_t*>> discardedBlocks;
+	MemoryBudget::Consumer memory;  // Free blocks, the only memory not counted by their users
+	bool mapFailed = false;
+	Stats stats;
+};
+
+} // namespace utils
\ No newline at end of file
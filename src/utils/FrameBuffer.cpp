@@ -1,5 +1,11 @@
 #include "utils/FrameBuffer.h"
+#include "utils/FrameArena.h"
 #include "utils/Logger.h"
+#include "utils/MemoryBudget.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 
 extern "C" {
@@ -8,19 +14,342 @@ extern "C" {
 
 namespace utils {
 
-// Custom deleter that returns frames to the pool
-class FramePoolDeleter {
+namespace {
+
+constexpr uint32_t NO_NODE = UINT32_MAX;
+constexpr uint32_t CHUNK_NODES = 64;
+constexpr uint32_t MAX_CHUNKS = 64;            // at most 4096 frames per pool
+constexpr size_t CONTROL_BLOCK_BYTES = 64;
+
+// getFrame() calls between updates of the pool target
+constexpr uint64_t TARGET_WINDOW = 256;
+
+// Frames are handed out with their own control block, which returns the
+// frame to the pool when it is deallocated; the deleter has nothing to do
+struct KeepFrame {
+	void operator()(AVFrame*) const {}
+};
+
+void updateMax(std::atomic<size_t>& value, size_t candidate) {
+	size_t current = value.load(std::memory_order_relaxed);
+	while (candidate > current &&
+		!value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+	}
+}
+
+}
+
+// A pool slot: a frame (or none, after trimming) and room for the control
+// block of the shared_ptr it is handed out with. Nodes live until the pool
+// state is destroyed, so the free-list stacks may read a node another
+// thread has just popped.
+struct FrameBufferPool::Node {
+	AVFrame* frame = nullptr;
+	State* state = nullptr;
+	uint32_t index = 0;
+	std::atomic<uint32_t> next{NO_NODE};
+	alignas(std::max_align_t) unsigned char controlBlock[CONTROL_BLOCK_BYTES];
+};
+
+struct FrameBufferPool::State {
+	// Treiber stack of node indices; the tag in the upper half of the head
+	// changes on every update, so a node popped and pushed back between a
+	// load and the CAS does not corrupt the list (ABA)
+	class NodeStack {
+	public:
+		void push(Node* node) {
+			uint64_t old = head.load(std::memory_order_relaxed);
+			uint64_t updated;
+			do {
+				node->next.store(indexOf(old), std::memory_order_relaxed);
+				updated = pack(node->index, tagOf(old) + 1);
+			} while (!head.compare_exchange_weak(old, updated, std::memory_order_release,
+				std::memory_order_relaxed));
+		}
+		
+		Node* pop(State& state) {
+			uint64_t old = head.load(std::memory_order_acquire);
+			Node* node;
+			uint64_t updated;
+			do {
+				if (indexOf(old) == NO_NODE) {
+					return nullptr;
+				}
+				node = state.node(indexOf(old));
+				updated = pack(node->next.load(std::memory_order_relaxed), tagOf(old) + 1);
+			} while (!head.compare_exchange_weak(old, updated, std::memory_order_acquire,
+				std::memory_order_acquire));
+			return node;
+		}
+	
+	private:
+		static uint64_t pack(uint32_t index, uint32_t tag) {
+			return (static_cast<uint64_t>(tag) << 32) | index;
+		}
+		static uint32_t indexOf(uint64_t value) { return static_cast<uint32_t>(value); }
+		static uint32_t tagOf(uint64_t value) { return static_cast<uint32_t>(value >> 32); }
+		
+		std::atomic<uint64_t> head{pack(NO_NODE, 0)};
+	};
+	
+	State(int width, int height, AVPixelFormat format, size_t minimum)
+		: width(width), height(height), format(format), minimum(minimum)
+		, frameBytes(static_cast<int64_t>(FrameArena::frameBytes(format, width, height)))
+		, memory("frame pools", MemoryBudget::CACHE), target(minimum) {}
+	
+	~State() {
+		for (uint32_t chunk = 0; chunk < MAX_CHUNKS; chunk++) {
+			Node* nodes = chunks[chunk].load(std::memory_order_relaxed);
+			if (!nodes) {
+				break;
+			}
+			for (uint32_t i = 0; i < CHUNK_NODES; i++) {
+				if (nodes[i].frame) {
+					av_frame_free(&nodes[i].frame);
+				}
+			}
+			delete[] nodes;
+		}
+	}
+	
+	Node* node(uint32_t index) const {
+		return &chunks[index / CHUNK_NODES].load(std::memory_order_acquire)[index % CHUNK_NODES];
+	}
+	
+	// A node for a new frame; only taken when both stacks are empty
+	Node* newNode() {
+		std::lock_guard<std::mutex> lock(growMutex);
+		if (nodeCount == CHUNK_NODES * MAX_CHUNKS) {
+			throw std::runtime_error("Frame buffer pool exhausted");
+		}
+		uint32_t chunk = nodeCount / CHUNK_NODES;
+		if (nodeCount % CHUNK_NODES == 0) {
+			Node* nodes = new Node[CHUNK_NODES];
+			for (uint32_t i = 0; i < CHUNK_NODES; i++) {
+				nodes[i].state = this;
+				nodes[i].index = chunk * CHUNK_NODES + i;
+			}
+			chunks[chunk].store(nodes, std::memory_order_release);
+		}
+		return node(nodeCount++);
+	}
+	
+	// Gives an empty frame buffers of the pool's size and format
+	void fillFrame(AVFrame* frame) {
+		frame->format = format;
+		frame->width = width;
+		frame->height = height;
+		
+		int ret = FrameArena::getInstance().getFrameBuffer(frame, 32); // 32-byte alignment for SIMD
+		if (ret < 0) {
+			throw std::runtime_error("Failed to allocate frame buffer");
+		}
+	}
+	
+	AVFrame* createFrame() {
+		AVFrame* frame = av_frame_alloc();
+		if (!frame) {
+			throw std::runtime_error("Failed to allocate frame");
+		}
+		
+		try {
+			fillFrame(frame);
+		} catch (...) {
+			av_frame_free(&frame);
+			throw;
+		}
+		
+		allocated.fetch_add(1, std::memory_order_relaxed);
+		memory.add(frameBytes);
+		return frame;
+	}
+	
+	Node* acquire() {
+		Node* node = cached.pop(*this);
+		if (node) {
+			freeFrames.fetch_sub(1, std::memory_order_relaxed);
+			memory.add(0, -frameBytes);
+			
+			// Someone may still hold a reference to the buffers (e.g. a clone
+			// queued for another encoder, or the decoder keeping a reference
+			// picture that avcodec_receive_frame swapped in). Writing into them
+			// would change the pixels they read, so the frame lets go of them
+			// and gets buffers of its own.
+			if (!av_frame_is_writable(node->frame)) {
+				av_frame_unref(node->frame);
+				try {
+					fillFrame(node->frame);
+				} catch (...) {
+					av_frame_free(&node->frame);
+					allocated.fetch_sub(1, std::memory_order_relaxed);
+					memory.add(-frameBytes);
+					empty.push(node);
+					throw;
+				}
+			}
+			hits.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (!node) {
+			node = empty.pop(*this);
+			if (!node) {
+				node = newNode();
+			}
+			try {
+				node->frame = createFrame();
+			} catch (...) {
+				empty.push(node);
+				throw;
+			}
+			misses.fetch_add(1, std::memory_order_relaxed);
+		}
+		
+		references.fetch_add(1, std::memory_order_relaxed);
+		size_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+		updateMax(windowPeak, used);
+		updateMax(highWater, used);
+		
+		// Follow the deepest point of the last window, up or down
+		if (requests.fetch_add(1, std::memory_order_relaxed) % TARGET_WINDOW == TARGET_WINDOW - 1) {
+			size_t peak = windowPeak.exchange(used, std::memory_order_relaxed);
+			target.store(std::max(minimum, peak), std::memory_order_relaxed);
+		}
+		return node;
+	}
+	
+	// Called when the control block of a handed-out frame is deallocated,
+	// the last time the node is touched on behalf of that frame
+	void release(Node* node) {
+		size_t used = inUse.fetch_sub(1, std::memory_order_relaxed) - 1;
+		bool underPressure = memory.pressure() > 0;
+		bool keep = !closed.load(std::memory_order_relaxed) && !underPressure &&
+			used + freeFrames.load(std::memory_order_relaxed) < target.load(std::memory_order_relaxed);
+		
+		if (keep) {
+			// Don't call av_frame_unref as it releases the buffer
+			// Just reset the essential metadata for reuse
+			AVFrame* frame = node->frame;
+			frame->pts = 0;
+			frame->pkt_dts = 0;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 134, 100)
+			frame->duration = 0;
+#else
+			frame->pkt_duration = 0;
+#endif
+			frame->flags = 0;
+			frame->pict_type = AV_PICTURE_TYPE_NONE;
+			frame->sample_aspect_ratio.num = 0;
+			frame->sample_aspect_ratio.den = 1;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 134, 100)
+			frame->crop_top = 0;
+			frame->crop_bottom = 0;
+			frame->crop_left = 0;
+			frame->crop_right = 0;
+#endif
+			freeFrames.fetch_add(1, std::memory_order_relaxed);
+			memory.add(0, frameBytes);
+			cached.push(node);
+		} else {
+			freeFrame(node);
+			if (underPressure) {
+				memory.released(frameBytes);
+				dropCached();
+			}
+		}
+		
+		unreference();
+	}
+	
+	void freeFrame(Node* node) {
+		av_frame_free(&node->frame);
+		allocated.fetch_sub(1, std::memory_order_relaxed);
+		trimmed.fetch_add(1, std::memory_order_relaxed);
+		memory.add(-frameBytes);
+		empty.push(node);
+	}
+	
+	// Free cached frames while the memory budget asks for it
+	void dropCached() {
+		while (memory.pressure() > 0) {
+			Node* node = cached.pop(*this);
+			if (!node) {
+				return;
+			}
+			freeFrames.fetch_sub(1, std::memory_order_relaxed);
+			memory.add(0, -frameBytes);
+			memory.released(frameBytes);
+			freeFrame(node);
+		}
+	}
+	
+	// The pool and each frame in use hold a reference
+	void unreference() {
+		if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete this;
+		}
+	}
+	
+	const int width;
+	const int height;
+	const AVPixelFormat format;
+	const size_t minimum;
+	const int64_t frameBytes;
+	
+	// Every frame counts against the memory budget; cached ones can be given back
+	MemoryBudget::Consumer memory;
+	
+	NodeStack cached;       // nodes holding a free frame
+	NodeStack empty;        // nodes whose frame was trimmed
+	
+	std::array<std::atomic<Node*>, MAX_CHUNKS> chunks{};
+	uint32_t nodeCount = 0;             // guarded by growMutex
+	std::mutex growMutex;
+	
+	std::atomic<size_t> references{1};
+	std::atomic<bool> closed{false};
+	std::atomic<size_t> freeFrames{0};
+	std::atomic<size_t> inUse{0};
+	std::atomic<size_t> allocated{0};
+	std::atomic<size_t> target;
+	std::atomic<size_t> windowPeak{0};
+	std::atomic<size_t> highWater{0};
+	std::atomic<uint64_t> requests{0};
+	std::atomic<uint64_t> hits{0};
+	std::atomic<uint64_t> misses{0};
+	std::atomic<uint64_t> trimmed{0};
+};
+
+// Places the shared_ptr control block in the node and hands the node back
+// to the pool when the control block goes away
+template<typename T>
+class FrameBufferPool::NodeAllocator {
 public:
-	FramePoolDeleter(FrameBufferPool* pool) : pool_(pool) {}
+	using value_type = T;
+	
+	explicit NodeAllocator(Node* node) : node(node) {}
 	
-	void operator()(AVFrame* frame) const {
-		if (frame && pool_) {
-			pool_->returnFrame(frame);
+	template<typename U>
+	NodeAllocator(const NodeAllocator<U>& other) : node(other.node) {}
+	
+	T* allocate(size_t n) {
+		static_assert(sizeof(T) <= CONTROL_BLOCK_BYTES, "control block does not fit in the pool node");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "control block is over-aligned");
+		if (n != 1) {
+			throw std::bad_alloc();
 		}
+		return reinterpret_cast<T*>(node->controlBlock);
+	}
+	
+	void deallocate(T*, size_t) {
+		node->state->release(node);
 	}
 	
+	template<typename U>
+	bool operator==(const NodeAllocator<U>& other) const { return node == other.node; }
+
 private:
-	FrameBufferPool* pool_;
+	template<typename U> friend class NodeAllocator;
+	
+	Node* node;
 };
 
 FrameBufferPool::FrameBufferPool(int width, int height, AVPixelFormat format,
@@ -28,30 +357,25 @@ FrameBufferPool::FrameBufferPool(int width, int height, AVPixelFormat format,
 	: width(width)
 	, height(height)
 	, format(format)
-	, poolSize(poolSize) {
+	, state(new State(width, height, format, poolSize)) {
 	
 	// Pre-allocate some frames to avoid initial allocation overhead
 	// Skip pre-allocation if poolSize is 0 (e.g., for hardware decoding)
 	if (width > 0 && height > 0 && format != AV_PIX_FMT_NONE && poolSize > 0) {
-		std::lock_guard<std::mutex> lock(poolMutex);
 		size_t preAllocCount = std::min(poolSize / 2, size_t(5));
 		try {
 			for (size_t i = 0; i < preAllocCount; ++i) {
-				availableFrames.push(createFrame());
+				Node* node = state->newNode();
+				node->frame = state->createFrame();
+				state->freeFrames.fetch_add(1, std::memory_order_relaxed);
+				state->memory.add(0, state->frameBytes);
+				state->cached.push(node);
 			}
 			Logger::debug("Frame buffer pool initialized: {}x{}, format: {}, pre-allocated: {}",
-				width, height, format, availableFrames.size());
+				width, height, format, preAllocCount);
 		} catch (const std::exception& e) {
 			// Pre-allocation failed, but pool can still work with on-demand allocation
 			Logger::warn("Frame buffer pool pre-allocation failed: {}, will allocate on-demand", e.what());
-			// Clean up any frames that were allocated before the failure
-			while (!availableFrames.empty()) {
-				auto frame = availableFrames.front();
-				availableFrames.pop();
-				if (frame) {
-					av_frame_free(&frame);
-				}
-			}
 		}
 	} else {
 		Logger::debug("Frame buffer pool initialized: {}x{}, format: {}, pre-allocation skipped",
@@ -60,149 +384,73 @@ FrameBufferPool::FrameBufferPool(int width, int height, AVPixelFormat format,
 }
 
 FrameBufferPool::~FrameBufferPool() {
-	std::lock_guard<std::mutex> lock(poolMutex);
-	// Clean up all frames in the pool
-	while (!availableFrames.empty()) {
-		auto frame = availableFrames.front();
-		availableFrames.pop();
-		if (frame) {
-			av_frame_free(&frame);
-		}
+	close();
+}
+
+void FrameBufferPool::close() {
+	if (!state) {
+		return;
 	}
-	Logger::debug("Frame buffer pool destroyed, cleaned up {} frames", totalAllocated);
+	
+	Stats stats = getStats();
+	Logger::debug("Frame buffer pool destroyed: {} hits, {} misses, {} trimmed, peak {} frames in use",
+		stats.hits, stats.misses, stats.trimmed, stats.highWater);
+	
+	// Frames still in use keep the state alive and are freed on release
+	state->closed.store(true, std::memory_order_relaxed);
+	state->unreference();
+	state = nullptr;
 }
 
-FrameBufferPool::FrameBufferPool(FrameBufferPool&& other) noexcept 
+FrameBufferPool::FrameBufferPool(FrameBufferPool&& other) noexcept
 	: width(other.width),
 	  height(other.height),
 	  format(other.format),
-	  poolSize(other.poolSize),
-	  availableFrames(std::move(other.availableFrames)),
-	  totalAllocated(other.totalAllocated) {
-	// Clear the moved-from object without locking
-	// The moved-from object should not be accessed concurrently
+	  state(other.state) {
 	other.width = 0;
 	other.height = 0;
 	other.format = AV_PIX_FMT_NONE;
-	other.totalAllocated = 0;
+	other.state = nullptr;
 }
 
 FrameBufferPool& FrameBufferPool::operator=(FrameBufferPool&& other) noexcept {
 	if (this != &other) {
-		// Use std::lock to avoid deadlock when locking multiple mutexes
-		std::unique_lock<std::mutex> lock1(poolMutex, std::defer_lock);
-		std::unique_lock<std::mutex> lock2(other.poolMutex, std::defer_lock);
-		std::lock(lock1, lock2);
-		
-		// Clean up existing frames
-		while (!availableFrames.empty()) {
-			auto frame = availableFrames.front();
-			availableFrames.pop();
-			if (frame) {
-				av_frame_free(&frame);
-			}
-		}
-		
+		close();
 		width = other.width;
 		height = other.height;
 		format = other.format;
-		poolSize = other.poolSize;
-		availableFrames = std::move(other.availableFrames);
-		totalAllocated = other.totalAllocated;
+		state = other.state;
 		
 		other.width = 0;
 		other.height = 0;
 		other.format = AV_PIX_FMT_NONE;
-		other.totalAllocated = 0;
+		other.state = nullptr;
 	}
 	return *this;
 }
 
-AVFrame* FrameBufferPool::createFrame() {
-	AVFrame* frame = av_frame_alloc();
-	if (!frame) {
-		throw std::runtime_error("Failed to allocate frame");
-	}
-	
-	frame->format = format;
-	frame->width = width;
-	frame->height = height;
-	
-	int ret = av_frame_get_buffer(frame, 32); // 32-byte alignment for SIMD
-	if (ret < 0) {
-		av_frame_free(&frame);
-		throw std::runtime_error("Failed to allocate frame buffer");
-	}
-	
-	totalAllocated++;
-	return frame;
-}
-
 std::shared_ptr<AVFrame> FrameBufferPool::getFrame() {
-	std::lock_guard<std::mutex> lock(poolMutex);
-	
-	AVFrame* frame = nullptr;
-	
-	if (!availableFrames.empty()) {
-		// Reuse frame from pool
-		frame = availableFrames.front();
-		availableFrames.pop();
-		
-		// Make frame writable and reset
-		av_frame_make_writable(frame);
-	} else {
-		// Create new frame if pool is empty
-		frame = createFrame();
-		
-		if (totalAllocated > poolSize * 2) {
-			static size_t warnCount = 0;
-			if (warnCount++ < 5) { // Only warn first 5 times
-				Logger::warn("Frame buffer pool: allocated {} frames (pool size: {})",
-					totalAllocated, poolSize);
-			}
-		}
+	if (!state) {
+		throw std::runtime_error("Frame buffer pool is not initialized");
 	}
 	
-	// Return frame with custom deleter that returns it to the pool
-	return std::shared_ptr<AVFrame>(frame, FramePoolDeleter(this));
+	Node* node = state->acquire();
+	return std::shared_ptr<AVFrame>(node->frame, KeepFrame(), NodeAllocator<AVFrame>(node));
 }
 
-void FrameBufferPool::returnFrame(AVFrame* frame) {
-	if (!frame) {
-		return;
-	}
-	
-	std::lock_guard<std::mutex> lock(poolMutex);
-	
-	// Only return to pool if we haven't exceeded the maximum
-	if (availableFrames.size() < poolSize) {
-		// Don't call av_frame_unref as it releases the buffer
-		// Just reset the essential metadata for reuse
-		frame->pts = 0;
-		frame->pkt_dts = 0;
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 134, 100)
-		frame->duration = 0;
-#else
-		frame->pkt_duration = 0;
-#endif
-		frame->flags = 0;
-		frame->pict_type = AV_PICTURE_TYPE_NONE;
-		frame->sample_aspect_ratio.num = 0;
-		frame->sample_aspect_ratio.den = 1;
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 134, 100)
-		frame->crop_top = 0;
-		frame->crop_bottom = 0;
-		frame->crop_left = 0;
-		frame->crop_right = 0;
-#endif
-		
-		// Return to pool
-		availableFrames.push(frame);
-	} else {
-		// Pool is full, free the frame
-		av_frame_free(&frame);
-		totalAllocated--;
+FrameBufferPool::Stats FrameBufferPool::getStats() const {
+	Stats stats;
+	if (!state) {
+		return stats;
 	}
+	stats.hits = state->hits.load(std::memory_order_relaxed);
+	stats.misses = state->misses.load(std::memory_order_relaxed);
+	stats.trimmed = state->trimmed.load(std::memory_order_relaxed);
+	stats.inUse = state->inUse.load(std::memory_order_relaxed);
+	stats.highWater = state->highWater.load(std::memory_order_relaxed);
+	stats.allocated = state->allocated.load(std::memory_order_relaxed);
+	stats.target = state->target.load(std::memory_order_relaxed);
+	return stats;
 }
 
 } // namespace utils
\ No newline at end of file
@@ -1,17 +1,39 @@
 #pragma once
 
 #include "media/MediaTypes.h"
-#include <queue>
-#include <mutex>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace utils {
 
-// Forward declaration
-class FramePoolDeleter;
-
+/**
+ * Pool of equally sized video frames.
+ *
+ * Free frames sit on a lock-free stack, so getFrame() and the release of a
+ * frame take no lock once the pool is warm. Each pooled frame also carries
+ * the storage for its shared_ptr control block, so handing out a frame
+ * allocates nothing.
+ *
+ * The pool keeps as many frames as were in use at once during the last
+ * window of requests (at least the initial poolSize). Frames released above
+ * that are freed, so the pool follows the pipeline depth instead of a fixed
+ * size.
+ *
+ * Frames may outlive the pool; the shared state goes away with the last one.
+ */
 class FrameBufferPool {
 public:
+	struct Stats {
+		uint64_t hits = 0;          // frames reused from the pool
+		uint64_t misses = 0;        // frames that had to be allocated
+		uint64_t trimmed = 0;       // frames freed because the pool was above its target
+		size_t inUse = 0;           // frames handed out and not yet released
+		size_t highWater = 0;       // most frames in use at once
+		size_t allocated = 0;       // frames currently owned (in use + free)
+		size_t target = 0;          // frames the pool currently keeps
+	};
+	
 	FrameBufferPool() = default;
 	FrameBufferPool(int width, int height, AVPixelFormat format,
 		size_t poolSize = 10);
@@ -26,24 +48,28 @@ public:
 	FrameBufferPool(const FrameBufferPool&) = delete;
 	FrameBufferPool& operator=(const FrameBufferPool&) = delete;
 	
+	// Thread-safe
 	std::shared_ptr<AVFrame> getFrame();
-	void returnFrame(AVFrame* frame);
+	
+	Stats getStats() const;
 	
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
 	AVPixelFormat getFormat() const { return format; }
-	
+
 private:
-	AVFrame* createFrame();
+	struct Node;
+	struct State;
+	template<typename T> class NodeAllocator;
+	
+	// Drop the pool's reference to the shared state
+	void close();
 	
 	int width = 0;
 	int height = 0;
 	AVPixelFormat format = AV_PIX_FMT_NONE;
-	size_t poolSize = 10;
 	
-	std::queue<AVFrame*> availableFrames;
-	mutable std::mutex poolMutex;
-	size_t totalAllocated = 0;
+	State* state = nullptr;     // shared with the frames in use
 };
 
 } // namespace utils
\ No newline at end of file
@@ -1,7 +1,323 @@
 #include "utils/Logger.h"
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
 
 namespace utils {
 
 std::atomic<Logger::Level> Logger::currentLevel{Logger::INFO};
 
+namespace {
+
+std::atomic<Logger::Format> outputFormat{Logger::TEXT};
+
+// Small per-thread ID for the JSON output
+uint32_t threadId() {
+	static std::atomic<uint32_t> nextId{1};
+	thread_local uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+	return id;
+}
+
+// One queued message; the text follows the struct in the same allocation
+struct Record {
+	std::atomic<Record*> next{nullptr};
+	Logger::Level level = Logger::INFO;
+	std::chrono::system_clock::time_point time;
+	uint32_t thread = 0;
+	uint32_t length = 0;
+	
+	std::string_view text() const {
+		return std::string_view(reinterpret_cast<const char*>(this + 1), length);
+	}
+	
+	static Record* create(Logger::Level level, std::string_view message) {
+		void* memory = ::operator new(sizeof(Record) + message.size());
+		Record* record = new (memory) Record();
+		record->level = level;
+		record->time = std::chrono::system_clock::now();
+		record->thread = threadId();
+		record->length = static_cast<uint32_t>(message.size());
+		message.copy(reinterpret_cast<char*>(record + 1), message.size());
+		return record;
+	}
+	
+	static void destroy(Record* record) {
+		record->~Record();
+		::operator delete(record);
+	}
+};
+
+/**
+ * Intrusive multi-producer single-consumer queue (Vyukov). push() is one
+ * exchange and one store; pop() may return nullptr while a producer is
+ * between the two, in which case the record shows up on the next pop.
+ */
+class RecordQueue {
+public:
+	RecordQueue() : head(&stub), tail(&stub) {}
+	
+	void push(Record* record) {
+		record->next.store(nullptr, std::memory_order_relaxed);
+		Record* previous = head.exchange(record, std::memory_order_acq_rel);
+		previous->next.store(record, std::memory_order_release);
+	}
+	
+	// Consumer only
+	Record* pop() {
+		Record* first = tail;
+		Record* next = first->next.load(std::memory_order_acquire);
+		if (first == &stub) {
+			if (!next) {
+				return nullptr;
+			}
+			tail = first = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+		if (next) {
+			tail = next;
+			return first;
+		}
+		if (first != head.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		// Last record: put the stub behind it so it can be unlinked
+		push(&stub);
+		next = first->next.load(std::memory_order_acquire);
+		if (next) {
+			tail = next;
+			return first;
+		}
+		return nullptr;
+	}
+
+private:
+	std::atomic<Record*> head;
+	Record* tail;
+	Record stub;
+};
+
+const char* levelName(Logger::Level level) {
+	switch (level) {
+		case Logger::ERROR: return "ERROR";
+		case Logger::WARN: return "WARN";
+		case Logger::INFO: return "INFO";
+		default: return "DEBUG";
+	}
+}
+
+const char* levelNameLower(Logger::Level level) {
+	switch (level) {
+		case Logger::ERROR: return "error";
+		case Logger::WARN: return "warn";
+		case Logger::INFO: return "info";
+		default: return "debug";
+	}
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+	static const char* hex = "0123456789abcdef";
+	out.push_back('"');
+	for (char c : text) {
+		switch (c) {
+			case '"': out.append("\\\""); break;
+			case '\\': out.append("\\\\"); break;
+			case '\n': out.append("\\n"); break;
+			case '\r': out.append("\\r"); break;
+			case '\t': out.append("\\t"); break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					out.append("\\u00");
+					out.push_back(hex[(c >> 4) & 0xf]);
+					out.push_back(hex[c & 0xf]);
+				} else {
+					out.push_back(c);
+				}
+		}
+	}
+	out.push_back('"');
+}
+
+// Formats one line of output; timestamps are formatted once per second
+class LineFormatter {
+public:
+	void append(std::string& out, Logger::Level level, std::chrono::system_clock::time_point time,
+		uint32_t thread, std::string_view message) {
+		std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+		Logger::Format format = outputFormat.load(std::memory_order_relaxed);
+		if (seconds != cachedSeconds || format != cachedFormat) {
+			formatSeconds(seconds, format);
+		}
+		
+		if (format == Logger::JSON) {
+			auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+				time.time_since_epoch()).count() % 1000;
+			char fraction[8];
+			std::snprintf(fraction, sizeof(fraction), ".%03dZ", static_cast<int>(millis));
+			out.append("{\"time\":\"").append(cachedTime).append(fraction);
+			out.append("\",\"level\":\"").append(levelNameLower(level));
+			out.append("\",\"thread\":").append(std::to_string(thread));
+			out.append(",\"message\":");
+			appendJsonString(out, message);
+			out.append("}\n");
+		} else {
+			out.append("[").append(cachedTime).append("] [").append(levelName(level)).append("] ");
+			out.append(message).append("\n");
+		}
+	}
+
+private:
+	void formatSeconds(std::time_t seconds, Logger::Format format) {
+		std::tm parts{};
+		bool utc = format == Logger::JSON;
+#ifdef _WIN32
+		utc ? gmtime_s(&parts, &seconds) : localtime_s(&parts, &seconds);
+#else
+		utc ? gmtime_r(&seconds, &parts) : localtime_r(&seconds, &parts);
+#endif
+		char text[32];
+		size_t length = std::strftime(text, sizeof(text), utc ? "%Y-%m-%dT%H:%M:%S" : "%Y-%m-%d %H:%M:%S", &parts);
+		cachedTime.assign(text, length);
+		cachedSeconds = seconds;
+		cachedFormat = format;
+	}
+	
+	std::time_t cachedSeconds = -1;
+	Logger::Format cachedFormat = Logger::TEXT;
+	std::string cachedTime;
+};
+
+// Set once the writer has been destroyed at exit; later messages are
+// written directly
+std::atomic<bool> writerGone{false};
+
+class LogWriter {
+public:
+	static LogWriter* get() {
+		static LogWriter instance;
+		return writerGone.load(std::memory_order_acquire) ? nullptr : &instance;
+	}
+	
+	void push(Record* record) {
+		queue.push(record);
+		pushed.fetch_add(1, std::memory_order_release);
+		pushed.notify_one();
+	}
+	
+	void flush() {
+		uint64_t target = pushed.load(std::memory_order_acquire);
+		uint64_t done = written.load(std::memory_order_acquire);
+		while (done < target) {
+			written.wait(done, std::memory_order_acquire);
+			done = written.load(std::memory_order_acquire);
+		}
+	}
+	
+	~LogWriter() {
+		writerGone.store(true, std::memory_order_release);
+		stopping.store(true, std::memory_order_release);
+		// Change the counter so the writer's wait returns
+		pushed.fetch_add(1, std::memory_order_release);
+		pushed.notify_one();
+		thread.join();
+	}
+
+private:
+	LogWriter() : thread(&LogWriter::run, this) {}
+	
+	void run() {
+		while (true) {
+			uint64_t seen = pushed.load(std::memory_order_acquire);
+			drain();
+			if (stopping.load(std::memory_order_acquire)) {
+				drain();
+				return;
+			}
+			pushed.wait(seen, std::memory_order_acquire);
+		}
+	}
+	
+	// Write everything queued; stdout is flushed once per batch, and before
+	// any error so the two streams stay in order on a terminal
+	void drain() {
+		uint64_t count = 0;
+		while (Record* record = queue.pop()) {
+			if (record->level == Logger::ERROR) {
+				writeOut();
+				errorLine.clear();
+				formatter.append(errorLine, record->level, record->time, record->thread, record->text());
+				std::cerr.write(errorLine.data(), static_cast<std::streamsize>(errorLine.size()));
+				std::cerr.flush();
+			} else {
+				formatter.append(batch, record->level, record->time, record->thread, record->text());
+				if (batch.size() >= 64 * 1024) {
+					writeOut();
+				}
+			}
+			Record::destroy(record);
+			count++;
+		}
+		writeOut();
+		if (count > 0) {
+			written.fetch_add(count, std::memory_order_release);
+			written.notify_all();
+		}
+	}
+	
+	void writeOut() {
+		if (!batch.empty()) {
+			std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+			std::cout.flush();
+			batch.clear();
+		}
+	}
+	
+	RecordQueue queue;
+	std::atomic<uint64_t> pushed{0};
+	std::atomic<uint64_t> written{0};
+	std::atomic<bool> stopping{false};
+	
+	// Writer thread only
+	LineFormatter formatter;
+	std::string batch;
+	std::string errorLine;
+	
+	std::thread thread;
+};
+
+}
+
+void Logger::setFormat(Format format) {
+	outputFormat.store(format, std::memory_order_relaxed);
+}
+
+void Logger::flush() {
+	if (LogWriter* writer = LogWriter::get()) {
+		writer->flush();
+	}
+}
+
+std::string& Logger::threadBuffer() {
+	thread_local std::string buffer;
+	return buffer;
+}
+
+void Logger::submit(Level level, std::string_view message) {
+	if (LogWriter* writer = LogWriter::get()) {
+		writer->push(Record::create(level, message));
+		return;
+	}
+	
+	// Logged from a static destructor after the writer stopped
+	static std::mutex lateMutex;
+	std::lock_guard<std::mutex> lock(lateMutex);
+	std::string line;
+	LineFormatter().append(line, level, std::chrono::system_clock::now(), threadId(), message);
+	std::ostream& stream = level == ERROR ? std::cerr : std::cout;
+	stream.write(line.data(), static_cast<std::streamsize>(line.size()));
+	stream.flush();
+}
+
 } // namespace utils
\ No newline at end of file
@@ -1,14 +1,27 @@
 #pragma once
 
-#include <string>
-#include <iostream>
-#include <sstream>
-#include <chrono>
-#include <iomanip>
 #include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace utils {
 
+/**
+ * Asynchronous logger.
+ *
+ * The calling thread formats the message into a thread-local buffer and
+ * pushes it onto a lock-free queue; a background thread adds the timestamp
+ * and writes it to stdout (errors to stderr), flushing once per batch rather
+ * than once per line. A level that is filtered out costs one branch.
+ *
+ * Format strings use {} placeholders and must be string literals: the number
+ * of placeholders is checked against the number of arguments at compile time.
+ */
 class Logger {
 public:
 	enum Level {
@@ -18,75 +31,136 @@ public:
 		DEBUG = 3
 	};
 	
+	enum Format {
+		TEXT,   // [2024-01-01 12:00:00] [INFO] message
+		JSON    // {"time":"2024-01-01T12:00:00.000Z","level":"info","thread":1,"message":"..."}
+	};
+	
+	// A format string whose {} count matches Args, checked when compiled
+	template<typename... Args>
+	class FormatString {
+	public:
+		template<size_t N>
+		consteval FormatString(const char (&text)[N]) : text(text, N - 1) {
+			if (countPlaceholders(this->text) != sizeof...(Args)) {
+				placeholderCountDoesNotMatchArguments();
+			}
+		}
+		
+		std::string_view get() const { return text; }
+	
+	private:
+		static consteval size_t countPlaceholders(std::string_view text) {
+			size_t count = 0;
+			for (size_t pos = text.find("{}"); pos != std::string_view::npos; pos = text.find("{}", pos + 2)) {
+				count++;
+			}
+			return count;
+		}
+		
+		// Not constexpr: reaching it fails the consteval constructor
+		static void placeholderCountDoesNotMatchArguments() {}
+		
+		std::string_view text;
+	};
+	
+	template<typename... Args>
+	using Format_t = FormatString<std::type_identity_t<Args>...>;
+	
 	static void setLevel(Level level) {
-		currentLevel = level;
+		currentLevel.store(level, std::memory_order_relaxed);
 	}
 	
-	template<typename... Args>
-	static void error(const std::string& format, Args... args) {
-		log(ERROR, "ERROR", format, args...);
+	static bool isEnabled(Level level) {
+		return level <= currentLevel.load(std::memory_order_relaxed);
 	}
 	
+	static void setFormat(Format format);
+	
+	// Block until every message logged so far has been written
+	static void flush();
+	
+	// Errors are flushed before returning, so they are on screen even if the
+	// process exits or aborts right after
 	template<typename... Args>
-	static void warn(const std::string& format, Args... args) {
-		log(WARN, "WARN", format, args...);
+	static void error(Format_t<Args...> format, const Args&... args) {
+		if (isEnabled(ERROR)) {
+			log(ERROR, format.get(), args...);
+			flush();
+		}
 	}
 	
 	template<typename... Args>
-	static void info(const std::string& format, Args... args) {
-		log(INFO, "INFO", format, args...);
+	static void warn(Format_t<Args...> format, const Args&... args) {
+		if (isEnabled(WARN)) {
+			log(WARN, format.get(), args...);
+		}
 	}
 	
 	template<typename... Args>
-	static void debug(const std::string& format, Args... args) {
-		log(DEBUG, "DEBUG", format, args...);
+	static void info(Format_t<Args...> format, const Args&... args) {
+		if (isEnabled(INFO)) {
+			log(INFO, format.get(), args...);
+		}
 	}
 	
+	template<typename... Args>
+	static void debug(Format_t<Args...> format, const Args&... args) {
+		if (isEnabled(DEBUG)) {
+			log(DEBUG, format.get(), args...);
+		}
+	}
+
 private:
 	static std::atomic<Level> currentLevel;
 	
+	// Formatted message of the calling thread, reused between calls
+	static std::string& threadBuffer();
+	
+	// Queue a formatted message for the writer thread
+	static void submit(Level level, std::string_view message);
+	
 	template<typename... Args>
-	static void log(Level level, const std::string& levelStr,
-		const std::string& format, Args... args) {
-		
-		if (level > currentLevel) {
-			return;
-		}
-		
-		auto now = std::chrono::system_clock::now();
-		auto time_t = std::chrono::system_clock::to_time_t(now);
-		
-		std::stringstream ss;
-		ss << "[" << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S") << "] ";
-		ss << "[" << levelStr << "] ";
-		
-		// Simple format string replacement
-		std::string message = format;
-		size_t argIndex = 0;
-		((replaceFirst(message, "{}", toString(args)), ++argIndex), ...);
-		
-		ss << message;
-		
-		if (level == ERROR) {
-			std::cerr << ss.str() << std::endl;
-		} else {
-			std::cout << ss.str() << std::endl;
-		}
+	static void log(Level level, std::string_view format, const Args&... args) {
+		std::string& message = threadBuffer();
+		message.clear();
+		size_t pos = 0;
+		(appendArgument(message, format, pos, args), ...);
+		message.append(format.substr(pos));
+		submit(level, message);
 	}
 	
-	static void replaceFirst(std::string& str, const std::string& from,
-		const std::string& to) {
-		size_t pos = str.find(from);
-		if (pos != std::string::npos) {
-			str.replace(pos, from.length(), to);
-		}
+	template<typename T>
+	static void appendArgument(std::string& out, std::string_view format, size_t& pos, const T& value) {
+		size_t placeholder = format.find("{}", pos);
+		out.append(format.substr(pos, placeholder - pos));
+		appendValue(out, value);
+		pos = placeholder + 2;
 	}
 	
 	template<typename T>
-	static std::string toString(const T& value) {
-		std::stringstream ss;
-		ss << value;
-		return ss.str();
+	static void appendValue(std::string& out, const T& value) {
+		if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+			out.append(std::string_view(value));
+		} else if constexpr (std::is_same_v<T, bool>) {
+			out.push_back(value ? '1' : '0');
+		} else if constexpr (std::is_same_v<T, char>) {
+			out.push_back(value);
+		} else if constexpr (std::is_integral_v<T>) {
+			char digits[24];
+			auto result = std::to_chars(digits, digits + sizeof(digits), value);
+			out.append(digits, result.ptr);
+		} else if constexpr (std::is_floating_point_v<T>) {
+			// Same as the default stream formatting
+			char digits[32];
+			int length = std::snprintf(digits, sizeof(digits), "%g", static_cast<double>(value));
+			out.append(digits, static_cast<size_t>(length));
+		} else {
+			thread_local std::ostringstream stream;
+			stream.str(std::string());
+			stream << value;
+			out.append(stream.str());
+		}
 	}
 };
 
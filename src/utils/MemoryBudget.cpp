@@ -0,0 +1,230 @@
+#include "utils/MemoryBudget.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace utils {
+
+namespace {
+
+void updateMax(std::atomic<uint64_t>& value, uint64_t candidate) {
+	uint64_t current = value.load(std::memory_order_relaxed);
+	while (candidate > current &&
+		!value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+	}
+}
+
+const char* kindName(MemoryBudget::Kind kind) {
+	switch (kind) {
+		case MemoryBudget::CACHE: return "cache";
+		case MemoryBudget::QUEUE: return "queue";
+		case MemoryBudget::DECODER: return "decoder";
+		default: return "fixed";
+	}
+}
+
+double megabytes(uint64_t bytes) {
+	return bytes / (1024.0 * 1024.0);
+}
+
+}
+
+struct MemoryBudget::Entry {
+	Entry(const std::string& name, Kind kind) : name(name), kind(kind) {}
+	
+	const std::string name;
+	const Kind kind;
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> reclaimableBytes{0};
+	std::atomic<uint64_t> peakBytes{0};
+	std::atomic<uint64_t> releasedBytes{0};
+};
+
+MemoryBudget& MemoryBudget::getInstance() {
+	// Never destroyed: frame pools released by static destructors at exit
+	// still take their usage off the budget
+	static MemoryBudget* instance = new MemoryBudget();
+	return *instance;
+}
+
+void MemoryBudget::setLimit(uint64_t bytes) {
+	limit.store(bytes, std::memory_order_relaxed);
+}
+
+bool MemoryBudget::hasRoomFor(uint64_t bytes) const {
+	uint64_t max = getLimit();
+	return max == 0 || getUsage() + bytes <= max;
+}
+
+MemoryBudget::Entry* MemoryBudget::entryFor(const std::string& name, Kind kind) {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (const auto& entry : entries) {
+		if (entry->name == name && entry->kind == kind) {
+			return entry.get();
+		}
+	}
+	entries.push_back(std::make_unique<Entry>(name, kind));
+	return entries.back().get();
+}
+
+void MemoryBudget::apply(Entry& entry, int64_t bytes, int64_t reclaimableBytes) {
+	if (bytes != 0) {
+		uint64_t held = entry.bytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed) + bytes;
+		updateMax(entry.peakBytes, held);
+		uint64_t total = totalBytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed) + bytes;
+		updateMax(peakBytes, total);
+	}
+	if (reclaimableBytes != 0 && entry.kind != FIXED) {
+		entry.reclaimableBytes.fetch_add(static_cast<uint64_t>(reclaimableBytes), std::memory_order_relaxed);
+		reclaimableByKind[entry.kind].fetch_add(static_cast<uint64_t>(reclaimableBytes), std::memory_order_relaxed);
+	}
+}
+
+uint64_t MemoryBudget::share(uint64_t limit, uint64_t total, const std::array<uint64_t, KINDS>& reclaimableByKind,
+	Kind kind, uint64_t reclaimable) {
+	if (limit == 0 || total <= limit || kind == FIXED || reclaimable == 0) {
+		return 0;
+	}
+	
+	// Earlier kinds give back what they can first
+	uint64_t excess = total - limit;
+	for (int earlier = 0; earlier < kind; earlier++) {
+		if (reclaimableByKind[earlier] >= excess) {
+			return 0;
+		}
+		excess -= reclaimableByKind[earlier];
+	}
+	
+	// The rest is split between the consumers of this kind by what each
+	// could give back
+	uint64_t ofKind = std::max(reclaimableByKind[kind], reclaimable);
+	uint64_t kindShare = std::min(excess, ofKind);
+	double fraction = static_cast<double>(reclaimable) / static_cast<double>(ofKind);
+	return std::min(reclaimable, std::max<uint64_t>(1, static_cast<uint64_t>(kindShare * fraction)));
+}
+
+uint64_t MemoryBudget::pressureOn(const Entry& entry) const {
+	uint64_t max = limit.load(std::memory_order_relaxed);
+	uint64_t total = totalBytes.load(std::memory_order_relaxed);
+	if (max == 0 || total <= max) {
+		return 0;
+	}
+	
+	std::array<uint64_t, KINDS> reclaimable;
+	for (int kind = 0; kind < KINDS; kind++) {
+		reclaimable[kind] = reclaimableByKind[kind].load(std::memory_order_relaxed);
+	}
+	return share(max, total, reclaimable, entry.kind, entry.reclaimableBytes.load(std::memory_order_relaxed));
+}
+
+std::vector<MemoryBudget::Usage> MemoryBudget::getUsageByConsumer() const {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	std::vector<Usage> usage;
+	usage.reserve(entries.size());
+	for (const auto& entry : entries) {
+		Usage item;
+		item.name = entry->name;
+		item.kind = entry->kind;
+		item.bytes = entry->bytes.load(std::memory_order_relaxed);
+		item.reclaimableBytes = entry->reclaimableBytes.load(std::memory_order_relaxed);
+		item.peakBytes = entry->peakBytes.load(std::memory_order_relaxed);
+		item.releasedBytes = entry->releasedBytes.load(std::memory_order_relaxed);
+		usage.push_back(std::move(item));
+	}
+	return usage;
+}
+
+void MemoryBudget::printReport() const {
+	std::vector<Usage> usage = getUsageByConsumer();
+	if (usage.empty()) {
+		return;
+	}
+	
+	uint64_t max = getLimit();
+	std::cout << "\n=== Memory Budget (limit: "
+			  << (max > 0 ? std::to_string(max / (1024 * 1024)) + " MB" : std::string("unlimited")) << ") ===\n";
+	std::cout << std::setw(32) << std::left << "Consumer"
+			  << std::setw(10) << "Kind"
+			  << std::setw(14) << std::right << "Current (MB)"
+			  << std::setw(12) << "Peak (MB)"
+			  << std::setw(15) << "Released (MB)" << "\n";
+	std::cout << std::string(83, '-') << "\n";
+	
+	for (const auto& item : usage) {
+		std::cout << std::setw(32) << std::left << item.name
+				  << std::setw(10) << kindName(item.kind)
+				  << std::setw(14) << std::right << std::fixed << std::setprecision(1) << megabytes(item.bytes)
+				  << std::setw(12) << megabytes(item.peakBytes)
+				  << std::setw(15) << megabytes(item.releasedBytes) << "\n";
+	}
+	std::cout << std::string(83, '-') << "\n";
+	std::cout << std::setw(42) << std::left << "Total"
+			  << std::setw(14) << std::right << megabytes(getUsage())
+			  << std::setw(12) << megabytes(getPeakUsage()) << "\n";
+}
+
+MemoryBudget::Consumer::Consumer(const std::string& name, Kind kind)
+	: entry(MemoryBudget::getInstance().entryFor(name, kind)) {
+}
+
+MemoryBudget::Consumer::~Consumer() {
+	reset();
+}
+
+MemoryBudget::Consumer::Consumer(Consumer&& other) noexcept
+	: entry(other.entry)
+	, bytes(other.bytes.exchange(0, std::memory_order_relaxed))
+	, reclaimableBytes(other.reclaimableBytes.exchange(0, std::memory_order_relaxed)) {
+	other.entry = nullptr;
+}
+
+MemoryBudget::Consumer& MemoryBudget::Consumer::operator=(Consumer&& other) noexcept {
+	if (this != &other) {
+		reset();
+		entry = other.entry;
+		bytes.store(other.bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		reclaimableBytes.store(other.reclaimableBytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		other.entry = nullptr;
+	}
+	return *this;
+}
+
+void MemoryBudget::Consumer::reset() {
+	if (entry) {
+		MemoryBudget::getInstance().apply(*entry,
+			-static_cast<int64_t>(bytes.exchange(0, std::memory_order_relaxed)),
+			-static_cast<int64_t>(reclaimableBytes.exchange(0, std::memory_order_relaxed)));
+		entry = nullptr;
+	}
+}
+
+void MemoryBudget::Consumer::add(int64_t deltaBytes, int64_t deltaReclaimable) {
+	if (!entry) {
+		return;
+	}
+	bytes.fetch_add(static_cast<uint64_t>(deltaBytes), std::memory_order_relaxed);
+	reclaimableBytes.fetch_add(static_cast<uint64_t>(deltaReclaimable), std::memory_order_relaxed);
+	MemoryBudget::getInstance().apply(*entry, deltaBytes, deltaReclaimable);
+}
+
+void MemoryBudget::Consumer::set(uint64_t newBytes, uint64_t newReclaimable) {
+	if (!entry) {
+		return;
+	}
+	uint64_t oldBytes = bytes.exchange(newBytes, std::memory_order_relaxed);
+	uint64_t oldReclaimable = reclaimableBytes.exchange(newReclaimable, std::memory_order_relaxed);
+	MemoryBudget::getInstance().apply(*entry, static_cast<int64_t>(newBytes - oldBytes),
+		static_cast<int64_t>(newReclaimable - oldReclaimable));
+}
+
+uint64_t MemoryBudget::Consumer::pressure() const {
+	return entry ? MemoryBudget::getInstance().pressureOn(*entry) : 0;
+}
+
+void MemoryBudget::Consumer::released(uint64_t releasedBytes) {
+	if (entry) {
+		entry->releasedBytes.fetch_add(releasedBytes, std::memory_order_relaxed);
+	}
+}
+
+} // namespace utils
\ No newline at end of file
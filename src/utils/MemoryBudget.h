@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Process-wide memory budget shared by frame pools, caches, queues and
+ * decoders.
+ *
+ * How much memory a render needs depends on the EDL: how many decoders are
+ * open, how deep the queues run, what the caches hold. Each of these
+ * registers a Consumer and reports the bytes it holds and how many of them it
+ * could give back. Once the total passes the limit (--max-memory), the
+ * excess is asked back from caches first, then queues, then decoders;
+ * consumers poll pressure() at points where shrinking is safe and give back
+ * what they can. The budget never blocks or fails an allocation.
+ *
+ * Without a limit it only keeps the per-consumer usage for the report.
+ */
+class MemoryBudget {
+public:
+	// Shrink order: all CACHE bytes are asked back before any QUEUE bytes,
+	// and so on. FIXED consumers are counted but never asked.
+	enum Kind {
+		CACHE = 0,
+		QUEUE = 1,
+		DECODER = 2,
+		FIXED = 3
+	};
+	
+	static constexpr int KINDS = 4;
+	
+	// Usage of the consumers sharing one name
+	struct Usage {
+		std::string name;
+		Kind kind = FIXED;
+		uint64_t bytes = 0;
+		uint64_t reclaimableBytes = 0;
+		uint64_t peakBytes = 0;
+		uint64_t releasedBytes = 0;     // Given back under pressure
+	};
+
+private:
+	struct Entry;
+
+public:
+	/**
+	 * Registration of one consumer. Consumers with the same name are reported
+	 * and asked together, e.g. every frame pool. Moving is allowed, copying is
+	 * not; destroying the handle takes its usage off the budget.
+	 *
+	 * add(), pressure() and released() are lock-free and may be called from
+	 * any thread.
+	 */
+	class Consumer {
+	public:
+		Consumer() = default;
+		Consumer(const std::string& name, Kind kind);
+		~Consumer();
+		
+		Consumer(Consumer&& other) noexcept;
+		Consumer& operator=(Consumer&& other) noexcept;
+		
+		Consumer(const Consumer&) = delete;
+		Consumer& operator=(const Consumer&) = delete;
+		
+		// Change the bytes held and the part of them that could be given back
+		void add(int64_t bytes, int64_t reclaimableBytes = 0);
+		
+		// Replace both numbers
+		void set(uint64_t bytes, uint64_t reclaimableBytes);
+		
+		/**
+		 * Bytes the consumers of this name should give back now, 0 while the
+		 * budget holds or earlier kinds can cover the excess
+		 */
+		uint64_t pressure() const;
+		
+		// Record bytes given back because of pressure (for the report)
+		void released(uint64_t bytes);
+		
+		uint64_t getBytes() const { return bytes.load(std::memory_order_relaxed); }
+	
+	private:
+		void reset();
+		
+		Entry* entry = nullptr;
+		std::atomic<uint64_t> bytes{0};
+		std::atomic<uint64_t> reclaimableBytes{0};
+	};
+	
+	/**
+	 * Get the singleton instance of the budget
+	 */
+	static MemoryBudget& getInstance();
+	
+	// Byte limit for all consumers together, 0 = unlimited
+	void setLimit(uint64_t bytes);
+	uint64_t getLimit() const { return limit.load(std::memory_order_relaxed); }
+	
+	uint64_t getUsage() const { return totalBytes.load(std::memory_order_relaxed); }
+	uint64_t getPeakUsage() const { return peakBytes.load(std::memory_order_relaxed); }
+	
+	// True if bytes more would still fit within the limit
+	bool hasRoomFor(uint64_t bytes) const;
+	
+	// Usage per consumer name, in order of registration
+	std::vector<Usage> getUsageByConsumer() const;
+	
+	// Per-consumer table for the verbose timing report
+	void printReport() const;
+	
+	// Bytes the consumers of kind and entry share should give back, given the
+	// current usage (exposed for the tests)
+	static uint64_t share(uint64_t limit, uint64_t total, const std::array<uint64_t, KINDS>& reclaimableByKind,
+		Kind kind, uint64_t reclaimable);
+
+private:
+	// Private constructor for singleton
+	MemoryBudget() = default;
+	
+	// Delete copy constructor and assignment operator
+	MemoryBudget(const MemoryBudget&) = delete;
+	MemoryBudget& operator=(const MemoryBudget&) = delete;
+	
+	Entry* entryFor(const std::string& name, Kind kind);
+	void apply(Entry& entry, int64_t bytes, int64_t reclaimableBytes);
+	uint64_t pressureOn(const Entry& entry) const;
+	
+	std::atomic<uint64_t> limit{0};
+	std::atomic<uint64_t> totalBytes{0};
+	std::atomic<uint64_t> peakBytes{0};
+	std::array<std::atomic<uint64_t>, KINDS> reclaimableByKind{};
+	
+	// Entries are never removed, so consumers keep plain pointers to them
+	mutable std::mutex registryMutex;
+	std::vector<std::unique_ptr<Entry>> entries;
+};
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "utils/ThreadBudget.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <thread>
+
+namespace utils {
+
+int ThreadBudget::hardwareThreads() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadBudget::Allocation ThreadBudget::allocate(int totalThreads, int activeDecoders, bool hardwareEncode) {
+	Allocation result;
+	result.totalThreads = std::max(1, totalThreads);
+	activeDecoders = std::max(1, activeDecoders);
+	
+	// A software encoder is the most expensive stage, so it gets half of the
+	// budget, but never so much that decoders and compositor drop below one
+	// thread each. A hardware encoder only needs a thread to feed the GPU.
+	result.encoderThreads = hardwareEncode ? 1 :
+		std::max(1, std::min(result.totalThreads / 2, result.totalThreads - activeDecoders - 1));
+	
+	// Two thirds of the rest go to the decoders that run at the same time,
+	// and the compositor gets what is left
+	int remaining = std::max(0, result.totalThreads - result.encoderThreads);
+	int decoderTotal = std::max(activeDecoders, remaining * 2 / 3);
+	result.decoderThreads = std::max(1, decoderTotal / activeDecoders);
+	result.compositorThreads = std::max(1, remaining - result.decoderThreads * activeDecoders);
+	
+	return result;
+}
+
+ThreadBudget::Allocation ThreadBudget::configure(int maxThreads, int activeDecoders, bool hardwareEncode) {
+	int totalThreads = maxThreads > 0 ? maxThreads : hardwareThreads();
+	Allocation result = allocate(totalThreads, activeDecoders, hardwareEncode);
+	
+	utils::Logger::info("Thread budget: {} threads (decoders: {} x {}, encoder: {}, compositor: {})",
+		result.totalThreads, std::max(1, activeDecoders), result.decoderThreads,
+		result.encoderThreads, result.compositorThreads);
+	return result;
+}
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+namespace utils {
+
+/**
+ * Thread budget of a render, shared by its decoders, compositor and
+ * encoders.
+ *
+ * FFmpeg's automatic thread count sizes every codec context for the whole
+ * machine, so N decoders plus an encoder create N+1 full thread sets that
+ * compete for the same cores. The budget instead splits a fixed number of
+ * threads (the core count, or --threads) between the components, so the
+ * process as a whole stays within its share of the node.
+ */
+class ThreadBudget {
+public:
+	// Thread counts handed to each component
+	struct Allocation {
+		int totalThreads = 1;
+		int decoderThreads = 1;     // Per decoder
+		int encoderThreads = 1;
+		int compositorThreads = 1;  // Including the render thread itself
+	};
+	
+	/**
+	 * Split the budget of one render between the pipeline components. Renders
+	 * running side by side (daemon workers, batch jobs) each pass their own
+	 * share, so nothing is kept between calls.
+	 * @param maxThreads Thread limit for the render, 0 = all cores
+	 * @param activeDecoders Number of decoders that may be open at the same time
+	 * @param hardwareEncode Encoding runs on the GPU and needs little CPU
+	 * @return The allocation
+	 */
+	static Allocation configure(int maxThreads, int activeDecoders, bool hardwareEncode);
+	
+	/**
+	 * Pure allocation policy behind configure()
+	 */
+	static Allocation allocate(int totalThreads, int activeDecoders, bool hardwareEncode);
+	
+	/**
+	 * Number of hardware threads on this machine (at least 1)
+	 */
+	static int hardwareThreads();
+	
+	ThreadBudget() = delete;
+};
+
+} // namespace utils
\ No newline at end of file
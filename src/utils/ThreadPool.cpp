@@ -0,0 +1,113 @@
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <latch>
+
+namespace utils {
+
+ThreadPool::ThreadPool(int threads) {
+	for (int i = 1; i < threads; ++i) {
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::workerLoop() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+bool ThreadPool::runPendingTask() {
+	std::function<void()> task;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (tasks.empty()) {
+			return false;
+		}
+		task = std::move(tasks.front());
+		tasks.pop_front();
+	}
+	task();
+	return true;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int begin, int end)>& body, int minBand) {
+	if (count <= 0) {
+		return;
+	}
+	
+	int bands = std::min(getThreadCount(), (count + minBand - 1) / std::max(1, minBand));
+	if (bands <= 1) {
+		body(0, count);
+		return;
+	}
+	
+	auto bandStart = [count, bands](int band) {
+		return static_cast<int>(static_cast<int64_t>(count) * band / bands);
+	};
+	
+	// Queued bands refer to body and done on this stack frame, so every band
+	// must finish before this returns, even when one of them throws
+	std::latch done(bands - 1);
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	auto fail = [&errorMutex, &error]() {
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error) {
+			error = std::current_exception();
+		}
+	};
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int band = 1; band < bands; ++band) {
+			tasks.emplace_back([&body, &done, &fail, begin = bandStart(band), end = bandStart(band + 1)] {
+				try {
+					body(begin, end);
+				} catch (...) {
+					fail();
+				}
+				done.count_down();
+			});
+		}
+	}
+	taskAvailable.notify_all();
+	
+	try {
+		body(0, bandStart(1));
+	} catch (...) {
+		fail();
+	}
+	
+	// Help with queued bands instead of sleeping while workers are busy
+	while (runPendingTask()) {
+	}
+	done.wait();
+	
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+} // namespace utils
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Fixed-size worker pool. The thread calling parallelFor() takes part in the
+ * work, so a pool of N threads starts N-1 workers and a pool of one thread
+ * runs everything inline.
+ */
+class ThreadPool {
+public:
+	explicit ThreadPool(int threads = 1);
+	~ThreadPool();
+	
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	
+	// Number of threads working on a parallelFor(), including the caller
+	int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+	
+	/**
+	 * Split [0, count) into contiguous bands and run body(begin, end) on each,
+	 * returning when all bands are done
+	 * @param minBand Smallest band worth handing to another thread
+	 * @throws The first exception thrown by body, once every band has finished
+	 */
+	void parallelFor(int count, const std::function<void(int begin, int end)>& body, int minBand = 16);
+
+private:
+	void workerLoop();
+	bool runPendingTask();
+	
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	bool stopping = false;
+};
+
+} // namespace utils
\ No newline at end of file
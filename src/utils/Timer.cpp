@@ -0,0 +1,278 @@
+#include "utils/Timer.h"
+#include "utils/BenchmarkReport.h"
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace utils {
+
+// Counters of one zone on one thread. Only the owning thread writes, so the
+// updates are plain relaxed load/store pairs; the atomics only make the
+// concurrent reads in printReport() well defined.
+struct Timer::ZoneStats {
+	std::atomic<uint64_t> count{0};
+	std::atomic<uint64_t> totalNs{0};
+	std::atomic<uint64_t> minNs{0};
+	std::atomic<uint64_t> maxNs{0};
+	std::array<std::atomic<uint64_t>, StageHistogram::BUCKETS> buckets{};
+};
+
+struct Timer::TraceChunk {
+	static constexpr uint32_t CAPACITY = 4096;
+	
+	struct Event {
+		uint32_t zone;
+		int64_t startNs;
+		int64_t durationNs;
+	};
+	
+	std::array<Event, CAPACITY> events;
+	std::atomic<uint32_t> used{0};
+	std::atomic<TraceChunk*> next{nullptr};
+};
+
+struct Timer::ThreadBuffer {
+	explicit ThreadBuffer(int id) : id(id), name("thread " + std::to_string(id)) {}
+	
+	~ThreadBuffer() {
+		for (auto& stats : zones) {
+			delete stats.load(std::memory_order_relaxed);
+		}
+		TraceChunk* chunk = head.load(std::memory_order_relaxed);
+		while (chunk) {
+			TraceChunk* next = chunk->next.load(std::memory_order_relaxed);
+			delete chunk;
+			chunk = next;
+		}
+	}
+	
+	const int id;
+	std::string name;           // guarded by registryMutex
+	bool owned = true;          // guarded by registryMutex; false once its thread exited
+	std::array<std::atomic<ZoneStats*>, MAX_ZONES> zones{};
+	std::atomic<TraceChunk*> head{nullptr};  // set once, on the first trace event
+	TraceChunk* tail = nullptr; // owning thread only
+};
+
+// Hands the calling thread's buffer back when the thread exits, so threads
+// that come and go (render jobs, pools) do not add a buffer each
+struct Timer::BufferOwner {
+	ThreadBuffer* buffer = nullptr;
+	
+	~BufferOwner() {
+		if (buffer) {
+			Timer::getInstance().releaseThreadBuffer(*buffer);
+		}
+	}
+};
+
+Timer::Timer() : epoch(Clock::now()) {}
+
+Timer::~Timer() = default;
+
+uint32_t Timer::zone(const char* name) {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (uint32_t i = 0; i < zoneNames.size(); i++) {
+		if (zoneNames[i] == name) {
+			return i;
+		}
+	}
+	if (zoneNames.size() < MAX_ZONES - 1) {
+		zoneNames.emplace_back(name);
+		return static_cast<uint32_t>(zoneNames.size() - 1);
+	}
+	if (zoneNames.size() == MAX_ZONES - 1) {
+		zoneNames.emplace_back("(other zones)");
+	}
+	return MAX_ZONES - 1;
+}
+
+void Timer::setTracing(bool on) {
+	tracing.store(on, std::memory_order_relaxed);
+	if (on) {
+		setEnabled(true);
+	}
+}
+
+Timer::ThreadBuffer& Timer::threadBuffer() {
+	thread_local BufferOwner owner;
+	if (owner.buffer) {
+		return *owner.buffer;
+	}
+	
+	std::lock_guard<std::mutex> lock(registryMutex);
+	
+	// Take over the buffer of an exited thread; its counters keep adding up
+	// in the report. Buffers holding trace events stay with their thread, so
+	// the trace does not mix threads.
+	for (const auto& thread : threads) {
+		if (!thread->owned && !thread->head.load(std::memory_order_relaxed)) {
+			thread->owned = true;
+			thread->name = "thread " + std::to_string(thread->id);
+			owner.buffer = thread.get();
+			return *owner.buffer;
+		}
+	}
+	
+	threads.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(threads.size()) + 1));
+	owner.buffer = threads.back().get();
+	return *owner.buffer;
+}
+
+void Timer::releaseThreadBuffer(ThreadBuffer& buffer) {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	buffer.owned = false;
+}
+
+void Timer::record(uint32_t zone, int64_t startNs, int64_t durationNs) {
+	ThreadBuffer& buffer = threadBuffer();
+	uint64_t duration = static_cast<uint64_t>(std::max<int64_t>(durationNs, 0));
+	
+	ZoneStats* stats = buffer.zones[zone].load(std::memory_order_relaxed);
+	if (!stats) {
+		stats = new ZoneStats();
+		buffer.zones[zone].store(stats, std::memory_order_release);
+	}
+	
+	uint64_t count = stats->count.load(std::memory_order_relaxed);
+	if (count == 0 || duration < stats->minNs.load(std::memory_order_relaxed)) {
+		stats->minNs.store(duration, std::memory_order_relaxed);
+	}
+	if (duration > stats->maxNs.load(std::memory_order_relaxed)) {
+		stats->maxNs.store(duration, std::memory_order_relaxed);
+	}
+	stats->totalNs.store(stats->totalNs.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+	auto& bucket = stats->buckets[StageHistogram::bucketFor(duration * 1e-9)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	stats->count.store(count + 1, std::memory_order_relaxed);
+	
+	if (!tracing.load(std::memory_order_relaxed)) {
+		return;
+	}
+	
+	// Threads only get trace chunks once they trace
+	TraceChunk* chunk = buffer.tail;
+	if (!chunk) {
+		chunk = buffer.tail = new TraceChunk();
+		buffer.head.store(chunk, std::memory_order_release);
+	}
+	uint32_t used = chunk->used.load(std::memory_order_relaxed);
+	if (used == TraceChunk::CAPACITY) {
+		TraceChunk* next = new TraceChunk();
+		chunk->next.store(next, std::memory_order_release);
+		buffer.tail = chunk = next;
+		used = 0;
+	}
+	chunk->events[used] = {zone, startNs, durationNs};
+	chunk->used.store(used + 1, std::memory_order_release);
+}
+
+void Timer::addTiming(uint32_t zone, double seconds) {
+	if (!isEnabled()) {
+		return;
+	}
+	int64_t duration = static_cast<int64_t>(seconds * 1e9);
+	record(zone, now() - duration, duration);
+}
+
+void Timer::setThreadName(const std::string& name) {
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(registryMutex);
+	buffer.name = name;
+}
+
+void Timer::printReport() const {
+	std::map<std::string, StageHistogram> zones;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		std::array<uint64_t, StageHistogram::BUCKETS> buckets;
+		for (const auto& thread : threads) {
+			for (uint32_t zone = 0; zone < zoneNames.size(); zone++) {
+				const ZoneStats* stats = thread->zones[zone].load(std::memory_order_acquire);
+				if (!stats) {
+					continue;
+				}
+				for (int bucket = 0; bucket < StageHistogram::BUCKETS; bucket++) {
+					buckets[bucket] = stats->buckets[bucket].load(std::memory_order_relaxed);
+				}
+				zones[zoneNames[zone]].merge(buckets.data(), stats->count.load(std::memory_order_relaxed),
+					stats->totalNs.load(std::memory_order_relaxed) * 1e-9,
+					stats->minNs.load(std::memory_order_relaxed) * 1e-9,
+					stats->maxNs.load(std::memory_order_relaxed) * 1e-9);
+			}
+		}
+	}
+	if (zones.empty()) {
+		return;
+	}
+	
+	std::cout << "\n=== Performance Timing Report ===\n";
+	std::cout << std::setw(32) << std::left << "Operation"
+			  << std::setw(12) << std::right << "Total (s)"
+			  << std::setw(10) << "Count"
+			  << std::setw(11) << "Avg (ms)"
+			  << std::setw(11) << "p50 (ms)"
+			  << std::setw(11) << "p95 (ms)"
+			  << std::setw(11) << "p99 (ms)"
+			  << std::setw(11) << "Max (ms)" << "\n";
+	std::cout << std::string(109, '-') << "\n";
+	
+	for (const auto& [name, histogram] : zones) {
+		std::cout << std::setw(32) << std::left << name
+				  << std::setw(12) << std::right << std::fixed << std::setprecision(3) << histogram.getTotal()
+				  << std::setw(10) << histogram.getCount()
+				  << std::setw(11) << std::setprecision(2) << histogram.mean() * 1000.0
+				  << std::setw(11) << histogram.percentile(0.50) * 1000.0
+				  << std::setw(11) << histogram.percentile(0.95) * 1000.0
+				  << std::setw(11) << histogram.percentile(0.99) * 1000.0
+				  << std::setw(11) << histogram.getMax() * 1000.0 << "\n";
+	}
+	std::cout << std::string(109, '-') << "\n";
+	std::cout << "Percentiles are histogram bucket bounds (within 19%)\n";
+}
+
+bool Timer::writeTrace(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	
+	std::lock_guard<std::mutex> lock(registryMutex);
+	
+	// Escape every zone name once rather than per event
+	std::vector<std::string> quotedNames;
+	quotedNames.reserve(zoneNames.size());
+	for (const auto& name : zoneNames) {
+		quotedNames.push_back(nlohmann::json(name).dump());
+	}
+	
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << std::fixed << std::setprecision(3);
+	bool first = true;
+	for (const auto& thread : threads) {
+		file << (first ? "" : ",\n")
+			 << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id
+			 << ",\"args\":{\"name\":" << nlohmann::json(thread->name).dump() << "}}";
+		first = false;
+		
+		for (const TraceChunk* chunk = thread->head.load(std::memory_order_acquire); chunk;
+			chunk = chunk->next.load(std::memory_order_acquire)) {
+			uint32_t used = chunk->used.load(std::memory_order_acquire);
+			for (uint32_t i = 0; i < used; i++) {
+				const auto& event = chunk->events[i];
+				file << ",\n{\"name\":" << quotedNames[event.zone]
+					 << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+					 << ",\"ts\":" << event.startNs / 1000.0
+					 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+			}
+		}
+	}
+	file << "\n]}\n";
+	
+	return static_cast<bool>(file);
+}
+
+} // namespace utils
\ No newline at end of file
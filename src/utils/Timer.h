@@ -1,52 +1,54 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
-#include <iostream>
-#include <iomanip>
+#include <vector>
 
 namespace utils {
 
+/**
+ * Low-overhead instrumentation of named zones (TIME_BLOCK).
+ *
+ * Zone names are interned once per call site into small integer IDs. Every
+ * thread records into its own buffer: per-zone counters and a latency
+ * histogram, plus a trace event per zone entry when tracing is on. Only the
+ * owning thread writes a buffer, so recording takes no lock. A thread that
+ * exits leaves its buffer to the next new thread (unless it holds trace
+ * events), so the buffers do not grow with short-lived threads. The report and
+ * the trace export read the buffers with atomic loads and may run while
+ * other threads are still recording.
+ *
+ * Timing is off until setEnabled(true). While off, a TIME_BLOCK costs one
+ * relaxed atomic load.
+ */
 class Timer {
 public:
-	using Clock = std::chrono::high_resolution_clock;
-	using TimePoint = Clock::time_point;
-	using Duration = std::chrono::duration<double>;
-	
-	struct TimingResult {
-		double totalTime = 0.0;
-		int count = 0;
-		double minTime = std::numeric_limits<double>::max();
-		double maxTime = 0.0;
-		
-		void add(double time) {
-			totalTime += time;
-			count++;
-			minTime = std::min(minTime, time);
-			maxTime = std::max(maxTime, time);
-		}
-		
-		double average() const {
-			return count > 0 ? totalTime / count : 0.0;
-		}
-	};
+	using Clock = std::chrono::steady_clock;
+	
+	static constexpr uint32_t MAX_ZONES = 256;
 	
+	// Times the enclosing scope into a zone
 	class ScopedTimer {
 	public:
-		ScopedTimer(Timer& timer, const std::string& name)
-			: timer_(timer), name_(name), start_(Clock::now()) {}
+		explicit ScopedTimer(uint32_t zone)
+			: zone(zone), start(Timer::isEnabled() ? Timer::now() : -1) {}
 		
 		~ScopedTimer() {
-			auto end = Clock::now();
-			Duration elapsed = end - start_;
-			timer_.addTiming(name_, elapsed.count());
+			if (start >= 0) {
+				Timer::getInstance().record(zone, start, Timer::now() - start);
+			}
 		}
 		
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	
 	private:
-		Timer& timer_;
-		std::string name_;
-		TimePoint start_;
+		uint32_t zone;
+		int64_t start;
 	};
 	
 	static Timer& getInstance() {
@@ -54,48 +56,68 @@ public:
 		return instance;
 	}
 	
-	ScopedTimer scope(const std::string& name) {
-		return ScopedTimer(*this, name);
-	}
+	// ID of a zone, registering the name on first use. Names past MAX_ZONES
+	// share the last zone.
+	uint32_t zone(const char* name);
 	
-	void addTiming(const std::string& name, double seconds) {
-		results_[name].add(seconds);
-	}
+	static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+	void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
 	
-	void printReport() const {
-		if (results_.empty()) {
-			return;
-		}
-		
-		std::cout << "\n=== Performance Timing Report ===\n";
-		std::cout << std::setw(40) << std::left << "Operation"
-				  << std::setw(12) << std::right << "Total (s)"
-				  << std::setw(10) << "Count"
-				  << std::setw(12) << "Avg (ms)"
-				  << std::setw(12) << "Min (ms)"
-				  << std::setw(12) << "Max (ms)" << "\n";
-		std::cout << std::string(98, '-') << "\n";
-		
-		for (const auto& [name, result] : results_) {
-			std::cout << std::setw(40) << std::left << name
-					  << std::setw(12) << std::right << std::fixed << std::setprecision(3) << result.totalTime
-					  << std::setw(10) << result.count
-					  << std::setw(12) << std::setprecision(1) << result.average() * 1000.0
-					  << std::setw(12) << result.minTime * 1000.0
-					  << std::setw(12) << result.maxTime * 1000.0 << "\n";
-		}
-		std::cout << std::string(98, '-') << "\n";
-	}
+	// Keep a trace event for every zone entry (implies enabled)
+	void setTracing(bool on);
+	bool isTracing() const { return tracing.load(std::memory_order_relaxed); }
 	
-	void reset() {
-		results_.clear();
+	// Nanoseconds since the timer was created
+	static int64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - getInstance().epoch).count();
 	}
 	
+	// Record a zone entry that started at startNs (from now())
+	void record(uint32_t zone, int64_t startNs, int64_t durationNs);
+	
+	// Record a duration measured elsewhere, as if it ended now
+	void addTiming(uint32_t zone, double seconds);
+	
+	// Name shown for the calling thread in the trace
+	void setThreadName(const std::string& name);
+	
+	// Per-zone totals and p50/p95/p99 on stdout
+	void printReport() const;
+	
+	/**
+	 * Write the trace as Chrome trace-event JSON (chrome://tracing, Perfetto)
+	 * @return false if the file cannot be written
+	 */
+	bool writeTrace(const std::string& path) const;
+
 private:
-	std::map<std::string, TimingResult> results_;
+	struct ZoneStats;
+	struct TraceChunk;
+	struct ThreadBuffer;
+	struct BufferOwner;
+	
+	Timer();
+	~Timer();
+	
+	ThreadBuffer& threadBuffer();
+	void releaseThreadBuffer(ThreadBuffer& buffer);
+	
+	static inline std::atomic<bool> enabled{false};
+	std::atomic<bool> tracing{false};
+	const Clock::time_point epoch;
+	
+	mutable std::mutex registryMutex;
+	std::vector<std::string> zoneNames;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
 };
 
-// Convenience macro for timing a block
-#define TIME_BLOCK(name) utils::Timer::ScopedTimer _timer_##__LINE__(utils::Timer::getInstance(), name)
+#define TIMER_CONCAT_INNER(a, b) a##b
+#define TIMER_CONCAT(a, b) TIMER_CONCAT_INNER(a, b)
+
+// Time the rest of the enclosing block; name must be a string literal (or
+// otherwise fixed per call site), as it is interned on the first pass only
+#define TIME_BLOCK(name) \
+	static const uint32_t TIMER_CONCAT(_timer_zone_, __LINE__) = utils::Timer::getInstance().zone(name); \
+	utils::Timer::ScopedTimer TIMER_CONCAT(_timer_, __LINE__)(TIMER_CONCAT(_timer_zone_, __LINE__))
 
 } // namespace utils
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "BenchmarkFixtures.h"
+#include "media/FFmpegEncoder.h"
+#include "utils/Logger.h"
+#include <filesystem>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace bench {
+
+int widthFor(int height) {
+	return height * 16 / 9;
+}
+
+std::shared_ptr<AVFrame> makeFrame(int width, int height) {
+	AVFrame* frame = av_frame_alloc();
+	frame->width = width;
+	frame->height = height;
+	frame->format = AV_PIX_FMT_YUV420P;
+	if (av_frame_get_buffer(frame, 0) < 0) {
+		av_frame_free(&frame);
+		throw std::runtime_error("Failed to allocate benchmark frame");
+	}
+	
+	for (int y = 0; y < height; y++) {
+		uint8_t* row = frame->data[0] + y * frame->linesize[0];
+		for (int x = 0; x < width; x++) {
+			row[x] = static_cast<uint8_t>(16 + (x + y) * 219 / (width + height));
+		}
+	}
+	for (int plane = 1; plane < 3; plane++) {
+		for (int y = 0; y < height / 2; y++) {
+			uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+			for (int x = 0; x < width / 2; x++) {
+				row[x] = static_cast<uint8_t>(plane == 1 ? 64 + x * 128 / width : 192 - y * 128 / height);
+			}
+		}
+	}
+	
+	return std::shared_ptr<AVFrame>(frame, [](AVFrame* f) { av_frame_free(&f); });
+}
+
+nlohmann::json syntheticEDL(int clipCount) {
+	const double clipSeconds = 2.0;
+	nlohmann::json clips = nlohmann::json::array();
+	for (int i = 0; i < clipCount; i++) {
+		double start = i * clipSeconds;
+		double sourceIn = (i % 7) * 1.5;
+		clips.push_back({
+			{"in", start},
+			{"out", start + clipSeconds},
+			{"track", {{"type", "video"}, {"number", 1}}},
+			{"source", {
+				{"uri", "source_" + std::to_string(i % 16) + ".mp4"},
+				{"trackId", "V1"},
+				{"in", sourceIn},
+				{"out", sourceIn + clipSeconds},
+				{"fps", 30}
+			}}
+		});
+		
+		if (i % 4 == 0) {
+			nlohmann::json linear = nlohmann::json::array({
+				{{"src", 0.0}, {"dst", 0.1}},
+				{{"src", 1.0}, {"dst", 0.9}}
+			});
+			clips.push_back({
+				{"in", start},
+				{"out", start + clipSeconds},
+				{"track", {{"type", "video"}, {"number", 1}, {"subtype", "effects"}, {"subnumber", 1}}},
+				{"source", {
+					{"type", "highlight"},
+					{"in", 0.0},
+					{"out", clipSeconds},
+					{"insideMaskFilters", nlohmann::json::array({{
+						{"type", "brightness"},
+						{"controlPoints", nlohmann::json::array({
+							{{"point", 0.0}, {"linear", linear}},
+							{{"point", clipSeconds}, {"linear", linear}}
+						})}
+					}})},
+					{"outsideMaskFilters", nlohmann::json::array()},
+					{"interpolation", "linear"}
+				}}
+			});
+		}
+	}
+	
+	return {{"fps", 30}, {"width", 1920}, {"height", 1080}, {"clips", clips}};
+}
+
+namespace {
+
+std::string createSyntheticMedia() {
+	auto path = std::filesystem::temp_directory_path() / "edl2ffmpeg_bench_source.mp4";
+	if (std::filesystem::exists(path)) {
+		return path.string();
+	}
+	
+	media::FFmpegEncoder::Config config;
+	config.codec = avcodec_find_encoder_by_name("libx264") ? "libx264" : "mpeg4";
+	config.width = 640;
+	config.height = 360;
+	config.frameRate = {30, 1};
+	config.bitrate = 2000000;
+	config.preset = "veryfast";
+	
+	// Written under another name, so an interrupted run is not reused
+	auto partial = path;
+	partial += ".partial.mp4";
+	bool ok = false;
+	try {
+		media::FFmpegEncoder encoder(partial.string(), config);
+		auto frame = makeFrame(config.width, config.height);
+		ok = true;
+		for (int i = 0; i < 300 && ok; i++) {
+			// Move a bright column across the frame so frames differ
+			for (int y = 0; y < config.height; y++) {
+				frame->data[0][y * frame->linesize[0] + (i * 2) % config.width] = 235;
+			}
+			ok = encoder.writeFrame(frame.get());
+		}
+		ok = ok && encoder.finalize();
+	} catch (const std::exception& e) {
+		utils::Logger::error("Failed to create benchmark media: {}", e.what());
+		ok = false;
+	}
+	if (!ok) {
+		std::filesystem::remove(partial);
+		return "";
+	}
+	std::filesystem::rename(partial, path);
+	
+	return path.string();
+}
+
+}
+
+const std::string& syntheticMedia() {
+	static const std::string path = createSyntheticMedia();
+	return path;
+}
+
+} // namespace bench
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace bench {
+
+// 16:9 width for a frame height (720 -> 1280)
+int widthFor(int height);
+
+// YUV 4:2:0 frame filled with a gradient, so LUTs and scalers see real values
+std::shared_ptr<AVFrame> makeFrame(int width, int height);
+
+/**
+ * EDL with clipCount two-second clips on video track 1, cycling through
+ * sixteen source files, plus a brightness effect clip over every fourth
+ * clip
+ */
+nlohmann::json syntheticEDL(int clipCount);
+
+/**
+ * Path of a ten-second 640x360 clip generated on first use in the temp
+ * directory (H.264 with its default GOP, or MPEG-4 Part 2 without libx264).
+ * Empty if it could not be created.
+ */
+const std::string& syntheticMedia();
+
+} // namespace bench
\ No newline at end of file
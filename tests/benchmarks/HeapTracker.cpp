@@ -0,0 +1,104 @@
+#include "HeapTracker.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Each allocation starts with its size and the tracking run it was made in
+// (0 outside one), padded so the memory handed out keeps new's alignment
+struct Header {
+	std::size_t size;
+	uint32_t run;
+};
+constexpr std::size_t HEADER_SIZE = (sizeof(Header) + alignof(std::max_align_t) - 1) /
+	alignof(std::max_align_t) * alignof(std::max_align_t);
+
+std::atomic<uint32_t> currentRun{0};   // 0 while not tracking
+uint32_t lastRun = 0;
+std::atomic<int64_t> allocations{0};
+std::atomic<int64_t> allocatedBytes{0};
+std::atomic<int64_t> heldBytes{0};     // Allocations of this run not yet freed
+std::atomic<int64_t> peakBytes{0};
+
+void* allocate(std::size_t size) {
+	void* block = std::malloc(size + HEADER_SIZE);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	
+	Header* header = static_cast<Header*>(block);
+	header->size = size;
+	header->run = currentRun.load(std::memory_order_relaxed);
+	if (header->run != 0) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+		int64_t held = heldBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) +
+			static_cast<int64_t>(size);
+		int64_t peak = peakBytes.load(std::memory_order_relaxed);
+		while (held > peak && !peakBytes.compare_exchange_weak(peak, held, std::memory_order_relaxed)) {
+		}
+	}
+	return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void release(void* pointer) {
+	if (!pointer) {
+		return;
+	}
+	void* block = static_cast<char*>(pointer) - HEADER_SIZE;
+	const Header* header = static_cast<const Header*>(block);
+	// Blocks of an earlier run are left out of this one's count
+	if (header->run != 0 && header->run == currentRun.load(std::memory_order_relaxed)) {
+		heldBytes.fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+	}
+	std::free(block);
+}
+
+}
+
+void* operator new(std::size_t size) {
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+	return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	release(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	release(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	release(pointer);
+}
+
+namespace bench {
+
+void HeapTracker::Start() {
+	allocations = 0;
+	allocatedBytes = 0;
+	heldBytes = 0;
+	peakBytes = 0;
+	currentRun = ++lastRun;
+}
+
+void HeapTracker::Stop(Result& result) {
+	currentRun = 0;
+	result.num_allocs = allocations;
+	result.max_bytes_used = peakBytes;
+	result.total_allocated_bytes = allocatedBytes;
+	result.net_heap_growth = heldBytes;
+}
+
+} // namespace bench
\ No newline at end of file
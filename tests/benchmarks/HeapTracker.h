@@ -0,0 +1,23 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+namespace bench {
+
+/**
+ * Heap use of each benchmark, for Google Benchmark's memory reports
+ * (allocs_per_iter and max_bytes_used in the results).
+ *
+ * Replaces the global operator new and delete of the benchmark binary.
+ * Between Start() and Stop() it counts the allocations, the bytes
+ * allocated, and the peak of the bytes still held; outside it only adds
+ * a small header to each allocation. Memory FFmpeg allocates with
+ * av_malloc is not counted.
+ */
+class HeapTracker : public benchmark::MemoryManager {
+public:
+	void Start() override;
+	void Stop(Result& result) override;
+};
+
+} // namespace bench
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "BenchmarkFixtures.h"
+#include "media/FFmpegDecoder.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+// Decoder access patterns on a generated 300-frame clip: the frames each
+// pattern asks for are decoded from a freshly opened decoder every pass
+
+namespace {
+
+void runPattern(benchmark::State& state, const std::vector<int64_t>& frames) {
+	const std::string& path = bench::syntheticMedia();
+	if (path.empty()) {
+		state.SkipWithError("Could not create the synthetic clip");
+		return;
+	}
+	
+	for (auto _ : state) {
+		state.PauseTiming();
+		media::FFmpegDecoder decoder(path);
+		state.ResumeTiming();
+		
+		for (int64_t frame : frames) {
+			auto decoded = decoder.getFrame(frame);
+			if (!decoded) {
+				state.SkipWithError("Decoding failed");
+				return;
+			}
+			benchmark::DoNotOptimize(decoded->data[0]);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(frames.size()));
+}
+
+void BM_DecodeSequential(benchmark::State& state) {
+	std::vector<int64_t> frames;
+	for (int64_t frame = 0; frame < 120; frame++) {
+		frames.push_back(frame);
+	}
+	runPattern(state, frames);
+}
+BENCHMARK(BM_DecodeSequential)->Unit(benchmark::kMillisecond);
+
+// Short clips cut from one source, skipping ahead between them
+void BM_DecodeSkipForward(benchmark::State& state) {
+	int64_t stride = state.range(0);
+	std::vector<int64_t> frames;
+	for (int64_t start = 0; start + 10 <= 300; start += stride) {
+		for (int64_t frame = start; frame < start + 10; frame++) {
+			frames.push_back(frame);
+		}
+	}
+	runPattern(state, frames);
+}
+BENCHMARK(BM_DecodeSkipForward)->ArgName("stride")->Arg(30)->Arg(90)->Unit(benchmark::kMillisecond);
+
+// Clips taken from the source in reverse order
+void BM_DecodeSeekBackward(benchmark::State& state) {
+	std::vector<int64_t> frames;
+	for (int64_t start = 290; start >= 0; start -= 60) {
+		for (int64_t frame = start; frame < start + 10; frame++) {
+			frames.push_back(frame);
+		}
+	}
+	runPattern(state, frames);
+}
+BENCHMARK(BM_DecodeSeekBackward)->Unit(benchmark::kMillisecond);
+
+void BM_DecodeRandom(benchmark::State& state) {
+	std::mt19937 random(7);
+	std::uniform_int_distribution<int64_t> pick(0, 299);
+	std::vector<int64_t> frames(20);
+	for (auto& frame : frames) {
+		frame = pick(random);
+	}
+	runPattern(state, frames);
+}
+BENCHMARK(BM_DecodeRandom)->Unit(benchmark::kMillisecond);
+
+}
\ No newline at end of file
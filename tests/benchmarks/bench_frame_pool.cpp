@@ -0,0 +1,41 @@
+#include "BenchmarkFixtures.h"
+#include "utils/FrameBuffer.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+// FrameBufferPool get/return, alone and with several threads sharing one
+// pool as the decoder, compositor and encoder threads do
+
+namespace {
+
+utils::FrameBufferPool& sharedPool() {
+	static utils::FrameBufferPool pool(1920, 1080, AV_PIX_FMT_YUV420P, 32);
+	return pool;
+}
+
+void BM_FramePoolGetReturn(benchmark::State& state) {
+	auto& pool = sharedPool();
+	for (auto _ : state) {
+		auto frame = pool.getFrame();
+		benchmark::DoNotOptimize(frame.get());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FramePoolGetReturn)->ThreadRange(1, 8)->UseRealTime();
+
+// Several frames held at once, as a transition or encoder queue does
+void BM_FramePoolBurst(benchmark::State& state) {
+	auto& pool = sharedPool();
+	std::vector<std::shared_ptr<AVFrame>> held;
+	held.reserve(4);
+	for (auto _ : state) {
+		for (int i = 0; i < 4; i++) {
+			held.push_back(pool.getFrame());
+		}
+		held.clear();
+	}
+	state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_FramePoolBurst)->ThreadRange(1, 8)->UseRealTime();
+
+}
\ No newline at end of file
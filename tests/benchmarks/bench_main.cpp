@@ -0,0 +1,20 @@
+#include "HeapTracker.h"
+#include "utils/Logger.h"
+#include <benchmark/benchmark.h>
+
+// BENCHMARK_MAIN() with the pipeline's own logging kept quiet and heap use
+// reported
+int main(int argc, char** argv) {
+	utils::Logger::setLevel(utils::Logger::ERROR);
+	
+	static bench::HeapTracker heapTracker;
+	benchmark::RegisterMemoryManager(&heapTracker);
+	
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
\ No newline at end of file
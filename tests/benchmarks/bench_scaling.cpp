@@ -0,0 +1,107 @@
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include "integration/common/StressEDLGenerator.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <map>
+#include <random>
+
+// How the timeline stages scale with EDL size, on generated EDLs of 10 to
+// 100k clips. Each benchmark fits its complexity (the _BigO and _RMS rows),
+// so a stage that turns super-linear reports N^2 instead of N. Heap use per
+// size is in max_bytes_used.
+
+namespace {
+
+using Reuse = test::StressEDLGenerator::Reuse;
+
+// Two video tracks with synced sound, a brightness effect on a quarter of
+// the clips, some transitions, fades and gaps
+nlohmann::json generateEDL(int clips, Reuse reuse) {
+	return test::StressEDLGenerator(42)
+		.withClips(clips)
+		.withTracks(2, 2)
+		.withSources(std::max(2, clips / 20), reuse)
+		.withEffectDensity(0.25)
+		.withTransitionDensity(0.1)
+		.withFadeDensity(0.2)
+		.withGapDensity(0.05)
+		.generate();
+}
+
+// Generating 100k clips takes longer than parsing them, so each EDL is
+// made once
+const nlohmann::json& stressEDL(int clips, Reuse reuse = Reuse::Hotspot) {
+	static std::map<std::pair<int, Reuse>, nlohmann::json> cache;
+	auto key = std::make_pair(clips, reuse);
+	auto it = cache.find(key);
+	if (it == cache.end()) {
+		it = cache.emplace(key, generateEDL(clips, reuse)).first;
+	}
+	return it->second;
+}
+
+void clipCounts(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgName("clips");
+	benchmark->RangeMultiplier(10)->Range(10, 100000);
+	benchmark->Unit(benchmark::kMillisecond);
+	benchmark->Complexity();
+}
+
+// JSON to EDL, including track alignment
+void BM_ScaleParse(benchmark::State& state) {
+	const auto& document = stressEDL(static_cast<int>(state.range(0)));
+	for (auto _ : state) {
+		auto edl = edl::EDLParser::parseJSON(document);
+		benchmark::DoNotOptimize(edl.clips.data());
+	}
+	state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ScaleParse)->Apply(clipCounts);
+
+void BM_ScaleCompile(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(stressEDL(static_cast<int>(state.range(0))));
+	for (auto _ : state) {
+		compositor::InstructionGenerator generator(edl);
+		benchmark::DoNotOptimize(generator.getTotalFrames());
+	}
+	state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ScaleCompile)->Apply(clipCounts);
+
+// Every clip reading a source of its own, so source lookups scale with the
+// clip count too
+void BM_ScaleCompileUniqueSources(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(stressEDL(static_cast<int>(state.range(0)), Reuse::Unique));
+	for (auto _ : state) {
+		compositor::InstructionGenerator generator(edl);
+		benchmark::DoNotOptimize(generator.getTimeline().sources.size());
+	}
+	state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ScaleCompileUniqueSources)->Apply(clipCounts);
+
+// A fixed number of random frames, so the time per lookup shows
+void BM_ScaleRandomLookup(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(stressEDL(static_cast<int>(state.range(0))));
+	compositor::InstructionGenerator generator(edl);
+	
+	std::mt19937 random(42);
+	std::uniform_int_distribution<int> pick(0, generator.getTotalFrames() - 1);
+	std::vector<int> frames(4096);
+	for (auto& frame : frames) {
+		frame = pick(random);
+	}
+	
+	for (auto _ : state) {
+		for (int frame : frames) {
+			auto instruction = generator.getInstructionForFrame(frame);
+			benchmark::DoNotOptimize(instruction.sourceFrameNumber);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(frames.size()));
+	state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ScaleRandomLookup)->Apply(clipCounts);
+
+}
\ No newline at end of file
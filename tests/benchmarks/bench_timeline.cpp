@@ -0,0 +1,87 @@
+#include "BenchmarkFixtures.h"
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+// EDL parsing and timeline evaluation on synthetic EDLs of up to 10k clips
+
+namespace {
+
+void clipCounts(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgName("clips");
+	benchmark->Arg(100)->Arg(1000)->Arg(10000);
+	benchmark->Unit(benchmark::kMillisecond);
+}
+
+void BM_EDLParseJSON(benchmark::State& state) {
+	auto document = bench::syntheticEDL(static_cast<int>(state.range(0)));
+	for (auto _ : state) {
+		auto edl = edl::EDLParser::parseJSON(document);
+		benchmark::DoNotOptimize(edl.clips.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EDLParseJSON)->Apply(clipCounts);
+
+// Text to EDL, including the JSON parse
+void BM_EDLParseText(benchmark::State& state) {
+	std::string text = bench::syntheticEDL(static_cast<int>(state.range(0))).dump();
+	for (auto _ : state) {
+		auto edl = edl::EDLParser::parseJSON(nlohmann::json::parse(text));
+		benchmark::DoNotOptimize(edl.clips.data());
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_EDLParseText)->Apply(clipCounts);
+
+void BM_CompileTimeline(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(bench::syntheticEDL(static_cast<int>(state.range(0))));
+	for (auto _ : state) {
+		compositor::InstructionGenerator generator(edl);
+		benchmark::DoNotOptimize(generator.getTotalFrames());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CompileTimeline)->Apply(clipCounts);
+
+// Every frame in order, as the render loop asks for them
+void BM_InstructionsSequential(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(bench::syntheticEDL(static_cast<int>(state.range(0))));
+	compositor::InstructionGenerator generator(edl);
+	int totalFrames = generator.getTotalFrames();
+	
+	for (auto _ : state) {
+		for (int frame = 0; frame < totalFrames; frame++) {
+			auto instruction = generator.getInstructionForFrame(frame);
+			benchmark::DoNotOptimize(instruction.sourceFrameNumber);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * totalFrames);
+}
+BENCHMARK(BM_InstructionsSequential)->Apply(clipCounts);
+
+// Random frames, as a scrubbing preview or segment re-render does
+void BM_InstructionsRandom(benchmark::State& state) {
+	auto edl = edl::EDLParser::parseJSON(bench::syntheticEDL(static_cast<int>(state.range(0))));
+	compositor::InstructionGenerator generator(edl);
+	int totalFrames = generator.getTotalFrames();
+	
+	std::mt19937 random(42);
+	std::uniform_int_distribution<int> pick(0, totalFrames - 1);
+	std::vector<int> frames(4096);
+	for (auto& frame : frames) {
+		frame = pick(random);
+	}
+	
+	for (auto _ : state) {
+		for (int frame : frames) {
+			auto instruction = generator.getInstructionForFrame(frame);
+			benchmark::DoNotOptimize(instruction.sourceFrameNumber);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(frames.size()));
+}
+BENCHMARK(BM_InstructionsRandom)->Apply(clipCounts);
+
+}
\ No newline at end of file
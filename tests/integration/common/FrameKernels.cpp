@@ -0,0 +1,174 @@
+#include "FrameKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRAME_KERNELS_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FRAME_KERNELS_NEON 1
+#endif
+
+namespace test {
+
+namespace kernels {
+
+namespace {
+
+void blockSumsScalar(const uint8_t* a, int strideA, const uint8_t* b, int strideB, BlockSums& out) {
+	out = BlockSums();
+	for (int y = 0; y < 4; y++) {
+		for (int x = 0; x < 4; x++) {
+			uint32_t pa = a[y * strideA + x];
+			uint32_t pb = b[y * strideB + x];
+			out.sumA += pa;
+			out.sumB += pb;
+			out.sumSquares += pa * pa + pb * pb;
+			out.sumProducts += pa * pb;
+		}
+	}
+}
+
+#if defined(FRAME_KERNELS_SSE2)
+// [p0+p1, p2+p3] of lo and hi as four lanes
+inline __m128i pairSums(__m128i lo, __m128i hi) {
+	lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+	hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+	return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+}
+
+void blockSums4x4(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, BlockSums* out) {
+	int block = 0;
+	
+#if defined(FRAME_KERNELS_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+	for (; block + 4 <= blocks; block += 4) {
+		// Lanes of the lo/hi accumulators hold pixel pairs 0-7 and 8-15
+		__m128i sumALo = zero, sumAHi = zero, sumBLo = zero, sumBHi = zero;
+		__m128i squaresLo = zero, squaresHi = zero, productsLo = zero, productsHi = zero;
+		for (int y = 0; y < 4; y++) {
+			__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * strideA + block * 4));
+			__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * strideB + block * 4));
+			__m128i aLo = _mm_unpacklo_epi8(va, zero);
+			__m128i aHi = _mm_unpackhi_epi8(va, zero);
+			__m128i bLo = _mm_unpacklo_epi8(vb, zero);
+			__m128i bHi = _mm_unpackhi_epi8(vb, zero);
+			sumALo = _mm_add_epi32(sumALo, _mm_madd_epi16(aLo, ones));
+			sumAHi = _mm_add_epi32(sumAHi, _mm_madd_epi16(aHi, ones));
+			sumBLo = _mm_add_epi32(sumBLo, _mm_madd_epi16(bLo, ones));
+			sumBHi = _mm_add_epi32(sumBHi, _mm_madd_epi16(bHi, ones));
+			squaresLo = _mm_add_epi32(squaresLo, _mm_add_epi32(_mm_madd_epi16(aLo, aLo), _mm_madd_epi16(bLo, bLo)));
+			squaresHi = _mm_add_epi32(squaresHi, _mm_add_epi32(_mm_madd_epi16(aHi, aHi), _mm_madd_epi16(bHi, bHi)));
+			productsLo = _mm_add_epi32(productsLo, _mm_madd_epi16(aLo, bLo));
+			productsHi = _mm_add_epi32(productsHi, _mm_madd_epi16(aHi, bHi));
+		}
+		
+		alignas(16) uint32_t sumA[4], sumB[4], squares[4], products[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(sumA), pairSums(sumALo, sumAHi));
+		_mm_store_si128(reinterpret_cast<__m128i*>(sumB), pairSums(sumBLo, sumBHi));
+		_mm_store_si128(reinterpret_cast<__m128i*>(squares), pairSums(squaresLo, squaresHi));
+		_mm_store_si128(reinterpret_cast<__m128i*>(products), pairSums(productsLo, productsHi));
+		for (int i = 0; i < 4; i++) {
+			out[block + i] = {sumA[i], sumB[i], squares[i], products[i]};
+		}
+	}
+#elif defined(FRAME_KERNELS_NEON)
+	for (; block + 4 <= blocks; block += 4) {
+		uint32x4_t sumA = vdupq_n_u32(0), sumB = vdupq_n_u32(0);
+		uint32x4_t squaresLo = vdupq_n_u32(0), squaresHi = vdupq_n_u32(0);
+		uint32x4_t productsLo = vdupq_n_u32(0), productsHi = vdupq_n_u32(0);
+		for (int y = 0; y < 4; y++) {
+			uint8x16_t va = vld1q_u8(a + y * strideA + block * 4);
+			uint8x16_t vb = vld1q_u8(b + y * strideB + block * 4);
+			// Pairwise adds of a row give one lane per block
+			sumA = vaddq_u32(sumA, vpaddlq_u16(vpaddlq_u8(va)));
+			sumB = vaddq_u32(sumB, vpaddlq_u16(vpaddlq_u8(vb)));
+			uint8x8_t aLo = vget_low_u8(va), aHi = vget_high_u8(va);
+			uint8x8_t bLo = vget_low_u8(vb), bHi = vget_high_u8(vb);
+			squaresLo = vaddq_u32(squaresLo, vaddq_u32(vpaddlq_u16(vmull_u8(aLo, aLo)), vpaddlq_u16(vmull_u8(bLo, bLo))));
+			squaresHi = vaddq_u32(squaresHi, vaddq_u32(vpaddlq_u16(vmull_u8(aHi, aHi)), vpaddlq_u16(vmull_u8(bHi, bHi))));
+			productsLo = vpadalq_u16(productsLo, vmull_u8(aLo, bLo));
+			productsHi = vpadalq_u16(productsHi, vmull_u8(aHi, bHi));
+		}
+		
+		uint32x4_t squares = vcombine_u32(vpadd_u32(vget_low_u32(squaresLo), vget_high_u32(squaresLo)),
+			vpadd_u32(vget_low_u32(squaresHi), vget_high_u32(squaresHi)));
+		uint32x4_t products = vcombine_u32(vpadd_u32(vget_low_u32(productsLo), vget_high_u32(productsLo)),
+			vpadd_u32(vget_low_u32(productsHi), vget_high_u32(productsHi)));
+		uint32_t sumALanes[4], sumBLanes[4], squareLanes[4], productLanes[4];
+		vst1q_u32(sumALanes, sumA);
+		vst1q_u32(sumBLanes, sumB);
+		vst1q_u32(squareLanes, squares);
+		vst1q_u32(productLanes, products);
+		for (int i = 0; i < 4; i++) {
+			out[block + i] = {sumALanes[i], sumBLanes[i], squareLanes[i], productLanes[i]};
+		}
+	}
+#endif
+	
+	for (; block < blocks; block++) {
+		blockSumsScalar(a + block * 4, strideA, b + block * 4, strideB, out[block]);
+	}
+}
+
+uint64_t sumSquaredError(const uint8_t* a, const uint8_t* b, int count) {
+	uint64_t sse = 0;
+	int i = 0;
+	
+#if defined(FRAME_KERNELS_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	for (; i + 16 <= count; i += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		__m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+		__m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+		__m128i squares = _mm_add_epi32(_mm_madd_epi16(diffLo, diffLo), _mm_madd_epi16(diffHi, diffHi));
+		// Widen to 64 bits every step, so no row length can overflow
+		sum = _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(squares, zero), _mm_unpackhi_epi32(squares, zero)));
+	}
+	alignas(16) uint64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+	sse = lanes[0] + lanes[1];
+#elif defined(FRAME_KERNELS_NEON)
+	uint64x2_t sum = vdupq_n_u64(0);
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+		uint32x4_t squares = vpaddlq_u16(vmull_u8(vget_low_u8(diff), vget_low_u8(diff)));
+		squares = vpadalq_u16(squares, vmull_u8(vget_high_u8(diff), vget_high_u8(diff)));
+		sum = vpadalq_u32(sum, squares);
+	}
+	sse = vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+#endif
+	
+	for (; i < count; i++) {
+		int diff = a[i] - b[i];
+		sse += diff * diff;
+	}
+	return sse;
+}
+
+double windowSSIM(const BlockSums& topLeft, const BlockSums& topRight,
+	const BlockSums& bottomLeft, const BlockSums& bottomRight) {
+	// Constants of the 8-bit SSIM, scaled to sums over 64 pixels
+	const double c1 = 0.01 * 0.01 * 255 * 255 * 64;
+	const double c2 = 0.03 * 0.03 * 255 * 255 * 64 * 63;
+	
+	double s1 = static_cast<double>(topLeft.sumA) + topRight.sumA + bottomLeft.sumA + bottomRight.sumA;
+	double s2 = static_cast<double>(topLeft.sumB) + topRight.sumB + bottomLeft.sumB + bottomRight.sumB;
+	double ss = static_cast<double>(topLeft.sumSquares) + topRight.sumSquares +
+		bottomLeft.sumSquares + bottomRight.sumSquares;
+	double s12 = static_cast<double>(topLeft.sumProducts) + topRight.sumProducts +
+		bottomLeft.sumProducts + bottomRight.sumProducts;
+	
+	double variances = ss * 64 - s1 * s1 - s2 * s2;
+	double covariance = s12 * 64 - s1 * s2;
+	return (2 * s1 * s2 + c1) * (2 * covariance + c2) / ((s1 * s1 + s2 * s2 + c1) * (variances + c2));
+}
+
+} // namespace kernels
+
+} // namespace test
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace test {
+
+/**
+ * Pixel kernels for comparing 8-bit planes, vectorised with SSE2 or NEON
+ * where available (scalar fallback otherwise).
+ *
+ * PSNR and SSIM come from one set of sums: SSIM is evaluated on 8x8 windows
+ * every 4 pixels, built from the sums of 4x4 blocks as in FFmpeg's ssim
+ * filter, and the squared error of a block is sumSquares - 2 * sumProducts.
+ */
+namespace kernels {
+
+// Sums over one 4x4 block of two planes a and b
+struct BlockSums {
+	uint32_t sumA = 0;
+	uint32_t sumB = 0;
+	uint32_t sumSquares = 0;    // Sum of a^2 + b^2
+	uint32_t sumProducts = 0;   // Sum of a * b
+};
+
+// Sums of `blocks` 4x4 blocks side by side, starting at the top left of a
+// and b and covering four rows of each
+void blockSums4x4(const uint8_t* a, int strideA, const uint8_t* b, int strideB, int blocks, BlockSums* out);
+
+// Sum of (a[i] - b[i])^2 over count pixels
+uint64_t sumSquaredError(const uint8_t* a, const uint8_t* b, int count);
+
+// SSIM of the 8x8 window made of four neighbouring blocks
+double windowSSIM(const BlockSums& topLeft, const BlockSums& topRight,
+	const BlockSums& bottomLeft, const BlockSums& bottomRight);
+
+} // namespace kernels
+
+} // namespace test
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "StressEDLGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace test {
+
+namespace {
+
+// Length of every named source; source in points stay inside it
+constexpr double SOURCE_SECONDS = 600.0;
+
+struct PlacedClip {
+	int inFrame;
+	int outFrame;
+	int source;
+	int sourceInFrame;
+	bool transition;
+	bool fade;
+};
+
+}
+
+StressEDLGenerator::StressEDLGenerator(unsigned int seed)
+	: rng_(seed) {
+}
+
+StressEDLGenerator& StressEDLGenerator::withClips(int count) {
+	clips_ = std::max(count, 1);
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withTracks(int videoTracks, int audioTracks) {
+	videoTracks_ = std::max(videoTracks, 1);
+	audioTracks_ = std::max(audioTracks, 0);
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withSources(int count, Reuse reuse) {
+	sources_ = std::max(count, 1);
+	reuse_ = reuse;
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withClipLength(double minSeconds, double maxSeconds) {
+	minClipSeconds_ = minSeconds;
+	maxClipSeconds_ = std::max(minSeconds, maxSeconds);
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withFrameRate(int fps) {
+	fps_ = std::max(fps, 1);
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withEffectDensity(double fraction) {
+	effectDensity_ = fraction;
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withTransitionDensity(double fraction) {
+	transitionDensity_ = fraction;
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withFadeDensity(double fraction) {
+	fadeDensity_ = fraction;
+	return *this;
+}
+
+StressEDLGenerator& StressEDLGenerator::withGapDensity(double fraction) {
+	gapDensity_ = fraction;
+	return *this;
+}
+
+nlohmann::json StressEDLGenerator::generate() {
+	// Clip lengths in whole frames, at least one
+	const int minFrames = std::max(1, static_cast<int>(std::lround(minClipSeconds_ * fps_)));
+	const int maxFrames = std::max(minFrames, static_cast<int>(std::lround(maxClipSeconds_ * fps_)));
+	const int sourceFrames = static_cast<int>(SOURCE_SECONDS * fps_);
+	
+	// Lay out each video track back to back; audio tracks repeat the cuts
+	// of a video track, as synced sound does
+	std::vector<std::vector<PlacedClip>> videoTracks(videoTracks_);
+	for (int i = 0; i < clips_; i++) {
+		auto& track = videoTracks[i % videoTracks_];
+		int start = track.empty() ? 0 : track.back().outFrame;
+		if (randomBool(gapDensity_)) {
+			start += randomInt(1, maxFrames);
+		}
+		
+		PlacedClip clip;
+		clip.inFrame = start;
+		clip.outFrame = start + randomInt(minFrames, maxFrames);
+		clip.source = pickSource(i);
+		clip.sourceInFrame = randomInt(0, std::max(0, sourceFrames - (clip.outFrame - clip.inFrame)));
+		clip.transition = randomBool(transitionDensity_);
+		clip.fade = randomBool(fadeDensity_);
+		track.push_back(clip);
+	}
+	
+	nlohmann::json clips = nlohmann::json::array();
+	for (int t = 0; t < videoTracks_; t++) {
+		for (const PlacedClip& placed : videoTracks[t]) {
+			nlohmann::json clip = mediaClip(placed.inFrame, placed.outFrame, t + 1, "video", placed.source);
+			clip["source"]["in"] = static_cast<double>(placed.sourceInFrame) / fps_;
+			clip["source"]["out"] = static_cast<double>(placed.sourceInFrame + placed.outFrame - placed.inFrame) / fps_;
+			
+			double seconds = static_cast<double>(placed.outFrame - placed.inFrame) / fps_;
+			if (placed.transition) {
+				clip["transition"] = {{"type", "dissolve"}, {"duration", std::min(0.5, seconds / 2)}};
+			}
+			if (placed.fade) {
+				clip["topFade"] = std::min(0.5, seconds / 2);
+				clip["tailFade"] = std::min(0.5, seconds / 2);
+			}
+			clips.push_back(clip);
+			
+			if (randomBool(effectDensity_)) {
+				clips.push_back(effectClip(placed.inFrame, placed.outFrame, t + 1));
+			}
+		}
+	}
+	
+	for (int a = 0; a < audioTracks_; a++) {
+		for (const PlacedClip& placed : videoTracks[a % videoTracks_]) {
+			nlohmann::json clip = mediaClip(placed.inFrame, placed.outFrame, a + 1, "audio", placed.source);
+			clip["source"]["in"] = static_cast<double>(placed.sourceInFrame) / fps_;
+			clip["source"]["out"] = static_cast<double>(placed.sourceInFrame + placed.outFrame - placed.inFrame) / fps_;
+			clip["channelMap"] = {{"1", 1.0}};
+			clips.push_back(clip);
+		}
+	}
+	
+	return {{"fps", fps_}, {"width", 1920}, {"height", 1080}, {"clips", clips}};
+}
+
+int StressEDLGenerator::randomInt(int min, int max) {
+	std::uniform_int_distribution<int> dist(min, max);
+	return dist(rng_);
+}
+
+bool StressEDLGenerator::randomBool(double probability) {
+	if (probability <= 0.0) {
+		return false;
+	}
+	std::bernoulli_distribution dist(std::min(probability, 1.0));
+	return dist(rng_);
+}
+
+int StressEDLGenerator::pickSource(int clipIndex) {
+	switch (reuse_) {
+		case Reuse::RoundRobin:
+			return clipIndex % sources_;
+		case Reuse::Random:
+			return randomInt(0, sources_ - 1);
+		case Reuse::Hotspot: {
+			int hot = std::max(1, sources_ / 5);
+			if (hot == sources_ || randomBool(0.8)) {
+				return randomInt(0, hot - 1);
+			}
+			return randomInt(hot, sources_ - 1);
+		}
+		case Reuse::Unique:
+			return clipIndex;
+	}
+	return 0;
+}
+
+nlohmann::json StressEDLGenerator::mediaClip(int inFrame, int outFrame, int trackNumber,
+	const std::string& type, int source) {
+	return {
+		{"in", static_cast<double>(inFrame) / fps_},
+		{"out", static_cast<double>(outFrame) / fps_},
+		{"track", {{"type", type}, {"number", trackNumber}}},
+		{"source", {
+			{"uri", "source_" + std::to_string(source) + ".mp4"},
+			{"trackId", type == "video" ? "V1" : "A1"},
+			{"fps", fps_}
+		}}
+	};
+}
+
+nlohmann::json StressEDLGenerator::effectClip(int inFrame, int outFrame, int trackNumber) {
+	return {
+		{"in", static_cast<double>(inFrame) / fps_},
+		{"out", static_cast<double>(outFrame) / fps_},
+		{"track", {{"type", "video"}, {"number", trackNumber}, {"subtype", "effects"}, {"subnumber", 1}}},
+		{"source", {
+			{"type", "brightness"},
+			{"in", 0.0},
+			{"out", static_cast<double>(outFrame - inFrame) / fps_},
+			{"value", std::uniform_real_distribution<double>(0.5, 1.5)(rng_)}
+		}}
+	};
+}
+
+} // namespace test
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace test {
+
+/**
+ * Builds large EDLs (tens of thousands of clips) for scaling and stress
+ * tests of parsing, timeline compilation and source handling.
+ *
+ * Unlike EDLGenerator, the EDLs are not meant to be rendered: sources are
+ * only named (source_<n>.mp4), never checked. Clips are cut on frame
+ * boundaries and never overlap on a track, so every EDL parses. The same
+ * seed and configuration always give the same EDL.
+ */
+class StressEDLGenerator {
+public:
+	// How clips pick their source
+	enum class Reuse {
+		RoundRobin,     // Clip i reads source i % sources
+		Random,         // Any source, uniformly
+		Hotspot,        // Four in five clips read the first fifth of the sources
+		Unique          // Every clip reads a source of its own
+	};
+	
+	explicit StressEDLGenerator(unsigned int seed = 1);
+	
+	// Configuration methods (fluent interface)
+	StressEDLGenerator& withClips(int count);  // Media clips over all video tracks
+	StressEDLGenerator& withTracks(int videoTracks, int audioTracks = 0);
+	StressEDLGenerator& withSources(int count, Reuse reuse = Reuse::RoundRobin);
+	StressEDLGenerator& withClipLength(double minSeconds, double maxSeconds);
+	StressEDLGenerator& withFrameRate(int fps);
+	
+	// Fractions of the media clips that get each feature
+	StressEDLGenerator& withEffectDensity(double fraction);      // Under a brightness effect
+	StressEDLGenerator& withTransitionDensity(double fraction);  // Starting with a dissolve
+	StressEDLGenerator& withFadeDensity(double fraction);        // Top and tail fades
+	StressEDLGenerator& withGapDensity(double fraction);         // After a gap on their track
+	
+	nlohmann::json generate();
+
+private:
+	std::mt19937 rng_;
+	
+	// Configuration
+	int clips_ = 1000;
+	int videoTracks_ = 1;
+	int audioTracks_ = 0;
+	int sources_ = 16;
+	Reuse reuse_ = Reuse::RoundRobin;
+	double minClipSeconds_ = 0.5;
+	double maxClipSeconds_ = 4.0;
+	double effectDensity_ = 0.0;
+	double transitionDensity_ = 0.0;
+	double fadeDensity_ = 0.0;
+	double gapDensity_ = 0.0;
+	int fps_ = 30;
+	
+	// Helper methods
+	int randomInt(int min, int max);
+	bool randomBool(double probability);
+	int pickSource(int clipIndex);
+	
+	nlohmann::json mediaClip(int inFrame, int outFrame, int trackNumber, const std::string& type, int source);
+	nlohmann::json effectClip(int inFrame, int outFrame, int trackNumber);
+};
+
+} // namespace test
\ No newline at end of file
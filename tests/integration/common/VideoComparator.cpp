@@ -1,9 +1,14 @@
 #include "VideoComparator.h"
+#include "FrameKernels.h"
+#include "utils/BoundedQueue.h"
+#include "utils/ThreadPool.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
+#include <thread>
 
 extern "C" {
 #include <libavutil/imgutils.h>
@@ -12,6 +17,47 @@ extern "C" {
 
 namespace test {
 
+namespace {
+
+// Continue a checksum over the U and V planes of YUV formats
+uint32_t checksumChroma(const AVFrame* frame, uint32_t crc) {
+	if (frame->format != AV_PIX_FMT_YUV420P && 
+		frame->format != AV_PIX_FMT_YUV422P &&
+		frame->format != AV_PIX_FMT_YUV444P) {
+		return crc;
+	}
+	
+	const AVCRC* crcTable = av_crc_get_table(AV_CRC_32_IEEE);
+	int chromaHeight = frame->height >> (frame->format == AV_PIX_FMT_YUV420P ? 1 : 0);
+	int chromaWidth = frame->width >> (frame->format != AV_PIX_FMT_YUV444P ? 1 : 0);
+	
+	for (int p = 1; p <= 2; p++) {
+		for (int y = 0; y < chromaHeight; y++) {
+			crc = av_crc(crcTable, crc,
+						frame->data[p] + y * frame->linesize[p],
+						chromaWidth);
+		}
+	}
+	return crc;
+}
+
+// 8-bit planar YUV, compared without conversion
+bool isPlanarYUV8(int format) {
+	switch (format) {
+		case AV_PIX_FMT_YUV420P:
+		case AV_PIX_FMT_YUVJ420P:
+		case AV_PIX_FMT_YUV422P:
+		case AV_PIX_FMT_YUVJ422P:
+		case AV_PIX_FMT_YUV444P:
+		case AV_PIX_FMT_YUVJ444P:
+			return true;
+		default:
+			return false;
+	}
+}
+
+}
+
 VideoComparator::VideoComparator() {
 	// Initialize FFmpeg (once per process) - only needed for old FFmpeg
 	static bool initialized = false;
@@ -42,69 +88,111 @@ ComparisonResult VideoComparator::compare(const std::string& video1Path,
 		return result;
 	}
 	
+	// Each video decodes on its own thread, up to a batch ahead of the
+	// comparison
+	const int threads = threads_ > 0 ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+	const size_t batchSize = static_cast<size_t>(threads) * 2;
+	utils::BoundedQueue<FramePtr> frames1(batchSize), frames2(batchSize);
+	auto decode = [this](VideoReader& reader, utils::BoundedQueue<FramePtr>& frames) {
+		for (int n = 0; maxFramesToCompare_ <= 0 || n < maxFramesToCompare_; n++) {
+			AVFrame* frame = reader.readNextFrame();
+			if (!frame) {
+				break;
+			}
+			if (!frames.push(FramePtr(frame, [](AVFrame* f) { av_frame_free(&f); }))) {
+				break;  // Comparison stopped early
+			}
+		}
+		frames.close();
+	};
+	std::thread decoder1(decode, std::ref(reader1), std::ref(frames1));
+	std::thread decoder2(decode, std::ref(reader2), std::ref(frames2));
+	
+	utils::ThreadPool pool(threads);
+	std::vector<std::pair<FramePtr, FramePtr>> batch;
+	std::vector<FrameMetrics> metrics;
 	int frameNum = 0;
 	double totalPSNR = 0.0;
-	
-	while (true) {
-		if (maxFramesToCompare_ > 0 && frameNum >= maxFramesToCompare_) {
-			break;
-		}
-		
-		AVFrame* frame1 = reader1.readNextFrame();
-		AVFrame* frame2 = reader2.readNextFrame();
-		
-		// Check if both videos ended
-		if (!frame1 && !frame2) {
-			break;
-		}
-		
-		// Check for length mismatch
-		if (!frame1 || !frame2) {
-			result.errorMsg = "Video length mismatch at frame " + std::to_string(frameNum);
-			result.mismatchedFrames++;
-			if (frame1) av_frame_free(&frame1);
-			if (frame2) av_frame_free(&frame2);
-			break;
+	double totalSSIM = 0.0;
+	int lengthMismatchAt = -1;
+	bool done = false;
+	
+	while (!done) {
+		batch.clear();
+		while (batch.size() < batchSize) {
+			std::optional<FramePtr> frame1 = frames1.pop();
+			std::optional<FramePtr> frame2 = frames2.pop();
+			
+			// Check if both videos ended
+			if (!frame1 && !frame2) {
+				done = true;
+				break;
+			}
+			
+			// Check for length mismatch
+			if (!frame1 || !frame2) {
+				lengthMismatchAt = frameNum + static_cast<int>(batch.size());
+				done = true;
+				break;
+			}
+			
+			batch.emplace_back(std::move(*frame1), std::move(*frame2));
 		}
 		
-		// Calculate PSNR
-		double psnr = calculatePSNR(frame1, frame2);
-		totalPSNR += psnr;
-		
-		if (psnr < result.minPSNR) result.minPSNR = psnr;
-		if (psnr > result.maxPSNR) result.maxPSNR = psnr;
-		
-		if (psnr < psnrThreshold_) {
-			result.mismatchedFrames++;
-			if (result.mismatchedFrames == 1) {
-				result.maxFrameDiff = frameNum;
+		// Measure the batch in parallel
+		metrics.assign(batch.size(), FrameMetrics());
+		pool.parallelFor(static_cast<int>(batch.size()), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				metrics[i] = measureFrames(batch[i].first.get(), batch[i].second.get(), calculateChecksums);
 			}
-		}
+		}, 1);
 		
-		// Calculate checksums if requested
-		if (calculateChecksums) {
-			FrameChecksum cs1 = {
-				frameNum,
-				calculateFrameChecksum(frame1),
-				static_cast<double>(frame1->pts)
-			};
-			FrameChecksum cs2 = {
-				frameNum,
-				calculateFrameChecksum(frame2),
-				static_cast<double>(frame2->pts)
-			};
-			result.ourChecksums.push_back(cs1);
-			result.refChecksums.push_back(cs2);
+		// Merge in frame order, so the result does not depend on the batches
+		for (size_t i = 0; i < batch.size(); i++) {
+			const FrameMetrics& frame = metrics[i];
+			totalPSNR += frame.psnr;
+			totalSSIM += frame.ssim;
+			
+			if (frame.psnr < result.minPSNR) result.minPSNR = frame.psnr;
+			if (frame.psnr > result.maxPSNR) result.maxPSNR = frame.psnr;
+			if (frame.ssim < result.minSSIM) result.minSSIM = frame.ssim;
+			
+			if (frame.psnr < psnrThreshold_) {
+				result.mismatchedFrames++;
+				if (result.mismatchedFrames == 1) {
+					result.maxFrameDiff = frameNum;
+				}
+			}
+			
+			if (calculateChecksums) {
+				result.ourChecksums.push_back({frameNum, frame.checksum1, static_cast<double>(batch[i].first->pts)});
+				result.refChecksums.push_back({frameNum, frame.checksum2, static_cast<double>(batch[i].second->pts)});
+			}
+			frameNum++;
+			
+			if (maxMismatchedFrames_ > 0 && result.mismatchedFrames >= maxMismatchedFrames_) {
+				result.stoppedEarly = true;
+				done = true;
+				break;
+			}
 		}
-		
-		av_frame_free(&frame1);
-		av_frame_free(&frame2);
-		frameNum++;
+	}
+	
+	// Stop the decoders if the comparison ended first
+	frames1.close();
+	frames2.close();
+	decoder1.join();
+	decoder2.join();
+	
+	if (lengthMismatchAt >= 0 && !result.stoppedEarly) {
+		result.errorMsg = "Video length mismatch at frame " + std::to_string(lengthMismatchAt);
+		result.mismatchedFrames++;
 	}
 	
 	result.totalFrames = frameNum;
 	if (frameNum > 0) {
 		result.avgPSNR = totalPSNR / frameNum;
+		result.avgSSIM = totalSSIM / frameNum;
 		result.completed = true;
 		result.identical = (result.mismatchedFrames == 0);
 	}
@@ -140,34 +228,99 @@ std::vector<FrameChecksum> VideoComparator::extractChecksums(const std::string&
 
 double VideoComparator::calculatePSNR(AVFrame* frame1, AVFrame* frame2) {
 	if (!frame1 || !frame2) return 0.0;
+	return measureFrames(frame1, frame2, false).psnr;
+}
+
+double VideoComparator::calculateSSIM(AVFrame* frame1, AVFrame* frame2) {
+	if (!frame1 || !frame2) return 0.0;
+	return measureFrames(frame1, frame2, false).ssim;
+}
+
+VideoComparator::FrameMetrics VideoComparator::measureFrames(AVFrame* frame1, AVFrame* frame2,
+															 bool checksums) {
+	FrameMetrics metrics;
 	
 	// Only compare Y plane for speed
-	uint64_t mse = 0;
-	int width = std::min(frame1->width, frame2->width);
-	int height = std::min(frame1->height, frame2->height);
-	
-	for (int y = 0; y < height; y++) {
-		uint8_t* ptr1 = frame1->data[0] + y * frame1->linesize[0];
-		uint8_t* ptr2 = frame2->data[0] + y * frame2->linesize[0];
+	const int width = std::min(frame1->width, frame2->width);
+	const int height = std::min(frame1->height, frame2->height);
+	const uint8_t* plane1 = frame1->data[0];
+	const uint8_t* plane2 = frame2->data[0];
+	const int stride1 = frame1->linesize[0];
+	const int stride2 = frame2->linesize[0];
+	
+	// Luma checksums are taken while the rows are in cache, when both frames
+	// are the compared size (a checksum covers the whole frame)
+	const AVCRC* crcTable = av_crc_get_table(AV_CRC_32_IEEE);
+	const bool inlineChecksums = checksums && frame1->width == frame2->width && frame1->height == frame2->height;
+	uint32_t crc1 = 0;
+	uint32_t crc2 = 0;
+	auto checksumRows = [&](int begin, int end) {
+		for (int y = begin; y < end; y++) {
+			crc1 = av_crc(crcTable, crc1, plane1 + y * stride1, width);
+			crc2 = av_crc(crcTable, crc2, plane2 + y * stride2, width);
+		}
+	};
+	
+	// Walk the plane in bands of four rows. Each band's 4x4 block sums give
+	// its squared error, and SSIM windows pair them with the band above.
+	const int blocksX = width / 4;
+	const int blocksY = height / 4;
+	const int tailX = blocksX * 4;
+	std::vector<kernels::BlockSums> above(blocksX), current(blocksX);
+	uint64_t sse = 0;
+	double ssimSum = 0.0;
+	int windows = 0;
+	
+	for (int by = 0; by < blocksY; by++) {
+		const int y = by * 4;
+		kernels::blockSums4x4(plane1 + y * stride1, stride1, plane2 + y * stride2, stride2, blocksX, current.data());
+		for (const auto& block : current) {
+			sse += static_cast<uint64_t>(block.sumSquares) - 2 * static_cast<uint64_t>(block.sumProducts);
+		}
+		for (int row = y; row < y + 4; row++) {
+			sse += kernels::sumSquaredError(plane1 + row * stride1 + tailX, plane2 + row * stride2 + tailX,
+											width - tailX);
+		}
+		
+		if (by > 0) {
+			for (int bx = 0; bx + 1 < blocksX; bx++) {
+				ssimSum += kernels::windowSSIM(above[bx], above[bx + 1], current[bx], current[bx + 1]);
+				windows++;
+			}
+		}
+		std::swap(above, current);
 		
-		for (int x = 0; x < width; x++) {
-			int diff = ptr1[x] - ptr2[x];
-			mse += diff * diff;
+		if (inlineChecksums) {
+			checksumRows(y, y + 4);
 		}
 	}
+	for (int row = blocksY * 4; row < height; row++) {
+		sse += kernels::sumSquaredError(plane1 + row * stride1, plane2 + row * stride2, width);
+	}
+	if (inlineChecksums) {
+		checksumRows(blocksY * 4, height);
+	}
 	
-	if (mse == 0) return 100.0;  // Identical frames
+	if (sse > 0) {
+		double mse = static_cast<double>(sse) / (static_cast<double>(width) * height);
+		metrics.psnr = 20.0 * log10(255.0 / sqrt(mse));
+	}
+	if (windows > 0) {
+		metrics.ssim = ssimSum / windows;
+	} else {
+		// Too small for one window
+		metrics.ssim = sse == 0 ? 1.0 : 0.0;
+	}
 	
-	double mseD = static_cast<double>(mse) / (width * height);
-	double psnr = 20.0 * log10(255.0 / sqrt(mseD));
+	if (inlineChecksums) {
+		metrics.checksum1 = checksumChroma(frame1, crc1);
+		metrics.checksum2 = checksumChroma(frame2, crc2);
+	} else if (checksums) {
+		metrics.checksum1 = calculateFrameChecksum(frame1);
+		metrics.checksum2 = calculateFrameChecksum(frame2);
+	}
 	
-	return psnr;
-}
-
-double VideoComparator::calculateSSIM(AVFrame* frame1, AVFrame* frame2) {
-	// TODO: Implement SSIM calculation if needed
-	// This is more expensive than PSNR but provides better perceptual similarity
-	return 0.0;
+	return metrics;
 }
 
 uint64_t VideoComparator::calculateFrameChecksum(AVFrame* frame) {
@@ -184,23 +337,31 @@ uint64_t VideoComparator::calculateFrameChecksum(AVFrame* frame) {
 	}
 	
 	// Also include U and V planes for YUV formats
-	if (frame->format == AV_PIX_FMT_YUV420P || 
-		frame->format == AV_PIX_FMT_YUV422P ||
-		frame->format == AV_PIX_FMT_YUV444P) {
-		
-		int chromaHeight = frame->height >> (frame->format == AV_PIX_FMT_YUV420P ? 1 : 0);
-		int chromaWidth = frame->width >> (frame->format != AV_PIX_FMT_YUV444P ? 1 : 0);
-		
-		for (int p = 1; p <= 2; p++) {
-			for (int y = 0; y < chromaHeight; y++) {
-				crc = av_crc(crcTable, crc,
-							frame->data[p] + y * frame->linesize[p],
-							chromaWidth);
-			}
-		}
+	return checksumChroma(frame, crc);
+}
+
+AVFrame* VideoComparator::convertToYUV420P(AVFrame* frame, SwsContext** swsCtx) {
+	*swsCtx = sws_getCachedContext(*swsCtx, frame->width, frame->height,
+								   static_cast<AVPixelFormat>(frame->format),
+								   frame->width, frame->height, AV_PIX_FMT_YUV420P,
+								   SWS_BILINEAR, nullptr, nullptr, nullptr);
+	if (!*swsCtx) {
+		return nullptr;
 	}
 	
-	return crc;
+	AVFrame* converted = av_frame_alloc();
+	converted->format = AV_PIX_FMT_YUV420P;
+	converted->width = frame->width;
+	converted->height = frame->height;
+	if (av_frame_get_buffer(converted, 0) < 0) {
+		av_frame_free(&converted);
+		return nullptr;
+	}
+	
+	sws_scale(*swsCtx, frame->data, frame->linesize, 0, frame->height,
+			  converted->data, converted->linesize);
+	converted->pts = frame->pts;
+	return converted;
 }
 
 bool VideoComparator::VideoReader::open(const std::string& path) {
@@ -248,6 +409,9 @@ bool VideoComparator::VideoReader::open(const std::string& path) {
 		return false;
 	}
 	
+	// Decode with the codec's own threads as well
+	codecCtx->thread_count = 0;
+	
 	// Open codec
 	if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
 		close();
@@ -260,42 +424,44 @@ bool VideoComparator::VideoReader::open(const std::string& path) {
 AVFrame* VideoComparator::VideoReader::readNextFrame() {
 	if (!formatCtx || !codecCtx) return nullptr;
 	
-	AVPacket packet;
-	av_init_packet(&packet);
+	AVFrame* frame = av_frame_alloc();
+	AVPacket* packet = av_packet_alloc();
 	
-	while (av_read_frame(formatCtx, &packet) >= 0) {
-		if (packet.stream_index == videoStreamIndex) {
-			// Send packet to decoder
-			int ret = avcodec_send_packet(codecCtx, &packet);
-			av_packet_unref(&packet);
-			
-			if (ret < 0) {
-				continue;
-			}
-			
-			// Get decoded frame
-			AVFrame* frame = av_frame_alloc();
-			ret = avcodec_receive_frame(codecCtx, frame);
-			
-			if (ret == 0) {
-				return frame;
-			} else {
-				av_frame_free(&frame);
-			}
-		} else {
-			av_packet_unref(&packet);
+	while (true) {
+		// Frames the decoder holds come first; a threaded decoder can have
+		// several ready after one packet
+		int ret = avcodec_receive_frame(codecCtx, frame);
+		if (ret == 0) {
+			break;
+		}
+		if (ret != AVERROR(EAGAIN)) {
+			// Flushed, or a decoder error
+			av_frame_free(&frame);
+			break;
 		}
+		
+		if (av_read_frame(formatCtx, packet) < 0) {
+			// Flush decoder
+			avcodec_send_packet(codecCtx, nullptr);
+			continue;
+		}
+		if (packet->stream_index == videoStreamIndex) {
+			avcodec_send_packet(codecCtx, packet);
+		}
+		av_packet_unref(packet);
 	}
-	
-	// Flush decoder
-	avcodec_send_packet(codecCtx, nullptr);
-	AVFrame* frame = av_frame_alloc();
-	if (avcodec_receive_frame(codecCtx, frame) == 0) {
-		return frame;
+	av_packet_free(&packet);
+	
+	// Compare anything but 8-bit planar YUV as YUV420P
+	if (frame && !isPlanarYUV8(frame->format)) {
+		AVFrame* converted = convertToYUV420P(frame, &swsCtx);
+		if (converted) {
+			av_frame_free(&frame);
+			frame = converted;
+		}
 	}
-	av_frame_free(&frame);
 	
-	return nullptr;
+	return frame;
 }
 
 void VideoComparator::VideoReader::close() {
@@ -339,7 +505,9 @@ std::string ComparisonResult::summary() const {
 	ss << "  Avg PSNR: " << std::fixed << std::setprecision(2) << avgPSNR << " dB\n";
 	ss << "  Min PSNR: " << minPSNR << " dB\n";
 	ss << "  Max PSNR: " << maxPSNR << " dB\n";
-	ss << "  Mismatched Frames: " << mismatchedFrames << "\n";
+	ss << "  Avg SSIM: " << std::setprecision(4) << avgSSIM << "\n";
+	ss << "  Min SSIM: " << minSSIM << "\n";
+	ss << "  Mismatched Frames: " << mismatchedFrames << (stoppedEarly ? " (stopped early)" : "") << "\n";
 	ss << "  Visually Identical: " << (isVisuallyIdentical() ? "Yes" : "No") << "\n";
 	
 	if (!errorMsg.empty()) {
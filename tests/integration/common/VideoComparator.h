@@ -4,6 +4,7 @@
 #include <vector>
 #include <optional>
 #include <cstdint>
+#include <memory>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -28,9 +29,12 @@ struct ComparisonResult {
 	double avgPSNR = 0.0;
 	double minPSNR = 100.0;
 	double maxPSNR = 0.0;
+	double avgSSIM = 0.0;
+	double minSSIM = 1.0;
 	int maxFrameDiff = 0;
 	int totalFrames = 0;
 	int mismatchedFrames = 0;
+	bool stoppedEarly = false;  // Mismatch limit reached before the end
 	
 	// Checksums for exact comparison
 	std::vector<FrameChecksum> ourChecksums;
@@ -50,6 +54,12 @@ struct ComparisonResult {
 	std::string summary() const;
 };
 
+/**
+ * Compares two videos frame by frame. Both videos are decoded at the same
+ * time on their own threads, and batches of frame pairs are measured in
+ * parallel. PSNR, SSIM and the checksums of a frame pair come from one pass
+ * over the planes (see FrameKernels.h). PSNR and SSIM are of the luma plane.
+ */
 class VideoComparator {
 public:
 	VideoComparator();
@@ -66,14 +76,30 @@ public:
 	// Calculate PSNR between two frames
 	static double calculatePSNR(AVFrame* frame1, AVFrame* frame2);
 	
-	// Calculate SSIM between two frames (optional, more expensive)
+	// Calculate SSIM between two frames
 	static double calculateSSIM(AVFrame* frame1, AVFrame* frame2);
 	
 	// Set comparison tolerance
 	void setPSNRThreshold(double threshold) { psnrThreshold_ = threshold; }
 	void setMaxFramesToCompare(int maxFrames) { maxFramesToCompare_ = maxFrames; }
 	
+	// Stop once this many frames are below the PSNR threshold (-1 = never)
+	void setMaxMismatchedFrames(int maxMismatches) { maxMismatchedFrames_ = maxMismatches; }
+	
+	// Threads measuring frames (0 = all cores)
+	void setThreads(int threads) { threads_ = threads; }
+	
 private:
+	using FramePtr = std::shared_ptr<AVFrame>;
+	
+	// Everything measured on one pair of frames
+	struct FrameMetrics {
+		double psnr = 100.0;
+		double ssim = 1.0;
+		uint64_t checksum1 = 0;
+		uint64_t checksum2 = 0;
+	};
+	
 	struct VideoReader {
 		AVFormatContext* formatCtx = nullptr;
 		AVCodecContext* codecCtx = nullptr;
@@ -89,11 +115,16 @@ private:
 	// Calculate checksum for a frame
 	static uint64_t calculateFrameChecksum(AVFrame* frame);
 	
+	// PSNR, SSIM and (optionally) checksums of a pair of frames in one pass
+	static FrameMetrics measureFrames(AVFrame* frame1, AVFrame* frame2, bool checksums);
+	
 	// Convert frame to common format for comparison
 	static AVFrame* convertToYUV420P(AVFrame* frame, SwsContext** swsCtx);
 	
 	double psnrThreshold_ = 35.0;  // Visually identical threshold
 	int maxFramesToCompare_ = -1;   // -1 means compare all frames
+	int maxMismatchedFrames_ = -1;  // -1 means never stop early
+	int threads_ = 0;
 };
 
 // Utility function to load checksums from file
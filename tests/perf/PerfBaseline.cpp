@@ -0,0 +1,113 @@
+#include "PerfBaseline.h"
+#include <algorithm>
+
+namespace perf {
+
+namespace {
+
+bool measured(const nlohmann::json& scenario) {
+	return scenario.is_object() && !scenario.contains("skipped") && !scenario.contains("error") &&
+		scenario.contains("fps");
+}
+
+nlohmann::json scenariosOf(const nlohmann::json& document) {
+	if (document.is_object() && document.contains("scenarios") && document["scenarios"].is_object()) {
+		return document["scenarios"];
+	}
+	return nlohmann::json::object();
+}
+
+}
+
+bool BaselineComparison::hasRegression() const {
+	return std::any_of(changes.begin(), changes.end(), [](const MetricChange& change) {
+		return change.regression;
+	});
+}
+
+Tolerances tolerancesOf(const nlohmann::json& baseline, const Tolerances& defaults) {
+	Tolerances tolerances = defaults;
+	if (baseline.is_object() && baseline.contains("tolerances")) {
+		const nlohmann::json& stored = baseline["tolerances"];
+		tolerances.fps = stored.value("fps", tolerances.fps);
+		tolerances.cpu = stored.value("cpu", tolerances.cpu);
+		tolerances.memory = stored.value("memory", tolerances.memory);
+	}
+	return tolerances;
+}
+
+BaselineComparison compareWithBaseline(const nlohmann::json& results, const nlohmann::json& baseline,
+	const Tolerances& tolerances) {
+	BaselineComparison comparison;
+	const nlohmann::json current = scenariosOf(results);
+	const nlohmann::json stored = scenariosOf(baseline);
+	
+	for (const auto& [name, before] : stored.items()) {
+		if (!measured(before)) {
+			continue;
+		}
+		if (!current.contains(name) || !measured(current[name])) {
+			comparison.missing.push_back(name);
+			continue;
+		}
+		const nlohmann::json& now = current[name];
+		
+		// Frames per second must not drop; CPU time and memory must not grow
+		struct Check {
+			const char* metric;
+			double tolerance;
+			bool higherIsBetter;
+		};
+		const Check checks[] = {
+			{"fps", tolerances.fps, true},
+			{"cpu_seconds", tolerances.cpu, false},
+			{"peak_rss_bytes", tolerances.memory, false}
+		};
+		for (const Check& check : checks) {
+			if (!before.contains(check.metric) || !now.contains(check.metric)) {
+				continue;
+			}
+			MetricChange change;
+			change.scenario = name;
+			change.metric = check.metric;
+			change.baseline = before[check.metric].get<double>();
+			change.current = now[check.metric].get<double>();
+			if (change.baseline <= 0.0) {
+				continue;
+			}
+			change.change = (change.current - change.baseline) / change.baseline;
+			change.regression = check.higherIsBetter ? change.change < -check.tolerance :
+				change.change > check.tolerance;
+			comparison.changes.push_back(change);
+		}
+	}
+	
+	for (const auto& [name, now] : current.items()) {
+		if (measured(now) && !(stored.contains(name) && measured(stored[name]))) {
+			comparison.added.push_back(name);
+		}
+	}
+	
+	return comparison;
+}
+
+nlohmann::json makeBaseline(const nlohmann::json& results, const Tolerances& tolerances) {
+	const nlohmann::json measuredScenarios = scenariosOf(results);
+	nlohmann::json scenarios = nlohmann::json::object();
+	for (const auto& [name, scenario] : measuredScenarios.items()) {
+		if (measured(scenario)) {
+			scenarios[name] = scenario;
+		}
+	}
+	
+	nlohmann::json baseline = {
+		{"tolerances", {{"fps", tolerances.fps}, {"cpu", tolerances.cpu}, {"memory", tolerances.memory}}},
+		{"scenarios", scenarios}
+	};
+	if (results.contains("host")) {
+		baseline["host"] = results["host"];
+	}
+	return baseline;
+}
+
+} // namespace perf
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace perf {
+
+/**
+ * Checks of a perf run against a stored baseline. Results and baselines
+ * share one layout:
+ *
+ *   {"scenarios": {"<name>": {"frames", "seconds", "fps", "cpu_seconds",
+ *                             "peak_rss_bytes"}, ...},
+ *    "tolerances": {"fps", "cpu", "memory"}}      (baselines only)
+ *
+ * A scenario that was skipped or failed has "skipped" or "error" instead of
+ * its measurements and is left out of the comparison.
+ */
+
+// Largest accepted change of each metric, as a fraction of the baseline
+struct Tolerances {
+	double fps = 0.10;          // Fewer frames per second
+	double cpu = 0.15;          // More CPU time
+	double memory = 0.20;       // Higher peak memory
+};
+
+// One metric of one scenario against the baseline
+struct MetricChange {
+	std::string scenario;
+	std::string metric;         // "fps", "cpu_seconds" or "peak_rss_bytes"
+	double baseline = 0.0;
+	double current = 0.0;
+	double change = 0.0;        // (current - baseline) / baseline
+	bool regression = false;
+};
+
+struct BaselineComparison {
+	std::vector<MetricChange> changes;
+	std::vector<std::string> missing;   // In the baseline, not measured now
+	std::vector<std::string> added;     // Measured now, not in the baseline
+	
+	bool hasRegression() const;
+};
+
+// Tolerances of a baseline; ones it does not set come from defaults
+Tolerances tolerancesOf(const nlohmann::json& baseline, const Tolerances& defaults = Tolerances());
+
+BaselineComparison compareWithBaseline(const nlohmann::json& results, const nlohmann::json& baseline,
+	const Tolerances& tolerances);
+
+// Baseline holding the measured scenarios of results and the tolerances
+nlohmann::json makeBaseline(const nlohmann::json& results, const Tolerances& tolerances);
+
+} // namespace perf
\ No newline at end of file
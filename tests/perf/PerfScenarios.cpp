@@ -0,0 +1,144 @@
+#include "PerfScenarios.h"
+#include <cmath>
+
+namespace perf {
+
+namespace {
+
+MediaSpec spec(int height, int gop, const std::string& codec = "libx264") {
+	MediaSpec media;
+	media.width = height * 16 / 9;
+	media.height = height;
+	media.gop = gop;
+	media.codec = codec;
+	return media;
+}
+
+Scenario scenario(const std::string& name, Shape shape, const MediaSpec& media, int seconds = 10) {
+	Scenario s;
+	s.name = name;
+	s.shape = shape;
+	s.media = media;
+	s.seconds = seconds;
+	return s;
+}
+
+nlohmann::json videoClip(double in, double out, const std::string& uri, double sourceIn, int fps) {
+	return {
+		{"in", in},
+		{"out", out},
+		{"track", {{"type", "video"}, {"number", 1}}},
+		{"source", {
+			{"uri", uri},
+			{"trackId", "V1"},
+			{"in", sourceIn},
+			{"out", sourceIn + (out - in)},
+			{"fps", fps}
+		}}
+	};
+}
+
+// Brightness ramp from 0.1 to 0.9 over an effect clip
+nlohmann::json brightnessClip(double in, double out) {
+	nlohmann::json linear = nlohmann::json::array({
+		{{"src", 0.0}, {"dst", 0.1}},
+		{{"src", 1.0}, {"dst", 0.9}}
+	});
+	return {
+		{"in", in},
+		{"out", out},
+		{"track", {{"type", "video"}, {"number", 1}, {"subtype", "effects"}, {"subnumber", 1}}},
+		{"source", {
+			{"type", "highlight"},
+			{"in", 0.0},
+			{"out", out - in},
+			{"insideMaskFilters", nlohmann::json::array({{
+				{"type", "brightness"},
+				{"controlPoints", nlohmann::json::array({
+					{{"point", 0.0}, {"linear", linear}},
+					{{"point", out - in}, {"linear", linear}}
+				})}
+			}})},
+			{"outsideMaskFilters", nlohmann::json::array()},
+			{"interpolation", "linear"}
+		}}
+	};
+}
+
+}
+
+std::vector<MediaSpec> Scenario::sources() const {
+	int count = shape == Shape::ManySources ? 16 : 2;
+	std::vector<MediaSpec> specs;
+	for (int i = 0; i < count; i++) {
+		MediaSpec source = media;
+		source.variant = i;
+		specs.push_back(source);
+	}
+	return specs;
+}
+
+nlohmann::json Scenario::edl(const std::vector<std::string>& files) const {
+	const int fps = media.fps;
+	double clipSeconds = 2.0;
+	if (shape == Shape::DenseCuts) {
+		clipSeconds = 5.0 / fps;
+	} else if (shape == Shape::ManySources) {
+		clipSeconds = 1.0;
+	}
+	// Source in points stay a clip short of the end of the source
+	const double sourceRange = media.seconds - clipSeconds;
+	
+	nlohmann::json clips = nlohmann::json::array();
+	const int clipCount = static_cast<int>(std::lround(seconds / clipSeconds));
+	for (int i = 0; i < clipCount; i++) {
+		double in = i * clipSeconds;
+		double out = in + clipSeconds;
+		const std::string& file = files[i % files.size()];
+		
+		// Dense cuts jump around the source, so most clips start with a seek;
+		// the others read forward from a few points
+		double sourceIn = shape == Shape::DenseCuts ? std::fmod(i * 2.3, sourceRange) :
+			std::fmod((i / static_cast<int>(files.size())) * 1.5, sourceRange);
+		sourceIn = std::round(sourceIn * fps) / fps;
+		
+		nlohmann::json clip = videoClip(in, out, file, sourceIn, fps);
+		if (shape == Shape::Fades) {
+			clip["topFade"] = 0.5;
+			clip["tailFade"] = 0.5;
+		} else if (shape == Shape::Effects) {
+			clip["motion"] = {{"panX", 0.1}, {"panY", -0.05}, {"zoomX", 1.25}, {"zoomY", 1.25}};
+		}
+		clips.push_back(clip);
+		
+		if (shape == Shape::Effects) {
+			clips.push_back(brightnessClip(in, out));
+		}
+	}
+	
+	return {{"fps", fps}, {"width", media.width}, {"height", media.height}, {"clips", clips}};
+}
+
+const std::vector<Scenario>& allScenarios() {
+	static const std::vector<Scenario> scenarios = {
+		// Resolutions and GOP lengths, cuts only
+		scenario("cuts_720p_long_gop", Shape::Cuts, spec(720, 300)),
+		scenario("cuts_1080p_long_gop", Shape::Cuts, spec(1080, 300)),
+		scenario("cuts_1080p_short_gop", Shape::Cuts, spec(1080, 15)),
+		scenario("cuts_4k_long_gop", Shape::Cuts, spec(2160, 300), 5),
+		scenario("cuts_4k_short_gop", Shape::Cuts, spec(2160, 15), 5),
+		// Source codecs
+		scenario("cuts_1080p_mpeg4", Shape::Cuts, spec(1080, 300, "mpeg4")),
+		scenario("cuts_1080p_hevc", Shape::Cuts, spec(1080, 300, "libx265")),
+		// Timeline shapes
+		scenario("dense_cuts_1080p_long_gop", Shape::DenseCuts, spec(1080, 300)),
+		scenario("dense_cuts_1080p_short_gop", Shape::DenseCuts, spec(1080, 15)),
+		scenario("fades_1080p", Shape::Fades, spec(1080, 300)),
+		scenario("effects_1080p", Shape::Effects, spec(1080, 300)),
+		scenario("many_sources_720p", Shape::ManySources, spec(720, 300), 16),
+		scenario("long_timeline_720p", Shape::LongTimeline, spec(720, 300), 60)
+	};
+	return scenarios;
+}
+
+} // namespace perf
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "SyntheticMedia.h"
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace perf {
+
+// Timeline shapes the scenarios render
+enum class Shape {
+	Cuts,           // Two-second clips alternating between two sources
+	DenseCuts,      // Five-frame clips, each seeking somewhere else
+	Fades,          // Cuts with a fade in and out on every clip
+	Effects,        // Cuts with a brightness effect and a pan/zoom on every clip
+	ManySources,    // One-second clips cycling through sixteen sources
+	LongTimeline    // Cuts over a minute of output
+};
+
+struct Scenario {
+	std::string name;
+	Shape shape = Shape::Cuts;
+	MediaSpec media;            // Spec of every source (variants 0..n-1)
+	int seconds = 10;           // Output length
+	
+	// Sources the scenario reads, one variant of media each
+	std::vector<MediaSpec> sources() const;
+	
+	/**
+	 * EDL of the scenario at the media's size and frame rate
+	 * @param files Files of sources(), relative to the media directory
+	 */
+	nlohmann::json edl(const std::vector<std::string>& files) const;
+};
+
+// Every scenario of the harness, in run order
+const std::vector<Scenario>& allScenarios();
+
+} // namespace perf
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "SyntheticMedia.h"
+#include "media/FFmpegEncoder.h"
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace perf {
+
+namespace {
+
+// SMPTE-like bars as Y, U, V: white, yellow, cyan, green, magenta, red, blue, black
+const uint8_t BAR_COLORS[8][3] = {
+	{235, 128, 128}, {210, 16, 146}, {170, 166, 16}, {145, 54, 34},
+	{106, 202, 222}, {81, 90, 240}, {41, 240, 110}, {16, 128, 128}
+};
+
+// Cheap deterministic hash for the grain
+inline uint32_t hash(uint32_t x, uint32_t y, uint32_t n) {
+	uint32_t h = x * 73856093u ^ y * 19349663u ^ n * 83492791u;
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	return h ^ (h >> 15);
+}
+
+}
+
+std::string MediaSpec::fileName() const {
+	return "perf_" + std::to_string(width) + "x" + std::to_string(height) + "_" + std::to_string(fps) + "fps_" +
+		std::to_string(seconds) + "s_gop" + std::to_string(gop) + "_" + codec +
+		(variant > 0 ? "_v" + std::to_string(variant) : std::string()) + ".mp4";
+}
+
+void drawTestPattern(AVFrame* frame, int n) {
+	const int width = frame->width;
+	const int height = frame->height;
+	const int barsHeight = height * 3 / 4;
+	const int barWidth = std::max(1, width / 8);
+	const int scroll = n * 4;
+	
+	// Bars with grain on top, luma ramp below
+	for (int y = 0; y < height; y++) {
+		uint8_t* row = frame->data[0] + y * frame->linesize[0];
+		if (y < barsHeight) {
+			for (int x = 0; x < width; x++) {
+				int bar = ((x + scroll) / barWidth) % 8;
+				int grain = static_cast<int>(hash(x, y, n) & 15) - 8;
+				row[x] = static_cast<uint8_t>(std::clamp(BAR_COLORS[bar][0] + grain, 16, 235));
+			}
+		} else {
+			for (int x = 0; x < width; x++) {
+				row[x] = static_cast<uint8_t>(16 + x * 219 / width);
+			}
+		}
+	}
+	for (int plane = 1; plane < 3; plane++) {
+		for (int y = 0; y < height / 2; y++) {
+			uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+			for (int x = 0; x < width / 2; x++) {
+				row[x] = y * 2 < barsHeight ? BAR_COLORS[((x * 2 + scroll) / barWidth) % 8][plane] : 128;
+			}
+		}
+	}
+	
+	// Box bouncing between the edges
+	const int box = std::max(8, height / 8);
+	const int rangeX = std::max(1, width - box);
+	const int rangeY = std::max(1, height - box);
+	int boxX = (n * 7) % (2 * rangeX);
+	int boxY = (n * 5) % (2 * rangeY);
+	boxX = boxX < rangeX ? boxX : 2 * rangeX - boxX;
+	boxY = boxY < rangeY ? boxY : 2 * rangeY - boxY;
+	for (int y = boxY; y < boxY + box && y < height; y++) {
+		std::fill_n(frame->data[0] + y * frame->linesize[0] + boxX, std::min(box, width - boxX), 235);
+	}
+	
+	// Frame number, most significant bit first
+	const int bit = std::max(4, width / 64);
+	for (int b = 0; b < 16 && (b + 1) * bit <= width; b++) {
+		uint8_t value = (n >> (15 - b)) & 1 ? 235 : 16;
+		for (int y = 0; y < bit && y < height; y++) {
+			std::fill_n(frame->data[0] + y * frame->linesize[0] + b * bit, bit, value);
+		}
+	}
+}
+
+bool canEncode(const std::string& codec) {
+	return avcodec_find_encoder_by_name(codec.c_str()) != nullptr;
+}
+
+std::string ensureMedia(const MediaSpec& spec, const std::filesystem::path& dir) {
+	auto path = dir / spec.fileName();
+	if (std::filesystem::exists(path)) {
+		return path.string();
+	}
+	if (!canEncode(spec.codec)) {
+		throw std::runtime_error("Encoder not available: " + spec.codec);
+	}
+	std::filesystem::create_directories(dir);
+	
+	media::FFmpegEncoder::Config config;
+	config.codec = spec.codec;
+	config.width = spec.width;
+	config.height = spec.height;
+	config.frameRate = {spec.fps, 1};
+	config.bitrate = spec.width * spec.height * spec.fps / 8;  // About 0.12 bits per pixel
+	config.preset = "veryfast";
+	// Short GOPs are forced keyframes; the encoder's own GOP is 300 frames
+	config.forcedIdr = spec.gop < 300;
+	
+	// Written under another name, so an interrupted run is not reused
+	auto partial = path;
+	partial += ".partial.mp4";
+	bool ok = false;
+	AVFrame* frame = av_frame_alloc();
+	frame->width = spec.width;
+	frame->height = spec.height;
+	frame->format = AV_PIX_FMT_YUV420P;
+	try {
+		media::FFmpegEncoder encoder(partial.string(), config);
+		ok = av_frame_get_buffer(frame, 0) >= 0;
+		
+		const int frames = spec.fps * spec.seconds;
+		for (int n = 0; n < frames && ok; n++) {
+			// The encoder may still reference the last frame's buffers
+			if (av_frame_make_writable(frame) < 0) {
+				ok = false;
+				break;
+			}
+			// Variants start at different points of the pattern
+			drawTestPattern(frame, n + spec.variant * 1000);
+			if (config.forcedIdr && n % spec.gop == 0) {
+				encoder.forceKeyframe();
+			}
+			ok = encoder.writeFrame(frame);
+		}
+		ok = ok && encoder.finalize();
+	} catch (const std::exception&) {
+		ok = false;
+	}
+	av_frame_free(&frame);
+	if (!ok) {
+		std::filesystem::remove(partial);
+		throw std::runtime_error("Failed to encode " + path.string());
+	}
+	std::filesystem::rename(partial, path);
+	
+	return path.string();
+}
+
+} // namespace perf
\ No newline at end of file
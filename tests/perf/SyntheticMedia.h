@@ -0,0 +1,41 @@
+#pragma once
+
+#include "media/MediaTypes.h"
+#include <filesystem>
+#include <string>
+
+namespace perf {
+
+// A generated source clip
+struct MediaSpec {
+	int width = 1920;
+	int height = 1080;
+	int fps = 30;
+	int seconds = 10;
+	int gop = 300;                  // Frames between keyframes
+	std::string codec = "libx264";
+	int variant = 0;                // Distinct clips of one spec
+	
+	// File name, unique per spec
+	std::string fileName() const;
+};
+
+/**
+ * Draw frame n of the test pattern into a YUV 4:2:0 frame: scrolling colour
+ * bars with film grain, a luma ramp, a box bouncing across the picture and
+ * the frame number as a row of binary blocks. The same n always gives the
+ * same picture, and every frame differs from the last, so encoders and
+ * decoders do real work.
+ */
+void drawTestPattern(AVFrame* frame, int n);
+
+/**
+ * Path of the clip for spec in dir, encoded in-process on first use
+ * @throws std::runtime_error if the codec is not available or encoding fails
+ */
+std::string ensureMedia(const MediaSpec& spec, const std::filesystem::path& dir);
+
+// Whether this FFmpeg build can encode spec's codec
+bool canEncode(const std::string& codec);
+
+} // namespace perf
\ No newline at end of file
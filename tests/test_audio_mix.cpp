@@ -0,0 +1,135 @@
+#include "audio/AudioKernels.h"
+#include "audio/AudioTimeline.h"
+#include "edl/EDLParser.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+static bool near(float a, float b, float tolerance = 1e-4f) {
+	return std::fabs(a - b) <= tolerance;
+}
+
+void testMixWithRamp() {
+	std::cout << "Testing gain ramp kernel" << std::endl;
+	
+	// Odd lengths exercise both the vector body and the scalar tail
+	for (int count : {1, 3, 4, 7, 64, 1023}) {
+		std::vector<float> src(count), dst(count, 0.5f);
+		for (int i = 0; i < count; ++i) {
+			src[i] = std::sin(i * 0.1f);
+		}
+		
+		audio::kernels::mixWithRamp(dst.data(), src.data(), count, 0.2f, 1.0f);
+		
+		float step = (1.0f - 0.2f) / count;
+		for (int i = 0; i < count; ++i) {
+			assert(near(dst[i], 0.5f + src[i] * (0.2f + step * i)));
+		}
+	}
+	
+	std::cout << "  ✓ Ramp matches the scalar reference" << std::endl;
+}
+
+void testClampSamples() {
+	std::cout << "Testing sample clamp kernel" << std::endl;
+	
+	std::vector<float> data = {-3.0f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f, 2.0f, 0.25f, -1.5f};
+	audio::kernels::clampSamples(data.data(), static_cast<int>(data.size()));
+	
+	std::vector<float> expected = {-1.0f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f, 1.0f, 0.25f, -1.0f};
+	for (size_t i = 0; i < data.size(); ++i) {
+		assert(data[i] == expected[i]);
+	}
+	
+	std::cout << "  ✓ Samples limited to [-1, 1]" << std::endl;
+}
+
+void testAudioTimeline() {
+	std::cout << "Testing audio timeline automation" << std::endl;
+	
+	nlohmann::json j = {
+		{"fps", 30},
+		{"width", 1920},
+		{"height", 1080},
+		{"clips", {
+			{
+				{"in", 0}, {"out", 10},
+				{"track", {{"type", "audio"}, {"number", 1}}},
+				{"source", {{"uri", "music.wav"}, {"trackId", "A1"}, {"in", 5}, {"out", 15}, {"audiomix", "avg"}}},
+				{"channelMap", {{"1", 1.0}}}
+			},
+			{
+				{"in", 2}, {"out", 6},
+				{"track", {{"type", "audio"}, {"number", 1}, {"subtype", "level"}}},
+				{"source", {{"in", 0}, {"out", 4}, {"controlPoints", {
+					{{"point", 0}, {"db", 0}},
+					{{"point", 2}, {"db", "-Infinity"}}
+				}}}}
+			},
+			{
+				{"in", 0}, {"out", 10},
+				{"track", {{"type", "audio"}, {"number", 1}, {"subtype", "pan"}}},
+				{"source", {{"in", 0}, {"out", 10}, {"controlPoints", {
+					{{"point", 0}, {"pan", -1}},
+					{{"point", 10}, {"pan", 1}}
+				}}}}
+			}
+		}}
+	};
+	
+	edl::EDL edl = edl::EDLParser::parseJSON(j);
+	audio::AudioTimeline timeline(edl);
+	
+	assert(timeline.getClips().size() == 1);
+	const auto& clip = timeline.getClips()[0];
+	assert(clip.uri == "music.wav");
+	assert(clip.sourceIn == 5.0);
+	assert(clip.average);
+	assert(clip.outputChannels.size() == 1 && clip.outputChannels[0] == 0);
+	assert(timeline.getDuration() == 10.0);
+	
+	// Unity outside the level clip, fading to silence over its first two seconds
+	assert(near(timeline.gainAt(1, 1.0), 1.0f));
+	assert(near(timeline.gainAt(1, 2.0), 1.0f));
+	assert(near(timeline.gainAt(1, 3.0), 0.5f));
+	assert(near(timeline.gainAt(1, 5.0), 0.0f));
+	assert(near(timeline.gainAt(1, 7.0), 1.0f));
+	
+	// Pan sweeps from left to right; other tracks stay centred at unity
+	assert(near(timeline.panAt(1, 0.0), -1.0f));
+	assert(near(timeline.panAt(1, 5.0), 0.0f));
+	assert(near(timeline.panAt(2, 5.0), 0.0f));
+	assert(near(timeline.gainAt(2, 5.0), 1.0f));
+	
+	assert(near(audio::AudioTimeline::dbToGain(-6.0f), 0.501187f));
+	
+	std::cout << "  ✓ Level and pan follow the control points" << std::endl;
+	
+	// Passthrough candidates: nowhere on the panned track, everywhere on an empty one
+	assert(timeline.unityRanges(1, 0.0, 10.0).empty());
+	auto untouched = timeline.unityRanges(2, 0.0, 10.0);
+	assert(untouched.size() == 1 && untouched[0].start == 0.0 && untouched[0].end == 10.0);
+	
+	// Without the pan track only the level clip's fade and silence are excluded
+	j["clips"].erase(2);
+	audio::AudioTimeline levelOnly(edl::EDLParser::parseJSON(j));
+	auto unity = levelOnly.unityRanges(1, 0.0, 10.0);
+	assert(unity.size() == 2);
+	assert(unity[0].start == 0.0 && unity[0].end == 2.0);
+	assert(unity[1].start == 6.0 && unity[1].end == 10.0);
+	
+	std::cout << "  ✓ Unity ranges exclude level and pan changes" << std::endl;
+}
+
+int main() {
+	std::cout << "Running audio mix tests..." << std::endl;
+	
+	testMixWithRamp();
+	testClampSamples();
+	testAudioTimeline();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
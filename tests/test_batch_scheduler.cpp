@@ -0,0 +1,133 @@
+#include "render/BatchScheduler.h"
+#include "compositor/TimelineSpan.h"
+#include <iostream>
+#include <cassert>
+
+using render::BatchScheduler;
+
+BatchScheduler::Range range(const std::string& source, double start, double end) {
+	BatchScheduler::Range r;
+	r.source = source;
+	r.start = start;
+	r.end = end;
+	return r;
+}
+
+void testOrder() {
+	std::cout << "Testing batch order" << std::endl;
+	
+	std::vector<BatchScheduler::Footprint> jobs = {
+		{range("b.mov", 30.0, 40.0)},                               // 0
+		{range("a.mov", 50.0, 70.0)},                               // 1
+		{},                                                         // 2: no media
+		{range("a.mov", 10.0, 30.0), range("b.mov", 0.0, 5.0)},     // 3
+		{range("b.mov", 5.0, 15.0)},                                // 4
+		{range("a.mov", 0.0, 10.0)}                                 // 5
+	};
+	BatchScheduler scheduler(jobs);
+	
+	assert(scheduler.getMainSource(3) == "a.mov");
+	assert(scheduler.getMainSource(2).empty());
+	
+	// a.mov is read for 50 seconds, b.mov for 20: a.mov's jobs come first, by
+	// where they start; the job without media comes last
+	std::vector<int> expected = {5, 3, 1, 4, 0, 2};
+	assert(scheduler.getOrder() == expected);
+	std::cout << "  ✓ Jobs are grouped by main source and ordered by start" << std::endl;
+	
+	// Ties between groups go by name, whatever the input order
+	BatchScheduler tied({{range("z.mov", 0.0, 1.0)}, {range("y.mov", 0.0, 1.0)}});
+	assert(tied.getOrder() == std::vector<int>({1, 0}));
+	std::cout << "  ✓ Equal groups are ordered by name" << std::endl;
+}
+
+void testNext() {
+	std::cout << "Testing job dispatch" << std::endl;
+	
+	std::vector<BatchScheduler::Footprint> jobs = {
+		{range("a.mov", 0.0, 30.0)},
+		{range("a.mov", 30.0, 60.0)},
+		{range("b.mov", 0.0, 20.0)},
+		{}
+	};
+	BatchScheduler scheduler(jobs);
+	assert(scheduler.getOrder() == std::vector<int>({0, 1, 2, 3}));
+	
+	// While job 0 reads a.mov, the next job goes to another source
+	assert(scheduler.next() == 0);
+	assert(scheduler.next() == 2);
+	assert(scheduler.next() == 3);
+	
+	// Only job 1 is left; it runs even though its source is busy
+	assert(scheduler.next() == 1);
+	assert(scheduler.next() == -1);
+	std::cout << "  ✓ Running jobs are kept on different sources" << std::endl;
+	
+	BatchScheduler sequential(jobs);
+	assert(sequential.next() == 0);
+	sequential.finished(0);
+	assert(sequential.next() == 1);
+	sequential.finished(1);
+	assert(sequential.next() == 2);
+	assert(sequential.next() == 3);
+	assert(sequential.next() == -1);
+	std::cout << "  ✓ One job at a time follows the order" << std::endl;
+}
+
+void testFootprint() {
+	std::cout << "Testing timeline footprint" << std::endl;
+	
+	compositor::CompiledTimeline timeline;
+	timeline.fps = 25;
+	timeline.sources = {"a.mov", "b.mov"};
+	
+	// Clip of a.mov at timeline 0-4 s, source in 10 s, split into two spans
+	compositor::TimelineSpan first;
+	first.startFrame = 0;
+	first.endFrame = 50;
+	first.kind = compositor::TimelineSpan::Media;
+	first.sourceIndex = 0;
+	first.clipIn = 0.0;
+	first.clipOut = 4.0;
+	first.sourceIn = 10.0;
+	compositor::TimelineSpan second = first;
+	second.startFrame = 50;
+	second.endFrame = 100;
+	
+	compositor::TimelineSpan gap;
+	gap.startFrame = 100;
+	gap.endFrame = 125;
+	
+	compositor::TimelineSpan other;
+	other.startFrame = 125;
+	other.endFrame = 150;
+	other.kind = compositor::TimelineSpan::Media;
+	other.sourceIndex = 1;
+	other.clipIn = 5.0;
+	other.clipOut = 6.0;
+	other.sourceIn = 2.0;
+	
+	timeline.spans = {first, second, gap, other};
+	timeline.totalFrames = 150;
+	
+	BatchScheduler::Footprint footprint = BatchScheduler::footprintOf(timeline,
+		[](const std::string& uri) { return "/media/" + uri; });
+	assert(footprint.size() == 3);
+	assert(footprint[0].source == "/media/a.mov");
+	assert(footprint[0].start == 10.0 && footprint[0].end == 12.0);
+	assert(footprint[1].start == 12.0 && footprint[1].end == 14.0);
+	assert(footprint[2].source == "/media/b.mov");
+	assert(footprint[2].start == 2.0 && footprint[2].end == 3.0);
+	std::cout << "  ✓ Media spans map to the source seconds they read" << std::endl;
+}
+
+int main() {
+	std::cout << "Running batch scheduler tests..." << std::endl;
+	
+	testOrder();
+	testNext();
+	testFootprint();
+	
+	std::cout << "\nAll batch scheduler tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
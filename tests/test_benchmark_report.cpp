@@ -0,0 +1,72 @@
+#include "utils/BenchmarkReport.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+void testHistogramPercentiles() {
+	std::cout << "Testing stage histogram" << std::endl;
+	
+	utils::StageHistogram histogram;
+	assert(histogram.percentile(0.5) == 0.0);
+	
+	// 90 samples of 1 ms and 10 of 20 ms
+	for (int i = 0; i < 90; i++) {
+		histogram.add(0.001);
+	}
+	for (int i = 0; i < 10; i++) {
+		histogram.add(0.020);
+	}
+	assert(histogram.getCount() == 100);
+	assert(std::abs(histogram.getTotal() - 0.29) < 1e-9);
+	assert(histogram.getMin() == 0.001 && histogram.getMax() == 0.020);
+	
+	// Buckets are within 19% of the sample, and clamped to the observed range
+	double p50 = histogram.percentile(0.50);
+	double p90 = histogram.percentile(0.90);
+	double p99 = histogram.percentile(0.99);
+	assert(p50 >= 0.001 && p50 < 0.001 * 1.19);
+	assert(p90 >= 0.001 && p90 < 0.001 * 1.19);
+	assert(p99 == 0.020);
+	
+	// Bounds grow by a quarter octave per bucket
+	assert(std::abs(utils::StageHistogram::bucketBound(4) / utils::StageHistogram::bucketBound(0) - 2.0) < 1e-9);
+	
+	std::cout << "  ✓ Percentiles follow the buckets" << std::endl;
+}
+
+void testReportJson() {
+	std::cout << "Testing benchmark report" << std::endl;
+	
+	utils::BenchmarkReport report("composite");
+	report.setInfo("edl", "test.json");
+	report.setInfo("width", 1920);
+	for (int i = 0; i < 50; i++) {
+		report.record("decode", 0.004);
+		report.record("composite", 0.002);
+	}
+	
+	auto json = nlohmann::json::parse(report.toJson(50, 2.0));
+	assert(json["mode"] == "composite");
+	assert(json["edl"] == "test.json");
+	assert(json["width"] == 1920);
+	assert(json["frames"] == 50);
+	assert(std::abs(json["fps"].get<double>() - 25.0) < 1e-9);
+	assert(json["stages"]["decode"]["count"] == 50);
+	assert(std::abs(json["stages"]["composite"]["mean_ms"].get<double>() - 2.0) < 1e-9);
+	assert(json["stages"]["decode"]["histogram"].size() == 1);
+	assert(json["stages"]["decode"]["histogram"][0]["count"] == 50);
+	assert(json.contains("peak_rss_bytes"));
+	
+	std::cout << "  ✓ Report lists every stage" << std::endl;
+}
+
+int main() {
+	std::cout << "Running benchmark report tests..." << std::endl;
+	
+	testHistogramPercentiles();
+	testReportJson();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
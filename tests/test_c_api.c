@@ -0,0 +1,198 @@
+/* The library API from C: sessions, options, frames, renders and cancel */
+
+#include "api/edl2ffmpeg.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/* Two seconds of black at 25 fps; needs no media files */
+static const char* BLACK_EDL =
+	"{\"fps\": 25, \"width\": 320, \"height\": 240, \"clips\": [{"
+	"\"in\": 0, \"out\": 2, \"track\": {\"type\": \"video\", \"number\": 1},"
+	"\"source\": {\"generate\": {\"type\": \"black\"}, \"in\": 0, \"out\": 2,"
+	"\"width\": 320, \"height\": 240}}]}";
+
+typedef struct {
+	int reports;
+	int lastFrame;
+	int done;
+} ProgressLog;
+
+static void onProgress(const edl2ffmpeg_progress* progress, void* userData) {
+	ProgressLog* log = (ProgressLog*)userData;
+	log->reports++;
+	log->lastFrame = progress->frame;
+	log->done = progress->done;
+}
+
+static void testSession(void) {
+	printf("Testing sessions and options\n");
+	
+	assert(edl2ffmpeg_api_version() == EDL2FFMPEG_API_VERSION);
+	
+	assert(edl2ffmpeg_session_create_from_string("{not json", NULL) == NULL);
+	assert(strlen(edl2ffmpeg_last_error()) > 0);
+	assert(edl2ffmpeg_session_create_from_file("/nonexistent/edit.json") == NULL);
+	
+	edl2ffmpeg_session* session = edl2ffmpeg_session_create_from_string(BLACK_EDL, NULL);
+	assert(session != NULL);
+	
+	edl2ffmpeg_info info;
+	assert(edl2ffmpeg_session_get_info(session, &info) == EDL2FFMPEG_OK);
+	assert(info.width == 320 && info.height == 240);
+	assert(info.frame_rate == 25 && info.total_frames == 50);
+	
+	assert(edl2ffmpeg_session_set_option(session, "codec", "mpeg4") == EDL2FFMPEG_OK);
+	assert(edl2ffmpeg_session_set_option(session, "crf", "5") == EDL2FFMPEG_OK);
+	assert(edl2ffmpeg_session_set_option(session, "crf", "high") == EDL2FFMPEG_INVALID_ARGUMENT);
+	assert(edl2ffmpeg_session_set_option(session, "no_such_option", "1") == EDL2FFMPEG_INVALID_ARGUMENT);
+	assert(strstr(edl2ffmpeg_last_error(), "no_such_option") != NULL);
+	
+	edl2ffmpeg_session_destroy(session);
+	printf("  ✓ Bad EDLs and options are reported through the last error\n");
+}
+
+static void testFrames(void) {
+	printf("Testing frame access\n");
+	
+	edl2ffmpeg_session* session = edl2ffmpeg_session_create_from_string(BLACK_EDL, NULL);
+	assert(session != NULL);
+	
+	/* Out of order, and black: one luma value, neutral chroma */
+	int numbers[] = {49, 0, 25};
+	for (int i = 0; i < 3; i++) {
+		edl2ffmpeg_frame frame;
+		assert(edl2ffmpeg_get_frame(session, numbers[i], &frame) == EDL2FFMPEG_OK);
+		assert(frame.number == numbers[i]);
+		assert(frame.width == 320 && frame.height == 240);
+		uint8_t black = frame.data[0][0];
+		assert(black <= 16);
+		for (int y = 0; y < frame.height; y++) {
+			for (int x = 0; x < frame.width; x++) {
+				assert(frame.data[0][y * frame.linesize[0] + x] == black);
+			}
+		}
+		for (int y = 0; y < frame.height / 2; y++) {
+			for (int x = 0; x < frame.width / 2; x++) {
+				assert(frame.data[1][y * frame.linesize[1] + x] == 128);
+				assert(frame.data[2][y * frame.linesize[2] + x] == 128);
+			}
+		}
+	}
+	
+	edl2ffmpeg_frame frame;
+	assert(edl2ffmpeg_get_frame(session, 50, &frame) == EDL2FFMPEG_INVALID_ARGUMENT);
+	assert(edl2ffmpeg_get_frame(session, -1, &frame) == EDL2FFMPEG_INVALID_ARGUMENT);
+	
+	edl2ffmpeg_session_destroy(session);
+	printf("  ✓ Frames come composited, in any order\n");
+}
+
+static void testRender(void) {
+	printf("Testing renders\n");
+	
+	edl2ffmpeg_session* session = edl2ffmpeg_session_create_from_string(BLACK_EDL, NULL);
+	assert(session != NULL);
+	assert(edl2ffmpeg_session_set_option(session, "codec", "mpeg4") == EDL2FFMPEG_OK);
+	assert(edl2ffmpeg_session_set_option(session, "bitrate", "200000") == EDL2FFMPEG_OK);
+	
+	ProgressLog log = {0, 0, 0};
+	edl2ffmpeg_session_set_progress_callback(session, onProgress, &log);
+	assert(edl2ffmpeg_render(session, "test_c_api.mp4") == EDL2FFMPEG_OK);
+	assert(log.reports > 0 && log.done && log.lastFrame == 50);
+	
+	FILE* output = fopen("test_c_api.mp4", "rb");
+	assert(output != NULL);
+	fseek(output, 0, SEEK_END);
+	assert(ftell(output) > 0);
+	fclose(output);
+	remove("test_c_api.mp4");
+	printf("  ✓ A synchronous render writes the output and reports progress\n");
+	
+	/* The same session again, in the background */
+	assert(edl2ffmpeg_render_async(session, "test_c_api_async.mp4") == EDL2FFMPEG_OK);
+	edl2ffmpeg_status status = edl2ffmpeg_wait(session);
+	assert(status == EDL2FFMPEG_OK);
+	remove("test_c_api_async.mp4");
+	
+	/* No render is running after wait, so there is nothing to cancel */
+	edl2ffmpeg_cancel(session);
+	assert(edl2ffmpeg_wait(session) == EDL2FFMPEG_OK);
+	printf("  ✓ An asynchronous render reports its result through wait\n");
+	
+	edl2ffmpeg_session_destroy(session);
+}
+
+#ifndef _WIN32
+static void* waitForRender(void* session) {
+	return (void*)(intptr_t)edl2ffmpeg_wait((edl2ffmpeg_session*)session);
+}
+
+static void testConcurrentWaits(void) {
+	printf("Testing concurrent waits\n");
+	
+	edl2ffmpeg_session* session = edl2ffmpeg_session_create_from_string(BLACK_EDL, NULL);
+	assert(session != NULL);
+	assert(edl2ffmpeg_session_set_option(session, "codec", "mpeg4") == EDL2FFMPEG_OK);
+	
+	for (int round = 0; round < 2; round++) {
+		assert(edl2ffmpeg_render_async(session, "test_c_api_waits.mp4") == EDL2FFMPEG_OK);
+		pthread_t waiters[3];
+		for (int i = 0; i < 3; i++) {
+			assert(pthread_create(&waiters[i], NULL, waitForRender, session) == 0);
+		}
+		assert(edl2ffmpeg_wait(session) == EDL2FFMPEG_OK);
+		for (int i = 0; i < 3; i++) {
+			void* result = NULL;
+			assert(pthread_join(waiters[i], &result) == 0);
+			assert((edl2ffmpeg_status)(intptr_t)result == EDL2FFMPEG_OK);
+		}
+	}
+	remove("test_c_api_waits.mp4");
+	
+	edl2ffmpeg_session_destroy(session);
+	printf("  ✓ Every waiter returns once the render has finished\n");
+}
+#endif
+
+static void cancelOnFirstReport(const edl2ffmpeg_progress* progress, void* userData) {
+	(void)progress;
+	edl2ffmpeg_cancel((edl2ffmpeg_session*)userData);
+}
+
+static void testCancel(void) {
+	printf("Testing cancel\n");
+	
+	edl2ffmpeg_session* session = edl2ffmpeg_session_create_from_string(BLACK_EDL, NULL);
+	assert(session != NULL);
+	assert(edl2ffmpeg_session_set_option(session, "codec", "mpeg4") == EDL2FFMPEG_OK);
+	edl2ffmpeg_session_set_progress_callback(session, cancelOnFirstReport, session);
+	
+	assert(edl2ffmpeg_render(session, "test_c_api_cancel.mp4") == EDL2FFMPEG_CANCELLED);
+	remove("test_c_api_cancel.mp4");
+	
+	edl2ffmpeg_session_destroy(session);
+	printf("  ✓ A render cancelled from its progress callback stops early\n");
+}
+
+int main(void) {
+	printf("Running C API tests...\n");
+	
+	edl2ffmpeg_set_log_level(EDL2FFMPEG_LOG_ERROR);
+	testSession();
+	testFrames();
+	testRender();
+#ifndef _WIN32
+	testConcurrentWaits();
+#endif
+	testCancel();
+	edl2ffmpeg_release_decoders();
+	
+	printf("\nAll C API tests passed!\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "media/FFmpegDecoder.h"
+#include "perf/SyntheticMedia.h"
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+// Opens path with probe as the cached probe and decodes its first frame
+void decodeFirstFrame(const std::string& path, std::shared_ptr<const media::SourceProbe> probe,
+	bool expectCached) {
+	media::FFmpegDecoder::Config config;
+	config.probe = std::move(probe);
+	media::FFmpegDecoder decoder(path, config);
+	assert(decoder.usedCachedProbe() == expectCached);
+	assert(decoder.getPixelFormat() == AV_PIX_FMT_YUV420P);
+	
+	auto frame = decoder.getFrame(0);
+	assert(frame != nullptr);
+	assert(frame->width == 160 && frame->height == 120);
+	assert(frame->format == AV_PIX_FMT_YUV420P);
+}
+
+void testCachedProbeDecodes(const std::string& path) {
+	std::cout << "Testing decoders opened from a cached probe" << std::endl;
+	
+	media::SourceProbe probe;
+	{
+		media::FFmpegDecoder decoder(path);
+		assert(!decoder.usedCachedProbe());
+		probe = decoder.getProbe();
+	}
+	assert(probe.isValid());
+	assert(probe.pixelFormat == AV_PIX_FMT_YUV420P);
+	
+	// H.264 only reports its pixel format after the first decode, so this
+	// open relies on the format stored in the probe
+	decodeFirstFrame(path, std::make_shared<const media::SourceProbe>(probe), true);
+	std::cout << "  ✓ First frame decodes without stream info discovery" << std::endl;
+	
+	media::SourceProbe unknownFormat = probe;
+	unknownFormat.pixelFormat = AV_PIX_FMT_NONE;
+	assert(!unknownFormat.isValid());
+	decodeFirstFrame(path, std::make_shared<const media::SourceProbe>(unknownFormat), false);
+	std::cout << "  ✓ Probes without a pixel format are not trusted" << std::endl;
+}
+
+int main() {
+	std::cout << "Running decoder probe tests..." << std::endl;
+	
+	perf::MediaSpec spec;
+	spec.width = 160;
+	spec.height = 120;
+	spec.fps = 25;
+	spec.seconds = 1;
+	spec.gop = 25;
+	if (!perf::canEncode(spec.codec)) {
+		std::cout << "Skipped: no " << spec.codec << " encoder" << std::endl;
+		return 0;
+	}
+	
+	fs::path tempDir = fs::temp_directory_path() / "edl2ffmpeg_test_decoder_probe";
+	fs::remove_all(tempDir);
+	testCachedProbeDecodes(perf::ensureMedia(spec, tempDir));
+	fs::remove_all(tempDir);
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "utils/FrameArena.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+AVFrame* makeFrame(int width, int height) {
+	AVFrame* frame = av_frame_alloc();
+	assert(frame);
+	frame->format = AV_PIX_FMT_YUV420P;
+	frame->width = width;
+	frame->height = height;
+	int ret = utils::FrameArena::getInstance().getFrameBuffer(frame, 32);
+	assert(ret == 0);
+	(void)ret;
+	return frame;
+}
+
+}
+
+void testDisabledFallsBack() {
+	std::cout << "Testing the disabled arena" << std::endl;
+	
+	utils::FrameArena& arena = utils::FrameArena::getInstance();
+	assert(!utils::FrameArena::isEnabled());
+	assert(arena.allocate(1024) == nullptr);
+	
+	AVFrame* frame = makeFrame(64, 48);
+	assert(frame->data[0] != nullptr);
+	assert(arena.getStats().mappedBytes == 0);
+	av_frame_free(&frame);
+	
+	std::cout << "  ✓ Frames come from av_frame_get_buffer until the arena is enabled" << std::endl;
+}
+
+void testPlaneLayout() {
+	std::cout << "Testing plane layout" << std::endl;
+	
+	AVFrame* frame = makeFrame(1918, 1080);
+	assert(frame->buf[0] != nullptr);
+	assert(frame->buf[1] == nullptr);   // all planes share one buffer
+	
+	for (int i = 0; i < 3; i++) {
+		assert(reinterpret_cast<uintptr_t>(frame->data[i]) % 64 == 0);
+		assert(frame->linesize[i] % 32 == 0);
+	}
+	assert(frame->linesize[0] >= 1918);
+	assert(frame->linesize[1] >= 959);
+	assert(frame->data[1] >= frame->data[0] + frame->linesize[0] * 1080);
+	assert(frame->data[2] >= frame->data[1] + frame->linesize[1] * 540);
+	assert(frame->data[2] + frame->linesize[2] * 540 <= frame->buf[0]->data + frame->buf[0]->size);
+	
+	// Every byte of every plane is usable
+	std::memset(frame->data[0], 16, frame->linesize[0] * 1080);
+	std::memset(frame->data[1], 128, frame->linesize[1] * 540);
+	std::memset(frame->data[2], 128, frame->linesize[2] * 540);
+	av_frame_free(&frame);
+	
+	// Large frames start on a huge page boundary
+	frame = makeFrame(3840, 2160);
+	assert(reinterpret_cast<uintptr_t>(frame->data[0]) % utils::FrameArena::HUGE_PAGE_SIZE == 0);
+	av_frame_free(&frame);
+	
+	std::cout << "  ✓ Planes are aligned, padded and do not overlap" << std::endl;
+}
+
+void testBlocksAreReused() {
+	std::cout << "Testing block reuse" << std::endl;
+	
+	utils::FrameArena& arena = utils::FrameArena::getInstance();
+	
+	AVFrame* frame = makeFrame(1280, 720);
+	uint8_t* first = frame->data[0];
+	auto before = arena.getStats();
+	assert(before.inUseBytes >= utils::FrameArena::frameBytes(AV_PIX_FMT_YUV420P, 1280, 720));
+	av_frame_free(&frame);
+	
+	auto released = arena.getStats();
+	assert(released.inUseBytes < before.inUseBytes);
+	assert(released.freeBytes > before.freeBytes);
+	
+	// Another reference keeps the block until it is released as well
+	frame = makeFrame(1280, 720);
+	assert(frame->data[0] == first);
+	AVBufferRef* extra = av_buffer_ref(frame->buf[0]);
+	av_frame_free(&frame);
+	assert(arena.getStats().inUseBytes == before.inUseBytes);
+	av_buffer_unref(&extra);
+	
+	auto after = arena.getStats();
+	assert(after.reused == released.reused + 1);
+	assert(after.mappedBytes == released.mappedBytes);
+	assert(after.inUseBytes == released.inUseBytes);
+	
+	std::cout << "  ✓ Released buffers are handed out again without mapping more memory" << std::endl;
+}
+
+void testConcurrentUse() {
+	std::cout << "Testing concurrent allocation" << std::endl;
+	
+	utils::FrameArena& arena = utils::FrameArena::getInstance();
+	size_t inUse = arena.getStats().inUseBytes;
+	
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([t]() {
+			for (int i = 0; i < 200; i++) {
+				AVFrame* frame = makeFrame(320 + 16 * t, 240);
+				frame->data[0][0] = static_cast<uint8_t>(i);
+				av_frame_free(&frame);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	
+	assert(arena.getStats().inUseBytes == inUse);
+	
+	std::cout << "  ✓ Every buffer was returned" << std::endl;
+}
+
+int main() {
+	std::cout << "Running frame arena tests..." << std::endl;
+	
+	testDisabledFallsBack();
+	
+	utils::FrameArena::Config config;
+	config.regionBytes = 16 * 1024 * 1024;
+	config.prefault = true;
+	utils::FrameArena::getInstance().enable(config);
+	
+	testPlaneLayout();
+	testBlocksAreReused();
+	testConcurrentUse();
+	
+	std::cout << "\nAll frame arena tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
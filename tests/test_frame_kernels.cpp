@@ -0,0 +1,107 @@
+#include "integration/common/FrameKernels.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace test::kernels;
+
+void testBlockSums() {
+	std::cout << "Testing 4x4 block sums" << std::endl;
+	
+	// 23 blocks: five vector steps and a scalar tail; odd strides
+	const int blocks = 23;
+	const int strideA = blocks * 4 + 3;
+	const int strideB = blocks * 4 + 7;
+	std::mt19937 rng(7);
+	std::vector<uint8_t> a(strideA * 4), b(strideB * 4);
+	for (auto& p : a) p = rng() & 0xFF;
+	for (auto& p : b) p = rng() & 0xFF;
+	// Extremes, so the widest sums are exercised
+	for (int y = 0; y < 4; y++) {
+		for (int x = 0; x < 4; x++) {
+			a[y * strideA + x] = 255;
+			b[y * strideB + x] = 255;
+		}
+	}
+	
+	std::vector<BlockSums> sums(blocks);
+	blockSums4x4(a.data(), strideA, b.data(), strideB, blocks, sums.data());
+	for (int block = 0; block < blocks; block++) {
+		BlockSums expected;
+		for (int y = 0; y < 4; y++) {
+			for (int x = block * 4; x < block * 4 + 4; x++) {
+				uint32_t pa = a[y * strideA + x];
+				uint32_t pb = b[y * strideB + x];
+				expected.sumA += pa;
+				expected.sumB += pb;
+				expected.sumSquares += pa * pa + pb * pb;
+				expected.sumProducts += pa * pb;
+			}
+		}
+		assert(sums[block].sumA == expected.sumA);
+		assert(sums[block].sumB == expected.sumB);
+		assert(sums[block].sumSquares == expected.sumSquares);
+		assert(sums[block].sumProducts == expected.sumProducts);
+	}
+	assert(sums[0].sumA == 16 * 255 && sums[0].sumSquares == 32 * 255 * 255);
+	std::cout << "  ✓ Vector and scalar blocks match the reference" << std::endl;
+}
+
+void testSquaredError() {
+	std::cout << "Testing squared error" << std::endl;
+	
+	std::mt19937 rng(11);
+	for (int count : {0, 5, 16, 31, 1920, 7681}) {
+		std::vector<uint8_t> a(count), b(count);
+		uint64_t expected = 0;
+		for (int i = 0; i < count; i++) {
+			a[i] = rng() & 0xFF;
+			b[i] = rng() & 0xFF;
+			int diff = a[i] - b[i];
+			expected += diff * diff;
+		}
+		assert(sumSquaredError(a.data(), b.data(), count) == expected);
+	}
+	
+	// Largest error per pixel over a long row
+	std::vector<uint8_t> white(1 << 20, 255), black(1 << 20, 0);
+	assert(sumSquaredError(white.data(), black.data(), 1 << 20) == (uint64_t(1) << 20) * 255 * 255);
+	std::cout << "  ✓ Matches the reference for any length, without overflow" << std::endl;
+}
+
+void testSSIM() {
+	std::cout << "Testing window SSIM" << std::endl;
+	
+	// An 8x8 window: four blocks of two rows of four
+	std::mt19937 rng(3);
+	std::vector<uint8_t> a(8 * 8), b(8 * 8), flat(8 * 8, 128);
+	for (auto& p : a) p = rng() & 0xFF;
+	for (size_t i = 0; i < b.size(); i++) b[i] = 255 - a[i];
+	
+	auto ssim = [](const std::vector<uint8_t>& x, const std::vector<uint8_t>& y) {
+		BlockSums top[2], bottom[2];
+		blockSums4x4(x.data(), 8, y.data(), 8, 2, top);
+		blockSums4x4(x.data() + 32, 8, y.data() + 32, 8, 2, bottom);
+		return windowSSIM(top[0], top[1], bottom[0], bottom[1]);
+	};
+	
+	assert(std::abs(ssim(a, a) - 1.0) < 1e-12);
+	assert(std::abs(ssim(flat, flat) - 1.0) < 1e-12);
+	// Inverted content is anti-correlated
+	assert(ssim(a, b) < 0.0);
+	assert(ssim(a, flat) < 0.1);
+	std::cout << "  ✓ Identical windows score 1, unrelated ones near or below 0" << std::endl;
+}
+
+int main() {
+	std::cout << "Running frame kernel tests..." << std::endl;
+	
+	testBlockSums();
+	testSquaredError();
+	testSSIM();
+	
+	std::cout << "\nAll frame kernel tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "utils/FrameBuffer.h"
+#include "utils/MemoryBudget.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+void testReuse() {
+	std::cout << "Testing frame reuse" << std::endl;
+	
+	utils::FrameBufferPool pool(64, 48, AV_PIX_FMT_YUV420P, 4);
+	
+	AVFrame* first = nullptr;
+	{
+		auto frame = pool.getFrame();
+		assert(frame->width == 64 && frame->height == 48);
+		assert(frame->data[0] != nullptr);
+		frame->pts = 99;
+		first = frame.get();
+	}
+	auto again = pool.getFrame();
+	assert(again.get() == first);
+	assert(again->pts == 0);
+	
+	auto stats = pool.getStats();
+	assert(stats.hits == 2);    // both served from the pre-allocated frames
+	assert(stats.misses == 0);
+	assert(stats.inUse == 1);
+	
+	std::cout << "  ✓ Released frames come back with their metadata reset" << std::endl;
+}
+
+void testSharedBuffersAreNotReused() {
+	std::cout << "Testing frames still referenced elsewhere" << std::endl;
+	
+	utils::FrameBufferPool pool(64, 48, AV_PIX_FMT_YUV420P, 1);
+	AVFrame* first = nullptr;
+	AVFrame* clone = nullptr;
+	{
+		auto frame = pool.getFrame();
+		std::memset(frame->data[0], 7, frame->linesize[0] * frame->height);
+		// As the encoder fan-out queues hold their frames
+		clone = av_frame_clone(frame.get());
+		assert(clone);
+		first = frame.get();
+	}
+	
+	auto next = pool.getFrame();
+	assert(next.get() == first);
+	assert(next->data[0] != clone->data[0]);
+	assert(av_frame_is_writable(next.get()));
+	std::memset(next->data[0], 9, next->linesize[0] * next->height);
+	assert(clone->data[0][0] == 7);
+	
+	auto stats = pool.getStats();
+	assert(stats.hits == 2 && stats.misses == 0);
+	assert(stats.allocated == 1);
+	av_frame_free(&clone);
+	
+	std::cout << "  ✓ A frame whose buffers are shared gets new ones, not overwritten" << std::endl;
+}
+
+void testDecodedFramesAreReused() {
+	std::cout << "Testing frames filled by a decoder" << std::endl;
+	
+	utils::FrameBufferPool pool(64, 48, AV_PIX_FMT_YUV420P, 1);
+	
+	// The decoder's picture, which it keeps as a reference frame
+	AVFrame* decoded = av_frame_alloc();
+	decoded->format = AV_PIX_FMT_YUV420P;
+	decoded->width = 64;
+	decoded->height = 48;
+	assert(av_frame_get_buffer(decoded, 0) >= 0);
+	std::memset(decoded->data[0], 3, decoded->linesize[0] * decoded->height);
+	
+	AVFrame* first = nullptr;
+	for (int i = 0; i < 3; i++) {
+		auto frame = pool.getFrame();
+		if (first) {
+			assert(frame.get() == first);
+			assert(frame->data[0] != decoded->data[0]);
+			assert(av_frame_is_writable(frame.get()));
+			std::memset(frame->data[0], 9, frame->linesize[0] * frame->height);
+		}
+		first = frame.get();
+		
+		// As avcodec_receive_frame does: unref, then move in the decoder's buffers
+		av_frame_unref(frame.get());
+		assert(av_frame_ref(frame.get(), decoded) >= 0);
+	}
+	assert(decoded->data[0][0] == 3);
+	
+	auto stats = pool.getStats();
+	assert(stats.hits == 3 && stats.misses == 0);
+	assert(stats.allocated == 1);
+	av_frame_free(&decoded);
+	
+	std::cout << "  ✓ The same frame is reused after its buffers were swapped" << std::endl;
+}
+
+void testTargetFollowsDepth() {
+	std::cout << "Testing adaptive pool size" << std::endl;
+	
+	utils::FrameBufferPool pool(32, 32, AV_PIX_FMT_YUV420P, 2);
+	
+	// Hold 12 frames at a time for a while: after the first window the pool
+	// keeps all of them and stops allocating
+	for (int round = 0; round < 100; round++) {
+		std::vector<std::shared_ptr<AVFrame>> held;
+		for (int i = 0; i < 12; i++) {
+			held.push_back(pool.getFrame());
+		}
+	}
+	auto deep = pool.getStats();
+	assert(deep.highWater == 12);
+	assert(deep.target == 12);
+	assert(deep.allocated == 12);
+	uint64_t missesAfterWarmup = deep.misses;
+	for (int round = 0; round < 10; round++) {
+		std::vector<std::shared_ptr<AVFrame>> held;
+		for (int i = 0; i < 12; i++) {
+			held.push_back(pool.getFrame());
+		}
+	}
+	assert(pool.getStats().misses == missesAfterWarmup);
+	
+	// One frame at a time: the target drops back and the extra frames go
+	for (int i = 0; i < 1000; i++) {
+		pool.getFrame();
+	}
+	auto shallow = pool.getStats();
+	assert(shallow.target == 2);
+	assert(shallow.allocated <= 2);
+	assert(shallow.trimmed >= 10);
+	
+	std::cout << "  ✓ Pool grew to " << deep.target << " frames and shrank back to " << shallow.target << std::endl;
+}
+
+void testFramesOutliveThePool() {
+	std::cout << "Testing frames released after the pool" << std::endl;
+	
+	std::shared_ptr<AVFrame> survivor;
+	{
+		utils::FrameBufferPool pool(16, 16, AV_PIX_FMT_YUV420P, 2);
+		survivor = pool.getFrame();
+		utils::FrameBufferPool moved = std::move(pool);
+		assert(moved.getStats().inUse == 1);
+	}
+	survivor->data[0][0] = 1;
+	survivor.reset();
+	
+	std::cout << "  ✓ The last frame frees the pool state" << std::endl;
+}
+
+void testMemoryPressure() {
+	std::cout << "Testing memory budget pressure" << std::endl;
+	
+	utils::MemoryBudget& budget = utils::MemoryBudget::getInstance();
+	uint64_t before = budget.getUsage();
+	{
+		utils::FrameBufferPool pool(64, 48, AV_PIX_FMT_YUV420P, 8);
+		auto held = pool.getFrame();
+		auto released = pool.getFrame();
+		size_t allocated = pool.getStats().allocated;
+		assert(allocated > 2);      // some still cached
+		assert(budget.getUsage() > before);
+		uint64_t frameBytes = (budget.getUsage() - before) / allocated;
+		
+		// Room for the held frame only: the released frame and the cached
+		// ones are given back
+		budget.setLimit(before + frameBytes);
+		released.reset();
+		
+		auto stats = pool.getStats();
+		assert(stats.allocated == 1);
+		assert(stats.inUse == 1);
+		assert(budget.getUsage() <= budget.getLimit());
+		budget.setLimit(0);
+	}
+	assert(budget.getUsage() == before);
+	
+	std::cout << "  ✓ Released and cached frames are freed while over budget" << std::endl;
+}
+
+void testConcurrentUse() {
+	std::cout << "Testing concurrent get/release" << std::endl;
+	
+	utils::FrameBufferPool pool(32, 32, AV_PIX_FMT_YUV420P, 8);
+	const int threads = 8;
+	const int iterations = 20000;
+	
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+		workers.emplace_back([&pool, t]() {
+			std::vector<std::shared_ptr<AVFrame>> held;
+			for (int i = 0; i < iterations; i++) {
+				auto frame = pool.getFrame();
+				// Nobody else may be writing this frame
+				frame->data[0][0] = static_cast<uint8_t>(t);
+				frame->pts = t;
+				assert(frame->data[0][0] == static_cast<uint8_t>(t) && frame->pts == t);
+				if (i % 3 == 0) {
+					held.push_back(frame);
+				}
+				if (held.size() > 4) {
+					held.clear();
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	
+	auto stats = pool.getStats();
+	assert(stats.inUse == 0);
+	assert(stats.hits + stats.misses == static_cast<uint64_t>(threads) * iterations);
+	assert(stats.highWater <= static_cast<size_t>(threads) * 6);
+	
+	std::cout << "  ✓ " << stats.hits << " hits, " << stats.misses << " misses, peak " << stats.highWater
+		<< " frames in use" << std::endl;
+}
+
+int main() {
+	std::cout << "Running frame buffer pool tests..." << std::endl;
+	
+	testReuse();
+	testSharedBuffersAreNotReused();
+	testDecodedFramesAreReused();
+	testTargetFollowsDepth();
+	testFramesOutliveThePool();
+	testMemoryPressure();
+	testConcurrentUse();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
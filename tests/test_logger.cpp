@@ -0,0 +1,109 @@
+#include "utils/Logger.h"
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+// Collects what the logger writes to stdout while in scope
+class CaptureStdout {
+public:
+	CaptureStdout() : previous(std::cout.rdbuf(captured.rdbuf())) {}
+	~CaptureStdout() { std::cout.rdbuf(previous); }
+	
+	std::string text() {
+		utils::Logger::flush();
+		return captured.str();
+	}
+	
+private:
+	std::ostringstream captured;
+	std::streambuf* previous;
+};
+
+}
+
+void testFormatting() {
+	std::cout << "Testing message formatting" << std::endl;
+	
+	utils::Logger::setLevel(utils::Logger::INFO);
+	std::string text;
+	{
+		CaptureStdout capture;
+		std::string name = "clip.mp4";
+		utils::Logger::info("{} at {} fps, {} frames, done: {}, {}", name, 29.97, 1800, true, 'x');
+		utils::Logger::info("no placeholders");
+		utils::Logger::debug("filtered {}", 1);
+		text = capture.text();
+	}
+	
+	assert(text.find("] [INFO] clip.mp4 at 29.97 fps, 1800 frames, done: 1, x\n") != std::string::npos);
+	assert(text.find("] [INFO] no placeholders\n") != std::string::npos);
+	assert(text.find("filtered") == std::string::npos);
+	assert(text[0] == '[');
+	
+	std::cout << "  ✓ Arguments fill the placeholders and filtered levels are dropped" << std::endl;
+}
+
+void testJsonFromThreads() {
+	std::cout << "Testing JSON output from several threads" << std::endl;
+	
+	const int threads = 4;
+	const int perThread = 2000;
+	std::string text;
+	{
+		CaptureStdout capture;
+		utils::Logger::setFormat(utils::Logger::JSON);
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([t]() {
+				for (int i = 0; i < perThread; i++) {
+					utils::Logger::warn("worker {} line {} \"quoted\"\t", t, i);
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		text = capture.text();
+		utils::Logger::setFormat(utils::Logger::TEXT);
+	}
+	
+	// Every line is a complete JSON object, and each thread's lines keep
+	// their order
+	std::istringstream lines(text);
+	std::string line;
+	std::vector<int> next(threads, 0);
+	int count = 0;
+	while (std::getline(lines, line)) {
+		auto record = nlohmann::json::parse(line);
+		assert(record["level"] == "warn");
+		assert(record["time"].get<std::string>().back() == 'Z');
+		int t = 0;
+		int i = 0;
+		std::string message = record["message"];
+		assert(std::sscanf(message.c_str(), "worker %d line %d", &t, &i) == 2);
+		assert(message.find("\"quoted\"\t") != std::string::npos);
+		assert(i == next[t]);
+		next[t]++;
+		count++;
+	}
+	assert(count == threads * perThread);
+	
+	std::cout << "  ✓ " << count << " records arrive whole and in order per thread" << std::endl;
+}
+
+int main() {
+	std::cout << "Running logger tests..." << std::endl;
+	
+	testFormatting();
+	testJsonFromThreads();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "utils/MemoryBudget.h"
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using utils::MemoryBudget;
+
+void testShareOrder() {
+	std::cout << "Testing shrink order" << std::endl;
+	
+	// 50 over the limit: caches cover 30 of it, queues the remaining 20
+	std::array<uint64_t, MemoryBudget::KINDS> reclaimable = {30, 40, 100, 0};
+	assert(MemoryBudget::share(100, 150, reclaimable, MemoryBudget::CACHE, 30) == 30);
+	assert(MemoryBudget::share(100, 150, reclaimable, MemoryBudget::QUEUE, 40) == 20);
+	assert(MemoryBudget::share(100, 150, reclaimable, MemoryBudget::DECODER, 100) == 0);
+	
+	// 80 over: decoders make up what caches and queues cannot
+	assert(MemoryBudget::share(100, 180, reclaimable, MemoryBudget::QUEUE, 40) == 40);
+	assert(MemoryBudget::share(100, 180, reclaimable, MemoryBudget::DECODER, 100) == 10);
+	
+	// Consumers of one kind split their share by what they could give back
+	assert(MemoryBudget::share(100, 150, reclaimable, MemoryBudget::QUEUE, 10) == 5);
+	
+	// Within the limit, without a limit and for fixed consumers: nothing
+	assert(MemoryBudget::share(200, 150, reclaimable, MemoryBudget::CACHE, 30) == 0);
+	assert(MemoryBudget::share(0, 150, reclaimable, MemoryBudget::CACHE, 30) == 0);
+	assert(MemoryBudget::share(100, 150, reclaimable, MemoryBudget::FIXED, 30) == 0);
+	
+	std::cout << "  ✓ Caches are asked first, then queues, then decoders" << std::endl;
+}
+
+void testAccounting() {
+	std::cout << "Testing usage accounting" << std::endl;
+	
+	MemoryBudget& budget = MemoryBudget::getInstance();
+	uint64_t before = budget.getUsage();
+	{
+		MemoryBudget::Consumer first("test pools", MemoryBudget::CACHE);
+		MemoryBudget::Consumer second("test pools", MemoryBudget::CACHE);
+		first.add(1000, 400);
+		second.add(500);
+		assert(budget.getUsage() == before + 1500);
+		
+		second.set(200, 0);
+		assert(budget.getUsage() == before + 1200);
+		
+		// Moving keeps the usage with the handle
+		MemoryBudget::Consumer moved = std::move(first);
+		assert(first.getBytes() == 0);
+		assert(moved.getBytes() == 1000);
+		first.add(999);
+		assert(budget.getUsage() == before + 1200);
+		
+		bool found = false;
+		for (const auto& usage : budget.getUsageByConsumer()) {
+			if (usage.name == "test pools") {
+				found = true;
+				assert(usage.bytes == 1200);
+				assert(usage.reclaimableBytes == 400);
+				assert(usage.peakBytes == 1500);
+			}
+		}
+		assert(found);
+	}
+	
+	// Destroyed handles take their usage with them
+	assert(budget.getUsage() == before);
+	
+	std::cout << "  ✓ Consumers of one name add up and leave nothing behind" << std::endl;
+}
+
+void testPressure() {
+	std::cout << "Testing pressure" << std::endl;
+	
+	MemoryBudget& budget = MemoryBudget::getInstance();
+	MemoryBudget::Consumer cache("test cache", MemoryBudget::CACHE);
+	MemoryBudget::Consumer decoders("test decoders", MemoryBudget::DECODER);
+	MemoryBudget::Consumer encoder("test encoder", MemoryBudget::FIXED);
+	cache.add(600, 600);
+	decoders.add(600, 300);
+	encoder.add(100, 100);
+	
+	assert(cache.pressure() == 0);
+	budget.setLimit(budget.getUsage() - 200);
+	
+	// The cache can cover the excess on its own
+	assert(cache.pressure() == 200);
+	assert(decoders.pressure() == 0);
+	assert(encoder.pressure() == 0);
+	
+	cache.add(-200, -200);
+	cache.released(200);
+	assert(cache.pressure() == 0);
+	assert(!budget.hasRoomFor(1));
+	
+	// Once the cache has nothing left to give, the decoders are asked
+	cache.add(0, -400);
+	budget.setLimit(budget.getUsage() - 150);
+	assert(cache.pressure() == 0);
+	assert(decoders.pressure() == 150);
+	
+	decoders.add(-150, -150);
+	assert(decoders.pressure() == 0);
+	
+	budget.setLimit(0);
+	assert(budget.hasRoomFor(UINT64_MAX / 2));
+	
+	std::cout << "  ✓ Pressure moves down the shrink order and ends with the excess" << std::endl;
+}
+
+void testConcurrentUse() {
+	std::cout << "Testing concurrent updates" << std::endl;
+	
+	MemoryBudget& budget = MemoryBudget::getInstance();
+	uint64_t before = budget.getUsage();
+	MemoryBudget::Consumer consumer("test queue", MemoryBudget::QUEUE);
+	
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&consumer]() {
+			for (int i = 0; i < 10000; i++) {
+				consumer.add(4096, 4096);
+				consumer.pressure();
+				consumer.add(-4096, -4096);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	
+	assert(budget.getUsage() == before);
+	assert(budget.getPeakUsage() >= before + 4096);
+	
+	std::cout << "  ✓ Updates from several threads add up" << std::endl;
+}
+
+int main() {
+	std::cout << "Running memory budget tests..." << std::endl;
+	
+	testShareOrder();
+	testAccounting();
+	testPressure();
+	testConcurrentUse();
+	
+	std::cout << "\nAll memory budget tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "perf/PerfBaseline.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+using nlohmann::json;
+
+json measurement(double fps, double cpu, double memory) {
+	return {{"frames", 300}, {"seconds", 300 / fps}, {"fps", fps}, {"cpu_seconds", cpu}, {"peak_rss_bytes", memory}};
+}
+
+const perf::MetricChange* find(const perf::BaselineComparison& comparison, const std::string& scenario,
+	const std::string& metric) {
+	for (const auto& change : comparison.changes) {
+		if (change.scenario == scenario && change.metric == metric) {
+			return &change;
+		}
+	}
+	return nullptr;
+}
+
+void testComparison() {
+	std::cout << "Testing baseline comparison" << std::endl;
+	
+	json baseline = {{"scenarios", {
+		{"cuts", measurement(100.0, 10.0, 400e6)},
+		{"fades", measurement(80.0, 12.0, 500e6)},
+		{"effects", measurement(60.0, 15.0, 600e6)},
+		{"gone", measurement(50.0, 5.0, 100e6)}
+	}}};
+	json results = {{"scenarios", {
+		{"cuts", measurement(95.0, 10.5, 410e6)},      // Within tolerance
+		{"fades", measurement(70.0, 12.0, 500e6)},     // 12.5% slower
+		{"effects", measurement(61.0, 18.0, 800e6)},   // 20% more CPU, 33% more memory
+		{"gone", {{"error", "decoder failed"}}},
+		{"new", measurement(30.0, 1.0, 1e6)}
+	}}};
+	
+	perf::BaselineComparison comparison = perf::compareWithBaseline(results, baseline, perf::Tolerances());
+	assert(comparison.hasRegression());
+	
+	assert(!find(comparison, "cuts", "fps")->regression);
+	assert(std::abs(find(comparison, "cuts", "fps")->change + 0.05) < 1e-9);
+	assert(!find(comparison, "cuts", "cpu_seconds")->regression);
+	assert(!find(comparison, "cuts", "peak_rss_bytes")->regression);
+	
+	assert(find(comparison, "fades", "fps")->regression);
+	assert(!find(comparison, "fades", "cpu_seconds")->regression);
+	
+	// Faster is never a regression, more CPU and memory beyond tolerance are
+	assert(!find(comparison, "effects", "fps")->regression);
+	assert(find(comparison, "effects", "cpu_seconds")->regression);
+	assert(find(comparison, "effects", "peak_rss_bytes")->regression);
+	
+	// A failed run is missing, not compared; a new scenario is listed
+	assert(!find(comparison, "gone", "fps"));
+	assert(comparison.missing == std::vector<std::string>({"gone"}));
+	assert(comparison.added == std::vector<std::string>({"new"}));
+	std::cout << "  ✓ Each metric is held to its own tolerance" << std::endl;
+	
+	perf::Tolerances loose;
+	loose.fps = 0.2;
+	loose.cpu = 0.25;
+	loose.memory = 0.5;
+	assert(!perf::compareWithBaseline(results, baseline, loose).hasRegression());
+	std::cout << "  ✓ Looser tolerances accept the same run" << std::endl;
+}
+
+void testBaselineFile() {
+	std::cout << "Testing baseline documents" << std::endl;
+	
+	json results = {
+		{"host", {{"hardware_threads", 8}}},
+		{"scenarios", {
+			{"cuts", measurement(100.0, 10.0, 400e6)},
+			{"hevc", {{"skipped", "Encoder not available: libx265"}}}
+		}}
+	};
+	perf::Tolerances tolerances;
+	tolerances.fps = 0.05;
+	json baseline = perf::makeBaseline(results, tolerances);
+	
+	// Only measured scenarios are kept, with the tolerances and the host
+	assert(baseline["scenarios"].size() == 1 && baseline["scenarios"].contains("cuts"));
+	assert(baseline["host"]["hardware_threads"] == 8);
+	perf::Tolerances stored = perf::tolerancesOf(baseline);
+	assert(stored.fps == 0.05 && stored.cpu == perf::Tolerances().cpu);
+	
+	// Unset tolerances fall back to the defaults given
+	perf::Tolerances defaults;
+	defaults.memory = 0.3;
+	assert(perf::tolerancesOf(json{{"tolerances", {{"cpu", 0.4}}}}, defaults).memory == 0.3);
+	assert(perf::tolerancesOf(json{{"tolerances", {{"cpu", 0.4}}}}, defaults).cpu == 0.4);
+	assert(perf::tolerancesOf(json()).fps == perf::Tolerances().fps);
+	
+	// A run against its own baseline passes
+	assert(!perf::compareWithBaseline(results, baseline, stored).hasRegression());
+	std::cout << "  ✓ Baselines keep measured scenarios and their tolerances" << std::endl;
+}
+
+int main() {
+	std::cout << "Running perf baseline tests..." << std::endl;
+	
+	testComparison();
+	testBaselineFile();
+	
+	std::cout << "\nAll perf baseline tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
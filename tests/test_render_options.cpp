@@ -0,0 +1,149 @@
+#include "render/RenderOptions.h"
+#include "server/JsonChannel.h"
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+using nlohmann::json;
+
+bool rejects(const json& job) {
+	try {
+		render::parseJobOptions(job);
+	} catch (const std::invalid_argument&) {
+		return true;
+	}
+	return false;
+}
+
+void testJobOptions() {
+	std::cout << "Testing render job options" << std::endl;
+	
+	render::Options defaults;
+	defaults.quiet = true;
+	defaults.threads = 4;
+	
+	json job = {
+		{"edl", "/media/cut.json"},
+		{"output", "/renders/cut.mp4"},
+		{"options", {{"codec", "libx265"}, {"crf", 28}, {"audio", false},
+			{"outputs", {"/renders/proxy.mp4,size=360,crf=30"}}}}
+	};
+	render::Options opts = render::parseJobOptions(job, defaults);
+	assert(opts.edlFile == "/media/cut.json");
+	assert(opts.edlJson.empty());
+	assert(opts.outputFile == "/renders/cut.mp4");
+	assert(opts.codec == "libx265");
+	assert(opts.crf == 28 && opts.bitrate == 0);
+	assert(!opts.audio);
+	assert(opts.quiet && opts.threads == 4);
+	assert(opts.extraOutputs.size() == 1);
+	assert(opts.extraOutputs[0].file == "/renders/proxy.mp4");
+	assert(opts.extraOutputs[0].height == 360 && opts.extraOutputs[0].crf == 30);
+	std::cout << "  ✓ Options override the defaults they start from" << std::endl;
+	
+	json inlineJob = {
+		{"edl", {{"fps", 25}, {"width", 1920}, {"height", 1080}, {"clips", json::array()}}},
+		{"media_dir", "/media"},
+		{"output", "/renders/inline.mp4"}
+	};
+	render::Options inlineOpts = render::parseJobOptions(inlineJob, opts);
+	assert(inlineOpts.edlFile.empty());
+	assert(json::parse(inlineOpts.edlJson)["fps"] == 25);
+	assert(inlineOpts.mediaDir == "/media");
+	std::cout << "  ✓ An inline EDL replaces the EDL file" << std::endl;
+	
+	assert(rejects({{"output", "out.mp4"}}));
+	assert(rejects({{"edl", "cut.json"}}));
+	assert(rejects({{"edl", 5}, {"output", "out.mp4"}}));
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"crf", "high"}}}}));
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"threads", -1}}}}));
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"verbose", true}}}}));
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"raw", "avi"}}}}));
+	std::cout << "  ✓ Missing fields, bad values and unknown keys are rejected" << std::endl;
+}
+
+void testProxy() {
+	std::cout << "Testing proxy render sizes" << std::endl;
+	
+	json job = {{"edl", "cut.json"}, {"output", "preview.mp4"}, {"options", {{"proxy", 4}}}};
+	assert(render::parseJobOptions(job).proxy == 4);
+	assert(render::parseJobOptions({{"edl", "cut.json"}, {"output", "out.mp4"}}).proxy == 0);
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"proxy", 1}}}}));
+	assert(rejects({{"edl", "cut.json"}, {"output", "out.mp4"}, {"options", {{"proxy", 32}}}}));
+	std::cout << "  ✓ The proxy factor is a job option between 2 and 16" << std::endl;
+	
+	assert(render::renderDimension(1920, 0) == 1920);
+	assert(render::renderDimension(1080, 4) == 270);
+	assert(render::renderDimension(1920, 3) == 640);
+	assert(render::renderDimension(1080, 16) == 66);
+	assert(render::renderDimension(720, 6) == 120);
+	assert(render::renderDimension(2, 16) == 2);
+	std::cout << "  ✓ Proxy frames are an even fraction of the EDL size" << std::endl;
+	
+	assert(render::proxyLowres(2) == 1);
+	assert(render::proxyLowres(3) == 1);
+	assert(render::proxyLowres(4) == 2);
+	assert(render::proxyLowres(8) == 3);
+	assert(render::proxyLowres(16) == 3);
+	std::cout << "  ✓ Decoders never decode below the proxy size" << std::endl;
+}
+
+void testChannel() {
+#ifndef _WIN32
+	std::cout << "Testing JSON channel" << std::endl;
+	
+	int fds[2];
+	assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	server::JsonChannel daemon(fds[0]);
+	
+	// Messages written from several threads arrive whole
+	std::thread writer([fd = fds[1]]() {
+		server::JsonChannel client(fd);
+		std::thread second([&client]() {
+			for (int i = 0; i < 100; i++) {
+				assert(client.write({{"type", "status"}, {"n", i}}));
+			}
+		});
+		for (int i = 0; i < 100; i++) {
+			assert(client.write({{"type", "render"}, {"edl", std::string(1000, 'x')}, {"n", i}}));
+		}
+		second.join();
+	});
+	
+	int renders = 0;
+	int statuses = 0;
+	json message;
+	while (daemon.read(message)) {
+		if (message["type"] == "render") {
+			assert(message["n"] == renders && message["edl"].get<std::string>().size() == 1000);
+			renders++;
+		} else {
+			assert(message["n"] == statuses);
+			statuses++;
+		}
+	}
+	writer.join();
+	assert(renders == 100 && statuses == 100);
+	
+	// Once the peer is gone, writes fail instead of raising SIGPIPE
+	assert(!daemon.write({{"event", "done"}}));
+	
+	std::cout << "  ✓ Concurrent writes arrive as whole lines, in order per writer" << std::endl;
+#endif
+}
+
+int main() {
+	std::cout << "Running render options tests..." << std::endl;
+	
+	testJobOptions();
+	testProxy();
+	testChannel();
+	
+	std::cout << "\nAll render options tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "cache/RenderPlan.h"
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include "utils/Logger.h"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static std::string sampleEDL(const char* name) {
+	const char* testDataDir = std::getenv("TEST_DATA_DIR");
+	return testDataDir ? (fs::path(testDataDir) / name).string() : std::string("sample_edls/") + name;
+}
+
+static bool sameInstruction(const compositor::CompositorInstruction& a, const compositor::CompositorInstruction& b) {
+	if (a.type != b.type || a.trackNumber != b.trackNumber || a.uri != b.uri ||
+		a.sourceFrameNumber != b.sourceFrameNumber ||
+		a.panX != b.panX || a.panY != b.panY || a.zoomX != b.zoomX || a.zoomY != b.zoomY ||
+		a.rotation != b.rotation || a.fade != b.fade ||
+		a.transition.type != b.transition.type || a.transition.progress != b.transition.progress ||
+		a.effects.size() != b.effects.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.effects.size(); ++i) {
+		if (a.effects[i].type != b.effects[i].type || a.effects[i].strength != b.effects[i].strength) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void testTimelineRoundTrip(const fs::path& tempDir) {
+	std::string edlPath = sampleEDL("multiple_clips_with_effects.json");
+	std::cout << "Testing render plan round trip: " << edlPath << std::endl;
+	
+	try {
+		edl::EDL edl = edl::EDLParser::parse(edlPath);
+		compositor::InstructionGenerator generator(edl);
+		const auto& timeline = generator.getTimeline();
+		assert(!timeline.spans.empty());
+		assert(timeline.spans.back().endFrame == generator.getTotalFrames());
+		
+		assert(!timeline.sources.empty());
+		
+		std::vector<cache::RenderPlan::Source> sources;
+		for (const auto& uri : timeline.sources) {
+			cache::RenderPlan::Source source;
+			source.uri = uri;
+			source.path = (tempDir / uri).string();
+			source.probe.width = 1920;
+			source.probe.height = 1080;
+			source.probe.pixelFormat = 0;
+			source.probe.frameRateNum = 30;
+			source.probe.timeBaseNum = 1;
+			source.probe.timeBaseDen = 15360;
+			source.probe.totalFrames = 300;
+			source.probe.keyframes = {0, 250};
+			sources.push_back(source);
+		}
+		
+		uint64_t hash = cache::RenderPlan::hashFile(edlPath);
+		std::string planPath = (tempDir / "plan.plan").string();
+		cache::RenderPlan::write(planPath, hash, timeline, sources);
+		
+		auto plan = cache::RenderPlan::load(planPath);
+		assert(plan);
+		assert(plan->getEDLHash() == hash);
+		
+		compositor::InstructionGenerator cached(plan->getTimeline());
+		assert(cached.getTotalFrames() == generator.getTotalFrames());
+		for (int frame = 0; frame < generator.getTotalFrames(); ++frame) {
+			assert(sameInstruction(generator.getInstructionForFrame(frame), cached.getInstructionForFrame(frame)));
+		}
+		
+		auto loaded = plan->getSources();
+		assert(loaded.size() == sources.size());
+		assert(loaded[0].uri == sources[0].uri);
+		assert(loaded[0].path == sources[0].path);
+		assert(loaded[0].probe.keyframes == sources[0].probe.keyframes);
+		
+		std::cout << "✓ Render plan round trip test passed" << std::endl;
+		
+	} catch (const std::exception& e) {
+		std::cerr << "✗ Render plan round trip test failed: " << e.what() << std::endl;
+		throw;
+	}
+}
+
+void testProbeInvalidation(const fs::path& tempDir) {
+	std::cout << "Testing cached probe invalidation" << std::endl;
+	
+	try {
+		std::string mediaPath = (tempDir / "media.bin").string();
+		std::ofstream(mediaPath) << "original";
+		
+		cache::RenderPlan::Source source;
+		source.uri = "media.bin";
+		source.path = mediaPath;
+		source.probe.width = 640;
+		source.probe.height = 360;
+		source.probe.pixelFormat = 0;
+		source.probe.frameRateNum = 25;
+		source.probe.frameRateDen = 1;
+		source.probe.timeBaseNum = 1;
+		source.probe.timeBaseDen = 12800;
+		assert(cache::RenderPlan::statFile(mediaPath, source.mtime, source.size));
+		
+		// A source that was never opened is stored without a probe
+		std::string unopenedPath = (tempDir / "unopened.bin").string();
+		std::ofstream(unopenedPath) << "never opened";
+		cache::RenderPlan::Source unopened;
+		unopened.uri = "unopened.bin";
+		unopened.path = unopenedPath;
+		assert(cache::RenderPlan::statFile(unopenedPath, unopened.mtime, unopened.size));
+		
+		std::string planPath = (tempDir / "probe.plan").string();
+		cache::RenderPlan::write(planPath, 0, compositor::CompiledTimeline{}, {source, unopened});
+		
+		auto plan = cache::RenderPlan::load(planPath);
+		assert(plan);
+		auto probe = plan->findProbe(mediaPath);
+		assert(probe && probe->width == 640 && probe->timeBaseDen == 12800);
+		assert(!plan->findProbe((tempDir / "other.bin").string()));
+		assert(!plan->findProbe(unopenedPath));
+		
+		// A changed file must not reuse the old probe
+		std::ofstream(mediaPath) << "modified contents";
+		assert(!plan->findProbe(mediaPath));
+		
+		std::cout << "✓ Cached probe invalidation test passed" << std::endl;
+		
+	} catch (const std::exception& e) {
+		std::cerr << "✗ Cached probe invalidation test failed: " << e.what() << std::endl;
+		throw;
+	}
+}
+
+void testCorruptPlan(const fs::path& tempDir) {
+	std::cout << "Testing corrupt render plan rejection" << std::endl;
+	
+	try {
+		std::string planPath = (tempDir / "corrupt.plan").string();
+		assert(!cache::RenderPlan::load(planPath));
+		
+		edl::EDL edl = edl::EDLParser::parse(sampleEDL("simple_single_clip.json"));
+		compositor::InstructionGenerator generator(edl);
+		std::vector<cache::RenderPlan::Source> sources(generator.getTimeline().sources.size());
+		for (size_t i = 0; i < sources.size(); ++i) {
+			sources[i].uri = generator.getTimeline().sources[i];
+		}
+		cache::RenderPlan::write(planPath, 1, generator.getTimeline(), sources);
+		assert(cache::RenderPlan::load(planPath));
+		
+		// Truncated file
+		fs::resize_file(planPath, fs::file_size(planPath) - 8);
+		assert(!cache::RenderPlan::load(planPath));
+		
+		// Wrong magic
+		std::ofstream(planPath, std::ios::binary | std::ios::trunc) << std::string(512, 'x');
+		assert(!cache::RenderPlan::load(planPath));
+		
+		std::cout << "✓ Corrupt render plan test passed" << std::endl;
+		
+	} catch (const std::exception& e) {
+		std::cerr << "✗ Corrupt render plan test failed: " << e.what() << std::endl;
+		throw;
+	}
+}
+
+int main() {
+	utils::Logger::setLevel(utils::Logger::INFO);
+	
+	fs::path tempDir = fs::temp_directory_path() / "edl2ffmpeg_test_render_plan";
+	fs::create_directories(tempDir);
+	
+	try {
+		testTimelineRoundTrip(tempDir);
+		testProbeInvalidation(tempDir);
+		testCorruptPlan(tempDir);
+		
+		fs::remove_all(tempDir);
+		std::cout << "\n✓ All tests passed!" << std::endl;
+		return 0;
+		
+	} catch (const std::exception& e) {
+		fs::remove_all(tempDir);
+		std::cerr << "\n✗ Test suite failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "ipc/SharedFrameRing.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+std::string ringName(const char* role) {
+	return "/edl2ffmpeg-test-" + std::to_string(getpid()) + "-" + role;
+}
+
+}
+
+void testWrapAndTimeout() {
+	std::cout << "Testing slot hand-over in one process" << std::endl;
+	
+	ipc::SharedFrameRing::Config config;
+	config.slotCount = 3;
+	config.slotBytes = 4096;
+	std::string name = ringName("wrap");
+	ipc::SharedFrameRing producer(name, config);
+	ipc::SharedFrameRing consumer(name);
+	assert(consumer.getSlotCount() == 3);
+	assert(consumer.getSlotBytes() == 4096);
+	
+	// Fill the ring; the next write must time out instead of overwriting
+	ipc::SharedFrameRing::Slot slot;
+	for (int i = 0; i < 3; i++) {
+		assert(producer.acquireWrite(slot, 0));
+		slot.header->frameNumber = i;
+		std::memset(slot.payload, i, slot.capacity);
+		producer.commitWrite();
+	}
+	assert(!producer.acquireWrite(slot, 10));
+	
+	// Read back around the wrap, in order
+	for (int i = 0; i < 10; i++) {
+		assert(consumer.acquireRead(slot, 0));
+		assert(slot.header->frameNumber == i);
+		assert(slot.payload[0] == static_cast<uint8_t>(i) && slot.payload[4095] == static_cast<uint8_t>(i));
+		consumer.releaseRead();
+		
+		assert(producer.acquireWrite(slot, 0));
+		slot.header->frameNumber = i + 3;
+		std::memset(slot.payload, i + 3, slot.capacity);
+		producer.commitWrite();
+	}
+	
+	// Frames published before close() are still delivered
+	producer.close();
+	for (int i = 10; i < 13; i++) {
+		assert(consumer.acquireRead(slot, 0));
+		assert(slot.header->frameNumber == i);
+		consumer.releaseRead();
+	}
+	assert(!consumer.acquireRead(slot, 10));
+	assert(!producer.acquireWrite(slot, 0));
+	
+	std::cout << "  ✓ Slots arrive in order and a full ring holds the producer back" << std::endl;
+}
+
+void testAttachRejectsMissingRing() {
+	std::cout << "Testing attach errors" << std::endl;
+	
+	bool threw = false;
+	try {
+		ipc::SharedFrameRing ring(ringName("missing"));
+	} catch (const std::runtime_error&) {
+		threw = true;
+	}
+	assert(threw);
+	
+	std::cout << "  ✓ Attaching to a missing ring throws" << std::endl;
+	
+	// Overwrite the slot count and stride of a valid ring's header
+	ipc::SharedFrameRing::Config config;
+	config.slotCount = 2;
+	config.slotBytes = 1024;
+	std::string name = ringName("malformed");
+	ipc::SharedFrameRing producer(name, config);
+	int fd = shm_open(name.c_str(), O_RDWR, 0600);
+	assert(fd >= 0);
+	void* mapped = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	assert(mapped != MAP_FAILED);
+	auto* header = static_cast<uint8_t*>(mapped);
+	
+	auto rejects = [&name]() {
+		try {
+			ipc::SharedFrameRing consumer(name);
+		} catch (const std::runtime_error&) {
+			return true;
+		}
+		return false;
+	};
+	
+	uint32_t slotCount;
+	uint64_t slotStride;
+	std::memcpy(&slotCount, header + 8, sizeof(slotCount));
+	std::memcpy(&slotStride, header + 24, sizeof(slotStride));
+	
+	const uint32_t zeroCount = 0;
+	std::memcpy(header + 8, &zeroCount, sizeof(zeroCount));
+	assert(rejects());
+	std::memcpy(header + 8, &slotCount, sizeof(slotCount));
+	
+	const uint64_t shortStride = 512;
+	std::memcpy(header + 24, &shortStride, sizeof(shortStride));
+	assert(rejects());
+	std::memcpy(header + 24, &slotStride, sizeof(slotStride));
+	
+	const uint32_t manySlots = 1u << 31;
+	std::memcpy(header + 8, &manySlots, sizeof(manySlots));
+	assert(rejects());
+	std::memcpy(header + 8, &slotCount, sizeof(slotCount));
+	
+	assert(!rejects());
+	munmap(mapped, 4096);
+	::close(fd);
+	
+	std::cout << "  ✓ Attaching to a ring with a malformed slot layout throws" << std::endl;
+}
+
+// Child process standing in for an external compositor: takes each exported
+// frame, "composites" it by copying its pixels, and returns it
+int runConsumer(const std::string& exportName, const std::string& returnName, uint64_t frameBytes) {
+	ipc::SharedFrameRing exportRing(exportName);
+	ipc::SharedFrameRing returnRing(returnName);
+	
+	ipc::SharedFrameRing::Slot in;
+	ipc::SharedFrameRing::Slot out;
+	while (exportRing.acquireRead(in, 5000)) {
+		if (!returnRing.acquireWrite(out, 5000)) {
+			return 1;
+		}
+		out.header->frameNumber = in.header->frameNumber;
+		out.header->layerCount = 1;
+		std::memcpy(out.payload, in.payload, frameBytes);
+		returnRing.commitWrite();
+		exportRing.releaseRead();
+	}
+	returnRing.close();
+	return 0;
+}
+
+void testRoundTripThroughput() {
+	std::cout << "Testing round trip through a second process" << std::endl;
+	
+	// 1080p YUV 4:2:0
+	const uint64_t frameBytes = 1920 * 1080 * 3 / 2;
+	const int frames = 240;
+	
+	ipc::SharedFrameRing::Config config;
+	config.slotCount = 4;
+	config.slotBytes = frameBytes;
+	std::string exportName = ringName("export");
+	std::string returnName = ringName("return");
+	ipc::SharedFrameRing exportRing(exportName, config);
+	ipc::SharedFrameRing returnRing(returnName, config);
+	
+	pid_t child = fork();
+	assert(child >= 0);
+	if (child == 0) {
+		_exit(runConsumer(exportName, returnName, frameBytes));
+	}
+	
+	auto start = std::chrono::steady_clock::now();
+	
+	// Export from a second thread so both rings stay full
+	std::thread producer([&]() {
+		ipc::SharedFrameRing::Slot slot;
+		for (int i = 0; i < frames; i++) {
+			bool ok = exportRing.acquireWrite(slot, 5000);
+			assert(ok);
+			(void)ok;
+			slot.header->frameNumber = i;
+			std::memset(slot.payload, i & 0xff, frameBytes);
+			exportRing.commitWrite();
+		}
+		exportRing.close();
+	});
+	
+	ipc::SharedFrameRing::Slot slot;
+	int received = 0;
+	while (returnRing.acquireRead(slot, 5000)) {
+		assert(slot.header->frameNumber == received);
+		assert(slot.payload[0] == static_cast<uint8_t>(received & 0xff));
+		assert(slot.payload[frameBytes - 1] == static_cast<uint8_t>(received & 0xff));
+		returnRing.releaseRead();
+		received++;
+	}
+	producer.join();
+	
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	int status = 0;
+	waitpid(child, &status, 0);
+	assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	assert(received == frames);
+	
+	double fps = frames / elapsed.count();
+	double bandwidth = fps * frameBytes * 2 / (1024.0 * 1024.0 * 1024.0);
+	std::cout << "  ✓ " << frames << " 1080p frames round trip at " << static_cast<int>(fps) << " fps ("
+		<< bandwidth << " GiB/s through shared memory)" << std::endl;
+}
+
+int main() {
+	std::cout << "Running shared frame ring tests..." << std::endl;
+	
+	testWrapAndTimeout();
+	testAttachRejectsMissingRing();
+	testRoundTripThroughput();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "integration/common/StressEDLGenerator.h"
+#include "compositor/InstructionGenerator.h"
+#include "edl/EDLParser.h"
+#include "utils/Logger.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <set>
+
+using Reuse = test::StressEDLGenerator::Reuse;
+
+std::set<std::string> sourcesOf(const edl::EDL& edl, edl::Track::Type type) {
+	std::set<std::string> uris;
+	for (const auto& clip : edl.clips) {
+		if (clip.track.type == type && clip.source && std::holds_alternative<edl::MediaSource>(*clip.source)) {
+			uris.insert(std::get<edl::MediaSource>(*clip.source).uri);
+		}
+	}
+	return uris;
+}
+
+int countClips(const edl::EDL& edl, edl::Track::Type type, const std::string& subtype) {
+	int count = 0;
+	for (const auto& clip : edl.clips) {
+		if (clip.track.type == type && clip.track.subtype == subtype) {
+			count++;
+		}
+	}
+	return count;
+}
+
+void testLayout() {
+	std::cout << "Testing generated EDL layout" << std::endl;
+	
+	auto generator = [] {
+		return test::StressEDLGenerator(7)
+			.withClips(2000)
+			.withTracks(3, 2)
+			.withSources(50)
+			.withEffectDensity(0.25)
+			.withTransitionDensity(0.1)
+			.withFadeDensity(0.2)
+			.withGapDensity(0.05);
+	};
+	auto document = generator().generate();
+	assert(document == generator().generate());
+	assert(document != test::StressEDLGenerator(8).withClips(2000).withTracks(3, 2).withSources(50).generate());
+	std::cout << "  ✓ Same seed, same EDL" << std::endl;
+	
+	// Parsing checks that no track overlaps
+	edl::EDL edl = edl::EDLParser::parseJSON(document);
+	assert(countClips(edl, edl::Track::Video, "") == 2000);
+	assert(countClips(edl, edl::Track::Audio, "") == 667 + 667);   // Sound of video tracks 1 and 2
+	int effects = countClips(edl, edl::Track::Video, "effects");
+	assert(effects > 400 && effects < 600);
+	assert(edl.tracks.count("video_3") && edl.tracks.count("audio_2"));
+	std::cout << "  ✓ " << edl.clips.size() << " clips parse, with " << effects << " effects" << std::endl;
+	
+	// Every clip is cut on a frame boundary
+	for (const auto& clip : edl.clips) {
+		double frames = clip.in * edl.fps;
+		assert(std::abs(frames - std::round(frames)) < 1e-6);
+	}
+	std::cout << "  ✓ Cuts on frame boundaries" << std::endl;
+}
+
+void testReuse() {
+	std::cout << "Testing source reuse patterns" << std::endl;
+	
+	auto sources = [](Reuse reuse) {
+		auto document = test::StressEDLGenerator(3).withClips(500).withSources(40, reuse).generate();
+		return sourcesOf(edl::EDLParser::parseJSON(document), edl::Track::Video);
+	};
+	assert(sources(Reuse::RoundRobin).size() == 40);
+	assert(sources(Reuse::Random).size() <= 40);
+	assert(sources(Reuse::Unique).size() == 500);
+	std::cout << "  ✓ Round robin and unique sources" << std::endl;
+	
+	// Four in five clips read the first eight of forty sources
+	auto document = test::StressEDLGenerator(3).withClips(1000).withSources(40, Reuse::Hotspot).generate();
+	int hot = 0;
+	for (const auto& clip : document["clips"]) {
+		std::string uri = clip["source"]["uri"];
+		int index = std::stoi(uri.substr(uri.find('_') + 1));
+		hot += index < 8 ? 1 : 0;
+	}
+	assert(hot > 740 && hot < 860);
+	std::cout << "  ✓ Hotspot reuse (" << hot << " of 1000 clips on hot sources)" << std::endl;
+}
+
+void testCompile() {
+	std::cout << "Testing timeline compilation of a large EDL" << std::endl;
+	
+	auto document = test::StressEDLGenerator(11)
+		.withClips(5000)
+		.withSources(1, Reuse::Unique)
+		.withEffectDensity(0.5)
+		.withGapDensity(0.1)
+		.generate();
+	edl::EDL edl = edl::EDLParser::parseJSON(document);
+	compositor::InstructionGenerator generator(edl);
+	const auto& timeline = generator.getTimeline();
+	
+	assert(timeline.sources.size() == 5000);
+	int media = 0;
+	int withEffects = 0;
+	for (const auto& span : timeline.spans) {
+		media += span.kind == compositor::TimelineSpan::Media ? 1 : 0;
+		withEffects += span.effectCount > 0 ? 1 : 0;
+	}
+	assert(media == 5000);
+	assert(withEffects > 2300 && withEffects < 2700);
+	std::cout << "  ✓ One span per clip, effects on " << withEffects << std::endl;
+}
+
+void testOverlappingEffects() {
+	std::cout << "Testing overlapping effects tracks" << std::endl;
+	
+	auto effect = [](double in, double out, int subnumber, double value) {
+		return nlohmann::json{
+			{"in", in}, {"out", out},
+			{"track", {{"type", "video"}, {"number", 1}, {"subtype", "effects"}, {"subnumber", subnumber}}},
+			{"source", {{"type", "brightness"}, {"in", 0}, {"out", out - in}, {"value", value}}}
+		};
+	};
+	nlohmann::json document = {
+		{"fps", 30}, {"width", 1920}, {"height", 1080},
+		{"clips", {
+			{
+				{"in", 0}, {"out", 3},
+				{"track", {{"type", "video"}, {"number", 1}}},
+				{"source", {{"uri", "a.mp4"}, {"in", 0}, {"out", 3}}}
+			},
+			effect(1, 2, 2, 0.25),
+			effect(0, 3, 1, 0.75)
+		}}
+	};
+	compositor::InstructionGenerator generator(edl::EDLParser::parseJSON(document));
+	
+	// The effect first in the EDL wins where both apply
+	auto strengthAt = [&](int frame) {
+		const auto* span = generator.findSpan(frame);
+		assert(span && span->effectCount == 1);
+		return generator.getTimeline().effects[span->effectOffset].strength;
+	};
+	assert(strengthAt(10) == 0.75f);
+	assert(strengthAt(45) == 0.25f);
+	assert(strengthAt(75) == 0.75f);
+	std::cout << "  ✓ First effect in the EDL applies" << std::endl;
+	
+	// The parser keeps clips on one effects track apart, but EDLs built in
+	// code may not: a long clip followed by a shorter one inside it
+	auto withEffect = [&](const nlohmann::json& clip) {
+		nlohmann::json single = document;
+		single["clips"] = {document["clips"][0], clip};
+		return edl::EDLParser::parseJSON(single);
+	};
+	edl::EDL sameTrack = withEffect(effect(0, 3, 1, 0.75));
+	sameTrack.clips.push_back(withEffect(effect(1, 1.5, 1, 0.25)).clips.back());
+	compositor::InstructionGenerator nested(sameTrack);
+	auto nestedStrengthAt = [&](int frame) {
+		const auto* span = nested.findSpan(frame);
+		assert(span && span->effectCount == 1);
+		return nested.getTimeline().effects[span->effectOffset].strength;
+	};
+	assert(nestedStrengthAt(10) == 0.75f);
+	assert(nestedStrengthAt(36) == 0.75f);
+	assert(nestedStrengthAt(60) == 0.75f);
+	std::cout << "  ✓ Clips overlapping on one effects track are all found" << std::endl;
+}
+
+int main() {
+	utils::Logger::setLevel(utils::Logger::ERROR);
+	std::cout << "Running stress EDL generator tests..." << std::endl;
+	
+	testLayout();
+	testReuse();
+	testCompile();
+	testOverlappingEffects();
+	
+	std::cout << "\nAll stress EDL generator tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
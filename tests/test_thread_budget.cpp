@@ -0,0 +1,135 @@
+#include "utils/BoundedQueue.h"
+#include "utils/ThreadBudget.h"
+#include "utils/ThreadPool.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+void testAllocationWithinBudget() {
+	std::cout << "Testing thread budget allocation" << std::endl;
+	
+	for (int total : {1, 2, 4, 8, 16, 32, 64}) {
+		for (int decoders : {1, 2, 4}) {
+			for (bool hardwareEncode : {false, true}) {
+				auto allocation = utils::ThreadBudget::allocate(total, decoders, hardwareEncode);
+				assert(allocation.decoderThreads >= 1);
+				assert(allocation.encoderThreads >= 1);
+				assert(allocation.compositorThreads >= 1);
+				
+				// Only the one-thread-per-stage minimum may exceed the budget
+				int used = allocation.decoderThreads * decoders + allocation.encoderThreads +
+					allocation.compositorThreads;
+				assert(used <= std::max(total, decoders + 2));
+			}
+		}
+	}
+	
+	// A hardware encoder leaves its share to decoding and compositing
+	auto software = utils::ThreadBudget::allocate(32, 2, false);
+	auto hardware = utils::ThreadBudget::allocate(32, 2, true);
+	assert(hardware.encoderThreads == 1);
+	assert(hardware.decoderThreads > software.decoderThreads);
+	assert(hardware.compositorThreads > software.compositorThreads);
+	
+	std::cout << "  ✓ Allocations stay within the budget" << std::endl;
+}
+
+void testParallelForCoversRange() {
+	std::cout << "Testing thread pool bands" << std::endl;
+	
+	utils::ThreadPool pool(4);
+	assert(pool.getThreadCount() == 4);
+	
+	for (int count : {0, 1, 15, 16, 17, 1080}) {
+		std::vector<std::atomic<int>> visits(count);
+		pool.parallelFor(count, [&](int begin, int end) {
+			assert(begin < end);
+			for (int i = begin; i < end; ++i) {
+				visits[i]++;
+			}
+		});
+		for (int i = 0; i < count; ++i) {
+			assert(visits[i] == 1);
+		}
+	}
+	
+	// A single-thread pool runs inline
+	utils::ThreadPool inlinePool(1);
+	int calls = 0;
+	inlinePool.parallelFor(1000, [&](int begin, int end) {
+		assert(begin == 0 && end == 1000);
+		calls++;
+	});
+	assert(calls == 1);
+	
+	std::cout << "  ✓ Every row is processed exactly once" << std::endl;
+	
+	// A throwing band does not leave others running against a finished call
+	for (int throwingBand : {0, 1000}) {
+		std::atomic<int> rows{0};
+		bool thrown = false;
+		try {
+			pool.parallelFor(1080, [&](int begin, int end) {
+				if (begin <= throwingBand && throwingBand < end) {
+					throw std::runtime_error("band failed");
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				rows += end - begin;
+			});
+		} catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		assert(thrown);
+		assert(rows == 1080 - 270);
+	}
+	
+	std::cout << "  ✓ Exceptions are rethrown after every band has finished" << std::endl;
+}
+
+void testBoundedQueue() {
+	std::cout << "Testing bounded queue" << std::endl;
+	
+	// Items arrive in order and the producer never gets ahead by more than the capacity
+	utils::BoundedQueue<int> queue(4);
+	std::atomic<int> produced{0};
+	std::thread producer([&]() {
+		for (int i = 0; i < 1000; i++) {
+			assert(queue.push(i));
+			produced++;
+		}
+		queue.close();
+	});
+	
+	int expected = 0;
+	while (auto item = queue.pop()) {
+		assert(*item == expected++);
+		assert(produced - expected <= static_cast<int>(queue.getCapacity()) + 1);
+	}
+	producer.join();
+	assert(expected == 1000);
+	
+	// A closed queue refuses new items but hands out what it holds
+	utils::BoundedQueue<int> closed(2);
+	assert(closed.push(1));
+	closed.close();
+	assert(!closed.push(2));
+	assert(closed.pop() == 1);
+	assert(!closed.pop());
+	
+	std::cout << "  ✓ FIFO order, bounded and drained on close" << std::endl;
+}
+
+int main() {
+	std::cout << "Running thread budget tests..." << std::endl;
+	
+	testAllocationWithinBudget();
+	testParallelForCoversRange();
+	testBoundedQueue();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "utils/Timer.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+int work(int i) {
+	TIME_BLOCK("work");
+	return i * 2;
+}
+
+}
+
+void testDisabledRecordsNothing() {
+	std::cout << "Testing disabled timer" << std::endl;
+	
+	auto& timer = utils::Timer::getInstance();
+	assert(!utils::Timer::isEnabled());
+	for (int i = 0; i < 100; i++) {
+		work(i);
+	}
+	
+	std::string path = "test_timer_disabled.json";
+	assert(timer.writeTrace(path));
+	auto trace = nlohmann::json::parse(std::ifstream(path));
+	for (const auto& event : trace["traceEvents"]) {
+		assert(event["ph"] != "X");
+	}
+	std::remove(path.c_str());
+	
+	std::cout << "  ✓ Nothing is recorded until the timer is enabled" << std::endl;
+}
+
+void testZonesAreInterned() {
+	std::cout << "Testing zone registry" << std::endl;
+	
+	auto& timer = utils::Timer::getInstance();
+	uint32_t first = timer.zone("interned");
+	assert(timer.zone("interned") == first);
+	assert(timer.zone("other") != first);
+	
+	// Two blocks on one line would collide; two lines must not
+	TIME_BLOCK("line_a");
+	TIME_BLOCK("line_b");
+	
+	std::cout << "  ✓ Names map to stable IDs" << std::endl;
+}
+
+int traceThreadCount(utils::Timer& timer) {
+	std::string path = "test_timer_threads.json";
+	assert(timer.writeTrace(path));
+	auto trace = nlohmann::json::parse(std::ifstream(path));
+	std::remove(path.c_str());
+	
+	int count = 0;
+	for (const auto& event : trace["traceEvents"]) {
+		if (event["ph"] == "M") {
+			count++;
+		}
+	}
+	return count;
+}
+
+void testExitedThreadsShareBuffers() {
+	std::cout << "Testing thread buffer reuse" << std::endl;
+	
+	auto& timer = utils::Timer::getInstance();
+	timer.setEnabled(true);
+	
+	// One thread at a time, as render jobs come and go
+	std::thread([]() { work(0); }).join();
+	int before = traceThreadCount(timer);
+	for (int t = 0; t < 50; t++) {
+		std::thread([t]() {
+			utils::Timer::getInstance().setThreadName("job " + std::to_string(t));
+			work(t);
+		}).join();
+	}
+	assert(traceThreadCount(timer) == before);
+	
+	std::cout << "  ✓ Short-lived threads reuse the buffers of exited ones" << std::endl;
+}
+
+void testTraceFromThreads() {
+	std::cout << "Testing trace export" << std::endl;
+	
+	auto& timer = utils::Timer::getInstance();
+	timer.setTracing(true);
+	assert(utils::Timer::isEnabled());
+	
+	// More entries than one trace chunk holds
+	const int perThread = 5000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 3; t++) {
+		threads.emplace_back([t]() {
+			utils::Timer::getInstance().setThreadName("worker \"" + std::to_string(t) + "\"");
+			for (int i = 0; i < perThread; i++) {
+				work(i);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	timer.addTiming(timer.zone("measured"), 0.002);
+	
+	std::string path = "test_timer_trace.json";
+	assert(timer.writeTrace(path));
+	auto trace = nlohmann::json::parse(std::ifstream(path));
+	std::remove(path.c_str());
+	
+	int workEvents = 0;
+	std::set<int> workThreads;
+	std::set<std::string> threadNames;
+	bool measured = false;
+	for (const auto& event : trace["traceEvents"]) {
+		if (event["ph"] == "M") {
+			threadNames.insert(event["args"]["name"].get<std::string>());
+		} else if (event["name"] == "work") {
+			assert(event["dur"].get<double>() >= 0.0);
+			workEvents++;
+			workThreads.insert(event["tid"].get<int>());
+		} else if (event["name"] == "measured") {
+			assert(std::abs(event["dur"].get<double>() - 2000.0) < 0.01);
+			measured = true;
+		}
+	}
+	assert(workEvents == 3 * perThread);
+	assert(workThreads.size() == 3);
+	assert(threadNames.count("worker \"0\"") == 1);
+	assert(measured);
+	
+	timer.printReport();
+	
+	std::cout << "  ✓ Every zone entry appears under its thread" << std::endl;
+}
+
+int main() {
+	std::cout << "Running timer tests..." << std::endl;
+	
+	testDisabledRecordsNothing();
+	testZonesAreInterned();
+	testExitedThreadsShareBuffers();
+	testTraceFromThreads();
+	
+	std::cout << "\nAll tests passed!" << std::endl;
+	return 0;
+}
\ No newline at end of file